@@ -0,0 +1,174 @@
+﻿/*****************************************************************//**
+ * @file   AsyncTextureLoader.cpp
+ * @brief  非同期テクスチャ読み込みの実装
+ *
+ * @details
+ * - state を Ready / Failed にするのは FinalizePending（描画スレッド）だけ。
+ *   Release も描画スレッドなので、完了済みかどうかの判定は競合しない
+ * - 未完了のまま Release されたものも必ずデコード済みキューを通し、
+ *   後始末は FinalizePending でまとめて行う
+ *********************************************************************/
+#include "AsyncTextureLoader.h"
+#include "../System/Profiler.h"
+#include <algorithm>
+
+AsyncTextureLoader::AsyncTextureLoader(ITextureBackend& backend, unsigned workerCount)
+    : m_backend(backend)
+{
+    if (workerCount == 0) {
+        // 描画スレッドの分を残す。読み込みは I/O 待ちも多いので上限は控えめに
+        const unsigned cores = std::thread::hardware_concurrency();
+        workerCount = (std::max)(1u, (std::min)(cores > 1 ? cores - 1 : 1u, 4u));
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&AsyncTextureLoader::WorkerMain, this);
+    }
+}
+
+AsyncTextureLoader::~AsyncTextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_quit = true;
+    }
+    m_queueCv.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+
+    // 作成待ちのデコード結果と、作成済みのテクスチャを破棄する
+    for (AsyncTexture* tex : m_decodedQueue) {
+        if (tex->decoded) {
+            m_backend.ReleaseDecoded(tex->decoded);
+            tex->decoded = nullptr;
+        }
+    }
+    for (const std::unique_ptr<AsyncTexture>& tex : m_textures) {
+        if (tex->texture) {
+            m_backend.Destroy(tex->texture);
+        }
+    }
+}
+
+AsyncTexture* AsyncTextureLoader::Request(const char* path)
+{
+    auto tex = std::make_unique<AsyncTexture>();
+    tex->path = path ? path : "";
+    AsyncTexture* handle = tex.get();
+    {
+        std::lock_guard<std::mutex> lock(m_ownMutex);
+        m_textures.push_back(std::move(tex));
+    }
+
+    m_pendingCount.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_decodeQueue.push_back(handle);
+    }
+    m_queueCv.notify_one();
+    return handle;
+}
+
+void AsyncTextureLoader::WorkerMain()
+{
+    PROFILE_THREAD_NAME("texture loader");
+    for (;;) {
+        AsyncTexture* tex = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCv.wait(lock, [this] { return m_quit || !m_decodeQueue.empty(); });
+            if (m_quit) {
+                return;
+            }
+            tex = m_decodeQueue.front();
+            m_decodeQueue.pop_front();
+        }
+
+        // キャンセル済みならデコードを省く（後始末は FinalizePending）
+        if (!tex->released.load(std::memory_order_acquire)) {
+            PROFILE_ZONE("AsyncTextureLoader::Decode");
+            tex->decoded = m_backend.Decode(tex->path);
+        }
+        tex->state.store(TextureLoadState::Decoded, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(m_doneMutex);
+            m_decodedQueue.push_back(tex);
+        }
+        m_doneCv.notify_all();
+    }
+}
+
+size_t AsyncTextureLoader::FinalizePending(size_t maxCount)
+{
+    size_t created = 0;
+    while (created < maxCount) {
+        AsyncTexture* tex = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_doneMutex);
+            if (m_decodedQueue.empty()) {
+                break;
+            }
+            tex = m_decodedQueue.front();
+            m_decodedQueue.pop_front();
+        }
+        m_pendingCount.fetch_sub(1);
+
+        if (tex->released.load(std::memory_order_acquire)) {
+            if (tex->decoded) {
+                m_backend.ReleaseDecoded(tex->decoded);
+                tex->decoded = nullptr;
+            }
+            Retire(tex);
+            continue;
+        }
+
+        if (tex->decoded) {
+            tex->texture = m_backend.Create(tex->decoded);
+            m_backend.ReleaseDecoded(tex->decoded);
+            tex->decoded = nullptr;
+            ++created;
+        }
+        tex->state.store(tex->texture ? TextureLoadState::Ready : TextureLoadState::Failed, std::memory_order_release);
+    }
+    return created;
+}
+
+void AsyncTextureLoader::Release(AsyncTexture* texture)
+{
+    if (!texture) {
+        return;
+    }
+    if (IsDone(texture)) {
+        if (texture->texture) {
+            m_backend.Destroy(texture->texture);
+            texture->texture = nullptr;
+        }
+        Retire(texture);
+        return;
+    }
+    texture->released.store(true, std::memory_order_release);
+}
+
+void AsyncTextureLoader::WaitAll()
+{
+    for (;;) {
+        FinalizePending();
+        if (m_pendingCount.load() == 0) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_doneMutex);
+        m_doneCv.wait(lock, [this] { return !m_decodedQueue.empty(); });
+    }
+}
+
+void AsyncTextureLoader::Retire(AsyncTexture* texture)
+{
+    std::lock_guard<std::mutex> lock(m_ownMutex);
+    auto it = std::find_if(m_textures.begin(), m_textures.end(),
+        [texture](const std::unique_ptr<AsyncTexture>& p) { return p.get() == texture; });
+    if (it != m_textures.end()) {
+        std::swap(*it, m_textures.back());
+        m_textures.pop_back();
+    }
+}
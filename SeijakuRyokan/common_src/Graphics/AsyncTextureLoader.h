@@ -0,0 +1,111 @@
+﻿/*****************************************************************//**
+ * @file   AsyncTextureLoader.h
+ * @brief  非同期テクスチャ読み込み（プラットフォーム非依存）
+ *
+ * @details
+ * - Request() は即座にハンドル（AsyncTexture*）を返す。読み込み完了までは
+ *   描画側がデフォルトテクスチャで代用する
+ * - ファイル読み込み・デコードはワーカースレッド、GPU リソース作成は
+ *   描画スレッドの FinalizePending() で行う
+ * - 実際のデコード/作成は ITextureBackend（D3D11 / テスト用の偽デバイス）に任せる
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../IGraphics.h"
+
+enum class TextureLoadState : int
+{
+    Pending, // デコード待ち・デコード中
+    Decoded, // デコード済み、GPU 作成待ち
+    Ready,   // 使用可能
+    Failed,  // 読み込み失敗（デフォルトテクスチャのまま）
+};
+
+class ITextureBackend
+{
+public:
+    virtual ~ITextureBackend() = default;
+
+    // ワーカースレッドから呼ばれる。GPU には触れず CPU 側の画像を返す（失敗時 nullptr）
+    virtual void* Decode(const std::string& path) = 0;
+
+    // 描画スレッドから呼ばれる。Decode の結果から GPU テクスチャを作る
+    virtual TextureHandle Create(void* decoded) = 0;
+
+    // Decode の結果を破棄する（Create の後、またはキャンセル時）
+    virtual void ReleaseDecoded(void* decoded) = 0;
+
+    // Create したテクスチャを破棄する
+    virtual void Destroy(TextureHandle texture) = 0;
+};
+
+// Request() が返すハンドルの実体
+struct AsyncTexture
+{
+    std::string path;
+    std::atomic<TextureLoadState> state{ TextureLoadState::Pending };
+    std::atomic<bool> released{ false };
+    TextureHandle texture = nullptr; // Ready になるまで nullptr（描画スレッドのみ触る）
+    void* decoded = nullptr;
+};
+
+class AsyncTextureLoader
+{
+public:
+    // workerCount が 0 ならコア数から決める
+    explicit AsyncTextureLoader(ITextureBackend& backend, unsigned workerCount = 0);
+    ~AsyncTextureLoader();
+
+    AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+    AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+    AsyncTexture* Request(const char* path);
+
+    // デコード済みのものを GPU に作成する（描画スレッドで毎フレーム呼ぶ）。作成数を返す
+    size_t FinalizePending(size_t maxCount = static_cast<size_t>(-1));
+
+    // 作成済みなら破棄、未完了ならキャンセル扱いにする（描画スレッドから呼ぶ）
+    void Release(AsyncTexture* texture);
+
+    // 完了（Ready / Failed）するまで待つ。起動時の必須テクスチャなど用
+    void WaitAll();
+
+    // 未完了（Pending / Decoded）の数
+    size_t GetPendingCount() const { return m_pendingCount.load(); }
+
+    static bool IsDone(const AsyncTexture* texture)
+    {
+        const TextureLoadState s = texture->state.load(std::memory_order_acquire);
+        return s == TextureLoadState::Ready || s == TextureLoadState::Failed;
+    }
+
+private:
+    void WorkerMain();
+    void Retire(AsyncTexture* texture);
+
+    ITextureBackend& m_backend;
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCv;
+    std::deque<AsyncTexture*> m_decodeQueue;
+    bool m_quit = false;
+
+    std::mutex m_doneMutex;
+    std::condition_variable m_doneCv;
+    std::deque<AsyncTexture*> m_decodedQueue;
+
+    std::atomic<size_t> m_pendingCount{ 0 };
+
+    // ハンドルの所有（Release されるまで保持）
+    std::mutex m_ownMutex;
+    std::vector<std::unique_ptr<AsyncTexture>> m_textures;
+};
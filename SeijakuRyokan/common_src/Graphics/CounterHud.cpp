@@ -0,0 +1,90 @@
+﻿/*****************************************************************//**
+ * @file   CounterHud.cpp
+ * @brief  FrameCounters のデバッグ HUD 実装
+ *********************************************************************/
+#include "CounterHud.h"
+#include "../System/MemoryTracker.h"
+#include "../System/NumberText.h"
+#include "GraphicsExtensions.h"
+
+bool CounterHud::Initialize(IGraphics& graphics, const char* glyphPath, const char* atlasPath)
+{
+    MemoryTagScope memoryTag(MemoryTag::Font);
+    if (!m_glyphs.Load(glyphPath)) {
+        return false;
+    }
+    m_atlas = graphics.LoadTexture(atlasPath);
+    // ThreadedGraphics は読み込みを待たずにハンドルを返すので、読めたかどうかは待って確かめる
+    if (auto* extensions = dynamic_cast<IGraphicsExtensions*>(&graphics)) {
+        extensions->WaitForTextures();
+        if (m_atlas && extensions->GetTextureState(m_atlas) == TextureLoadState::Failed) {
+            graphics.UnloadTexture(m_atlas);
+            m_atlas = nullptr;
+        }
+    }
+    if (!m_atlas) {
+        m_glyphs.Unload();
+        return false;
+    }
+    m_layouts = std::make_unique<TextLayoutCache>(m_glyphs, FrameCounters::COUNT * 4);
+    return true;
+}
+
+void CounterHud::Finalize(IGraphics& graphics)
+{
+    m_layouts.reset();
+    if (m_atlas) {
+        graphics.UnloadTexture(m_atlas);
+        m_atlas = nullptr;
+    }
+    m_glyphs.Unload();
+}
+
+void CounterHud::Update(IGamepad& gamepad)
+{
+    if (gamepad.WasButtonPressed(Button::BACK)) {
+        m_visible = !m_visible;
+        m_framesSinceRefresh = REFRESH_FRAMES; // 表示した瞬間に最新の値を出す
+    }
+}
+
+void CounterHud::Draw(IGraphics& graphics)
+{
+    if (!m_visible || !m_layouts) {
+        return;
+    }
+    if (++m_framesSinceRefresh >= REFRESH_FRAMES) {
+        RebuildLines();
+        m_framesSinceRefresh = 0;
+    }
+
+    const MyGame::Float4 color{ 1.0f, 1.0f, 0.6f, 1.0f };
+    MyGame::Float2 pos = m_pos;
+    for (const std::string& line : m_lines) {
+        const TextLayout& layout = m_layouts->Get(line, m_textSize);
+        DrawTextLayout(graphics, m_atlas, layout, pos, color);
+        pos.y += layout.height > 0.0f ? layout.height : m_textSize;
+    }
+    m_layouts->EndFrame();
+}
+
+void CounterHud::RebuildLines()
+{
+    const FrameCounters::Snapshot last = FrameCounters::GetLastFrame();
+    NumberText number;
+    for (size_t i = 0; i < FrameCounters::COUNT; ++i) {
+        const FrameCounter c = static_cast<FrameCounter>(i);
+        double average = 0.0;
+        uint64_t maximum = 0;
+        FrameCounters::GetRecent(c, average, maximum);
+
+        std::string& line = m_lines[i];
+        line.assign(FrameCounters::GetName(c));
+        line.append(" ");
+        line.append(number.Format(static_cast<long long>(last[c])));
+        line.append(" / ");
+        line.append(number.Format(average, 1));
+        line.append(" / ");
+        line.append(number.Format(static_cast<long long>(maximum)));
+    }
+}
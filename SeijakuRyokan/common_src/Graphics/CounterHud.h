@@ -0,0 +1,57 @@
+﻿/*****************************************************************//**
+ * @file   CounterHud.h
+ * @brief  FrameCounters を画面に重ねて表示するデバッグ HUD
+ *
+ * @details
+ * - ゲームパッドの BACK で表示・非表示を切り替える（既定は非表示）
+ * - 1 行に 1 カウンタ、「名前 直前のフレーム / 平均 / 最大」を SDF テキストで描く
+ * - 数字が毎フレーム変わると読めないうえ TextLayoutCache も効かないので、
+ *   文字列は REFRESH_FRAMES フレームごとに作り直す
+ * - HUD 自身の Quad もカウンタに入る（表示中は quads・draw_calls が数行分増える）
+ *********************************************************************/
+#pragma once
+#include <memory>
+#include <string>
+#include "../IGamepad.h"
+#include "../IGraphics.h"
+#include "../System/FrameCounters.h"
+#include "GlyphTable.h"
+#include "TextLayoutCache.h"
+
+class CounterHud
+{
+public:
+    static constexpr uint32_t REFRESH_FRAMES = 15;
+
+    CounterHud() = default;
+
+    // グリフテーブルとアトラスを読む。失敗しても HUD が出ないだけ
+    bool Initialize(IGraphics& graphics, const char* glyphPath, const char* atlasPath);
+    void Finalize(IGraphics& graphics);
+
+    // 入力の更新後に毎フレーム呼ぶ
+    void Update(IGamepad& gamepad);
+
+    // BeginDraw〜EndDraw の間、最前面に描きたい位置で呼ぶ
+    void Draw(IGraphics& graphics);
+
+    void SetVisible(bool visible) { m_visible = visible; }
+    bool IsVisible() const { return m_visible; }
+
+    void SetPosition(const MyGame::Float2& pos) { m_pos = pos; }
+    void SetTextSize(float size) { m_textSize = size; }
+
+private:
+    void RebuildLines();
+
+    GlyphTable m_glyphs;
+    std::unique_ptr<TextLayoutCache> m_layouts;
+    TextureHandle m_atlas = nullptr;
+
+    bool m_visible = false;
+    uint32_t m_framesSinceRefresh = REFRESH_FRAMES;
+    std::string m_lines[FrameCounters::COUNT];
+
+    MyGame::Float2 m_pos{ 24.0f, 24.0f };
+    float m_textSize = 22.0f;
+};
@@ -0,0 +1,148 @@
+﻿/*****************************************************************//**
+ * @file   DrawCommandBuffer.cpp
+ * @brief  ソートキー付き描画コマンドバッファ実装
+ *********************************************************************/
+#include "DrawCommandBuffer.h"
+#include <cstring>
+
+namespace
+{
+    constexpr int LAYER_SHIFT = 56;
+    constexpr int SHADER_SHIFT = 55;
+    constexpr int TEXTURE_SHIFT = 32;
+    constexpr uint32_t TEXTURE_MASK = (1u << 23) - 1;
+    constexpr int ORDERED_SEQUENCE_SHIFT = 24;
+}
+
+DrawCommandBuffer::DrawCommandBuffer()
+{
+    for (auto& mode : m_layerModes) {
+        mode = LayerSortMode::Ordered;
+    }
+    m_commands.reserve(4096);
+    m_entries.reserve(4096);
+}
+
+void DrawCommandBuffer::Reset()
+{
+    m_commands.clear();
+    m_entries.clear();
+    m_textureIds.clear();
+    m_sequence = 0;
+    m_lastKey = 0;
+    m_inOrder = true;
+}
+
+void DrawCommandBuffer::Record(const Quad& quad, bool sdf)
+{
+    const uint32_t index = static_cast<uint32_t>(m_commands.size());
+
+    const LayerSortMode mode = m_layerModes[m_layer];
+
+    DrawCommand cmd;
+    cmd.quad = quad;
+    cmd.sdf = sdf;
+    cmd.layer = m_layer;
+    cmd.mode = mode;
+    m_commands.push_back(cmd);
+
+    // Ordered のキーにテクスチャは入らないので、ID を引くのは ByState のときだけ
+    const uint32_t textureId = mode == LayerSortMode::ByState ? GetTextureId(quad.texture) : 0;
+
+    DrawSortEntry entry;
+    entry.key = MakeKey(m_layer, mode, sdf, textureId, m_sequence++);
+    entry.index = index;
+    m_entries.push_back(entry);
+
+    m_inOrder = m_inOrder && entry.key >= m_lastKey;
+    m_lastKey = entry.key;
+}
+
+void DrawCommandBuffer::Sort()
+{
+    if (m_inOrder) {
+        return;
+    }
+    RadixSort(m_entries, m_scratch);
+    m_inOrder = true;
+    m_lastKey = m_entries.back().key;
+}
+
+uint64_t DrawCommandBuffer::MakeKey(uint8_t layer, LayerSortMode mode, bool sdf, uint32_t textureId, uint32_t sequence)
+{
+    uint64_t key = static_cast<uint64_t>(layer) << LAYER_SHIFT;
+    if (mode == LayerSortMode::Ordered) {
+        key |= static_cast<uint64_t>(sequence) << ORDERED_SEQUENCE_SHIFT;
+    }
+    else {
+        key |= static_cast<uint64_t>(sdf ? 1 : 0) << SHADER_SHIFT;
+        key |= static_cast<uint64_t>(textureId & TEXTURE_MASK) << TEXTURE_SHIFT;
+        key |= sequence;
+    }
+    return key;
+}
+
+void DrawCommandBuffer::RadixSort(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch)
+{
+    const size_t count = entries.size();
+    if (count < 2) {
+        return;
+    }
+
+    // 8桁ぶんのヒストグラムを1回の走査でまとめて作る
+    uint32_t histogram[8][256];
+    std::memset(histogram, 0, sizeof(histogram));
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t key = entries[i].key;
+        for (int d = 0; d < 8; ++d) {
+            histogram[d][(key >> (d * 8)) & 0xFF]++;
+        }
+    }
+
+    scratch.resize(count);
+    DrawSortEntry* src = entries.data();
+    DrawSortEntry* dst = scratch.data();
+
+    for (int d = 0; d < 8; ++d) {
+        uint32_t* h = histogram[d];
+
+        // 全要素が同じ値の桁は並べ替え不要
+        const uint32_t firstDigit = static_cast<uint32_t>((src[0].key >> (d * 8)) & 0xFF);
+        if (h[firstDigit] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            const uint32_t n = h[b];
+            h[b] = offset;
+            offset += n;
+        }
+
+        const int shift = d * 8;
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t digit = static_cast<uint32_t>((src[i].key >> shift) & 0xFF);
+            dst[h[digit]++] = src[i];
+        }
+
+        DrawSortEntry* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    // 奇数回入れ替わった場合は結果が scratch 側にある
+    if (src != entries.data()) {
+        entries.swap(scratch);
+    }
+}
+
+uint32_t DrawCommandBuffer::GetTextureId(const void* texture)
+{
+    auto it = m_textureIds.find(texture);
+    if (it != m_textureIds.end()) {
+        return it->second;
+    }
+    const uint32_t id = static_cast<uint32_t>(m_textureIds.size());
+    m_textureIds.emplace(texture, id);
+    return id;
+}
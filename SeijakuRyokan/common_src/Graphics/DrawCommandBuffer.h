@@ -0,0 +1,87 @@
+﻿/*****************************************************************//**
+ * @file   DrawCommandBuffer.h
+ * @brief  ソートキー付き描画コマンドバッファ（バックエンド非依存）
+ *
+ * @details
+ * - DrawQuad を即時描画せず、1フレーム分のコマンドとして記録する
+ * - 各コマンドに 64bit ソートキーを付け、EndDraw で基数ソートしてから描画する
+ * - キー構成（上位→下位）
+ *   - Ordered レイヤ : [layer:8][sequence:32][未使用:24]        … 呼び出し順を維持
+ *   - ByState レイヤ : [layer:8][shader:1][texture:23][sequence:32] … テクスチャ/シェーダでまとめる
+ * - 既定ではすべてのレイヤが Ordered（従来と同じ描画順）。重なりを気にしない
+ *   レイヤ（タイル・ゲストなど）だけ ByState にしてバッチをまとめる
+ * - キーが記録順ですでに昇順なら（全レイヤ Ordered でレイヤ番号を戻さない場合など）Sort は何もしない
+ * - テクスチャID はフレームごとに初出順で振り直す（解放後に同じアドレスが再利用されても混ざらない）
+ *********************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../IGraphics.h"
+
+enum class LayerSortMode : uint8_t
+{
+    Ordered, // 呼び出し順で描画（既定）
+    ByState, // 同じレイヤ内はシェーダ→テクスチャ順にまとめる
+};
+
+struct DrawCommand
+{
+    Quad quad;
+    bool sdf = false;
+    uint8_t layer = 0;                          // 記録したときのレイヤ
+    LayerSortMode mode = LayerSortMode::Ordered; // 記録したときのそのレイヤの並べ方
+};
+
+// 基数ソート用のキーとコマンド番号の組
+struct DrawSortEntry
+{
+    uint64_t key;
+    uint32_t index;
+};
+
+class DrawCommandBuffer
+{
+public:
+    static constexpr int LAYER_COUNT = 256;
+
+    DrawCommandBuffer();
+
+    // フレーム先頭で呼ぶ（レイヤ設定は維持、テクスチャIDは振り直し）
+    void Reset();
+
+    void SetLayer(uint8_t layer) { m_layer = layer; }
+    uint8_t GetLayer() const { return m_layer; }
+    void SetLayerSortMode(uint8_t layer, LayerSortMode mode) { m_layerModes[layer] = mode; }
+
+    void Record(const Quad& quad, bool sdf);
+
+    // 記録済みコマンドをキー順に並べ替える（記録順で昇順なら省く）
+    void Sort();
+    bool IsInOrder() const { return m_inOrder; }
+
+    size_t Size() const { return m_commands.size(); }
+
+    // Sort() 後は i 番目に描画すべきコマンドを返す
+    const DrawCommand& GetSorted(size_t i) const { return m_commands[m_entries[i].index]; }
+
+    static uint64_t MakeKey(uint8_t layer, LayerSortMode mode, bool sdf, uint32_t textureId, uint32_t sequence);
+
+    // LSD 基数ソート（8bit × 8パス。全要素で同じ桁のパスは省略）
+    static void RadixSort(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch);
+
+private:
+    uint32_t GetTextureId(const void* texture);
+
+    std::vector<DrawCommand> m_commands;
+    std::vector<DrawSortEntry> m_entries;
+    std::vector<DrawSortEntry> m_scratch;
+
+    std::unordered_map<const void*, uint32_t> m_textureIds;
+    LayerSortMode m_layerModes[LAYER_COUNT];
+    uint8_t m_layer = 0;
+    uint32_t m_sequence = 0;
+    uint64_t m_lastKey = 0;
+    bool m_inOrder = true;
+};
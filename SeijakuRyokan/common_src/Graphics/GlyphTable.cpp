@@ -0,0 +1,139 @@
+﻿/*****************************************************************//**
+ * @file   GlyphTable.cpp
+ * @brief  SDF フォントのグリフ情報テーブル実装
+ *********************************************************************/
+#include "GlyphTable.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    const char MAGIC[4] = { 'G', 'L', 'Y', 'T' };
+
+    size_t DirectoryOffset()
+    {
+        return sizeof(GlyphTableHeader);
+    }
+
+    size_t PagesOffset()
+    {
+        return DirectoryOffset() + sizeof(uint16_t) * GlyphTable::DIRECTORY_SIZE;
+    }
+
+    size_t GlyphsOffset(uint32_t pageCount)
+    {
+        return PagesOffset() + sizeof(uint16_t) * GlyphTable::PAGE_SIZE * pageCount;
+    }
+}
+
+bool GlyphTable::Load(const char* path)
+{
+    Unload();
+    if (!m_file.Open(path)) {
+        return false;
+    }
+    if (!LoadFromMemory(m_file.GetData(), m_file.GetSize())) {
+        m_file.Close();
+        return false;
+    }
+    return true;
+}
+
+bool GlyphTable::LoadFromMemory(const uint8_t* data, size_t size)
+{
+    m_header = nullptr;
+    if (!data || size < PagesOffset()) {
+        return false;
+    }
+    const GlyphTableHeader* header = reinterpret_cast<const GlyphTableHeader*>(data);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) {
+        return false;
+    }
+    if (header->pageCount > DIRECTORY_SIZE || header->glyphCount >= NONE) {
+        return false;
+    }
+    const size_t expected = GlyphsOffset(header->pageCount) + sizeof(GlyphRecord) * header->glyphCount;
+    if (size < expected) {
+        return false;
+    }
+
+    // 範囲外を指す番号が無いかだけ確認しておけば、Find は検査なしで引ける
+    const uint16_t* directory = reinterpret_cast<const uint16_t*>(data + DirectoryOffset());
+    const uint16_t* pages = reinterpret_cast<const uint16_t*>(data + PagesOffset());
+    for (uint32_t i = 0; i < DIRECTORY_SIZE; ++i) {
+        if (directory[i] != NONE && directory[i] >= header->pageCount) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->pageCount * PAGE_SIZE; ++i) {
+        if (pages[i] != NONE && pages[i] >= header->glyphCount) {
+            return false;
+        }
+    }
+
+    m_size = size;
+    m_directory = directory;
+    m_pages = pages;
+    m_glyphs = reinterpret_cast<const GlyphRecord*>(data + GlyphsOffset(header->pageCount));
+    m_header = header;
+    return true;
+}
+
+void GlyphTable::Unload()
+{
+    m_header = nullptr;
+    m_directory = nullptr;
+    m_pages = nullptr;
+    m_glyphs = nullptr;
+    m_size = 0;
+    m_file.Close();
+}
+
+std::vector<uint8_t> GlyphTable::Build(const GlyphTableHeader& metrics, const std::vector<GlyphRecord>& glyphs)
+{
+    // コードポイント順に並べ、BMP 外と重複を落とす
+    std::vector<GlyphRecord> sorted;
+    sorted.reserve(glyphs.size());
+    for (const GlyphRecord& g : glyphs) {
+        if (g.codepoint <= 0xFFFF) {
+            sorted.push_back(g);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(),
+        [](const GlyphRecord& a, const GlyphRecord& b) { return a.codepoint < b.codepoint; });
+    sorted.erase(std::unique(sorted.begin(), sorted.end(),
+        [](const GlyphRecord& a, const GlyphRecord& b) { return a.codepoint == b.codepoint; }), sorted.end());
+    if (sorted.size() >= NONE) {
+        sorted.resize(NONE - 1);
+    }
+
+    std::vector<uint16_t> directory(DIRECTORY_SIZE, NONE);
+    std::vector<uint16_t> pages;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const uint32_t cp = sorted[i].codepoint;
+        uint16_t& page = directory[cp >> 8];
+        if (page == NONE) {
+            page = static_cast<uint16_t>(pages.size() / PAGE_SIZE);
+            pages.resize(pages.size() + PAGE_SIZE, NONE);
+        }
+        pages[page * PAGE_SIZE + (cp & 0xFF)] = static_cast<uint16_t>(i);
+    }
+
+    GlyphTableHeader header = metrics;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.glyphCount = static_cast<uint32_t>(sorted.size());
+    header.pageCount = static_cast<uint32_t>(pages.size() / PAGE_SIZE);
+    header.reserved = 0;
+
+    std::vector<uint8_t> out(GlyphsOffset(header.pageCount) + sizeof(GlyphRecord) * sorted.size());
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + DirectoryOffset(), directory.data(), sizeof(uint16_t) * directory.size());
+    if (!pages.empty()) {
+        std::memcpy(out.data() + PagesOffset(), pages.data(), sizeof(uint16_t) * pages.size());
+    }
+    if (!sorted.empty()) {
+        std::memcpy(out.data() + GlyphsOffset(header.pageCount), sorted.data(), sizeof(GlyphRecord) * sorted.size());
+    }
+    return out;
+}
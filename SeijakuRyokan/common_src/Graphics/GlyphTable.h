@@ -0,0 +1,94 @@
+﻿/*****************************************************************//**
+ * @file   GlyphTable.h
+ * @brief  SDF フォントのグリフ情報テーブル（バイナリ・メモリマップ）
+ *
+ * @details
+ * - tools/GlyphTableBuilder が sdf_atlas.json から sdf_atlas.glyphs を生成する
+ * - 実行時はファイルをマップするだけで、パースもヒープ確保も無い
+ * - 検索は2段の直引きテーブル（上位8bit → ページ、下位8bit → グリフ番号）。
+ *   BMP（U+0000～U+FFFF）のみ対応。ASCII・かな・漢字・全角記号はすべてこの範囲
+ *
+ * - ファイル構成（リトルエンディアン、4バイト境界）
+ *     GlyphTableHeader
+ *     uint16_t directory[256]             // cp >> 8 → ページ番号（NONE なら無し）
+ *     uint16_t pages[pageCount][256]      // cp & 0xFF → グリフ番号（NONE なら無し）
+ *     GlyphRecord glyphs[glyphCount]
+ *********************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../System/MappedFile.h"
+
+struct GlyphTableHeader
+{
+    char     magic[4];    // "GLYT"
+    uint32_t version;
+    uint32_t glyphCount;
+    uint32_t pageCount;
+    int32_t  fontPx;
+    int32_t  ascent;
+    int32_t  descent;
+    int32_t  lineGap;
+    int32_t  spread;
+    int32_t  atlasWidth;
+    int32_t  atlasHeight;
+    uint32_t reserved;
+};
+static_assert(sizeof(GlyphTableHeader) == 48, "GlyphTableHeader layout");
+
+struct GlyphRecord
+{
+    uint32_t codepoint;
+    uint16_t x, y, w, h;     // アトラス上のピクセル矩形
+    float    u0, v0, u1, v1; // 同 UV
+    int16_t  xoff, yoff;     // ベースラインからのオフセット（fontPx 基準）
+    int16_t  xadvance;
+    int16_t  pad;
+};
+static_assert(sizeof(GlyphRecord) == 36, "GlyphRecord layout");
+
+class GlyphTable
+{
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint16_t NONE = 0xFFFF;
+    static constexpr uint32_t DIRECTORY_SIZE = 256;
+    static constexpr uint32_t PAGE_SIZE = 256;
+
+    bool Load(const char* path);
+
+    // data は Unload まで呼び出し側が保持すること
+    bool LoadFromMemory(const uint8_t* data, size_t size);
+    void Unload();
+
+    const GlyphRecord* Find(uint32_t codepoint) const
+    {
+        if (codepoint > 0xFFFF || !m_header) {
+            return nullptr;
+        }
+        const uint16_t page = m_directory[codepoint >> 8];
+        if (page == NONE) {
+            return nullptr;
+        }
+        const uint16_t index = m_pages[page * PAGE_SIZE + (codepoint & 0xFF)];
+        return index == NONE ? nullptr : &m_glyphs[index];
+    }
+
+    bool IsLoaded() const { return m_header != nullptr; }
+    const GlyphTableHeader& GetHeader() const { return *m_header; }
+    const GlyphRecord* GetGlyphs() const { return m_glyphs; }
+    uint32_t GetGlyphCount() const { return m_header ? m_header->glyphCount : 0; }
+    size_t GetDataSize() const { return m_size; }
+
+    // metrics の magic / version / 件数は Build が埋める。BMP 外と重複はスキップ
+    static std::vector<uint8_t> Build(const GlyphTableHeader& metrics, const std::vector<GlyphRecord>& glyphs);
+
+private:
+    MappedFile m_file;
+    size_t m_size = 0;
+    const GlyphTableHeader* m_header = nullptr;
+    const uint16_t* m_directory = nullptr;
+    const uint16_t* m_pages = nullptr;
+    const GlyphRecord* m_glyphs = nullptr;
+};
@@ -0,0 +1,33 @@
+﻿/*****************************************************************//**
+ * @file   GraphicsExtensions.h
+ * @brief  IGraphics に無い描画機能（レイヤ・非同期読み込み）の拡張インターフェース
+ *
+ * @details
+ * - IGraphics は各プラットフォーム共通の最小限なので、描画レイヤと非同期読み込みはここに分ける
+ * - DirectXGraphics / SoftwareGraphics / ThreadedGraphics が実装する。ThreadedGraphics は
+ *   RenderList に記録して描画スレッドでバックエンドに流す（バックエンドが実装していなければ、
+ *   レイヤは無視し、非同期読み込みは同期読み込みに置き換える）
+ * - ゲーム側は持っている IGraphics* から取り出す
+ *     if (auto* ext = dynamic_cast<IGraphicsExtensions*>(graphics)) { ext->SetDrawLayer(2); }
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include "../IGraphics.h"
+#include "AsyncTextureLoader.h"
+#include "DrawCommandBuffer.h"
+
+class IGraphicsExtensions
+{
+public:
+    virtual ~IGraphicsExtensions() = default;
+
+    // 描画レイヤ（小さい順に描画）。同一レイヤ内の順序は SetLayerSortMode に従う
+    virtual void SetDrawLayer(uint8_t layer) = 0;
+    virtual void SetLayerSortMode(uint8_t layer, LayerSortMode mode) = 0;
+
+    // 非同期読み込み。すぐにハンドルを返し、完了までは白テクスチャで描画される
+    virtual TextureHandle LoadTextureAsync(const char* filePath) = 0;
+    virtual TextureLoadState GetTextureState(TextureHandle handle) const = 0;
+    // 非同期読み込みがすべて完了するまで待つ（ロード画面など）
+    virtual void WaitForTextures() = 0;
+};
@@ -0,0 +1,98 @@
+﻿/*****************************************************************//**
+ * @file   SpriteBatch.cpp
+ * @brief  プラットフォーム非依存のスプライトバッチ実装
+ *********************************************************************/
+#include "SpriteBatch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float DEG_TO_RAD = 3.14159265358979323846f / 180.0f;
+
+    // 旧 SpriteDrawer の固定頂点バッファと同じ並び（TRIANGLESTRIP 4頂点）
+    constexpr float LOCAL_X[4] = { -0.5f, -0.5f,  0.5f, 0.5f };
+    constexpr float LOCAL_Y[4] = {  0.5f, -0.5f,  0.5f, -0.5f };
+}
+
+SpriteBatch::SpriteBatch(uint32_t maxQuads)
+    : m_maxQuads((std::max)(maxQuads, 1u))
+{
+    m_vertices.resize(static_cast<size_t>(m_maxQuads) * VERTICES_PER_QUAD);
+    m_runs.reserve(64);
+}
+
+void SpriteBatch::Begin()
+{
+    m_active = true;
+    m_quadCount = 0;
+    m_runs.clear();
+    m_stats = {};
+}
+
+void SpriteBatch::End()
+{
+    Flush();
+    m_active = false;
+}
+
+void SpriteBatch::Add(void* texture, bool sdf,
+    const MyGame::Float2& pos, const MyGame::Float2& scale,
+    const MyGame::Float4& color, float angleDeg,
+    const MyGame::Float2& uvPos, const MyGame::Float2& uvScale)
+{
+    if (m_quadCount >= m_maxQuads) {
+        Flush();
+    }
+
+    // テクスチャかシェーダが変わったら新しい Run を開始
+    if (m_runs.empty() || m_runs.back().texture != texture || m_runs.back().sdf != sdf) {
+        SpriteBatchRun run;
+        run.texture = texture;
+        run.sdf = sdf;
+        run.firstQuad = m_quadCount;
+        m_runs.push_back(run);
+    }
+    m_runs.back().quadCount++;
+
+    // 回転なしの場合は三角関数を省く（タイル・UIの大半）
+    float cs = 1.0f, sn = 0.0f;
+    if (angleDeg != 0.0f) {
+        const float rad = angleDeg * DEG_TO_RAD;
+        cs = std::cos(rad);
+        sn = std::sin(rad);
+    }
+
+    SpriteBatchVertex* v = &m_vertices[static_cast<size_t>(m_quadCount) * VERTICES_PER_QUAD];
+    for (int i = 0; i < 4; ++i) {
+        const float px = LOCAL_X[i] * scale.x;
+        const float py = LOCAL_Y[i] * scale.y;
+        v[i].x = px * cs - py * sn + pos.x;
+        v[i].y = px * sn + py * cs + pos.y;
+        v[i].u = (LOCAL_X[i] + 0.5f) * uvScale.x + uvPos.x;
+        v[i].v = (LOCAL_Y[i] + 0.5f) * uvScale.y + uvPos.y;
+        v[i].r = color.x;
+        v[i].g = color.y;
+        v[i].b = color.z;
+        v[i].a = color.w;
+    }
+
+    m_quadCount++;
+    m_stats.quads++;
+}
+
+void SpriteBatch::Flush()
+{
+    if (m_quadCount == 0) {
+        return;
+    }
+
+    if (m_sink) {
+        m_sink->OnFlush(m_vertices.data(), m_quadCount, m_runs.data(), static_cast<uint32_t>(m_runs.size()));
+    }
+    m_stats.flushes++;
+    m_stats.drawCalls += static_cast<uint32_t>(m_runs.size());
+
+    m_quadCount = 0;
+    m_runs.clear();
+}
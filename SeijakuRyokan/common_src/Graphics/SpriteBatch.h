@@ -0,0 +1,90 @@
+﻿/*****************************************************************//**
+ * @file   SpriteBatch.h
+ * @brief  プラットフォーム非依存のスプライトバッチ
+ *
+ * @details
+ * - BeginDraw〜EndDraw の間に積まれたQuadをCPU側で頂点化して溜める
+ * - テクスチャ/シェーダが変わる区間（Run）ごとに1ドローにまとめる
+ * - 実際のGPU転送・描画は ISpriteBatchSink（各プラットフォーム側）が担当
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../VectorTypes.h"
+
+// バッチが生成する頂点（スクリーン座標・ピクセル単位）
+struct SpriteBatchVertex
+{
+    float x, y;       // スクリーン座標
+    float u, v;       // テクスチャ座標
+    float r, g, b, a; // 乗算色（Quad.color をそのまま。1.0 を超える値も丸めない）
+};
+
+// 同一テクスチャ・同一シェーダで連続するQuadの区間
+struct SpriteBatchRun
+{
+    void*    texture = nullptr;
+    bool     sdf = false;
+    uint32_t firstQuad = 0;
+    uint32_t quadCount = 0;
+};
+
+// 計測用カウンタ（BeginDraw でリセット）
+struct SpriteBatchStats
+{
+    uint32_t quads = 0;     // 積まれたQuad数
+    uint32_t drawCalls = 0; // 発行したドロー数（= Run数の合計）
+    uint32_t flushes = 0;   // 頂点バッファへの転送回数
+};
+
+// バッチの吐き出し先（D3D11 / ヘッドレス計測など）
+class ISpriteBatchSink
+{
+public:
+    virtual ~ISpriteBatchSink() = default;
+
+    // vertices は quadCount * 4 個（TRIANGLESTRIP 順: 左下, 左上, 右下, 右上）
+    virtual void OnFlush(const SpriteBatchVertex* vertices, uint32_t quadCount,
+        const SpriteBatchRun* runs, uint32_t runCount) = 0;
+};
+
+class SpriteBatch
+{
+public:
+    static constexpr uint32_t VERTICES_PER_QUAD = 4;
+    static constexpr uint32_t INDICES_PER_QUAD = 6;
+
+    explicit SpriteBatch(uint32_t maxQuads = 4096);
+
+    void SetSink(ISpriteBatchSink* sink) { m_sink = sink; }
+    uint32_t GetMaxQuads() const { return m_maxQuads; }
+
+    void Begin();
+    void End();
+    bool IsActive() const { return m_active; }
+
+    // 中心座標・サイズ・回転（度）・UV矩形で1枚追加（SpriteDrawer::Draw と同じ引数）
+    void Add(void* texture, bool sdf,
+        const MyGame::Float2& pos,
+        const MyGame::Float2& scale,
+        const MyGame::Float4& color,
+        float angleDeg,
+        const MyGame::Float2& uvPos,
+        const MyGame::Float2& uvScale);
+
+    // 溜まっている分を Sink に吐き出す（容量超過時は Add から自動で呼ばれる）
+    void Flush();
+
+    const SpriteBatchStats& GetStats() const { return m_stats; }
+
+private:
+    ISpriteBatchSink* m_sink = nullptr;
+    uint32_t m_maxQuads = 0;
+    bool m_active = false;
+
+    std::vector<SpriteBatchVertex> m_vertices;
+    std::vector<SpriteBatchRun> m_runs;
+    uint32_t m_quadCount = 0;
+
+    SpriteBatchStats m_stats;
+};
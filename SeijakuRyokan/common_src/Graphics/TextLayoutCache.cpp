@@ -0,0 +1,273 @@
+﻿/*****************************************************************//**
+ * @file   TextLayoutCache.cpp
+ * @brief  SDF テキストのレイアウト結果のキャッシュ実装
+ *********************************************************************/
+#include "TextLayoutCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    // UTF-8 を1文字読み進める（不正なバイトは U+FFFD 扱いで1バイト進める）
+    uint32_t DecodeUtf8(std::string_view text, size_t& pos)
+    {
+        const uint8_t c = static_cast<uint8_t>(text[pos]);
+        int length = 1;
+        uint32_t cp = c;
+        if (c >= 0xF0) { length = 4; cp = c & 0x07; }
+        else if (c >= 0xE0) { length = 3; cp = c & 0x0F; }
+        else if (c >= 0xC0) { length = 2; cp = c & 0x1F; }
+        else if (c >= 0x80) { ++pos; return 0xFFFD; }
+
+        if (pos + length > text.size()) {
+            pos = text.size();
+            return 0xFFFD;
+        }
+        for (int i = 1; i < length; ++i) {
+            cp = (cp << 6) | (static_cast<uint8_t>(text[pos + i]) & 0x3F);
+        }
+        pos += length;
+        return cp;
+    }
+
+    struct LineInfo
+    {
+        size_t firstQuad;
+        float width;
+    };
+
+    uint32_t FloatBits(float f)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+}
+
+TextLayoutCache::TextLayoutCache(const GlyphTable& glyphs, size_t maxEntries)
+    : m_glyphs(glyphs)
+    , m_maxEntries(maxEntries > 0 ? maxEntries : 1)
+{
+    m_entries.reserve(m_maxEntries);
+}
+
+const TextLayout& TextLayoutCache::Get(std::string_view text, float size, float wrapWidth, TextAlign align)
+{
+    const uint64_t key = HashKey(text, size, wrapWidth, align);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        Entry& e = it->second;
+        if (e.size == size && e.wrapWidth == wrapWidth && e.align == align && e.text == text) {
+            e.lastUsedFrame = m_frame;
+            ++m_current.hits;
+            return e.layout;
+        }
+    }
+
+    // ミス：レイアウトし直して登録（ハッシュ衝突時はそのエントリを上書き）
+    const auto start = std::chrono::steady_clock::now();
+    if (it == m_entries.end()) {
+        if (m_entries.size() >= m_maxEntries) {
+            EvictOldest();
+        }
+        it = m_entries.emplace(key, Entry()).first;
+    }
+    Entry& e = it->second;
+    e.text.assign(text.data(), text.size());
+    e.size = size;
+    e.wrapWidth = wrapWidth;
+    e.align = align;
+    e.lastUsedFrame = m_frame;
+    Layout(m_glyphs, text, size, wrapWidth, align, e.layout);
+
+    ++m_current.misses;
+    m_current.glyphsLaidOut += static_cast<uint32_t>(e.layout.quads.size());
+    m_current.layoutMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return e.layout;
+}
+
+void TextLayoutCache::EndFrame()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (m_frame - it->second.lastUsedFrame > EVICT_FRAMES) {
+            it = m_entries.erase(it);
+            ++m_current.evictions;
+        }
+        else {
+            ++it;
+        }
+    }
+
+    m_total.hits += m_current.hits;
+    m_total.misses += m_current.misses;
+    m_total.evictions += m_current.evictions;
+    m_total.glyphsLaidOut += m_current.glyphsLaidOut;
+    m_total.layoutMicros += m_current.layoutMicros;
+    m_lastFrame = m_current;
+    m_current = TextLayoutStats();
+    ++m_frame;
+}
+
+void TextLayoutCache::Clear()
+{
+    m_entries.clear();
+}
+
+void TextLayoutCache::EvictOldest()
+{
+    auto oldest = m_entries.begin();
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->second.lastUsedFrame < oldest->second.lastUsedFrame) {
+            oldest = it;
+        }
+    }
+    if (oldest != m_entries.end()) {
+        m_entries.erase(oldest);
+        ++m_current.evictions;
+    }
+}
+
+uint64_t TextLayoutCache::HashKey(std::string_view text, float size, float wrapWidth, TextAlign align)
+{
+    // FNV-1a（文字列）にサイズ・折り返し幅・揃えを混ぜる
+    uint64_t h = 14695981039346656037ull;
+    for (char c : text) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 1099511628211ull;
+    }
+    const uint64_t params = (static_cast<uint64_t>(FloatBits(size)) << 32) ^ FloatBits(wrapWidth) ^ (static_cast<uint64_t>(align) << 61);
+    h ^= params + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+void TextLayoutCache::Layout(const GlyphTable& glyphs, std::string_view text, float size, float wrapWidth, TextAlign align, TextLayout& out)
+{
+    out.quads.clear();
+    out.width = 0.0f;
+    out.height = 0.0f;
+    out.lines = 0;
+    if (!glyphs.IsLoaded()) {
+        return;
+    }
+
+    const GlyphTableHeader& font = glyphs.GetHeader();
+    const float scale = font.fontPx > 0 ? size / static_cast<float>(font.fontPx) : 1.0f;
+    const float lineHeight = static_cast<float>(font.ascent - font.descent + font.lineGap) * scale;
+    const float ascent = static_cast<float>(font.ascent) * scale;
+
+    std::vector<LineInfo> lines;
+    size_t lineStart = 0;
+    float penX = 0.0f;
+    float baseline = ascent;
+
+    // 直前の空白（英単語単位の折り返し位置）。無ければ文字単位で折り返す
+    size_t breakQuad = SIZE_MAX;
+    float breakX = 0.0f;    // 空白の直後のペン位置
+    float breakWidth = 0.0f; // 空白の手前までの行幅
+
+    auto newLine = [&](size_t firstQuadOfNext, float width) {
+        lines.push_back({ lineStart, width });
+        lineStart = firstQuadOfNext;
+        baseline += lineHeight;
+        breakQuad = SIZE_MAX;
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const uint32_t cp = DecodeUtf8(text, pos);
+        if (cp == '\n') {
+            newLine(out.quads.size(), penX);
+            penX = 0.0f;
+            continue;
+        }
+
+        const GlyphRecord* g = glyphs.Find(cp);
+        if (!g) {
+            g = glyphs.Find('?');
+            if (!g) continue;
+        }
+        const float advance = static_cast<float>(g->xadvance) * scale;
+
+        if (wrapWidth > 0.0f && penX > 0.0f && penX + advance > wrapWidth) {
+            if (cp == ' ') {
+                // 行末の空白は次の行に持ち越さない
+                newLine(out.quads.size(), penX);
+                penX = 0.0f;
+                continue;
+            }
+            if (breakQuad != SIZE_MAX) {
+                // 空白以降の単語を次の行へ移す
+                const size_t moveFrom = breakQuad;
+                const float shift = breakX;
+                newLine(moveFrom, breakWidth);
+                for (size_t i = moveFrom; i < out.quads.size(); ++i) {
+                    out.quads[i].center.x -= shift;
+                    out.quads[i].center.y += lineHeight;
+                }
+                penX -= shift;
+            }
+            else {
+                newLine(out.quads.size(), penX);
+                penX = 0.0f;
+            }
+        }
+
+        if (g->w > 0 && g->h > 0) {
+            TextGlyphQuad q;
+            const float w = static_cast<float>(g->w) * scale;
+            const float h = static_cast<float>(g->h) * scale;
+            q.center = MyGame::Float2(penX + static_cast<float>(g->xoff) * scale + w * 0.5f,
+                baseline + static_cast<float>(g->yoff) * scale + h * 0.5f);
+            q.size = MyGame::Float2(w, h);
+            q.uvPos = MyGame::Float2(g->u0, g->v0);
+            q.uvSize = MyGame::Float2(g->u1 - g->u0, g->v1 - g->v0);
+            out.quads.push_back(q);
+        }
+        if (cp == ' ') {
+            breakQuad = out.quads.size();
+            breakWidth = penX;
+            breakX = penX + advance;
+        }
+        penX += advance;
+    }
+    lines.push_back({ lineStart, penX });
+
+    for (const LineInfo& line : lines) {
+        out.width = (std::max)(out.width, line.width);
+    }
+    out.lines = static_cast<int>(lines.size());
+    out.height = lineHeight * static_cast<float>(out.lines);
+
+    if (align != TextAlign::Left) {
+        const float box = wrapWidth > 0.0f ? wrapWidth : out.width;
+        const float factor = (align == TextAlign::Center) ? 0.5f : 1.0f;
+        for (size_t l = 0; l < lines.size(); ++l) {
+            const size_t end = (l + 1 < lines.size()) ? lines[l + 1].firstQuad : out.quads.size();
+            const float offset = (box - lines[l].width) * factor;
+            for (size_t i = lines[l].firstQuad; i < end; ++i) {
+                out.quads[i].center.x += offset;
+            }
+        }
+    }
+}
+
+void DrawTextLayout(IGraphics& graphics, TextureHandle atlas, const TextLayout& layout,
+    const MyGame::Float2& pos, const MyGame::Float4& color)
+{
+    graphics.SetSdfMode(true);
+    for (const TextGlyphQuad& g : layout.quads) {
+        Quad quad;
+        quad.texture = atlas;
+        quad.position.x = pos.x + g.center.x;
+        quad.position.y = pos.y + g.center.y;
+        quad.size.x = g.size.x;
+        quad.size.y = g.size.y;
+        quad.color = color;
+        quad.uvPos = g.uvPos;
+        quad.uvSize = g.uvSize;
+        graphics.DrawQuad(quad);
+    }
+    graphics.SetSdfMode(false);
+}
@@ -0,0 +1,106 @@
+﻿/*****************************************************************//**
+ * @file   TextLayoutCache.h
+ * @brief  SDF テキストのレイアウト結果のキャッシュ
+ *
+ * @details
+ * - (文字列, サイズ, 折り返し幅, 揃え) をキーに、配置済みのグリフ Quad を保持する
+ * - 同じ文字列を毎フレーム描く UI（スコア・タイマー・チュートリアル）は
+ *   2フレーム目からグリフ検索・折り返し計算を省ける
+ * - ヒット時はヒープ確保なし（キーは文字列のハッシュで引き、文字列比較で確定）
+ * - EVICT_FRAMES フレーム使われなかったものは EndFrame で捨てる
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../IGraphics.h"
+#include "GlyphTable.h"
+
+enum class TextAlign : uint8_t
+{
+    Left,
+    Center,
+    Right,
+};
+
+// 原点（1行目の左上）からの相対位置に置いたグリフ
+struct TextGlyphQuad
+{
+    MyGame::Float2 center;
+    MyGame::Float2 size;
+    MyGame::Float2 uvPos;
+    MyGame::Float2 uvSize;
+};
+
+struct TextLayout
+{
+    std::vector<TextGlyphQuad> quads;
+    float width = 0.0f;  // 最も長い行の幅
+    float height = 0.0f; // 行数 × 行の高さ
+    int lines = 0;
+};
+
+struct TextLayoutStats
+{
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t evictions = 0;
+    uint32_t glyphsLaidOut = 0; // ミス時に配置したグリフ数
+    double layoutMicros = 0.0;  // ミス時のレイアウトにかかった時間
+
+    float GetHitRate() const
+    {
+        const uint32_t total = hits + misses;
+        return total ? static_cast<float>(hits) / static_cast<float>(total) : 0.0f;
+    }
+};
+
+class TextLayoutCache
+{
+public:
+    static constexpr uint32_t EVICT_FRAMES = 120;
+
+    explicit TextLayoutCache(const GlyphTable& glyphs, size_t maxEntries = 512);
+
+    // text は UTF-8。wrapWidth <= 0 なら折り返さない（改行文字のみ）
+    const TextLayout& Get(std::string_view text, float size, float wrapWidth = 0.0f, TextAlign align = TextAlign::Left);
+
+    // フレーム境界で呼ぶ。古いエントリを捨て、フレーム統計を確定する
+    void EndFrame();
+    void Clear();
+
+    const TextLayoutStats& GetFrameStats() const { return m_lastFrame; } // 直前のフレーム
+    const TextLayoutStats& GetTotalStats() const { return m_total; }
+    size_t GetEntryCount() const { return m_entries.size(); }
+
+    // キャッシュを使わないレイアウト（比較計測用にも使う）
+    static void Layout(const GlyphTable& glyphs, std::string_view text, float size, float wrapWidth, TextAlign align, TextLayout& out);
+
+private:
+    struct Entry
+    {
+        std::string text;
+        float size = 0.0f;
+        float wrapWidth = 0.0f;
+        TextAlign align = TextAlign::Left;
+        uint32_t lastUsedFrame = 0;
+        TextLayout layout;
+    };
+
+    static uint64_t HashKey(std::string_view text, float size, float wrapWidth, TextAlign align);
+    void EvictOldest();
+
+    const GlyphTable& m_glyphs;
+    size_t m_maxEntries;
+    uint32_t m_frame = 0;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    TextLayoutStats m_current;
+    TextLayoutStats m_lastFrame;
+    TextLayoutStats m_total;
+};
+
+// レイアウト済みテキストを1グリフ1 Quad で描く（pos は1行目の左上）
+void DrawTextLayout(IGraphics& graphics, TextureHandle atlas, const TextLayout& layout,
+    const MyGame::Float2& pos, const MyGame::Float4& color);
@@ -0,0 +1,242 @@
+﻿/*****************************************************************//**
+ * @file   TextureAtlas.cpp
+ * @brief  テクスチャアトラスのパッキングとマニフェスト実装
+ *********************************************************************/
+#include "TextureAtlas.h"
+#include "../System/json.hpp"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <fstream>
+
+using json = nlohmann::json;
+
+namespace
+{
+    bool Contains(const AtlasRect& a, const AtlasRect& b)
+    {
+        return b.x >= a.x && b.y >= a.y && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h;
+    }
+
+    bool Intersects(const AtlasRect& a, const AtlasRect& b)
+    {
+        return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+    }
+}
+
+// ==============================
+// MaxRectsPacker
+// ==============================
+
+void MaxRectsPacker::Init(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_usedArea = 0;
+    m_freeRects.clear();
+    m_freeRects.push_back({ 0, 0, width, height });
+}
+
+bool MaxRectsPacker::Insert(int w, int h, AtlasRect& out)
+{
+    // Best Short Side Fit: 余りの短辺が最小になる空き矩形を選ぶ
+    int bestShort = INT_MAX;
+    int bestLong = INT_MAX;
+    bool found = false;
+    for (const AtlasRect& fr : m_freeRects) {
+        if (fr.w < w || fr.h < h) {
+            continue;
+        }
+        const int dx = fr.w - w;
+        const int dy = fr.h - h;
+        const int shortSide = (std::min)(dx, dy);
+        const int longSide = (std::max)(dx, dy);
+        if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong)) {
+            bestShort = shortSide;
+            bestLong = longSide;
+            out = { fr.x, fr.y, w, h };
+            found = true;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    // 配置した矩形と重なる空き矩形を分割
+    m_newRects.clear();
+    for (size_t i = 0; i < m_freeRects.size();) {
+        if (Intersects(m_freeRects[i], out)) {
+            SplitFreeRect(m_freeRects[i], out);
+            m_freeRects[i] = m_freeRects.back();
+            m_freeRects.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+    m_freeRects.insert(m_freeRects.end(), m_newRects.begin(), m_newRects.end());
+    PruneFreeRects();
+
+    m_usedArea += static_cast<long long>(w) * h;
+    return true;
+}
+
+float MaxRectsPacker::GetOccupancy() const
+{
+    const long long total = static_cast<long long>(m_width) * m_height;
+    return total > 0 ? static_cast<float>(m_usedArea) / static_cast<float>(total) : 0.0f;
+}
+
+void MaxRectsPacker::SplitFreeRect(const AtlasRect& fr, const AtlasRect& used)
+{
+    // used の上下左右に残る最大矩形をそれぞれ空き矩形として登録
+    if (used.x > fr.x) {
+        m_newRects.push_back({ fr.x, fr.y, used.x - fr.x, fr.h });
+    }
+    if (used.x + used.w < fr.x + fr.w) {
+        m_newRects.push_back({ used.x + used.w, fr.y, fr.x + fr.w - (used.x + used.w), fr.h });
+    }
+    if (used.y > fr.y) {
+        m_newRects.push_back({ fr.x, fr.y, fr.w, used.y - fr.y });
+    }
+    if (used.y + used.h < fr.y + fr.h) {
+        m_newRects.push_back({ fr.x, used.y + used.h, fr.w, fr.y + fr.h - (used.y + used.h) });
+    }
+}
+
+void MaxRectsPacker::PruneFreeRects()
+{
+    // 他の空き矩形に完全に含まれるものを除去
+    for (size_t i = 0; i < m_freeRects.size(); ++i) {
+        for (size_t j = i + 1; j < m_freeRects.size();) {
+            if (Contains(m_freeRects[i], m_freeRects[j])) {
+                m_freeRects.erase(m_freeRects.begin() + j);
+                continue;
+            }
+            if (Contains(m_freeRects[j], m_freeRects[i])) {
+                m_freeRects.erase(m_freeRects.begin() + i);
+                --i;
+                break;
+            }
+            ++j;
+        }
+    }
+}
+
+// ==============================
+// AtlasManifest
+// ==============================
+
+bool AtlasManifest::Load(const char* path)
+{
+    Clear();
+
+    std::ifstream ifs(path);
+    if (!ifs) {
+        return false;
+    }
+
+    json j = json::parse(ifs, nullptr, false);
+    if (j.is_discarded() || !j.contains("pages") || !j.contains("sprites")) {
+        return false;
+    }
+
+    for (const auto& p : j["pages"]) {
+        AtlasPage page;
+        page.file = p.value("file", "");
+        page.width = p.value("width", 0);
+        page.height = p.value("height", 0);
+        if (page.width <= 0 || page.height <= 0) {
+            Clear();
+            return false;
+        }
+        m_pages.push_back(page);
+    }
+
+    for (const auto& s : j["sprites"]) {
+        const int page = s.value("page", -1);
+        if (page < 0 || page >= static_cast<int>(m_pages.size())) {
+            continue;
+        }
+        AtlasRect rect;
+        rect.x = s.value("x", 0);
+        rect.y = s.value("y", 0);
+        rect.w = s.value("w", 0);
+        rect.h = s.value("h", 0);
+        AddSprite(s.value("source", ""), page, rect);
+    }
+    return true;
+}
+
+bool AtlasManifest::Save(const char* path) const
+{
+    json j;
+    j["pages"] = json::array();
+    for (const AtlasPage& page : m_pages) {
+        j["pages"].push_back({ { "file", page.file }, { "width", page.width }, { "height", page.height } });
+    }
+    j["sprites"] = json::array();
+    for (const AtlasSprite& s : m_sprites) {
+        j["sprites"].push_back({
+            { "source", s.source }, { "page", s.page },
+            { "x", s.rect.x }, { "y", s.rect.y }, { "w", s.rect.w }, { "h", s.rect.h } });
+    }
+
+    std::ofstream ofs(path);
+    if (!ofs) {
+        return false;
+    }
+    ofs << j.dump(2) << "\n";
+    return static_cast<bool>(ofs);
+}
+
+void AtlasManifest::Clear()
+{
+    m_pages.clear();
+    m_sprites.clear();
+    m_index.clear();
+}
+
+void AtlasManifest::AddSprite(const std::string& source, int page, const AtlasRect& rect)
+{
+    const AtlasPage& p = m_pages[page];
+
+    AtlasSprite sprite;
+    sprite.source = NormalizePath(source.c_str());
+    sprite.key = MakeKey(source.c_str());
+    sprite.page = page;
+    sprite.rect = rect;
+    sprite.uvPos = MyGame::Float2(static_cast<float>(rect.x) / p.width, static_cast<float>(rect.y) / p.height);
+    sprite.uvSize = MyGame::Float2(static_cast<float>(rect.w) / p.width, static_cast<float>(rect.h) / p.height);
+
+    m_index[sprite.key] = m_sprites.size();
+    m_sprites.push_back(sprite);
+}
+
+const AtlasSprite* AtlasManifest::Find(const char* source) const
+{
+    if (m_index.empty() || !source) {
+        return nullptr;
+    }
+    auto it = m_index.find(MakeKey(source));
+    return it != m_index.end() ? &m_sprites[it->second] : nullptr;
+}
+
+std::string AtlasManifest::NormalizePath(const char* path)
+{
+    std::string s = path ? path : "";
+    std::replace(s.begin(), s.end(), '\\', '/');
+    if (s.compare(0, 2, "./") == 0) {
+        s.erase(0, 2);
+    }
+    return s;
+}
+
+std::string AtlasManifest::MakeKey(const char* path)
+{
+    std::string s = NormalizePath(path);
+    for (char& c : s) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return s;
+}
@@ -0,0 +1,91 @@
+﻿/*****************************************************************//**
+ * @file   TextureAtlas.h
+ * @brief  テクスチャアトラスのパッキングとマニフェスト（プラットフォーム非依存）
+ *
+ * @details
+ * - MaxRectsPacker : MaxRects（Best Short Side Fit・回転なし）による矩形詰め
+ * - AtlasManifest  : 元画像パス → (アトラス番号, ピクセル矩形, UV矩形) の対応表
+ *   - 検索は大文字小文字を区別しない（Windows のパス比較に合わせる）。source は元の表記のまま
+ *     持つので、元画像を単体で読み直すときは大文字小文字を区別するファイルシステムでも開ける
+ * - アトラスの生成は tools/AtlasPacker、参照は各プラットフォームの LoadTexture が行う
+ *********************************************************************/
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../VectorTypes.h"
+
+struct AtlasRect
+{
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+class MaxRectsPacker
+{
+public:
+    void Init(int width, int height);
+
+    // 空き領域に w×h を配置できれば out に位置を返す
+    bool Insert(int w, int h, AtlasRect& out);
+
+    // 使用面積 / 全体面積
+    float GetOccupancy() const;
+
+private:
+    void SplitFreeRect(const AtlasRect& freeRect, const AtlasRect& used);
+    void PruneFreeRects();
+
+    int m_width = 0;
+    int m_height = 0;
+    long long m_usedArea = 0;
+    std::vector<AtlasRect> m_freeRects;
+    std::vector<AtlasRect> m_newRects;
+};
+
+struct AtlasPage
+{
+    std::string file; // アトラス画像のパス（実行ディレクトリ基準）
+    int width = 0;
+    int height = 0;
+};
+
+struct AtlasSprite
+{
+    std::string source; // 元画像のパス（区切り文字だけ正規化。大文字小文字は元のまま）
+    std::string key;    // 検索キー（source を小文字化したもの）
+    int page = 0;
+    AtlasRect rect;     // パディングを除いた画像本体の矩形
+    MyGame::Float2 uvPos;
+    MyGame::Float2 uvSize;
+};
+
+class AtlasManifest
+{
+public:
+    bool Load(const char* path);
+    bool Save(const char* path) const;
+
+    void Clear();
+    void AddPage(const AtlasPage& page) { m_pages.push_back(page); }
+    void AddSprite(const std::string& source, int page, const AtlasRect& rect);
+
+    // 元画像パスから検索（見つからなければ nullptr）
+    const AtlasSprite* Find(const char* source) const;
+
+    const std::vector<AtlasPage>& GetPages() const { return m_pages; }
+    const std::vector<AtlasSprite>& GetSprites() const { return m_sprites; }
+
+    // 区切り文字を '/' に揃え、先頭の "./" を除く（大文字小文字はそのまま）
+    static std::string NormalizePath(const char* path);
+
+    // NormalizePath したうえで小文字化した検索キー
+    static std::string MakeKey(const char* path);
+
+private:
+    std::vector<AtlasPage> m_pages;
+    std::vector<AtlasSprite> m_sprites;
+    std::unordered_map<std::string, size_t> m_index;
+};
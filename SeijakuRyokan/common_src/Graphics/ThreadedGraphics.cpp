@@ -0,0 +1,388 @@
+﻿/*****************************************************************//**
+ * @file   ThreadedGraphics.cpp
+ * @brief  描画を専用スレッドで行う IGraphics の実装
+ *********************************************************************/
+#include "ThreadedGraphics.h"
+#include "../System/FrameArena.h"
+#include "../System/MemoryTracker.h"
+#include "../System/Profiler.h"
+#include <algorithm>
+#include <chrono>
+
+ThreadedGraphics::ThreadedGraphics(IGraphics& backend)
+    : m_backend(backend)
+    , m_extensions(dynamic_cast<IGraphicsExtensions*>(&backend))
+{
+    std::fill(std::begin(m_layerModes), std::end(m_layerModes), LayerSortMode::Ordered);
+    std::fill(std::begin(m_backendModes), std::end(m_backendModes), LayerSortMode::Ordered);
+}
+
+ThreadedGraphics::~ThreadedGraphics()
+{
+    Finalize();
+    // Unload されなかったハンドル（バックエンドのテクスチャはバックエンドの Finalize に任せる）
+    for (Texture* texture : m_textures) {
+        delete texture;
+    }
+}
+
+bool ThreadedGraphics::Initialize(void* windowHandle, int screenWidth, int screenHeight)
+{
+    MemoryTagScope memoryTag(MemoryTag::Graphics);
+    // デバイス作成は呼び出し元のスレッドで行い、以降は描画スレッドだけがコンテキストを使う
+    if (!m_backend.Initialize(windowHandle, screenWidth, screenHeight)) {
+        return false;
+    }
+    m_quit = false;
+    m_running = true;
+    m_thread = std::thread(&ThreadedGraphics::RenderMain, this);
+    return true;
+}
+
+void ThreadedGraphics::Finalize()
+{
+    if (!m_running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_quit = true;
+    }
+    m_wakeCv.notify_one();
+    m_thread.join();
+    m_running = false;
+
+    // 描画スレッドはもう無いので、保留中のハンドルはすべて壊してよい
+    ReleaseUnloads(UINT64_MAX);
+    {
+        // 読まないまま終わった要求は失敗扱い
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        for (Texture* texture : m_loadRequests) {
+            texture->state.store(TextureLoadState::Failed, std::memory_order_release);
+        }
+        m_loadRequests.clear();
+    }
+    m_backend.Finalize();
+}
+
+void ThreadedGraphics::BeginDraw()
+{
+    // ゲーム側スレッドのアリーナ（描画スレッドのものはバックエンドの BeginDraw が回す）
+    FrameArena::ForThisThread().Reset();
+    m_recording = &m_lists.Back();
+    m_recording->frame = ++m_frame;
+    m_recording->commands.clear(); // 容量は残るので、慣れた後は確保が起きない
+    m_sdfMode = false;
+}
+
+void ThreadedGraphics::EndDraw()
+{
+    if (!m_recording) {
+        return;
+    }
+    if (m_overlay) {
+        m_overlay(*this);
+    }
+
+    // ゲーム側の FrameCounters は累計で渡す（RenderList が飛ばされても描画スレッドが差を取れば漏れない）
+    uint64_t counters[FrameCounters::COUNT];
+    FrameCounters::TakeCurrent(counters);
+    for (size_t i = 0; i < FrameCounters::COUNT; ++i) {
+        m_gameCounters[i] += counters[i];
+        m_recording->counters[i] = m_gameCounters[i];
+    }
+    m_recording = nullptr;
+    m_lists.Publish();
+    ++m_published;
+
+    // 受け渡しはロックフリー。ここのロックは眠っている描画スレッドを起こすためだけ
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wakeCv.notify_one();
+}
+
+TextureHandle ThreadedGraphics::LoadTexture(const char* filePath)
+{
+    return RequestLoad(filePath, false);
+}
+
+TextureHandle ThreadedGraphics::LoadTextureAsync(const char* filePath)
+{
+    return RequestLoad(filePath, true);
+}
+
+TextureHandle ThreadedGraphics::RequestLoad(const char* filePath, bool async)
+{
+    PROFILE_ZONE("ThreadedGraphics::LoadTexture");
+    MemoryTagScope memoryTag(MemoryTag::Graphics);
+    Texture* texture = new Texture();
+    texture->path = filePath ? filePath : "";
+    texture->async = async;
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_textures.insert(texture);
+        m_loadRequests.push_back(texture);
+    }
+
+    if (!m_running) {
+        // 描画スレッドが無いので、この場で読む
+        ServiceLoads();
+        UpdateLoadStates();
+        return texture;
+    }
+    m_wakeCv.notify_one();
+    return texture;
+}
+
+void ThreadedGraphics::UnloadTexture(TextureHandle handle)
+{
+    if (!handle) {
+        return;
+    }
+    Texture* texture = static_cast<Texture*>(handle);
+    if (!m_running) {
+        DestroyTexture(texture);
+        return;
+    }
+    // 記録中のフレーム（記録中でなければ最後に渡したフレーム）を描き終えるまで待たせる
+    std::lock_guard<std::mutex> lock(m_unloadMutex);
+    m_pendingUnloads.push_back({ m_frame, texture });
+    ++m_deferredUnloads;
+}
+
+TextureLoadState ThreadedGraphics::GetTextureState(TextureHandle handle) const
+{
+    if (!handle) {
+        return TextureLoadState::Failed;
+    }
+    return static_cast<const Texture*>(handle)->state.load(std::memory_order_acquire);
+}
+
+void ThreadedGraphics::WaitForTextures()
+{
+    if (!m_running) {
+        ServiceLoads();
+        if (m_extensions) {
+            m_extensions->WaitForTextures();
+        }
+        UpdateLoadStates();
+        return;
+    }
+    // 描画スレッドに積んである読み込みとバックエンドの非同期読み込みを済ませてもらう
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    const uint64_t ticket = ++m_waitRequests;
+    m_wakeCv.notify_one();
+    m_doneCv.wait(lock, [&] { return m_waitServed >= ticket; });
+}
+
+void ThreadedGraphics::DrawQuad(const Quad& quad)
+{
+    if (!m_recording) {
+        return;
+    }
+    DrawCommand cmd;
+    cmd.quad = quad;
+    cmd.sdf = m_sdfMode;
+    cmd.layer = m_layer;
+    cmd.mode = m_layerModes[m_layer];
+    m_recording->commands.push_back(cmd);
+}
+
+void ThreadedGraphics::Flush()
+{
+    if (!m_running) {
+        return;
+    }
+    // 最後に渡したフレームは m_frame（記録中なら 1 つ前）
+    const uint64_t last = m_recording ? m_frame - 1 : m_frame;
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_doneCv.wait(lock, [&] { return m_renderedFrame.load(std::memory_order_acquire) >= last; });
+}
+
+ThreadedGraphicsStats ThreadedGraphics::GetStats() const
+{
+    ThreadedGraphicsStats stats;
+    stats.published = m_published;
+    stats.rendered = m_renderedCount.load(std::memory_order_relaxed);
+    stats.submitMs = m_submitNanos.load(std::memory_order_relaxed) / 1.0e6;
+    stats.loads = m_loadCount.load(std::memory_order_relaxed);
+    stats.deferredUnloads = m_deferredUnloads;
+    return stats;
+}
+
+void ThreadedGraphics::RenderMain()
+{
+    PROFILE_THREAD_NAME("render");
+    // このスレッドの FrameCounters は次に描き終えた RenderList の分として確定する
+    FrameCounters::CaptureScope capture(m_renderCounters);
+    for (;;) {
+        uint64_t waitTicket = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wakeCv.wait(lock, [&] {
+                return m_quit || m_lists.HasFresh() || !m_loadRequests.empty() || m_waitServed != m_waitRequests;
+            });
+            if (m_quit && !m_lists.HasFresh()) {
+                break;
+            }
+            waitTicket = m_waitRequests;
+        }
+
+        // 読み込みはフレームの合間に済ませる（次の RenderList で使われるかもしれないので先に）
+        ServiceLoads();
+        if (waitTicket != m_waitServed) {
+            if (m_extensions) {
+                m_extensions->WaitForTextures();
+            }
+            UpdateLoadStates();
+            {
+                std::lock_guard<std::mutex> lock(m_wakeMutex);
+                m_waitServed = waitTicket;
+            }
+            m_doneCv.notify_all();
+        }
+
+        if (!m_lists.Acquire()) {
+            continue;
+        }
+        const RenderList& list = m_lists.Front();
+
+        const auto start = std::chrono::steady_clock::now();
+        Submit(list);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        m_submitNanos.fetch_add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), std::memory_order_relaxed);
+        m_renderedCount.fetch_add(1, std::memory_order_relaxed);
+
+        // バックエンドは BeginDraw で非同期読み込みを進めるので、描いた後に状態を拾う
+        UpdateLoadStates();
+        ReleaseUnloads(list.frame);
+
+        // このフレームの FrameCounters を確定（前に描いた RenderList からのゲーム側の増分 + 描画スレッドの値）
+        uint64_t counters[FrameCounters::COUNT];
+        for (size_t i = 0; i < FrameCounters::COUNT; ++i) {
+            counters[i] = list.counters[i] - m_committedCounters[i] + m_renderCounters[i];
+            m_committedCounters[i] = list.counters[i];
+            m_renderCounters[i] = 0;
+        }
+        FrameCounters::CommitFrame(list.frame, counters);
+
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_renderedFrame.store(list.frame, std::memory_order_release);
+        }
+        m_doneCv.notify_all();
+    }
+}
+
+void ThreadedGraphics::Submit(const RenderList& list)
+{
+    PROFILE_ZONE("ThreadedGraphics::Submit");
+    m_backend.BeginDraw();
+    bool sdf = false;
+    m_backend.SetSdfMode(false);
+    int layer = -1;
+    for (const DrawCommand& cmd : list.commands) {
+        if (m_extensions) {
+            // レイヤと並べ方は変わったところだけ流す（並べ方はレイヤごとにバックエンドが覚えている）
+            if (cmd.layer != layer) {
+                layer = cmd.layer;
+                m_extensions->SetDrawLayer(cmd.layer);
+            }
+            if (cmd.mode != m_backendModes[cmd.layer]) {
+                m_backendModes[cmd.layer] = cmd.mode;
+                m_extensions->SetLayerSortMode(cmd.layer, cmd.mode);
+            }
+        }
+        if (cmd.sdf != sdf) {
+            sdf = cmd.sdf;
+            m_backend.SetSdfMode(sdf);
+        }
+        // 読み終わっていない・読めなかったハンドルは nullptr（白テクスチャ）で描く
+        Quad quad = cmd.quad;
+        quad.texture = quad.texture ? static_cast<Texture*>(quad.texture)->backend : nullptr;
+        m_backend.DrawQuad(quad);
+    }
+    if (sdf) {
+        m_backend.SetSdfMode(false);
+    }
+    m_backend.EndDraw();
+}
+
+void ThreadedGraphics::ServiceLoads()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        if (m_loadRequests.empty()) {
+            return;
+        }
+        m_loading.swap(m_loadRequests);
+    }
+    for (Texture* texture : m_loading) {
+        if (texture->async && m_extensions) {
+            texture->backend = m_extensions->LoadTextureAsync(texture->path.c_str());
+            m_pendingAsync.push_back(texture);
+        }
+        else {
+            texture->backend = m_backend.LoadTexture(texture->path.c_str());
+            texture->state.store(texture->backend ? TextureLoadState::Ready : TextureLoadState::Failed,
+                std::memory_order_release);
+        }
+    }
+    m_loadCount.fetch_add(m_loading.size(), std::memory_order_relaxed);
+    m_loading.clear();
+}
+
+void ThreadedGraphics::UpdateLoadStates()
+{
+    size_t keep = 0;
+    for (Texture* texture : m_pendingAsync) {
+        const TextureLoadState state = m_extensions->GetTextureState(texture->backend);
+        texture->state.store(state, std::memory_order_release);
+        if (state == TextureLoadState::Pending || state == TextureLoadState::Decoded) {
+            m_pendingAsync[keep++] = texture;
+        }
+    }
+    m_pendingAsync.resize(keep);
+}
+
+void ThreadedGraphics::ReleaseUnloads(uint64_t renderedFrame)
+{
+    std::vector<Texture*> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_unloadMutex);
+        if (m_pendingUnloads.empty()) {
+            return;
+        }
+        // 描き終えたフレーム以前に登録されたものだけ壊す（それより古い RenderList はもう描かれない）
+        size_t keep = 0;
+        for (const PendingUnload& u : m_pendingUnloads) {
+            if (u.frame <= renderedFrame) {
+                ready.push_back(u.texture);
+            }
+            else {
+                m_pendingUnloads[keep++] = u;
+            }
+        }
+        m_pendingUnloads.resize(keep);
+    }
+    for (Texture* texture : ready) {
+        DestroyTexture(texture);
+    }
+}
+
+void ThreadedGraphics::DestroyTexture(Texture* texture)
+{
+    {
+        // まだ読んでいなければ要求ごと取り下げる
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_loadRequests.erase(std::remove(m_loadRequests.begin(), m_loadRequests.end(), texture), m_loadRequests.end());
+        m_textures.erase(texture);
+    }
+    m_pendingAsync.erase(std::remove(m_pendingAsync.begin(), m_pendingAsync.end(), texture), m_pendingAsync.end());
+    if (texture->backend) {
+        m_backend.UnloadTexture(texture->backend);
+    }
+    delete texture;
+}
@@ -0,0 +1,171 @@
+﻿/*****************************************************************//**
+ * @file   ThreadedGraphics.h
+ * @brief  描画を専用スレッドで行う IGraphics（バックエンドを包む）
+ *
+ * @details
+ * - ゲーム側（シミュレーションスレッド）の BeginDraw〜EndDraw は RenderList に記録するだけ。
+ *   EndDraw で TripleBuffer に渡し、描画スレッドが本物のバックエンドに流して Present する
+ * - これでフレーム N の描画・Present と、フレーム N+1 の Update が並行して進む
+ * - 描画スレッドが追いつかない場合は古い RenderList を飛ばし、最新の 1 枚だけ描く
+ * - IGraphicsExtensions も実装する
+ *   - SetDrawLayer / SetLayerSortMode は DrawCommand ごとに記録し、描画スレッドが
+ *     変わったところだけバックエンドに流し直す
+ *   - バックエンドが IGraphicsExtensions でなければレイヤは無視し、
+ *     LoadTextureAsync は描画スレッドでの LoadTexture になる
+ *
+ * - TextureHandle の扱い
+ *   - ゲーム側に返すのは ThreadedGraphics のハンドル（中身は描画スレッドが読んだバックエンドの
+ *     ハンドル）。DrawQuad にはここで得たハンドルだけを渡す
+ *   - LoadTexture / LoadTextureAsync はどちらも待たない。要求を積んで描画スレッドを起こし、
+ *     描画スレッドがフレームの合間（次の RenderList を流す前）にバックエンドで読む。
+ *     ゲーム側がバックエンドの描画や Present の終わりを待つことはない
+ *   - 読み終わるまで、また読めなかったハンドルは白テクスチャで描かれる。
+ *     成否は GetTextureState で見る（Pending → Ready / Failed）。待つなら WaitForTextures
+ *   - UnloadTexture は即座には壊さない。呼んだ時点までに記録された RenderList を描画スレッドが
+ *     描き終えてから（または Finalize で）バックエンドの UnloadTexture を呼ぶ。
+ *     呼んだ後にそのハンドルを DrawQuad に渡してはいけない
+ *   - Initialize 前・Finalize 後は呼んだスレッドでそのままバックエンドを呼ぶ
+ *
+ * - FrameCounters
+ *   - EndDraw でゲーム側の値の累計を RenderList に載せ、描画スレッドがその RenderList を描き終えたところで
+ *     前に描いた RenderList との差と描画側の値を合わせて確定する（飛ばされた RenderList の
+ *     ゲーム側の値は次に描いたフレームに入る）。ゲームループは FrameCounters::EndFrame を呼ばない
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "../IGraphics.h"
+#include "../System/FrameCounters.h"
+#include "../System/MemoryTracker.h"
+#include "DrawCommandBuffer.h"
+#include "GraphicsExtensions.h"
+#include "TripleBuffer.h"
+
+// 1 フレーム分の描画命令（記録後は描画スレッドが読むだけ）
+struct RenderList
+{
+    uint64_t frame = 0; // 1 から始まる通し番号
+    std::vector<DrawCommand, TaggedAllocator<DrawCommand, MemoryTag::Graphics>> commands;
+    uint64_t counters[FrameCounters::COUNT] = {}; // このフレームまでのゲーム側の FrameCounters の累計
+};
+
+struct ThreadedGraphicsStats
+{
+    uint64_t published = 0; // EndDraw で渡した RenderList の数
+    uint64_t rendered = 0;  // 描画スレッドが描いた数（差は飛ばされた数）
+    uint64_t deferredUnloads = 0;
+    uint64_t loads = 0;     // 描画スレッドで読んだテクスチャの数
+    double submitMs = 0.0;  // 描画スレッドがバックエンドに流した時間の合計（Present 込み）
+};
+
+class ThreadedGraphics : public IGraphics, public IGraphicsExtensions
+{
+public:
+    explicit ThreadedGraphics(IGraphics& backend);
+    ~ThreadedGraphics() override;
+
+    ThreadedGraphics(const ThreadedGraphics&) = delete;
+    ThreadedGraphics& operator=(const ThreadedGraphics&) = delete;
+
+    // IGraphicsインターフェースの実装
+    bool Initialize(void* windowHandle, int screenWidth, int screenHeight) override; // 描画スレッドを起動する
+    void Finalize() override; // 描画スレッドを止め、保留中の Unload を済ませてから後始末
+    void BeginDraw() override;
+    void EndDraw() override;
+    TextureHandle LoadTexture(const char* filePath) override;
+    void UnloadTexture(TextureHandle handle) override;
+    void DrawQuad(const Quad& quad) override;
+    void SetSdfMode(bool enable) override { m_sdfMode = enable; }
+
+    // IGraphicsExtensionsの実装
+    void SetDrawLayer(uint8_t layer) override { m_layer = layer; }
+    void SetLayerSortMode(uint8_t layer, LayerSortMode mode) override { m_layerModes[layer] = mode; }
+    TextureHandle LoadTextureAsync(const char* filePath) override;
+    TextureLoadState GetTextureState(TextureHandle handle) const override;
+    void WaitForTextures() override; // 積んである読み込みも含めて終わるまで待つ
+
+    // EndDraw の直前（ゲーム側スレッド）に呼ばれ、そのフレームの最後に描き足す。
+    // Game の外から最前面に重ねるもの（デバッグ HUD など）に使う
+    void SetOverlay(std::function<void(IGraphics&)> overlay) { m_overlay = std::move(overlay); }
+
+    // 渡した RenderList がすべて描き終わるまで待つ（スクリーンショット・テストなど）
+    void Flush();
+
+    // 描画スレッドが最後に描いたフレーム番号
+    uint64_t GetRenderedFrame() const { return m_renderedFrame.load(std::memory_order_acquire); }
+
+    // ゲーム側スレッドから読む。rendered・loads・submitMs は描画スレッドが更新中の値
+    ThreadedGraphicsStats GetStats() const;
+
+private:
+    // ゲーム側に返すハンドルの実体
+    struct Texture
+    {
+        std::string path;
+        bool async = false;
+        TextureHandle backend = nullptr; // 描画スレッドが読んでから入れる（描画スレッドだけが触る）
+        std::atomic<TextureLoadState> state{ TextureLoadState::Pending };
+    };
+
+    struct PendingUnload
+    {
+        uint64_t frame; // この番号以降の RenderList を描き終えたら壊してよい
+        Texture* texture;
+    };
+
+    TextureHandle RequestLoad(const char* filePath, bool async);
+    void RenderMain();
+    void Submit(const RenderList& list);
+    void ServiceLoads();
+    void UpdateLoadStates();
+    void ReleaseUnloads(uint64_t renderedFrame);
+    void DestroyTexture(Texture* texture);
+
+    IGraphics& m_backend;
+    IGraphicsExtensions* m_extensions = nullptr; // バックエンドが実装していれば
+
+    // --- ゲーム側スレッド ---
+    TripleBuffer<RenderList> m_lists;
+    RenderList* m_recording = nullptr; // BeginDraw〜EndDraw の間だけ有効
+    uint64_t m_frame = 0;              // 最後に BeginDraw したフレーム番号
+    uint64_t m_published = 0;
+    bool m_sdfMode = false;
+    uint8_t m_layer = 0;
+    LayerSortMode m_layerModes[DrawCommandBuffer::LAYER_COUNT];
+    uint64_t m_gameCounters[FrameCounters::COUNT] = {}; // ゲーム側の FrameCounters の累計
+    std::function<void(IGraphics&)> m_overlay;
+
+    // --- 描画スレッド ---
+    std::thread m_thread;
+    bool m_running = false;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCv; // 新しい RenderList / 読み込み要求 / 待ち要求 / 終了要求
+    std::condition_variable m_doneCv; // 1 フレーム描き終えた / 待ち要求を済ませた
+    bool m_quit = false;
+    std::atomic<uint64_t> m_renderedFrame{ 0 };
+    std::atomic<uint64_t> m_renderedCount{ 0 };
+    std::atomic<uint64_t> m_submitNanos{ 0 };
+    std::atomic<uint64_t> m_loadCount{ 0 };
+    LayerSortMode m_backendModes[DrawCommandBuffer::LAYER_COUNT]; // バックエンドに設定済みの並べ方
+    uint64_t m_renderCounters[FrameCounters::COUNT] = {};         // 描画スレッドの FrameCounters
+    uint64_t m_committedCounters[FrameCounters::COUNT] = {};      // 最後に描いた RenderList の counters
+    std::vector<Texture*> m_loading;       // ServiceLoads 用の作業領域
+    std::vector<Texture*> m_pendingAsync;  // バックエンドで非同期読み込み中
+
+    // --- 読み込み要求（m_wakeMutex で守る） ---
+    std::vector<Texture*> m_loadRequests;
+    std::unordered_set<Texture*> m_textures; // 作ったハンドルすべて（残りはデストラクタで消す）
+    uint64_t m_waitRequests = 0; // WaitForTextures の呼び出し数
+    uint64_t m_waitServed = 0;   // 描画スレッドが済ませた数
+
+    std::mutex m_unloadMutex;
+    std::vector<PendingUnload> m_pendingUnloads;
+    uint64_t m_deferredUnloads = 0;
+};
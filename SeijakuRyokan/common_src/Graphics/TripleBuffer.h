@@ -0,0 +1,62 @@
+﻿/*****************************************************************//**
+ * @file   TripleBuffer.h
+ * @brief  1 対 1 スレッド間のロックフリー三重バッファ
+ *
+ * @details
+ * - 書き手は Back() に書いて Publish()、読み手は Acquire() で最新版を Front() に受け取る
+ * - 3 つのスロットを「書き手用・受け渡し用・読み手用」で回すので、どちらも相手を待たない
+ * - 読み手が間に合わなかった版は上書きされ、読み手は常に最新の版だけを見る
+ * - 受け渡し用スロットの番号と「未読」フラグを 1 つの atomic に持ち、exchange だけで入れ替える
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // --- 書き手スレッド専用 ---
+    T& Back() { return m_slots[m_back]; }
+
+    // Back() を読み手に渡し、受け渡し用だったスロットを次の Back() にする
+    void Publish()
+    {
+        const uint8_t prev = m_middle.exchange(static_cast<uint8_t>(m_back | FRESH), std::memory_order_acq_rel);
+        m_back = prev & INDEX_MASK;
+    }
+
+    // --- 読み手スレッド専用 ---
+    // 未読の版があれば Front() と入れ替えて true を返す
+    bool Acquire()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+            return false;
+        }
+        const uint8_t prev = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = prev & INDEX_MASK;
+        return true;
+    }
+
+    const T& Front() const { return m_slots[m_front]; }
+    T& Front() { return m_slots[m_front]; }
+
+    // どちらのスレッドからでも呼べる（目安。直後に変わり得る）
+    bool HasFresh() const { return (m_middle.load(std::memory_order_relaxed) & FRESH) != 0; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    T m_slots[3];
+
+    // 書き手・読み手・共有の変数は別々のキャッシュラインに置く
+    alignas(64) uint8_t m_back = 0;
+    alignas(64) uint8_t m_front = 2;
+    alignas(64) std::atomic<uint8_t> m_middle{ 1 };
+};
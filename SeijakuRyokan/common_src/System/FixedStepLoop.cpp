@@ -0,0 +1,96 @@
+﻿/*****************************************************************//**
+ * @file   FixedStepLoop.cpp
+ * @brief  上限付きの固定タイムステップ実装
+ *********************************************************************/
+#include "FixedStepLoop.h"
+#include <algorithm>
+
+namespace
+{
+    double g_interpolationAlpha = 1.0;
+}
+
+double GetInterpolationAlpha()
+{
+    return g_interpolationAlpha;
+}
+
+FixedStepLoop::FixedStepLoop(const FixedStepConfig& config)
+{
+    SetConfig(config);
+}
+
+void FixedStepLoop::SetConfig(const FixedStepConfig& config)
+{
+    m_config = config;
+    if (m_config.stepSeconds <= 0.0) {
+        m_config.stepSeconds = 1.0 / 60.0;
+    }
+    m_config.maxSubsteps = (std::max)(m_config.maxSubsteps, 1);
+    m_config.maxBacklogSteps = (std::max)(m_config.maxBacklogSteps, m_config.maxSubsteps);
+    if (m_config.maxFrameSeconds <= 0.0) {
+        m_config.maxFrameSeconds = m_config.stepSeconds * m_config.maxSubsteps;
+    }
+}
+
+void FixedStepLoop::Reset()
+{
+    m_accumulator = 0.0;
+}
+
+FixedStepFrame FixedStepLoop::Begin(double elapsedSeconds)
+{
+    const double step = m_config.stepSeconds;
+    FixedStepFrame frame;
+
+    // 時計が戻った・止まっていた（デバッガ）ときの値をそのまま使わない
+    double elapsed = (std::max)(elapsedSeconds, 0.0);
+    if (elapsed > m_config.maxFrameSeconds) {
+        m_stats.droppedSeconds += elapsed - m_config.maxFrameSeconds;
+        elapsed = m_config.maxFrameSeconds;
+        frame.clamped = true;
+    }
+    m_accumulator += elapsed;
+
+    // 割り算で回数を出す（0.1 秒溜まっていても 1 ステップずつ引かない）
+    const double available = m_accumulator / step;
+    int steps = static_cast<int>(available);
+    if (steps > m_config.maxSubsteps) {
+        steps = m_config.maxSubsteps;
+        frame.clamped = true;
+    }
+    m_accumulator -= steps * step;
+
+    if (frame.clamped && m_accumulator >= step) {
+        if (m_config.dilateOnOverload) {
+            // 端数だけ残し、追いつけなかった分は捨てる
+            const double excess = step * static_cast<int>(m_accumulator / step);
+            m_stats.droppedSeconds += excess;
+            m_accumulator -= excess;
+        }
+        else {
+            const double backlog = m_config.maxBacklogSteps * step;
+            if (m_accumulator > backlog) {
+                m_stats.droppedSeconds += m_accumulator - backlog;
+                m_accumulator = backlog;
+            }
+        }
+    }
+
+    frame.substeps = steps;
+    frame.alpha = (std::min)(m_accumulator / step, 1.0);
+    if (m_accumulator >= step) {
+        // 持ち越し中は補間しても意味が無いので最新の状態を描く
+        frame.alpha = 1.0;
+    }
+
+    g_interpolationAlpha = frame.alpha;
+
+    ++m_stats.frames;
+    m_stats.steps += static_cast<uint64_t>(steps);
+    m_stats.maxSubstepsSeen = (std::max)(m_stats.maxSubstepsSeen, steps);
+    if (frame.clamped) {
+        ++m_stats.clampedFrames;
+    }
+    return frame;
+}
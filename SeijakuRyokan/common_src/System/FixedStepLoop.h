@@ -0,0 +1,81 @@
+﻿/*****************************************************************//**
+ * @file   FixedStepLoop.h
+ * @brief  上限付きの固定タイムステップ（描画補間の alpha 付き）
+ *
+ * @details
+ * - 経過時間を溜め、固定の 1 ステップ（既定 1/60 秒）ごとに Update を回す
+ * - 1 フレームで回す Update の数は maxSubsteps まで。ヒッチ（テクスチャ読み込み・
+ *   ウィンドウのドラッグなど）の後に追いつこうとして更に遅れる悪循環を防ぐ
+ * - 上限に達したときの残りは
+ *   - dilateOnOverload = true  : 捨てる（その分ゲーム内時間がゆっくり進む）
+ *   - dilateOnOverload = false : maxBacklogSteps まで持ち越し、次のフレーム以降で追いつく
+ * - 端数（次の Update までの割合）を alpha として返すので、描画側は
+ *   前回と今回の状態を alpha で補間すれば表示レートに関係なく滑らかになる。
+ *   Game::Draw() は引数を取らないので、描画側は GetInterpolationAlpha() で読む
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+
+struct FixedStepConfig
+{
+    double stepSeconds = 1.0 / 60.0;
+    int maxSubsteps = 5;              // 1 フレームで回す Update の上限
+    double maxFrameSeconds = 0.25;    // 1 フレームの経過時間はここで頭打ち（デバッガ停止など）
+    bool dilateOnOverload = true;     // 上限に達した分を捨てる（スローモーションになる）
+    int maxBacklogSteps = 10;         // dilateOnOverload = false のときに持ち越せる上限
+};
+
+// Advance 1 回分の結果
+struct FixedStepFrame
+{
+    int substeps = 0;     // このフレームで回した Update の数
+    double alpha = 0.0;   // 描画補間の割合 [0, 1]（持ち越し中は 1）
+    bool clamped = false; // maxSubsteps / maxFrameSeconds に当たった
+};
+
+struct FixedStepStats
+{
+    uint64_t frames = 0;
+    uint64_t steps = 0;
+    uint64_t clampedFrames = 0;
+    int maxSubstepsSeen = 0;
+    double droppedSeconds = 0.0; // 捨てた（ゲーム内で進まなかった）実時間
+};
+
+class FixedStepLoop
+{
+public:
+    explicit FixedStepLoop(const FixedStepConfig& config = FixedStepConfig());
+
+    void SetConfig(const FixedStepConfig& config);
+    const FixedStepConfig& GetConfig() const { return m_config; }
+
+    // 溜まった時間を捨てる（ロード明けなど）
+    void Reset();
+
+    // 経過時間を足し、回すべき回数だけ update(stepSeconds) を呼ぶ
+    template <typename UpdateFn>
+    FixedStepFrame Advance(double elapsedSeconds, UpdateFn&& update)
+    {
+        FixedStepFrame frame = Begin(elapsedSeconds);
+        for (int i = 0; i < frame.substeps; ++i) {
+            update(m_config.stepSeconds);
+        }
+        return frame;
+    }
+
+    // Advance の Update を呼ばない版（回数だけ決めて呼び出し側で回す）
+    FixedStepFrame Begin(double elapsedSeconds);
+
+    const FixedStepStats& GetStats() const { return m_stats; }
+    void ResetStats() { m_stats = FixedStepStats(); }
+
+private:
+    FixedStepConfig m_config;
+    double m_accumulator = 0.0;
+    FixedStepStats m_stats;
+};
+
+// 最後に Advance / Begin した FixedStepLoop の alpha（一度も回していなければ 1 = 最新の状態をそのまま描く）。
+// ゲームループと同じスレッドから読む
+double GetInterpolationAlpha();
@@ -0,0 +1,525 @@
+﻿/*****************************************************************//**
+ * @file   FlowField.cpp
+ * @brief  流れ場の構築とキャッシュの実装
+ *********************************************************************/
+#include "FlowField.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+namespace
+{
+    // 辺のコストは 10 / 14 しかないので、距離 % 15 のバケットを回す（Dial 法）
+    constexpr int BUCKET_COUNT = NavGrid::DIAGONAL_COST + 1;
+
+    struct BuildScratch
+    {
+        std::vector<int> distance;
+        std::vector<int> buckets[BUCKET_COUNT];
+    };
+
+    BuildScratch& GetScratch()
+    {
+        thread_local BuildScratch scratch;
+        return scratch;
+    }
+
+    struct HeapEntry
+    {
+        int distance;
+        int index;
+
+        bool operator<(const HeapEntry& other) const { return distance > other.distance; } // 小さい距離を先に出す
+    };
+
+    // 解き直すセルが全体のこれだけを超えるなら、作り直した方が速い
+    size_t GetAffectedLimit(int cellCount)
+    {
+        return (std::max)(static_cast<size_t>(cellCount) / 4, static_cast<size_t>(64));
+    }
+
+    double ElapsedMicros(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+// ApplyEdit の作業領域（世代番号で初期化を省く）
+struct FlowField::EditScratch
+{
+    uint32_t generation = 0;
+    std::vector<uint32_t> oldStamp; // generation と同じなら oldDistance が求めてある
+    std::vector<int> oldDistance;   // 書き換え前の距離（向きをたどって求める）
+    std::vector<uint32_t> newStamp; // generation と同じなら距離が変わるセル
+    std::vector<int> newDistance;
+    std::vector<int> affected;
+    std::vector<int> chain;
+    std::vector<HeapEntry> heap;
+    std::vector<uint8_t> directions;
+};
+
+FlowField::EditScratch& FlowField::GetEditScratch()
+{
+    thread_local EditScratch scratch;
+    return scratch;
+}
+
+FlowField::EditScratch& FlowField::BeginEdit(int cellCount)
+{
+    EditScratch& scratch = GetEditScratch();
+    if (scratch.oldStamp.size() != static_cast<size_t>(cellCount) || ++scratch.generation == 0) {
+        scratch.oldStamp.assign(cellCount, 0);
+        scratch.newStamp.assign(cellCount, 0);
+        scratch.oldDistance.resize(cellCount);
+        scratch.newDistance.resize(cellCount);
+        scratch.generation = 1;
+    }
+    scratch.affected.clear();
+    return scratch;
+}
+
+void FlowField::Build(const NavGrid& grid, const GridPoint* goals, size_t goalCount)
+{
+    m_width = grid.GetWidth();
+    m_height = grid.GetHeight();
+    m_revision = grid.GetRevision();
+    if (goals != m_goals.data()) {
+        m_goals.assign(goals, goals + goalCount);
+    }
+    const int cellCount = grid.GetCellCount();
+    m_directions.assign(cellCount, UNREACHABLE);
+
+    BuildScratch& scratch = GetScratch();
+    std::vector<int>& distance = scratch.distance;
+    distance.assign(cellCount, INT_MAX);
+    for (std::vector<int>& bucket : scratch.buckets) {
+        bucket.clear();
+    }
+
+    size_t pending = 0;
+    for (size_t i = 0; i < goalCount; ++i) {
+        if (!grid.IsWalkable(goals[i])) {
+            continue;
+        }
+        const int index = grid.ToIndex(goals[i]);
+        if (distance[index] != 0) {
+            distance[index] = 0;
+            m_directions[index] = GOAL;
+            scratch.buckets[0].push_back(index);
+            ++pending;
+        }
+    }
+
+    // 逆向きの Dijkstra（距離だけ求める）
+    for (int d = 0; pending > 0; ++d) {
+        std::vector<int>& bucket = scratch.buckets[d % BUCKET_COUNT];
+        // 処理中に同じバケットへ積まれることはない（辺のコスト >= 10）
+        for (size_t k = 0; k < bucket.size(); ++k) {
+            const int index = bucket[k];
+            --pending;
+            if (distance[index] != d) {
+                continue; // もっと短い距離で処理済み
+            }
+            const GridPoint p = grid.ToPoint(index);
+            for (int dir = 0; dir < NavGrid::DIRECTION_COUNT; ++dir) {
+                if (!grid.CanStep(p.x, p.y, dir)) {
+                    continue;
+                }
+                const int ni = grid.ToIndex(p.x + NavGrid::DX[dir], p.y + NavGrid::DY[dir]);
+                const int nd = d + NavGrid::StepCost(dir);
+                if (nd < distance[ni]) {
+                    distance[ni] = nd;
+                    scratch.buckets[nd % BUCKET_COUNT].push_back(ni);
+                    ++pending;
+                }
+            }
+        }
+        bucket.clear();
+    }
+
+    // 各セルで距離が最も縮む一歩を向きとして残す
+    for (int index = 0; index < cellCount; ++index) {
+        const int d = distance[index];
+        if (d == INT_MAX || d == 0) {
+            continue;
+        }
+        const GridPoint p = grid.ToPoint(index);
+        int best = INT_MAX;
+        for (int dir = 0; dir < NavGrid::DIRECTION_COUNT; ++dir) {
+            if (!grid.CanStep(p.x, p.y, dir)) {
+                continue;
+            }
+            const int nd = distance[grid.ToIndex(p.x + NavGrid::DX[dir], p.y + NavGrid::DY[dir])];
+            if (nd != INT_MAX && nd + NavGrid::StepCost(dir) < best) {
+                best = nd + NavGrid::StepCost(dir);
+                m_directions[index] = static_cast<uint8_t>(dir);
+            }
+        }
+    }
+}
+
+void FlowField::Rebuild(const NavGrid& grid)
+{
+    Build(grid, m_goals.data(), m_goals.size());
+}
+
+bool FlowField::ApplyEdit(const NavGrid& grid, int x, int y, int width, int height)
+{
+    if (!IsBuilt() || grid.GetWidth() != m_width || grid.GetHeight() != m_height) {
+        return false;
+    }
+    const int rx0 = (std::max)(x, 0);
+    const int ry0 = (std::max)(y, 0);
+    const int rx1 = (std::min)(x + width, m_width);
+    const int ry1 = (std::min)(y + height, m_height);
+    for (const GridPoint& goal : m_goals) {
+        if (goal.x >= rx0 && goal.x < rx1 && goal.y >= ry0 && goal.y < ry1) {
+            return false; // 行き先そのものが変わった
+        }
+    }
+    int walls = 0;
+    for (int py = ry0; py < ry1; ++py) {
+        for (int px = rx0; px < rx1; ++px) {
+            walls += grid.IsWalkable(px, py) ? 0 : 1;
+        }
+    }
+    if (walls != 0 && walls != (rx1 - rx0) * (ry1 - ry0)) {
+        return false; // 通れる・通れないが混ざった書き換えは扱わない
+    }
+
+    // 通れるかが変わる一歩は、両端とも矩形と周り 1 マス（以下「周辺」）の中にある
+    EditRegion region;
+    region.x0 = (std::max)(x - 1, 0);
+    region.y0 = (std::max)(y - 1, 0);
+    region.x1 = (std::min)(x + width + 1, m_width);
+    region.y1 = (std::min)(y + height + 1, m_height);
+    bool touched = false;
+    for (int py = region.y0; py < region.y1 && !touched; ++py) {
+        for (int px = region.x0; px < region.x1 && !touched; ++px) {
+            touched = m_directions[static_cast<size_t>(py) * m_width + px] != UNREACHABLE;
+        }
+    }
+    // 周辺に行き先へつながるセルが無ければ、矩形がどう変わっても行き先へはつながらない
+    if (touched && !(walls > 0 ? RepairBlocked(grid, region) : RepairOpened(grid, region))) {
+        return false;
+    }
+    m_revision = grid.GetRevision();
+    return true;
+}
+
+int FlowField::GetOldDistance(int index) const
+{
+    EditScratch& scratch = GetEditScratch();
+    std::vector<int>& chain = scratch.chain;
+    chain.clear();
+    int distance = INT_MAX;
+    for (int i = index;;) {
+        if (scratch.oldStamp[i] == scratch.generation) {
+            distance = scratch.oldDistance[i];
+            break;
+        }
+        const uint8_t d = m_directions[i];
+        if (d == GOAL) {
+            distance = 0;
+            break;
+        }
+        if (d == UNREACHABLE || chain.size() >= m_directions.size()) {
+            break;
+        }
+        chain.push_back(i);
+        i += NavGrid::DY[d] * m_width + NavGrid::DX[d];
+    }
+    // たどった道の距離も覚えておく（隣のセルはたいてい同じ道に合流する）
+    for (size_t k = chain.size(); k-- > 0;) {
+        if (distance != INT_MAX) {
+            distance += NavGrid::StepCost(m_directions[chain[k]]);
+        }
+        scratch.oldStamp[chain[k]] = scratch.generation;
+        scratch.oldDistance[chain[k]] = distance;
+    }
+    return chain.empty() ? distance : scratch.oldDistance[index];
+}
+
+bool FlowField::RepairBlocked(const NavGrid& grid, const EditRegion& region)
+{
+    EditScratch& scratch = BeginEdit(grid.GetCellCount());
+    std::vector<int>& affected = scratch.affected;
+    const size_t limit = GetAffectedLimit(grid.GetCellCount());
+    const auto inAffected = [&scratch](int index) { return scratch.newStamp[index] == scratch.generation; };
+    const auto addAffected = [&](int index) {
+        scratch.newStamp[index] = scratch.generation;
+        scratch.newDistance[index] = INT_MAX;
+        affected.push_back(index);
+    };
+
+    // 通れなくなった一歩を向きに持つセル・壁になったセルから、向きを逆にたどって
+    // 最短経路がそこを通っていたセルを集める。それ以外のセルの距離は変わらない（減ることもない）
+    for (int py = region.y0; py < region.y1; ++py) {
+        for (int px = region.x0; px < region.x1; ++px) {
+            const int index = grid.ToIndex(px, py);
+            const uint8_t d = m_directions[index];
+            if (d == UNREACHABLE || d == GOAL) {
+                continue;
+            }
+            if (!grid.IsWalkable(px, py) || !grid.CanStep(px, py, d)) {
+                addAffected(index);
+            }
+        }
+    }
+    for (size_t k = 0; k < affected.size(); ++k) {
+        const GridPoint p = grid.ToPoint(affected[k]);
+        for (int dir = 0; dir < NavGrid::DIRECTION_COUNT; ++dir) {
+            const int nx = p.x + NavGrid::DX[dir];
+            const int ny = p.y + NavGrid::DY[dir];
+            if (!grid.InBounds(nx, ny)) {
+                continue;
+            }
+            const int ni = grid.ToIndex(nx, ny);
+            const uint8_t nd = m_directions[ni];
+            if (nd < NavGrid::DIRECTION_COUNT && nx + NavGrid::DX[nd] == p.x && ny + NavGrid::DY[nd] == p.y && !inAffected(ni)) {
+                if (affected.size() >= limit) {
+                    return false;
+                }
+                addAffected(ni);
+            }
+        }
+    }
+
+    // 集めたセルの中だけ、外側の元の距離から Dijkstra で解き直す
+    std::vector<HeapEntry>& heap = scratch.heap;
+    heap.clear();
+    for (const int index : affected) {
+        const GridPoint p = grid.ToPoint(index);
+        if (!grid.IsWalkable(p)) {
+            continue;
+        }
+        int best = INT_MAX;
+        for (int dir = 0; dir < NavGrid::DIRECTION_COUNT; ++dir) {
+            if (!grid.CanStep(p.x, p.y, dir)) {
+                continue;
+            }
+            const int ni = grid.ToIndex(p.x + NavGrid::DX[dir], p.y + NavGrid::DY[dir]);
+            if (inAffected(ni)) {
+                continue;
+            }
+            const int od = GetOldDistance(ni);
+            if (od != INT_MAX) {
+                best = (std::min)(best, od + NavGrid::StepCost(dir));
+            }
+        }
+        if (best != INT_MAX) {
+            scratch.newDistance[index] = best;
+            heap.push_back(HeapEntry{ best, index });
+        }
+    }
+    std::make_heap(heap.begin(), heap.end());
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end());
+        const HeapEntry top = heap.back();
+        heap.pop_back();
+        if (top.distance != scratch.newDistance[top.index]) {
+            continue;
+        }
+        const GridPoint p = grid.ToPoint(top.index);
+        for (int dir = 0; dir < NavGrid::DIRECTION_COUNT; ++dir) {
+            if (!grid.CanStep(p.x, p.y, dir)) {
+                continue;
+            }
+            const int ni = grid.ToIndex(p.x + NavGrid::DX[dir], p.y + NavGrid::DY[dir]);
+            const int nd = top.distance + NavGrid::StepCost(dir);
+            if (inAffected(ni) && nd < scratch.newDistance[ni]) {
+                scratch.newDistance[ni] = nd;
+                heap.push_back(HeapEntry{ nd, ni });
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+    }
+    AssignDirections(grid, affected);
+    return true;
+}
+
+bool FlowField::RepairOpened(const NavGrid& grid, const EditRegion& region)
+{
+    EditScratch& scratch = BeginEdit(grid.GetCellCount());
+    std::vector<int>& changed = scratch.affected;
+    const size_t limit = GetAffectedLimit(grid.GetCellCount());
+    const auto current = [&](int index) {
+        return scratch.newStamp[index] == scratch.generation ? scratch.newDistance[index] : GetOldDistance(index);
+    };
+
+    // 距離は縮むだけ。周辺のセルを今の距離で積み、縮んだセルから先へ Dijkstra で広げる
+    // （新しく通れる一歩は両端とも周辺にあるので、周辺から始めれば全部使われる）
+    std::vector<HeapEntry>& heap = scratch.heap;
+    heap.clear();
+    for (int py = region.y0; py < region.y1; ++py) {
+        for (int px = region.x0; px < region.x1; ++px) {
+            const int index = grid.ToIndex(px, py);
+            const int d = grid.IsWalkable(px, py) ? GetOldDistance(index) : INT_MAX;
+            if (d != INT_MAX) {
+                heap.push_back(HeapEntry{ d, index });
+            }
+        }
+    }
+    std::make_heap(heap.begin(), heap.end());
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end());
+        const HeapEntry top = heap.back();
+        heap.pop_back();
+        if (top.distance != current(top.index)) {
+            continue;
+        }
+        const GridPoint p = grid.ToPoint(top.index);
+        for (int dir = 0; dir < NavGrid::DIRECTION_COUNT; ++dir) {
+            if (!grid.CanStep(p.x, p.y, dir)) {
+                continue;
+            }
+            const int ni = grid.ToIndex(p.x + NavGrid::DX[dir], p.y + NavGrid::DY[dir]);
+            const int nd = top.distance + NavGrid::StepCost(dir);
+            if (nd >= current(ni)) {
+                continue;
+            }
+            if (scratch.newStamp[ni] != scratch.generation) {
+                if (changed.size() >= limit) {
+                    return false;
+                }
+                scratch.newStamp[ni] = scratch.generation;
+                changed.push_back(ni);
+            }
+            scratch.newDistance[ni] = nd;
+            heap.push_back(HeapEntry{ nd, ni });
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+    AssignDirections(grid, changed);
+    return true;
+}
+
+void FlowField::AssignDirections(const NavGrid& grid, const std::vector<int>& cells)
+{
+    // Build と同じ決め方（縦横を先に見て、真に縮むときだけ入れ替える）
+    EditScratch& scratch = GetEditScratch();
+    const auto current = [&](int index) {
+        return scratch.newStamp[index] == scratch.generation ? scratch.newDistance[index] : GetOldDistance(index);
+    };
+    // 元の距離を引くのに古い向きを使うので、全部決めてから書き込む
+    std::vector<uint8_t>& directions = scratch.directions;
+    directions.assign(cells.size(), UNREACHABLE);
+    for (size_t k = 0; k < cells.size(); ++k) {
+        const GridPoint p = grid.ToPoint(cells[k]);
+        if (!grid.IsWalkable(p) || current(cells[k]) == INT_MAX) {
+            continue;
+        }
+        int best = INT_MAX;
+        for (int dir = 0; dir < NavGrid::DIRECTION_COUNT; ++dir) {
+            if (!grid.CanStep(p.x, p.y, dir)) {
+                continue;
+            }
+            const int nd = current(grid.ToIndex(p.x + NavGrid::DX[dir], p.y + NavGrid::DY[dir]));
+            if (nd != INT_MAX && nd + NavGrid::StepCost(dir) < best) {
+                best = nd + NavGrid::StepCost(dir);
+                directions[k] = static_cast<uint8_t>(dir);
+            }
+        }
+    }
+    for (size_t k = 0; k < cells.size(); ++k) {
+        m_directions[cells[k]] = directions[k];
+    }
+}
+
+// ==============================
+// FlowFieldCache
+// ==============================
+const FlowField& FlowFieldCache::Get(const NavGrid& grid, uint32_t key, const GridPoint* goals, size_t goalCount)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        if (m_capacity > 0 && m_entries.size() >= m_capacity) {
+            auto oldest = m_entries.begin();
+            for (auto e = m_entries.begin(); e != m_entries.end(); ++e) {
+                if (e->second.lastUse < oldest->second.lastUse) {
+                    oldest = e;
+                }
+            }
+            m_entries.erase(oldest);
+            ++m_stats.evictions;
+        }
+        it = m_entries.emplace(key, Entry{}).first;
+    }
+
+    Entry& entry = it->second;
+    entry.lastUse = ++m_useCounter;
+    if (entry.field.IsBuilt() && (entry.field.GetRevision() == grid.GetRevision() || m_updateBudgetMs > 0.0)) {
+        ++m_stats.hits;
+        return entry.field;
+    }
+    Refresh(entry.field, grid, goals, goalCount);
+    return entry.field;
+}
+
+void FlowFieldCache::Refresh(FlowField& field, const NavGrid& grid, const GridPoint* goals, size_t goalCount)
+{
+    if (field.IsBuilt() && field.GetRevision() == m_lastEdit.revisionBefore && grid.GetRevision() == m_lastEdit.revisionAfter) {
+        if (field.ApplyEdit(grid, m_lastEdit.x, m_lastEdit.y, m_lastEdit.width, m_lastEdit.height)) {
+            ++m_stats.patches;
+            return;
+        }
+        ++m_stats.invalidations;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    if (goals) {
+        field.Build(grid, goals, goalCount);
+    }
+    else {
+        field.Rebuild(grid);
+    }
+    m_stats.buildMicros += ElapsedMicros(start);
+    ++m_stats.builds;
+}
+
+void FlowFieldCache::OnGridEdited(const NavGrid& grid, uint32_t revisionBefore, int x, int y, int width, int height)
+{
+    m_lastEdit.revisionBefore = revisionBefore;
+    m_lastEdit.revisionAfter = grid.GetRevision();
+    m_lastEdit.x = x;
+    m_lastEdit.y = y;
+    m_lastEdit.width = width;
+    m_lastEdit.height = height;
+}
+
+size_t FlowFieldCache::Update(const NavGrid& grid)
+{
+    if (m_updateBudgetMs <= 0.0) {
+        return 0;
+    }
+    std::vector<Entry*> stale;
+    for (auto& entry : m_entries) {
+        if (entry.second.field.IsBuilt() && entry.second.field.GetRevision() != grid.GetRevision()) {
+            stale.push_back(&entry.second);
+        }
+    }
+    std::sort(stale.begin(), stale.end(), [](const Entry* a, const Entry* b) { return a->lastUse > b->lastUse; });
+    const auto start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    while (count < stale.size()) {
+        Refresh(stale[count]->field, grid, nullptr, 0);
+        ++count;
+        if (ElapsedMicros(start) >= m_updateBudgetMs * 1000.0) {
+            break;
+        }
+    }
+    return count;
+}
+
+void FlowFieldCache::Clear()
+{
+    m_entries.clear();
+}
+
+size_t FlowFieldCache::GetMemorySize() const
+{
+    size_t bytes = 0;
+    for (const auto& entry : m_entries) {
+        bytes += entry.second.field.GetMemorySize();
+    }
+    return bytes;
+}
@@ -0,0 +1,154 @@
+﻿/*****************************************************************//**
+ * @file   FlowField.h
+ * @brief  行き先ごとの流れ場（各セルで次に進む方向）とそのキャッシュ
+ *
+ * @details
+ * - 行き先（部屋の内側のセル全部など、複数セル可）から逆向きに 1 回だけ Dijkstra を流し、
+ *   各セルに「最短で行き先へ向かう方向」を 1 バイトで持たせる
+ * - 同じ行き先へ向かう客は何人でもこれをたどるだけなので、1 tick の経路コストは客数によらない
+ * - 向きは NavGrid の 8 方向の番号。縦横を先に見るので、同じ距離なら縦横の一歩を選ぶ
+ * - 移動の可否（斜めで角を切らない）は向きを入れ替えても同じなので、逆向きに探索した結果を
+ *   そのまま順方向に使える
+ * - FlowFieldCache はグリッドのリビジョンが変わったときだけ作り直す（マップが変わらない限り再探索しない）
+ * - 書き換えの後始末（FlowField::ApplyEdit）
+ *   - 書き換えた矩形と周り 1 マスに行き先へつながるセルが無い場は、そのまま最新として扱う
+ *   - 壁にした書き換えは、最短経路がそこを通っていたセル（向きを逆にたどった部分木）だけを、
+ *     外側の距離から Dijkstra で解き直す。通れるようにした書き換えは、周辺から距離が縮むセルにだけ広げる。
+ *     距離は持たず、向きをたどって求める（1 セル 1 バイトのまま）
+ *   - 解き直すセルが全体の 1/4 を超える・行き先が矩形の中にあるなどで直せなければ作り直す
+ * - FlowFieldCache は OnGridEdited で直前の書き換えを覚えておき、それ 1 回ぶんだけ古い場は ApplyEdit で直す。
+ *   SetUpdateBudget を指定すると、古い場は Get でその場で直さず、Update が tick ごとに持ち時間の分だけ
+ *   最近使った場から直す（それまでは古い場を返す）
+ *********************************************************************/
+#pragma once
+#include "NavGrid.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class FlowField
+{
+public:
+    static constexpr uint8_t GOAL = 0xFE;        // 行き先のセル
+    static constexpr uint8_t UNREACHABLE = 0xFF; // 壁・行き先へつながっていないセル
+
+    // goals のうち通行できないセルは無視する
+    void Build(const NavGrid& grid, const GridPoint* goals, size_t goalCount);
+    // 前回 Build に渡した行き先で作り直す
+    void Rebuild(const NavGrid& grid);
+
+    // grid の (x, y, width, height) を通れる・壁のどちらかにそろえた直後に呼ぶ（場は書き換え前のグリッドで最新だったこと）。
+    // 最短距離が変わるセルだけ向きを直して最新にし、true を返す。false なら場は変えない（作り直しが要る）
+    bool ApplyEdit(const NavGrid& grid, int x, int y, int width, int height);
+
+    bool IsBuilt() const { return !m_directions.empty(); }
+    uint32_t GetRevision() const { return m_revision; }
+
+    uint8_t GetDirection(const GridPoint& p) const
+    {
+        if (p.x < 0 || p.y < 0 || p.x >= m_width || p.y >= m_height) {
+            return UNREACHABLE;
+        }
+        return m_directions[static_cast<size_t>(p.y) * m_width + p.x];
+    }
+    bool IsGoal(const GridPoint& p) const { return GetDirection(p) == GOAL; }
+    bool IsReachable(const GridPoint& p) const { return GetDirection(p) != UNREACHABLE; }
+
+    // 次に進むセル（行き先・到達不能ならその場）
+    GridPoint GetNextStep(const GridPoint& p) const
+    {
+        const uint8_t d = GetDirection(p);
+        if (d >= NavGrid::DIRECTION_COUNT) {
+            return p;
+        }
+        return GridPoint{ p.x + NavGrid::DX[d], p.y + NavGrid::DY[d] };
+    }
+
+    size_t GetMemorySize() const { return m_directions.capacity() + m_goals.capacity() * sizeof(GridPoint); }
+
+private:
+    struct EditScratch;
+    struct EditRegion
+    {
+        int x0, y0, x1, y1; // 矩形と周り 1 マス（グリッドの中に切り詰めた半開区間）
+    };
+
+    static EditScratch& GetEditScratch();
+    static EditScratch& BeginEdit(int cellCount);
+    // 書き換え前の向きをたどった距離（到達不能なら INT_MAX）
+    int GetOldDistance(int index) const;
+    bool RepairBlocked(const NavGrid& grid, const EditRegion& region);
+    bool RepairOpened(const NavGrid& grid, const EditRegion& region);
+    // cells の向きを、変わった距離と元の距離から決め直す
+    void AssignDirections(const NavGrid& grid, const std::vector<int>& cells);
+
+    int m_width = 0;
+    int m_height = 0;
+    uint32_t m_revision = 0;
+    std::vector<uint8_t> m_directions;
+    std::vector<GridPoint> m_goals; // Rebuild 用
+};
+
+struct FlowFieldCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t builds = 0;    // 初回・マップ変更による作り直しを含む
+    uint64_t evictions = 0;
+    uint64_t patches = 0;       // 書き換えを ApplyEdit で直した回数（影響の無かった場を含む）
+    uint64_t invalidations = 0; // ApplyEdit で直せず作り直した回数
+    double buildMicros = 0.0;
+};
+
+class FlowFieldCache
+{
+public:
+    // capacity は保持する場の最大数（0 なら無制限）。超えたら最も長く使われていないものを捨てる
+    explicit FlowFieldCache(size_t capacity = 0) : m_capacity(capacity) {}
+
+    // key は呼び出し側が行き先ごとに決める（部屋番号など）。goals は作り直すときだけ使う
+    // 返した参照は次に Get / Clear を呼ぶまで有効（容量無制限なら Clear まで同じ場を指す）
+    const FlowField& Get(const NavGrid& grid, uint32_t key, const GridPoint* goals, size_t goalCount);
+
+    // 0（既定）なら Get が古い場をその場で直す。正なら Get は一度作った場を古いまま返し、
+    // 直すのは Update に任せる
+    void SetUpdateBudget(double milliseconds) { m_updateBudgetMs = milliseconds; }
+    // grid の (x, y, width, height) を通れる・壁のどちらかにそろえた直後に呼ぶ。revisionBefore は書き換える前のリビジョン。
+    // 覚えておくだけで、場を直すのは Get / Update
+    void OnGridEdited(const NavGrid& grid, uint32_t revisionBefore, int x, int y, int width, int height);
+    // 古い場を最近使った順に、持ち時間まで（少なくとも 1 つ）直し、直した数を返す（SetUpdateBudget が 0 なら何もしない）
+    size_t Update(const NavGrid& grid);
+
+    void Clear();
+
+    size_t GetFieldCount() const { return m_entries.size(); }
+    size_t GetMemorySize() const;
+    const FlowFieldCacheStats& GetStats() const { return m_stats; }
+
+private:
+    struct Entry
+    {
+        FlowField field;
+        uint64_t lastUse = 0;
+    };
+
+    struct Edit
+    {
+        uint32_t revisionBefore = 0;
+        uint32_t revisionAfter = 0;
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    // 場を grid に追いつかせる（直前の書き換え 1 回ぶんだけ古ければ ApplyEdit、直せなければ goals で作り直す）
+    void Refresh(FlowField& field, const NavGrid& grid, const GridPoint* goals, size_t goalCount);
+
+    size_t m_capacity = 0;
+    double m_updateBudgetMs = 0.0;
+    Edit m_lastEdit;
+    uint64_t m_useCounter = 0;
+    std::unordered_map<uint32_t, Entry> m_entries;
+    FlowFieldCacheStats m_stats;
+};
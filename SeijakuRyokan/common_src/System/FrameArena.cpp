@@ -0,0 +1,119 @@
+﻿/*****************************************************************//**
+ * @file   FrameArena.cpp
+ * @brief  1 フレーム用バンプアロケータの実装
+ *********************************************************************/
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace
+{
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // ブロックの先頭は max_align_t 境界（new[] の保証）なので、オフセットを揃えれば足りる
+    size_t AlignOffset(const uint8_t* base, size_t offset, size_t alignment)
+    {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(base) + offset;
+        return offset + (AlignUp(address, alignment) - address);
+    }
+}
+
+FrameArena::FrameArena(size_t initialCapacity)
+{
+    m_main.size = initialCapacity;
+    m_stats.capacity = initialCapacity;
+}
+
+FrameArena::~FrameArena() = default;
+
+FrameArena& FrameArena::ForThisThread()
+{
+    thread_local FrameArena arena;
+    return arena;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+    size = (std::max<size_t>)(size, 1);
+
+    if (m_overflow.empty()) {
+        if (!m_main.data && m_main.size > 0) {
+            MemoryTagScope memoryTag(MemoryTag::System);
+            m_main.data.reset(new uint8_t[m_main.size]);
+            ++m_stats.heapAllocations;
+        }
+        const size_t offset = AlignOffset(m_main.data.get(), m_offset, alignment);
+        if (m_main.data && offset + size <= m_main.size) {
+            m_offset = offset + size;
+            m_stats.used = m_offset;
+            return m_main.data.get() + offset;
+        }
+    }
+    return AllocateOverflow(size, alignment);
+}
+
+void* FrameArena::AllocateOverflow(size_t size, size_t alignment)
+{
+    if (!m_overflow.empty()) {
+        Block& block = m_overflow.back();
+        const size_t offset = AlignOffset(block.data.get(), m_overflowOffset, alignment);
+        if (offset + size <= block.size) {
+            m_overflowUsed += offset + size - m_overflowOffset;
+            m_overflowOffset = offset + size;
+            m_stats.used = m_offset + m_overflowUsed;
+            return block.data.get() + offset;
+        }
+    }
+
+    // 今の主ブロックと同じだけ（大きな要求ならその分）追加し、倍々で伸ばす
+    Block block;
+    block.size = (std::max)(AlignUp(size + alignment, 4096), (std::max)(m_main.size, DEFAULT_CAPACITY));
+    {
+        MemoryTagScope memoryTag(MemoryTag::System);
+        block.data.reset(new uint8_t[block.size]);
+    }
+    ++m_stats.heapAllocations;
+
+    const size_t offset = AlignOffset(block.data.get(), 0, alignment);
+    m_overflowOffset = offset + size;
+    m_overflowUsed += m_overflowOffset;
+    m_stats.used = m_offset + m_overflowUsed;
+    uint8_t* result = block.data.get() + offset;
+    m_overflow.push_back(std::move(block));
+    return result;
+}
+
+void FrameArena::Reset()
+{
+    const size_t used = m_offset + m_overflowUsed;
+    m_stats.highWater = (std::max)(m_stats.highWater, used);
+    ++m_stats.resets;
+    ++m_generation;
+
+#if SEIJAKU_ARENA_POISON
+    if (m_main.data) {
+        std::memset(m_main.data.get(), POISON, m_offset);
+    }
+    for (Block& block : m_overflow) {
+        std::memset(block.data.get(), POISON, block.size);
+    }
+#endif
+
+    if (!m_overflow.empty()) {
+        // 足りなかったので、このフレームの使用量が 1 ブロックに収まるよう作り直す
+        m_overflow.clear();
+        m_main.data.reset();
+        m_main.size = AlignUp(used + used / 2, 4096);
+        m_stats.capacity = m_main.size;
+    }
+    m_offset = 0;
+    m_overflowOffset = 0;
+    m_overflowUsed = 0;
+    m_stats.used = 0;
+}
@@ -0,0 +1,153 @@
+﻿/*****************************************************************//**
+ * @file   FrameArena.h
+ * @brief  1 フレームだけ使う一時データ用のバンプアロケータ
+ *
+ * @details
+ * - 確保はポインタを進めるだけ、解放は個別に行わず Reset でまとめて捨てる
+ * - スレッドごとに 1 つ（FrameArena::ForThisThread）。各 IGraphics の BeginDraw が
+ *   呼んだスレッドのアリーナを Reset する
+ *   （ThreadedGraphics ならゲーム側とバックエンドの描画スレッドで別々に回る）
+ * - 足りなくなったら追加のブロックをヒープから取り、次の Reset でその分だけ
+ *   大きな 1 ブロックにまとめ直す。数フレームで落ち着き、以降は malloc が起きない
+ * - FrameVector / FrameString などの別名で STL コンテナの置き場にできる。
+ *   そのフレームの中で作って捨てるもの（UI の一時配列、整形した文字列、探索の作業領域）に使う
+ * - デバッグ時（_DEBUG または SEIJAKU_ARENA_POISON=1）は
+ *   - Reset で使った範囲を 0xDD で埋める（Reset 後に古いポインタを読むと値が壊れて見える）
+ *   - ArenaAllocator が確保したときの世代を覚え、Reset をまたいで確保・解放したら assert する
+ *********************************************************************/
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef SEIJAKU_ARENA_POISON
+#if defined(_DEBUG)
+#define SEIJAKU_ARENA_POISON 1
+#else
+#define SEIJAKU_ARENA_POISON 0
+#endif
+#endif
+
+struct FrameArenaStats
+{
+    size_t capacity = 0;          // 今の主ブロックの大きさ
+    size_t used = 0;              // 今のフレームで使った量（追加ブロック込み）
+    size_t highWater = 0;         // これまでの 1 フレームの最大
+    uint64_t resets = 0;
+    uint64_t heapAllocations = 0; // ブロックをヒープから取った回数（落ち着けば増えない）
+};
+
+class FrameArena
+{
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 256 * 1024;
+    static constexpr uint8_t POISON = 0xDD;
+
+    explicit FrameArena(size_t initialCapacity = DEFAULT_CAPACITY);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // 呼んだスレッドのアリーナ（初めて確保するまでメモリは取らない）
+    static FrameArena& ForThisThread();
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* AllocateArray(size_t count)
+    {
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // 確保したものをすべて捨てる（デストラクタは呼ばない）
+    void Reset();
+
+    // Reset のたびに 1 増える。確保したときの値と比べれば、Reset をまたいだか分かる
+    uint64_t GetGeneration() const { return m_generation; }
+
+    const FrameArenaStats& GetStats() const { return m_stats; }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size = 0;
+    };
+
+    void* AllocateOverflow(size_t size, size_t alignment);
+
+    Block m_main;
+    size_t m_offset = 0;               // m_main 上の次の位置
+    std::vector<Block> m_overflow;     // 今のフレームで足りなかった分
+    size_t m_overflowOffset = 0;       // m_overflow.back() 上の次の位置
+    size_t m_overflowUsed = 0;
+    uint64_t m_generation = 0;
+    FrameArenaStats m_stats;
+};
+
+// STL コンテナ用のアロケータ。解放は何もしない（Reset でまとめて捨てる）
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept : ArenaAllocator(FrameArena::ForThisThread()) {}
+    explicit ArenaAllocator(FrameArena& arena) noexcept
+        : m_arena(&arena)
+#if SEIJAKU_ARENA_POISON
+        , m_generation(arena.GetGeneration())
+#endif
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : m_arena(other.m_arena)
+#if SEIJAKU_ARENA_POISON
+        , m_generation(other.m_generation)
+#endif
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+#if SEIJAKU_ARENA_POISON
+        assert(m_generation == m_arena->GetGeneration() && "FrameArena: container used after Reset");
+#endif
+        return m_arena->AllocateArray<T>(count);
+    }
+
+    void deallocate(T*, size_t) noexcept
+    {
+#if SEIJAKU_ARENA_POISON
+        assert(m_generation == m_arena->GetGeneration() && "FrameArena: container used after Reset");
+#endif
+    }
+
+    FrameArena& GetArena() const { return *m_arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return m_arena == other.m_arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return m_arena != other.m_arena; }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    FrameArena* m_arena;
+#if SEIJAKU_ARENA_POISON
+    uint64_t m_generation;
+#endif
+};
+
+// フレームの中だけで使うコンテナ（既定では呼んだスレッドの FrameArena に置く）
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+using FrameString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+using FrameWString = std::basic_string<wchar_t, std::char_traits<wchar_t>, ArenaAllocator<wchar_t>>;
@@ -0,0 +1,132 @@
+﻿/*****************************************************************//**
+ * @file   FrameCounters.cpp
+ * @brief  フレーム単位のカウンタ実装
+ *********************************************************************/
+#include "FrameCounters.h"
+#include <algorithm>
+#include <mutex>
+
+std::atomic<uint64_t> FrameCounters::g_current[FrameCounters::COUNT];
+thread_local uint64_t* FrameCounters::t_capture = nullptr;
+
+namespace
+{
+    const char* const NAMES[FrameCounters::COUNT] = {
+        "quads",
+        "draw_calls",
+        "flushes",
+        "texture_switches",
+        "shader_switches",
+        "sdf_toggles",
+        "path_queries",
+        "guests_updated",
+        "bytes_uploaded",
+    };
+
+    std::mutex g_historyMutex;
+    FrameCounters::Snapshot g_history[FrameCounters::HISTORY_FRAMES];
+    uint64_t g_frame = 0; // 確定したフレーム数
+}
+
+void FrameCounters::EndFrame()
+{
+    uint64_t values[COUNT];
+    TakeCurrent(values);
+    std::lock_guard<std::mutex> lock(g_historyMutex);
+    Snapshot& s = g_history[g_frame % HISTORY_FRAMES];
+    s.frame = g_frame;
+    std::copy(values, values + COUNT, s.values);
+    ++g_frame;
+}
+
+void FrameCounters::TakeCurrent(uint64_t (&out)[COUNT])
+{
+    for (size_t i = 0; i < COUNT; ++i) {
+        out[i] = g_current[i].exchange(0, std::memory_order_relaxed);
+    }
+}
+
+void FrameCounters::CommitFrame(uint64_t frame, const uint64_t (&values)[COUNT])
+{
+    std::lock_guard<std::mutex> lock(g_historyMutex);
+    Snapshot& s = g_history[g_frame % HISTORY_FRAMES];
+    s.frame = frame;
+    std::copy(values, values + COUNT, s.values);
+    ++g_frame;
+}
+
+FrameCounters::Snapshot FrameCounters::GetLastFrame()
+{
+    std::lock_guard<std::mutex> lock(g_historyMutex);
+    if (g_frame == 0) {
+        return Snapshot();
+    }
+    return g_history[(g_frame - 1) % HISTORY_FRAMES];
+}
+
+uint64_t FrameCounters::GetCommittedCount()
+{
+    std::lock_guard<std::mutex> lock(g_historyMutex);
+    return g_frame;
+}
+
+bool FrameCounters::GetCommitted(uint64_t index, Snapshot& out)
+{
+    std::lock_guard<std::mutex> lock(g_historyMutex);
+    if (index >= g_frame || g_frame - index > HISTORY_FRAMES) {
+        return false;
+    }
+    out = g_history[index % HISTORY_FRAMES];
+    return true;
+}
+
+void FrameCounters::GetRecent(FrameCounter c, double& average, uint64_t& maximum)
+{
+    std::lock_guard<std::mutex> lock(g_historyMutex);
+    const size_t n = static_cast<size_t>((std::min<uint64_t>)(g_frame, HISTORY_FRAMES));
+    const size_t index = static_cast<size_t>(c);
+    uint64_t sum = 0;
+    maximum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t v = g_history[i].values[index];
+        sum += v;
+        maximum = (std::max)(maximum, v);
+    }
+    average = n ? static_cast<double>(sum) / static_cast<double>(n) : 0.0;
+}
+
+void FrameCounters::Reset()
+{
+    for (std::atomic<uint64_t>& c : g_current) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(g_historyMutex);
+    for (Snapshot& s : g_history) {
+        s = Snapshot();
+    }
+    g_frame = 0;
+}
+
+const char* FrameCounters::GetName(FrameCounter c)
+{
+    const size_t index = static_cast<size_t>(c);
+    return index < COUNT ? NAMES[index] : "";
+}
+
+void FrameCounters::WriteCsvHeader(FILE* fp)
+{
+    std::fputs("frame", fp);
+    for (const char* name : NAMES) {
+        std::fprintf(fp, ",%s", name);
+    }
+    std::fputc('\n', fp);
+}
+
+void FrameCounters::WriteCsvRow(FILE* fp, const Snapshot& snapshot)
+{
+    std::fprintf(fp, "%llu", static_cast<unsigned long long>(snapshot.frame));
+    for (uint64_t v : snapshot.values) {
+        std::fprintf(fp, ",%llu", static_cast<unsigned long long>(v));
+    }
+    std::fputc('\n', fp);
+}
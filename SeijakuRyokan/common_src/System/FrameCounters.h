@@ -0,0 +1,105 @@
+﻿/*****************************************************************//**
+ * @file   FrameCounters.h
+ * @brief  フレーム単位の描画・シミュレーションのカウンタ
+ *
+ * @details
+ * - 描画（DirectXGraphics / SpriteDrawer / NullGraphics）とゲーム側の各システムが
+ *   FrameCounters::Add で数え、ゲームループがフレーム境界で EndFrame を呼んで確定する
+ * - 描画スレッドを使う場合（ThreadedGraphics）はゲームループは EndFrame を呼ばない
+ *   - EndDraw でゲーム側の値を TakeCurrent で取り出し、累計を RenderList に載せる
+ *   - 描画スレッドは CaptureScope で自分の Add を集め、RenderList を描き終えたところで
+ *     前に描いた RenderList からのゲーム側の増分と合わせて CommitFrame する
+ *   - これで 1 フレームの値は「その RenderList の Update 側＋描画側」になる。
+ *     飛ばされた RenderList のゲーム側の値は次に描いたフレームに足される
+ * - 直近 HISTORY_FRAMES フレーム分を残すので、HUD で平均・最大を出せる（履歴はロックで守る）
+ * - CSV（1行1フレーム）で書き出せる。UI の変更でテクスチャ切り替えが倍になった、
+ *   といった退行をヘッドレス実行の差分で見つけるため
+ * - Add は CaptureScope の中ならそのスレッドの配列に、外なら relaxed の fetch_add で共有の値に足す
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+enum class FrameCounter : uint8_t
+{
+    Quads,           // 描いた Quad 数
+    DrawCalls,       // 発行したドロー数
+    Flushes,         // 頂点バッファへの転送回数
+    TextureSwitches, // 直前のドローとテクスチャが変わった回数
+    ShaderSwitches,  // 通常 ↔ SDF シェーダの切り替え回数
+    SdfToggles,      // SetSdfMode で状態が実際に変わった回数
+    PathQueries,     // 経路探索の回数
+    GuestsUpdated,   // Update したお客様の数
+    BytesUploaded,   // GPU に送ったバイト数（頂点・テクスチャ）
+
+    Count
+};
+
+namespace FrameCounters
+{
+    constexpr size_t COUNT = static_cast<size_t>(FrameCounter::Count);
+    constexpr size_t HISTORY_FRAMES = 240;
+
+    struct Snapshot
+    {
+        uint64_t frame = 0;
+        uint64_t values[COUNT] = {};
+
+        uint64_t operator[](FrameCounter c) const { return values[static_cast<size_t>(c)]; }
+    };
+
+    extern std::atomic<uint64_t> g_current[COUNT];
+    extern thread_local uint64_t* t_capture;
+
+    inline void Add(FrameCounter c, uint64_t n = 1)
+    {
+        if (uint64_t* capture = t_capture) {
+            capture[static_cast<size_t>(c)] += n;
+            return;
+        }
+        g_current[static_cast<size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // 生存中、このスレッドの Add を values に足す（入れ子にできる）
+    class CaptureScope
+    {
+    public:
+        explicit CaptureScope(uint64_t (&values)[COUNT]) : m_prev(t_capture) { t_capture = values; }
+        ~CaptureScope() { t_capture = m_prev; }
+
+        CaptureScope(const CaptureScope&) = delete;
+        CaptureScope& operator=(const CaptureScope&) = delete;
+
+    private:
+        uint64_t* m_prev;
+    };
+
+    // フレーム境界で呼ぶ（ゲームループの Draw の後）。今のフレームを確定して 0 に戻す
+    void EndFrame();
+
+    // 共有の値を out に移して 0 に戻す（確定はしない）
+    void TakeCurrent(uint64_t (&out)[COUNT]);
+
+    // values を frame 番のフレームとして確定する
+    void CommitFrame(uint64_t frame, const uint64_t (&values)[COUNT]);
+
+    // 直前に確定したフレーム（確定は別スレッドのこともあるのでコピーを返す）
+    Snapshot GetLastFrame();
+
+    // これまでに確定したフレーム数と、index 番目（0 から）に確定したフレーム。
+    // 履歴から押し出されていれば false
+    uint64_t GetCommittedCount();
+    bool GetCommitted(uint64_t index, Snapshot& out);
+
+    // 直近 HISTORY_FRAMES フレーム（確定済みの分だけ）の平均と最大
+    void GetRecent(FrameCounter c, double& average, uint64_t& maximum);
+
+    void Reset();
+
+    const char* GetName(FrameCounter c);
+
+    // CSV（frame,quads,draw_calls,...）
+    void WriteCsvHeader(FILE* fp);
+    void WriteCsvRow(FILE* fp, const Snapshot& snapshot);
+}
@@ -0,0 +1,205 @@
+﻿/*****************************************************************//**
+ * @file   FramePacer.cpp
+ * @brief  スリープ＋最後だけスピンのフレーム待ち実装
+ *********************************************************************/
+#include "FramePacer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#elif defined(__linux__)
+#include <cerrno>
+#include <time.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+namespace
+{
+    constexpr int64_t NS_PER_MS = 1000000;
+    constexpr int64_t MIN_SPIN_MARGIN_NS = 100000;  // 0.1ms
+    constexpr int64_t MAX_SPIN_MARGIN_NS = 4000000; // 4ms
+}
+
+int64_t PacerClock::NowNs()
+{
+#if defined(_WIN32)
+    static const int64_t frequency = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return static_cast<int64_t>(f.QuadPart);
+    }();
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    // 秒と端数に分けて掛ける（そのまま 1e9 倍するとあふれる）
+    const int64_t seconds = now.QuadPart / frequency;
+    const int64_t rest = now.QuadPart % frequency;
+    return seconds * 1000000000 + rest * 1000000000 / frequency;
+#elif defined(__linux__)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+FramePacer::FramePacer()
+{
+#if defined(_WIN32)
+    // Windows 10 1803 以降は高分解能タイマーで 0.5ms 程度の精度で起きられる
+    m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!m_timer) {
+        // 無い環境では Sleep の分解能を 1ms に上げる
+        m_timerPeriodSet = timeBeginPeriod(1) == TIMERR_NOERROR;
+    }
+#endif
+    Reset(m_targetFps);
+}
+
+FramePacer::~FramePacer()
+{
+#if defined(_WIN32)
+    if (m_timer) {
+        CloseHandle(m_timer);
+    }
+    if (m_timerPeriodSet) {
+        timeEndPeriod(1);
+    }
+#endif
+}
+
+void FramePacer::Reset(double targetFps)
+{
+    SetTargetFps(targetFps);
+    m_nextNs = PacerClock::NowNs() + m_periodNs;
+}
+
+void FramePacer::SetTargetFps(double targetFps)
+{
+    m_targetFps = targetFps > 0.0 ? targetFps : 60.0;
+    m_periodNs = static_cast<int64_t>(1.0e9 / m_targetFps + 0.5);
+}
+
+void FramePacer::SetLateTolerance(double milliseconds)
+{
+    m_lateToleranceNs = static_cast<int64_t>(milliseconds * NS_PER_MS);
+}
+
+int64_t FramePacer::WaitForNextFrame()
+{
+    PROFILE_ZONE("FramePacer::Wait");
+    const int64_t target = m_nextNs;
+    const int64_t start = PacerClock::NowNs();
+
+    // 1) 目標の spinMargin 手前までスリープ
+    int64_t slept = 0;
+    const int64_t sleepDeadline = target - m_spinMarginNs;
+    if (start < sleepDeadline) {
+        SleepUntil(sleepDeadline);
+        const int64_t woke = PacerClock::NowNs();
+        slept = woke - start;
+
+        // 寝過ごし量を覚えておき、次回からのスピン時間に反映する
+        const int64_t oversleep = (std::max<int64_t>)(woke - sleepDeadline, 0);
+        m_oversleepPeakNs = (std::max)(oversleep, m_oversleepPeakNs - m_oversleepPeakNs / 64);
+    }
+
+    // 2) 残りはスピン
+    int64_t now = PacerClock::NowNs();
+    const int64_t spinStart = now;
+    while (now < target) {
+        now = PacerClock::NowNs();
+    }
+    const int64_t spun = now - spinStart;
+
+    // 3) 次の目標は前回の目標基準で進める（ずれを持ち越さない）
+    m_nextNs = target + m_periodNs;
+    if (now - target >= m_periodNs) {
+        // 大きく遅れたときは取り戻そうとせず、今から数え直す
+        m_nextNs = now + m_periodNs;
+        ++m_stats.resyncs;
+    }
+
+    // 寝過ごしの最大値 + 余裕 25% をスピンに回す
+    m_spinMarginNs = (std::clamp)(m_oversleepPeakNs + m_oversleepPeakNs / 4,
+        MIN_SPIN_MARGIN_NS, MAX_SPIN_MARGIN_NS);
+
+    Record(now - target, slept, spun);
+    return now;
+}
+
+void FramePacer::SleepUntil(int64_t deadlineNs)
+{
+#if defined(_WIN32)
+    const int64_t remaining = deadlineNs - PacerClock::NowNs();
+    if (remaining <= 0) {
+        return;
+    }
+    if (m_timer) {
+        LARGE_INTEGER due;
+        due.QuadPart = -(remaining / 100); // 100ns 単位、負値は相対時間
+        if (SetWaitableTimerEx(m_timer, &due, 0, nullptr, nullptr, nullptr, 0)) {
+            WaitForSingleObject(m_timer, INFINITE);
+            return;
+        }
+    }
+    const DWORD ms = static_cast<DWORD>(remaining / NS_PER_MS);
+    if (ms > 0) {
+        Sleep(ms);
+    }
+#elif defined(__linux__)
+    // 絶対時刻で待つので、シグナルで起こされても同じ期限で待ち直せる
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+#else
+    const int64_t remaining = deadlineNs - PacerClock::NowNs();
+    if (remaining > 0) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(remaining));
+    }
+#endif
+}
+
+void FramePacer::Record(int64_t errorNs, int64_t sleptNs, int64_t spunNs)
+{
+    const double error = static_cast<double>(errorNs);
+    const double absError = std::fabs(error);
+
+    ++m_stats.frames;
+    if (absError > static_cast<double>(m_lateToleranceNs)) {
+        ++m_stats.lateFrames;
+    }
+    m_errorSum += error;
+    m_errorSqSum += error * error;
+    m_absErrorSum += absError;
+
+    const double n = static_cast<double>(m_stats.frames);
+    const double mean = m_errorSum / n;
+    const double variance = (std::max)(m_errorSqSum / n - mean * mean, 0.0);
+    m_stats.jitterMeanMs = m_absErrorSum / n / NS_PER_MS;
+    m_stats.jitterStdDevMs = std::sqrt(variance) / NS_PER_MS;
+    m_stats.jitterMaxMs = (std::max)(m_stats.jitterMaxMs, absError / NS_PER_MS);
+    m_stats.sleepMs += static_cast<double>(sleptNs) / NS_PER_MS;
+    m_stats.spinMs += static_cast<double>(spunNs) / NS_PER_MS;
+}
+
+void FramePacer::ResetStats()
+{
+    m_stats = FramePacingStats();
+    m_errorSum = 0.0;
+    m_errorSqSum = 0.0;
+    m_absErrorSum = 0.0;
+}
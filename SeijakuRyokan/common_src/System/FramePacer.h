@@ -0,0 +1,94 @@
+﻿/*****************************************************************//**
+ * @file   FramePacer.h
+ * @brief  スリープ＋最後だけスピンのフレーム待ち（プラットフォーム非依存）
+ *
+ * @details
+ * - 目標時刻の少し手前までは OS のスリープで待ち、残りだけ時計を見て回す。
+ *   busy wait だけの待ちに比べて CPU をほとんど使わない
+ * - 目標時刻は「前回の目標 + 1 フレーム」で進めるので、起床の遅れが積み重ならない。
+ *   1 フレーム以上遅れた場合だけ現在時刻に付け直す（追いつこうと連続で返さない）
+ * - スピンに回す時間は、実際に観測したスリープの寝過ごし量から自動で決める
+ * - 時計は Windows が QueryPerformanceCounter、Linux 等が clock_gettime(CLOCK_MONOTONIC)
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+
+namespace PacerClock
+{
+    // 単調増加する時刻（ナノ秒）。起点は不定なので差分だけ使う
+    int64_t NowNs();
+}
+
+// 起床時刻のずれ（実際の起床 - 目標時刻）の統計
+struct FramePacingStats
+{
+    uint64_t frames = 0;
+    uint64_t lateFrames = 0; // 許容範囲（既定 0.2ms）より遅れて起きた回数
+    uint64_t resyncs = 0;    // 1 フレーム以上遅れ、目標を付け直した回数
+
+    double jitterMeanMs = 0.0;   // |ずれ| の平均
+    double jitterStdDevMs = 0.0; // ずれの標準偏差
+    double jitterMaxMs = 0.0;    // |ずれ| の最大
+
+    double sleepMs = 0.0; // スリープに使った時間の合計
+    double spinMs = 0.0;  // スピンに使った時間の合計
+
+    // 待ち時間のうちスピン（CPU を使った分）の割合
+    double SpinRatio() const
+    {
+        const double total = sleepMs + spinMs;
+        return total > 0.0 ? spinMs / total : 0.0;
+    }
+};
+
+class FramePacer
+{
+public:
+    FramePacer();
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // 目標の起点を現在時刻にする（最初の待ちはここから 1 フレーム後）
+    void Reset(double targetFps = 60.0);
+
+    // 目標 FPS を変える。起点はそのまま
+    void SetTargetFps(double targetFps);
+    double GetTargetFps() const { return m_targetFps; }
+
+    // 次のフレームの目標時刻まで待つ。起床したときの時刻（ナノ秒）を返す
+    int64_t WaitForNextFrame();
+
+    // ずれがこれを超えたら lateFrames に数える
+    void SetLateTolerance(double milliseconds);
+
+    const FramePacingStats& GetStats() const { return m_stats; }
+    void ResetStats();
+
+    // 現在スピンに回している時間（ミリ秒）
+    double GetSpinMarginMs() const { return m_spinMarginNs / 1.0e6; }
+
+private:
+    void SleepUntil(int64_t deadlineNs);
+    void Record(int64_t errorNs, int64_t sleptNs, int64_t spunNs);
+
+    double m_targetFps = 60.0;
+    int64_t m_periodNs = 0;
+    int64_t m_nextNs = 0;
+    int64_t m_lateToleranceNs = 200000;
+
+    // スピンに回す時間。寝過ごしの観測値から毎フレーム見直す
+    int64_t m_spinMarginNs = 1000000;
+    int64_t m_oversleepPeakNs = 0; // 減衰させながら保持する寝過ごしの最大値
+
+    FramePacingStats m_stats;
+    double m_errorSum = 0.0;    // ずれの合計（標準偏差用、ナノ秒）
+    double m_errorSqSum = 0.0;  // ずれの二乗の合計
+    double m_absErrorSum = 0.0; // |ずれ| の合計
+
+#if defined(_WIN32)
+    void* m_timer = nullptr;    // 高分解能の待機可能タイマー（無ければ Sleep）
+    bool m_timerPeriodSet = false;
+#endif
+};
@@ -0,0 +1,220 @@
+﻿/*****************************************************************//**
+ * @file   FrameTimeHistogram.cpp
+ * @brief  フレーム時間のヒストグラムとヒッチ記録の実装
+ *********************************************************************/
+#include "FrameTimeHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    uint32_t HighestBit(uint64_t v)
+    {
+        uint32_t bit = 0;
+        while (v >>= 1) {
+            ++bit;
+        }
+        return bit;
+    }
+
+    const double DEFAULT_THRESHOLDS_MS[] = { 25.0, 50.0, 100.0 }; // 60fps で 1.5 / 3 / 6 フレーム分
+    const double SUMMARY_PERCENTILES[] = { 50.0, 90.0, 99.0, 99.9, 99.99 };
+}
+
+// ============================================================
+// FrameTimeHistogram
+// ============================================================
+
+size_t FrameTimeHistogram::BucketIndex(uint64_t micros)
+{
+    if (micros < (1u << SUB_BITS)) {
+        return static_cast<size_t>(micros);
+    }
+    // 上位 SUB_BITS ビットだけ残す: [2^k, 2^(k+1)) を HALF_SUB 等分
+    const uint32_t shift = HighestBit(micros) - (SUB_BITS - 1);
+    return static_cast<size_t>(shift) * HALF_SUB + static_cast<size_t>(micros >> shift);
+}
+
+uint64_t FrameTimeHistogram::BucketUpperBound(size_t index)
+{
+    if (index < (1u << SUB_BITS)) {
+        return index;
+    }
+    const uint32_t shift = static_cast<uint32_t>(index / HALF_SUB) - 1;
+    const uint64_t sub = index - static_cast<uint64_t>(shift) * HALF_SUB;
+    return ((sub + 1) << shift) - 1;
+}
+
+void FrameTimeHistogram::Record(uint64_t micros)
+{
+    micros = (std::min)(micros, MAX_VALUE);
+    ++m_buckets[BucketIndex(micros)];
+    if (m_count == 0 || micros < m_min) {
+        m_min = micros;
+    }
+    m_max = (std::max)(m_max, micros);
+    m_sum += micros;
+    ++m_count;
+}
+
+void FrameTimeHistogram::RecordSeconds(double seconds)
+{
+    Record(seconds > 0.0 ? static_cast<uint64_t>(std::llround(seconds * 1.0e6)) : 0);
+}
+
+void FrameTimeHistogram::Reset()
+{
+    std::memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_sum = 0;
+    m_min = 0;
+    m_max = 0;
+}
+
+uint64_t FrameTimeHistogram::GetPercentile(double percentile) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    percentile = (std::min)((std::max)(percentile, 0.0), 100.0);
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(m_count)));
+    rank = (std::max<uint64_t>)(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            // バケットの上端で答える（実際に記録した最大値は超えない）
+            return (std::min)(BucketUpperBound(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+void FrameTimeHistogram::Add(const FrameTimeHistogram& other)
+{
+    if (other.m_count == 0) {
+        return;
+    }
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_min = m_count ? (std::min)(m_min, other.m_min) : other.m_min;
+    m_max = (std::max)(m_max, other.m_max);
+    m_sum += other.m_sum;
+    m_count += other.m_count;
+}
+
+// ============================================================
+// FrameTimeMonitor
+// ============================================================
+
+FrameTimeMonitor::FrameTimeMonitor()
+{
+    SetHitchThresholds(std::vector<double>(std::begin(DEFAULT_THRESHOLDS_MS), std::end(DEFAULT_THRESHOLDS_MS)));
+    m_frameStartTicks = Profiler::Now();
+}
+
+void FrameTimeMonitor::SetHitchThresholds(std::vector<double> thresholdsMs)
+{
+    std::sort(thresholdsMs.begin(), thresholdsMs.end());
+    m_thresholdsMs = std::move(thresholdsMs);
+    m_hitchCounts.assign(m_thresholdsMs.size(), 0);
+}
+
+void FrameTimeMonitor::AddFrame(double seconds)
+{
+    const uint64_t now = Profiler::Now();
+    const uint64_t frameStart = m_frameStartTicks;
+    m_frameStartTicks = now;
+
+    const uint64_t frame = m_frame++;
+    if (frame < m_warmupFrames) {
+        return;
+    }
+    m_totalSeconds += seconds;
+    m_histogram.RecordSeconds(seconds);
+
+    const double ms = seconds * 1000.0;
+    if (m_thresholdsMs.empty() || ms < m_thresholdsMs.front()) {
+        return;
+    }
+    for (size_t i = 0; i < m_thresholdsMs.size() && ms >= m_thresholdsMs[i]; ++i) {
+        ++m_hitchCounts[i];
+    }
+    if (m_hitches.size() >= MAX_HITCH_RECORDS) {
+        return;
+    }
+
+    HitchRecord record;
+    record.frame = frame;
+    record.atSeconds = m_totalSeconds;
+    record.frameMs = ms;
+    if (m_contextProvider) {
+        m_contextProvider(record.context);
+    }
+    if (Profiler::IsEnabled()) {
+        record.zones = Profiler::CollectSlowestZones(frameStart, now, ZONES_PER_HITCH);
+    }
+    m_hitches.push_back(std::move(record));
+}
+
+void FrameTimeMonitor::Reset()
+{
+    m_histogram.Reset();
+    m_hitchCounts.assign(m_thresholdsMs.size(), 0);
+    m_hitches.clear();
+    m_frame = 0;
+    m_totalSeconds = 0.0;
+    m_frameStartTicks = Profiler::Now();
+}
+
+uint64_t FrameTimeMonitor::GetHitchCount(size_t thresholdIndex) const
+{
+    return thresholdIndex < m_hitchCounts.size() ? m_hitchCounts[thresholdIndex] : 0;
+}
+
+void FrameTimeMonitor::WriteSummary(FILE* fp) const
+{
+    const FrameTimeHistogram& h = m_histogram;
+    std::fprintf(fp, "frames %llu, %.1f s\n", static_cast<unsigned long long>(h.GetCount()), m_totalSeconds);
+    std::fprintf(fp, "frame time (ms): min %.3f mean %.3f max %.3f\n",
+        h.GetMin() / 1000.0, h.GetMean() / 1000.0, h.GetMax() / 1000.0);
+    for (double p : SUMMARY_PERCENTILES) {
+        std::fprintf(fp, "  p%-6g %8.3f ms\n", p, h.GetPercentile(p) / 1000.0);
+    }
+
+    const double minutes = m_totalSeconds / 60.0;
+    for (size_t i = 0; i < m_thresholdsMs.size(); ++i) {
+        std::fprintf(fp, "hitches >= %.1f ms: %llu (%.2f / min)\n", m_thresholdsMs[i],
+            static_cast<unsigned long long>(m_hitchCounts[i]),
+            minutes > 0.0 ? m_hitchCounts[i] / minutes : 0.0);
+    }
+
+    if (!m_hitches.empty()) {
+        std::fprintf(fp, "first %zu hitches:\n", m_hitches.size());
+    }
+    for (const HitchRecord& r : m_hitches) {
+        std::fprintf(fp, "  frame %llu at %.3f s: %.3f ms", static_cast<unsigned long long>(r.frame), r.atSeconds, r.frameMs);
+        if (!r.context.empty()) {
+            std::fprintf(fp, "  [%s]", r.context.c_str());
+        }
+        std::fputc('\n', fp);
+        for (const Profiler::ZoneSample& z : r.zones) {
+            std::fprintf(fp, "      %8.3f ms  %s (thread %u)\n", z.durationUs / 1000.0, z.name, z.tid);
+        }
+    }
+}
+
+bool FrameTimeMonitor::WriteSummary(const char* path) const
+{
+    FILE* fp = std::fopen(path, "w");
+    if (!fp) {
+        return false;
+    }
+    WriteSummary(fp);
+    const bool ok = std::ferror(fp) == 0;
+    std::fclose(fp);
+    return ok;
+}
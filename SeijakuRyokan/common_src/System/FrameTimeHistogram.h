@@ -0,0 +1,109 @@
+﻿/*****************************************************************//**
+ * @file   FrameTimeHistogram.h
+ * @brief  フレーム時間のヒストグラム（p50/p99/p99.9）とヒッチの記録
+ *
+ * @details
+ * - FrameTimeHistogram は HDR Histogram と同じ対数＋線形のバケット。
+ *   マイクロ秒単位で、どの値でも相対誤差は 1/256（約 0.4%）以内。
+ *   バケット数が固定なので、何時間回してもメモリは増えない（約 58KB）
+ * - FrameTimeMonitor はヒストグラムに加えて、しきい値を超えたフレーム（ヒッチ）を
+ *   しきい値ごとに数え、最初の MAX_HITCH_RECORDS 件は詳細を残す
+ *   - 残すのは「何フレーム目・起動から何秒・何 ms」と、コンテキスト文字列
+ *     （SetContextProvider で渡した関数が、そのフレームのゲームの状態を書く）
+ *   - プロファイラが有効なら、そのフレームの間に終わった区間のうち長いものも残す
+ * - WriteSummary は固定の書式で書くので、長時間のプレイ同士を diff で比べられる
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Profiler.h"
+
+class FrameTimeHistogram
+{
+public:
+    static constexpr uint32_t SUB_BITS = 9;                  // 2^9 = 512 の線形バケットで 1 段
+    static constexpr uint32_t HALF_SUB = 1u << (SUB_BITS - 1);
+    static constexpr uint64_t MAX_VALUE = (1ull << 36) - 1;  // 約 19 時間（これ以上は丸める）
+    static constexpr size_t BUCKET_COUNT = (36 - SUB_BITS + 2) * HALF_SUB;
+
+    FrameTimeHistogram() { Reset(); }
+
+    void Record(uint64_t micros);
+    void RecordSeconds(double seconds);
+    void Reset();
+
+    uint64_t GetCount() const { return m_count; }
+    uint64_t GetMin() const { return m_count ? m_min : 0; }
+    uint64_t GetMax() const { return m_max; }
+    double GetMean() const { return m_count ? static_cast<double>(m_sum) / static_cast<double>(m_count) : 0.0; }
+
+    // percentile は 0～100。その割合のフレームがこの値以下（マイクロ秒）
+    uint64_t GetPercentile(double percentile) const;
+
+    // 別のヒストグラムを足し込む（複数回の計測をまとめる）
+    void Add(const FrameTimeHistogram& other);
+
+private:
+    static size_t BucketIndex(uint64_t micros);
+    static uint64_t BucketUpperBound(size_t index);
+
+    uint64_t m_buckets[BUCKET_COUNT];
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = 0;
+    uint64_t m_max = 0;
+};
+
+// ヒッチ 1 回分の記録
+struct HitchRecord
+{
+    uint64_t frame = 0;      // Reset からのフレーム番号
+    double atSeconds = 0.0;  // Reset からの経過時間
+    double frameMs = 0.0;
+    std::string context;
+    std::vector<Profiler::ZoneSample> zones; // 長い順
+};
+
+class FrameTimeMonitor
+{
+public:
+    static constexpr size_t MAX_HITCH_RECORDS = 256;
+    static constexpr size_t ZONES_PER_HITCH = 8;
+
+    FrameTimeMonitor();
+
+    // ヒッチとみなすしきい値（ms）。小さい順に並べ替えて持ち、最小のものを超えたら記録する
+    void SetHitchThresholds(std::vector<double> thresholdsMs);
+    const std::vector<double>& GetHitchThresholds() const { return m_thresholdsMs; }
+
+    // ヒッチのフレームの状態を文字列で書く関数（フレーム番号・シーン名・カウンタなど）
+    void SetContextProvider(std::function<void(std::string&)> provider) { m_contextProvider = std::move(provider); }
+
+    // Reset 直後の何フレームを数えないか（起動直後の読み込みを除く。既定 1）
+    void SetWarmupFrames(uint32_t frames) { m_warmupFrames = frames; }
+
+    // 1 フレームの所要時間を入れる（UpdateTime から呼ぶ）
+    void AddFrame(double seconds);
+    void Reset();
+
+    const FrameTimeHistogram& GetHistogram() const { return m_histogram; }
+    uint64_t GetHitchCount(size_t thresholdIndex) const;
+    const std::vector<HitchRecord>& GetHitches() const { return m_hitches; }
+
+    void WriteSummary(FILE* fp) const;
+    bool WriteSummary(const char* path) const;
+
+private:
+    FrameTimeHistogram m_histogram;
+    std::vector<double> m_thresholdsMs;
+    std::vector<uint64_t> m_hitchCounts;
+    std::vector<HitchRecord> m_hitches;
+    std::function<void(std::string&)> m_contextProvider;
+    uint32_t m_warmupFrames = 1;
+    uint64_t m_frame = 0;
+    double m_totalSeconds = 0.0;
+    uint64_t m_frameStartTicks = 0; // Profiler::Now()。このフレームで終わった区間を探す起点
+};
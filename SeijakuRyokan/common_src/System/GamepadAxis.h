@@ -0,0 +1,42 @@
+﻿/*****************************************************************//**
+ * @file   GamepadAxis.h
+ * @brief  スティック・トリガーの生値を -1〜1 / 0〜1 に直す（デッドゾーン付き）
+ *
+ * @details
+ * - XInputGamepad が毎ポーリングで使う。Windows ヘッダに依存しないよう共通側に置き、
+ *   Linux のベンチからも同じ実装を測れるようにしている
+ * - デッドゾーンの外側を 0 から測り直すので、倒し始めでも値が跳ばない
+ *********************************************************************/
+#pragma once
+#include <algorithm>
+#include <cstdlib>
+
+namespace GamepadAxis
+{
+    // short（-32768〜32767）のスティック値 → -1〜1
+    inline float NormalizeThumb(short v, short deadzone)
+    {
+        const int iv = static_cast<int>(v);
+        const int dz = (std::max<int>)(0, deadzone);
+        const int mag = std::abs(iv);
+        if (mag <= dz) {
+            return 0.0f;
+        }
+        const float sign = (iv < 0) ? -1.0f : 1.0f;
+        const float range = 32767.0f - dz;
+        const float n = static_cast<float>(mag - dz) / range;
+        return sign * (std::clamp)(n, 0.0f, 1.0f);
+    }
+
+    // 0〜255 のトリガー値 → 0〜1
+    inline float NormalizeTrigger(unsigned char v, unsigned char deadzone)
+    {
+        const int iv = static_cast<int>(v);
+        const int dz = static_cast<int>(deadzone);
+        if (iv <= dz) {
+            return 0.0f;
+        }
+        const float n = static_cast<float>(iv - dz) / static_cast<float>(255 - dz);
+        return (std::clamp)(n, 0.0f, 1.0f);
+    }
+}
@@ -0,0 +1,117 @@
+﻿/*****************************************************************//**
+ * @file   MappedFile.cpp
+ * @brief  読み取り専用のファイルマッピング実装
+ *********************************************************************/
+#include "MappedFile.h"
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const char* path)
+{
+    Close();
+
+#if defined(_WIN32)
+    const int wideSize = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+    if (wideSize <= 0) {
+        return false;
+    }
+    std::vector<wchar_t> widePath(wideSize);
+    MultiByteToWideChar(CP_UTF8, 0, path, -1, widePath.data(), wideSize);
+
+    HANDLE file = CreateFileW(widePath.data(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = static_cast<size_t>(size.QuadPart);
+    return true;
+#elif defined(__unix__) || defined(__APPLE__)
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // マップはファイルを閉じても残る
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    m_mapped = true;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = static_cast<size_t>(st.st_size);
+    return true;
+#else
+    FILE* fp = std::fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    std::fseek(fp, 0, SEEK_END);
+    const long size = std::ftell(fp);
+    std::fseek(fp, 0, SEEK_SET);
+    if (size <= 0) {
+        std::fclose(fp);
+        return false;
+    }
+    m_buffer.resize(static_cast<size_t>(size));
+    const size_t read = std::fread(m_buffer.data(), 1, m_buffer.size(), fp);
+    std::fclose(fp);
+    if (read != m_buffer.size()) {
+        m_buffer.clear();
+        return false;
+    }
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+#endif
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file) CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = nullptr;
+#elif defined(__unix__) || defined(__APPLE__)
+    if (m_mapped) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_mapped = false;
+    }
+#endif
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,41 @@
+﻿/*****************************************************************//**
+ * @file   MappedFile.h
+ * @brief  読み取り専用のファイルマッピング
+ *
+ * @details
+ * - Windows は CreateFileMapping、Linux 等は mmap で丸ごとマップする
+ * - どちらも無い環境では全体をメモリに読み込んで同じように扱う
+ *********************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path);
+    void Close();
+
+    const uint8_t* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+    bool IsOpen() const { return m_data != nullptr; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+
+#if defined(_WIN32)
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#elif defined(__unix__) || defined(__APPLE__)
+    bool m_mapped = false;
+#endif
+    std::vector<uint8_t> m_buffer; // マップできない場合の読み込み先
+};
@@ -0,0 +1,422 @@
+﻿/*****************************************************************//**
+ * @file   MemoryTracker.cpp
+ * @brief  サブシステム別メモリ計測の実装（operator new / delete の置き換えを含む）
+ *********************************************************************/
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+    const char* const TAG_NAMES[MemoryTracker::TAG_COUNT] = {
+        "untagged",
+        "graphics",
+        "texture",
+        "font",
+        "map",
+        "guest",
+        "audio",
+        "ui",
+        "system",
+    };
+
+    constexpr size_t LEAK_LIST_MAX = 32; // DumpLeaks で 1 件ずつ書く数（大きい順）
+
+    struct AtomicTagStats
+    {
+        std::atomic<int64_t> liveBytes{ 0 };
+        std::atomic<int64_t> liveCount{ 0 };
+        std::atomic<int64_t> highWaterBytes{ 0 };
+        std::atomic<uint64_t> totalBytes{ 0 };
+        std::atomic<uint64_t> totalCount{ 0 };
+    };
+
+    AtomicTagStats g_stats[MemoryTracker::TAG_COUNT];
+    std::atomic<uint64_t> g_serial{ 0 };
+    thread_local MemoryTag t_tag = MemoryTag::Untagged;
+
+    size_t TagIndex(MemoryTag tag)
+    {
+        const size_t index = static_cast<size_t>(tag);
+        return index < MemoryTracker::TAG_COUNT ? index : 0;
+    }
+
+    // --- new を通らない確保 ---
+    struct External
+    {
+        MemoryTag tag;
+        size_t bytes;
+        uint64_t serial;
+    };
+
+    // 表そのものは malloc から取り、リーク一覧に計測側の確保が混ざらないようにする
+    template <typename T>
+    struct RawAllocator
+    {
+        using value_type = T;
+
+        RawAllocator() = default;
+        template <typename U>
+        RawAllocator(const RawAllocator<U>&) noexcept {}
+
+        T* allocate(size_t count)
+        {
+            if (void* p = std::malloc(count * sizeof(T))) {
+                return static_cast<T*>(p);
+            }
+            throw std::bad_alloc();
+        }
+        void deallocate(T* p, size_t) noexcept { std::free(p); }
+
+        template <typename U>
+        bool operator==(const RawAllocator<U>&) const noexcept { return true; }
+        template <typename U>
+        bool operator!=(const RawAllocator<U>&) const noexcept { return false; }
+    };
+
+    struct ExternalRegistry
+    {
+        std::mutex mutex;
+        std::unordered_map<const void*, External, std::hash<const void*>, std::equal_to<const void*>,
+            RawAllocator<std::pair<const void* const, External>>> entries;
+    };
+
+    ExternalRegistry& GetExternals()
+    {
+        static ExternalRegistry registry;
+        return registry;
+    }
+
+    // --- レート計算用（前回の WriteReport の時点） ---
+    std::mutex g_reportMutex;
+    bool g_hasLastReport = false;
+    std::chrono::steady_clock::time_point g_lastReportTime;
+    uint64_t g_lastTotalBytes[MemoryTracker::TAG_COUNT] = {};
+    uint64_t g_lastTotalCount[MemoryTracker::TAG_COUNT] = {};
+
+    struct LeakEntry
+    {
+        size_t bytes;
+        MemoryTag tag;
+        uint64_t serial;
+        bool external;
+    };
+
+    // 大きい順に LEAK_LIST_MAX 件だけ残す（確保しないよう固定長）
+    struct LeakCollector
+    {
+        LeakEntry largest[LEAK_LIST_MAX];
+        size_t largestCount = 0;
+        size_t count[MemoryTracker::TAG_COUNT] = {};
+        size_t bytes[MemoryTracker::TAG_COUNT] = {};
+
+        void Add(const LeakEntry& e)
+        {
+            const size_t index = TagIndex(e.tag);
+            ++count[index];
+            bytes[index] += e.bytes;
+            if (largestCount < LEAK_LIST_MAX) {
+                largest[largestCount++] = e;
+                return;
+            }
+            LeakEntry* smallest = std::min_element(largest, largest + largestCount,
+                [](const LeakEntry& a, const LeakEntry& b) { return a.bytes < b.bytes; });
+            if (smallest->bytes < e.bytes) {
+                *smallest = e;
+            }
+        }
+    };
+}
+
+#if SEIJAKU_MEMORY_TRACKING
+namespace
+{
+    // 確保ごとに前に付ける管理領域（生きている確保を双方向リストでつなぐ）
+    struct alignas(alignof(std::max_align_t)) AllocHeader
+    {
+        AllocHeader* prev;
+        AllocHeader* next;
+        size_t size;
+        uint64_t serialAndTag; // 上位 56 ビットが通し番号、下位 8 ビットがタグ
+    };
+
+    AllocHeader g_liveHead = { &g_liveHead, &g_liveHead, 0, 0 };
+
+    // operator new は静的初期化の途中からも呼ばれるので、定数初期化できるスピンロックで守る
+    std::atomic<bool> g_liveLock{ false };
+
+    struct LiveListLock
+    {
+        LiveListLock()
+        {
+            while (g_liveLock.exchange(true, std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+        ~LiveListLock()
+        {
+            g_liveLock.store(false, std::memory_order_release);
+        }
+    };
+
+    void* TrackedAllocate(size_t size)
+    {
+        AllocHeader* header = static_cast<AllocHeader*>(std::malloc(sizeof(AllocHeader) + size));
+        if (!header) {
+            return nullptr;
+        }
+        const MemoryTag tag = t_tag;
+        const uint64_t serial = g_serial.fetch_add(1, std::memory_order_relaxed) + 1;
+        header->size = size;
+        header->serialAndTag = (serial << 8) | static_cast<uint64_t>(tag);
+        {
+            LiveListLock lock;
+            header->prev = &g_liveHead;
+            header->next = g_liveHead.next;
+            g_liveHead.next->prev = header;
+            g_liveHead.next = header;
+        }
+        MemoryTracker::OnAllocate(tag, size);
+        return header + 1;
+    }
+
+    void TrackedFree(void* p)
+    {
+        if (!p) {
+            return;
+        }
+        AllocHeader* header = static_cast<AllocHeader*>(p) - 1;
+        {
+            LiveListLock lock;
+            header->prev->next = header->next;
+            header->next->prev = header->prev;
+        }
+        MemoryTracker::OnFree(static_cast<MemoryTag>(header->serialAndTag & 0xFF), header->size);
+        std::free(header);
+    }
+}
+
+void* operator new(size_t size)
+{
+    if (void* p = TrackedAllocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return TrackedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return TrackedAllocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    TrackedFree(p);
+}
+#endif
+
+MemoryTag MemoryTracker::GetCurrentTag()
+{
+    return t_tag;
+}
+
+void MemoryTracker::SetCurrentTag(MemoryTag tag)
+{
+    t_tag = tag;
+}
+
+void MemoryTracker::OnAllocate(MemoryTag tag, size_t bytes)
+{
+    AtomicTagStats& s = g_stats[TagIndex(tag)];
+    const int64_t live = s.liveBytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+    s.liveCount.fetch_add(1, std::memory_order_relaxed);
+    s.totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+    s.totalCount.fetch_add(1, std::memory_order_relaxed);
+
+    int64_t high = s.highWaterBytes.load(std::memory_order_relaxed);
+    while (live > high && !s.highWaterBytes.compare_exchange_weak(high, live, std::memory_order_relaxed)) {
+    }
+}
+
+void MemoryTracker::OnFree(MemoryTag tag, size_t bytes)
+{
+    AtomicTagStats& s = g_stats[TagIndex(tag)];
+    s.liveBytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    s.liveCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void MemoryTracker::TrackExternal(const void* key, MemoryTag tag, size_t bytes)
+{
+    if (!key) {
+        return;
+    }
+    const uint64_t serial = g_serial.fetch_add(1, std::memory_order_relaxed) + 1;
+    ExternalRegistry& registry = GetExternals();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto result = registry.entries.emplace(key, External{ tag, bytes, serial });
+        if (!result.second) {
+            // 同じキーの付け直し（前の分を外してから数える）
+            OnFree(result.first->second.tag, result.first->second.bytes);
+            result.first->second = External{ tag, bytes, serial };
+        }
+    }
+    OnAllocate(tag, bytes);
+}
+
+void MemoryTracker::UntrackExternal(const void* key)
+{
+    if (!key) {
+        return;
+    }
+    ExternalRegistry& registry = GetExternals();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto found = registry.entries.find(key);
+    if (found == registry.entries.end()) {
+        return;
+    }
+    OnFree(found->second.tag, found->second.bytes);
+    registry.entries.erase(found);
+}
+
+MemoryTracker::TagStats MemoryTracker::GetStats(MemoryTag tag)
+{
+    const AtomicTagStats& s = g_stats[TagIndex(tag)];
+    TagStats result;
+    result.liveBytes = s.liveBytes.load(std::memory_order_relaxed);
+    result.liveCount = s.liveCount.load(std::memory_order_relaxed);
+    result.highWaterBytes = s.highWaterBytes.load(std::memory_order_relaxed);
+    result.totalBytes = s.totalBytes.load(std::memory_order_relaxed);
+    result.totalCount = s.totalCount.load(std::memory_order_relaxed);
+    return result;
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag)
+{
+    return TAG_NAMES[TagIndex(tag)];
+}
+
+uint64_t MemoryTracker::GetSerial()
+{
+    return g_serial.load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::WriteReport(FILE* fp)
+{
+    std::lock_guard<std::mutex> lock(g_reportMutex);
+    const auto now = std::chrono::steady_clock::now();
+    const double seconds = g_hasLastReport
+        ? std::chrono::duration<double>(now - g_lastReportTime).count()
+        : 0.0;
+
+    std::fprintf(fp, "%-10s %12s %10s %12s %14s %12s\n",
+        "tag", "live KB", "live #", "peak KB", "alloc KB/s", "alloc #/s");
+    TagStats sum;
+    for (size_t i = 0; i < TAG_COUNT; ++i) {
+        const TagStats s = GetStats(static_cast<MemoryTag>(i));
+        const double bytesRate = seconds > 0.0 ? (s.totalBytes - g_lastTotalBytes[i]) / seconds : 0.0;
+        const double countRate = seconds > 0.0 ? (s.totalCount - g_lastTotalCount[i]) / seconds : 0.0;
+        g_lastTotalBytes[i] = s.totalBytes;
+        g_lastTotalCount[i] = s.totalCount;
+        if (s.totalCount == 0) {
+            continue;
+        }
+        std::fprintf(fp, "%-10s %12.1f %10lld %12.1f %14.1f %12.1f\n",
+            TAG_NAMES[i], s.liveBytes / 1024.0, static_cast<long long>(s.liveCount),
+            s.highWaterBytes / 1024.0, bytesRate / 1024.0, countRate);
+        sum.liveBytes += s.liveBytes;
+        sum.liveCount += s.liveCount;
+    }
+    std::fprintf(fp, "%-10s %12.1f %10lld\n", "total", sum.liveBytes / 1024.0, static_cast<long long>(sum.liveCount));
+    if (!IsEnabled()) {
+        std::fprintf(fp, "(operator new is not tracked: build with SEIJAKU_MEMORY_TRACKING=1; only external allocations are counted)\n");
+    }
+
+    g_lastReportTime = now;
+    g_hasLastReport = true;
+}
+
+size_t MemoryTracker::DumpLeaks(FILE* fp, uint64_t sinceSerial)
+{
+    LeakCollector leaks;
+#if SEIJAKU_MEMORY_TRACKING
+    {
+        LiveListLock lock;
+        for (const AllocHeader* h = g_liveHead.next; h != &g_liveHead; h = h->next) {
+            const uint64_t serial = h->serialAndTag >> 8;
+            if (serial > sinceSerial) {
+                leaks.Add({ h->size, static_cast<MemoryTag>(h->serialAndTag & 0xFF), serial, false });
+            }
+        }
+    }
+#endif
+    {
+        ExternalRegistry& registry = GetExternals();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& entry : registry.entries) {
+            if (entry.second.serial > sinceSerial) {
+                leaks.Add({ entry.second.bytes, entry.second.tag, entry.second.serial, true });
+            }
+        }
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < TAG_COUNT; ++i) {
+        total += leaks.count[i];
+    }
+    std::fprintf(fp, "leaks since #%llu: %zu\n", static_cast<unsigned long long>(sinceSerial), total);
+    for (size_t i = 0; i < TAG_COUNT; ++i) {
+        if (leaks.count[i]) {
+            std::fprintf(fp, "  %-10s %8zu allocation(s) %12zu bytes\n", TAG_NAMES[i], leaks.count[i], leaks.bytes[i]);
+        }
+    }
+    std::sort(leaks.largest, leaks.largest + leaks.largestCount,
+        [](const LeakEntry& a, const LeakEntry& b) { return a.bytes > b.bytes; });
+    for (size_t i = 0; i < leaks.largestCount; ++i) {
+        const LeakEntry& e = leaks.largest[i];
+        std::fprintf(fp, "    #%-10llu %10zu bytes  %s%s\n", static_cast<unsigned long long>(e.serial), e.bytes,
+            TAG_NAMES[TagIndex(e.tag)], e.external ? " (external)" : "");
+    }
+    return total;
+}
@@ -0,0 +1,144 @@
+﻿/*****************************************************************//**
+ * @file   MemoryTracker.h
+ * @brief  サブシステム別のメモリ使用量（現在量・最大・確保レート）とリークの書き出し
+ *
+ * @details
+ * - 確保は「今のタグ」に付く。MemoryTagScope で囲んだ範囲の new はそのタグで数える
+ *   （タグはスレッドごと。囲んでいない確保は Untagged）。
+ *   コンテナは TaggedAllocator を使えば、どこで伸びても同じタグになる
+ * - operator new / delete の置き換えは SEIJAKU_MEMORY_TRACKING が 1 のときだけ
+ *   （_DEBUG では既定で 1。ヘッドレスは -DSEIJAKU_MEMORY_TRACKING=1 で有効にする）。
+ *   有効時は 1 確保ごとに 32 バイトの管理領域を前に付け、生きている確保を連結リストで持つ
+ * - GPU のテクスチャなど new を通らないものは TrackExternal / UntrackExternal で数える
+ *   （PC は CreateTexture で幅 × 高さ × bpp（ミップ込み）を数える。
+ *   ヘッドレスの SoftwareGraphics はピクセル配列が Texture タグの new で数えられる）
+ * - GetSerial で印を付け、終了処理の後に DumpLeaks(印) を呼ぶと、
+ *   印より後に確保されてまだ生きているものをタグ別に書き出す
+ * - WriteReport はタグごとの現在量・最大・前回の WriteReport からの確保レートを書く。
+ *   2 時間のセッションで増え続けるタグがないかを見るため
+ * - alignas で過剰にアラインされた型の new（align_val_t 版）は数えない
+ *********************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+
+#ifndef SEIJAKU_MEMORY_TRACKING
+#if defined(_DEBUG)
+#define SEIJAKU_MEMORY_TRACKING 1
+#else
+#define SEIJAKU_MEMORY_TRACKING 0
+#endif
+#endif
+
+enum class MemoryTag : uint8_t
+{
+    Untagged,
+    Graphics, // 描画の管理データ（RenderList・コマンドバッファ・シェーダなど）
+    Texture,  // テクスチャ（GPU 側は TrackExternal で数える）
+    Font,     // グリフテーブル・テキストのレイアウト
+    Map,
+    Guest,
+    Audio,
+    UI,
+    System,   // プロファイラ・カウンタ・アリーナなどの計測・基盤
+
+    Count
+};
+
+namespace MemoryTracker
+{
+    constexpr size_t TAG_COUNT = static_cast<size_t>(MemoryTag::Count);
+
+    struct TagStats
+    {
+        int64_t liveBytes = 0;
+        int64_t liveCount = 0;
+        int64_t highWaterBytes = 0;
+        uint64_t totalBytes = 0; // これまでに確保した合計（レートの計算用）
+        uint64_t totalCount = 0;
+    };
+
+    // operator new の置き換えが入っているか
+    constexpr bool IsEnabled() { return SEIJAKU_MEMORY_TRACKING != 0; }
+
+    MemoryTag GetCurrentTag();
+    void SetCurrentTag(MemoryTag tag);
+
+    // new を通らない確保（GPU リソースなど）。key は解放時に同じものを渡す
+    void TrackExternal(const void* key, MemoryTag tag, size_t bytes);
+    void UntrackExternal(const void* key);
+
+    TagStats GetStats(MemoryTag tag);
+    const char* GetTagName(MemoryTag tag);
+
+    // 確保の通し番号（DumpLeaks の印に使う）
+    uint64_t GetSerial();
+
+    // タグ別の表（現在量・最大・確保レート）
+    void WriteReport(FILE* fp);
+
+    // sinceSerial 以降に確保され、まだ解放されていないものを書き出す。戻り値は件数
+    size_t DumpLeaks(FILE* fp, uint64_t sinceSerial);
+
+    // operator new / delete から呼ばれる
+    void OnAllocate(MemoryTag tag, size_t bytes);
+    void OnFree(MemoryTag tag, size_t bytes);
+}
+
+// スコープの間、このスレッドの確保に tag を付ける
+class MemoryTagScope
+{
+public:
+    explicit MemoryTagScope(MemoryTag tag)
+        : m_previous(MemoryTracker::GetCurrentTag())
+    {
+        MemoryTracker::SetCurrentTag(tag);
+    }
+
+    ~MemoryTagScope()
+    {
+        MemoryTracker::SetCurrentTag(m_previous);
+    }
+
+    MemoryTagScope(const MemoryTagScope&) = delete;
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+private:
+    MemoryTag m_previous;
+};
+
+// 確保のたびに Tag を付ける STL アロケータ（std::vector<T, TaggedAllocator<T, MemoryTag::Map>> など）
+template <typename T, MemoryTag Tag>
+class TaggedAllocator
+{
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = TaggedAllocator<U, Tag>;
+    };
+
+    TaggedAllocator() noexcept = default;
+    template <typename U>
+    TaggedAllocator(const TaggedAllocator<U, Tag>&) noexcept {}
+
+    T* allocate(size_t count)
+    {
+        MemoryTagScope scope(Tag);
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept
+    {
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const TaggedAllocator<U, Tag>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const TaggedAllocator<U, Tag>&) const noexcept { return false; }
+};
@@ -0,0 +1,377 @@
+﻿/*****************************************************************//**
+ * @file   NavGrid.cpp
+ * @brief  通行可否グリッドと A* 探索の実装
+ *********************************************************************/
+#include "NavGrid.h"
+#include <algorithm>
+
+const int NavGrid::DX[NavGrid::DIRECTION_COUNT] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+const int NavGrid::DY[NavGrid::DIRECTION_COUNT] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+void NavGrid::Resize(int width, int height, bool walkable)
+{
+    m_width = (std::max)(width, 0);
+    m_height = (std::max)(height, 0);
+    m_cells.assign(static_cast<size_t>(m_width) * m_height, walkable ? 1 : 0);
+    ++m_revision;
+}
+
+void NavGrid::SetWalkable(int x, int y, bool walkable)
+{
+    if (!InBounds(x, y)) {
+        return;
+    }
+    uint8_t& cell = m_cells[ToIndex(x, y)];
+    const uint8_t value = walkable ? 1 : 0;
+    if (cell != value) {
+        cell = value;
+        ++m_revision;
+    }
+}
+
+void NavGrid::FillRect(int x, int y, int width, int height, bool walkable)
+{
+    for (int cy = y; cy < y + height; ++cy) {
+        for (int cx = x; cx < x + width; ++cx) {
+            SetWalkable(cx, cy, walkable);
+        }
+    }
+}
+
+bool NavGrid::HasLineOfSight(const GridPoint& a, const GridPoint& b) const
+{
+    int x = a.x;
+    int y = a.y;
+    const int dx = std::abs(b.x - a.x);
+    const int dy = -std::abs(b.y - a.y);
+    const int sx = a.x < b.x ? 1 : -1;
+    const int sy = a.y < b.y ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        if (!IsWalkable(x, y)) {
+            return false;
+        }
+        if (x == b.x && y == b.y) {
+            return true;
+        }
+        const int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+}
+
+// ==============================
+// GridAStar
+// ==============================
+namespace
+{
+    template <typename Entry>
+    struct OpenGreater
+    {
+        // f が小さい順、同じなら goal に近い（h が小さい）順
+        bool operator()(const Entry& a, const Entry& b) const
+        {
+            return a.f != b.f ? a.f > b.f : a.h > b.h;
+        }
+    };
+}
+
+void GridAStar::Prepare(int cellCount)
+{
+    if (static_cast<int>(m_g.size()) != cellCount) {
+        m_g.assign(cellCount, 0);
+        m_parent.assign(cellCount, -1);
+        m_visited.assign(cellCount, 0);
+        m_closed.assign(cellCount, 0);
+        m_generation = 0;
+    }
+    if (++m_generation == 0) {
+        // 一周したら印を消し直す
+        std::fill(m_visited.begin(), m_visited.end(), 0);
+        std::fill(m_closed.begin(), m_closed.end(), 0);
+        m_generation = 1;
+    }
+    m_open.clear();
+    m_stats = NavSearchStats{};
+}
+
+void GridAStar::Push(int index, int parent, int g, const GridPoint& p, const GridPoint& goal)
+{
+    if (m_closed[index] == m_generation) {
+        return;
+    }
+    if (m_visited[index] == m_generation && g >= m_g[index]) {
+        return;
+    }
+    m_visited[index] = m_generation;
+    m_g[index] = g;
+    m_parent[index] = parent;
+    const int h = NavGrid::Octile(p, goal);
+    m_open.push_back(OpenEntry{ g + h, h, index });
+    std::push_heap(m_open.begin(), m_open.end(), OpenGreater<OpenEntry>());
+    ++m_stats.pushed;
+}
+
+void GridAStar::BuildPath(const NavGrid& grid, int goalIndex, NavPath& out) const
+{
+    out.cost = m_g[goalIndex];
+    GridPoint p = grid.ToPoint(goalIndex);
+    out.points.push_back(p);
+    for (int i = m_parent[goalIndex]; i >= 0; i = m_parent[i]) {
+        // 親との間を 1 マスずつ埋める（A* は隣どうし。JPS は縦横か斜めの一直線）
+        const GridPoint next = grid.ToPoint(i);
+        while (p != next) {
+            p.x += (next.x > p.x) - (next.x < p.x);
+            p.y += (next.y > p.y) - (next.y < p.y);
+            out.points.push_back(p);
+        }
+    }
+    std::reverse(out.points.begin(), out.points.end());
+}
+
+bool GridAStar::FindPath(const NavGrid& grid, GridPoint start, GridPoint goal, NavPath& out)
+{
+    Begin(grid, start, goal);
+    return Resume(UINT32_MAX, out) == NavSearchStatus::Found;
+}
+
+void GridAStar::Begin(const NavGrid& grid, GridPoint start, GridPoint goal)
+{
+    Prepare(grid.GetCellCount());
+    m_searchGrid = &grid;
+    m_searchGoal = goal;
+    m_goalIndex = -1;
+    if (!grid.IsWalkable(start) || !grid.IsWalkable(goal)) {
+        m_status = NavSearchStatus::NotFound;
+        return;
+    }
+    if (m_mode == NavSearchMode::JumpPoint) {
+        PrepareJumpTable(grid);
+    }
+    m_goalIndex = grid.ToIndex(goal);
+    m_status = NavSearchStatus::Running;
+    Push(grid.ToIndex(start), -1, 0, start, goal);
+}
+
+NavSearchStatus GridAStar::Resume(uint32_t maxExpansions, NavPath& out)
+{
+    if (m_status != NavSearchStatus::Running) {
+        out.Clear();
+        if (m_status == NavSearchStatus::Found) {
+            BuildPath(*m_searchGrid, m_goalIndex, out);
+        }
+        return m_status;
+    }
+
+    const NavGrid& grid = *m_searchGrid;
+    const OpenGreater<OpenEntry> greater;
+    for (uint32_t count = 0; count < maxExpansions;) {
+        if (m_open.empty()) {
+            m_status = NavSearchStatus::NotFound;
+            out.Clear();
+            return m_status;
+        }
+        std::pop_heap(m_open.begin(), m_open.end(), greater);
+        const OpenEntry current = m_open.back();
+        m_open.pop_back();
+        if (m_closed[current.index] == m_generation) {
+            continue; // 古い重複エントリ
+        }
+        m_closed[current.index] = m_generation;
+        ++m_stats.expanded;
+        ++count;
+
+        if (current.index == m_goalIndex) {
+            m_status = NavSearchStatus::Found;
+            out.Clear();
+            BuildPath(grid, m_goalIndex, out);
+            return m_status;
+        }
+        if (m_mode == NavSearchMode::JumpPoint) {
+            ExpandJump(grid, current.index);
+        }
+        else {
+            ExpandNeighbors(grid, current.index);
+        }
+    }
+    return m_status;
+}
+
+void GridAStar::ExpandNeighbors(const NavGrid& grid, int index)
+{
+    const GridPoint p = grid.ToPoint(index);
+    const int g = m_g[index];
+    for (int d = 0; d < NavGrid::DIRECTION_COUNT; ++d) {
+        if (!grid.CanStep(p.x, p.y, d)) {
+            continue;
+        }
+        const GridPoint n{ p.x + NavGrid::DX[d], p.y + NavGrid::DY[d] };
+        Push(grid.ToIndex(n), index, g + NavGrid::StepCost(d), n, m_searchGoal);
+    }
+}
+
+// ==============================
+// Jump Point Search
+// ==============================
+namespace
+{
+    // ジャンプ表の縦横 4 方向（NavGrid::DX / DY の先頭 4 つと同じ順）
+    constexpr int STRAIGHT_COUNT = 4;
+
+    int StraightIndex(int dx, int dy)
+    {
+        return dx > 0 ? 0 : dx < 0 ? 1 : dy > 0 ? 2 : 3;
+    }
+
+    // (x, y) に (dx, dy) 方向から入ったとき、曲がる必要があるか（強制隣接）
+    // 角を切らない移動では、真横が空きでその一つ後ろが壁のときに限られる
+    bool HasForcedNeighbor(const NavGrid& grid, int x, int y, int dx, int dy)
+    {
+        if (dx != 0) {
+            return (grid.IsWalkable(x, y - 1) && !grid.IsWalkable(x - dx, y - 1))
+                || (grid.IsWalkable(x, y + 1) && !grid.IsWalkable(x - dx, y + 1));
+        }
+        return (grid.IsWalkable(x - 1, y) && !grid.IsWalkable(x - 1, y - dy))
+            || (grid.IsWalkable(x + 1, y) && !grid.IsWalkable(x + 1, y - dy));
+    }
+
+    int Sign(int value)
+    {
+        return (value > 0) - (value < 0);
+    }
+}
+
+void GridAStar::PrepareJumpTable(const NavGrid& grid)
+{
+    if (m_jumpGrid == &grid && m_jumpRevision == grid.GetRevision()
+        && m_jumpWidth == grid.GetWidth() && m_jumpHeight == grid.GetHeight()) {
+        return;
+    }
+    m_jumpGrid = &grid;
+    m_jumpRevision = grid.GetRevision();
+    m_jumpWidth = grid.GetWidth();
+    m_jumpHeight = grid.GetHeight();
+    m_jumps.assign(static_cast<size_t>(grid.GetCellCount()) * STRAIGHT_COUNT, 0);
+
+    // 進む向きの先にあるセルから順に埋める（1 つ先の値 + 1 で済む）
+    for (int d = 0; d < STRAIGHT_COUNT; ++d) {
+        const int dx = NavGrid::DX[d];
+        const int dy = NavGrid::DY[d];
+        for (int j = 0; j < m_jumpHeight; ++j) {
+            const int y = dy > 0 ? m_jumpHeight - 1 - j : j;
+            for (int i = 0; i < m_jumpWidth; ++i) {
+                const int x = dx > 0 ? m_jumpWidth - 1 - i : i;
+                const int nx = x + dx;
+                const int ny = y + dy;
+                if (!grid.IsWalkable(x, y) || !grid.IsWalkable(nx, ny)) {
+                    continue; // 0 = すぐ先が壁
+                }
+                int16_t value = 1;
+                if (!HasForcedNeighbor(grid, nx, ny, dx, dy)) {
+                    const int16_t next = m_jumps[static_cast<size_t>(grid.ToIndex(nx, ny)) * STRAIGHT_COUNT + d];
+                    value = next > 0 ? static_cast<int16_t>(next + 1) : static_cast<int16_t>(next - 1);
+                }
+                m_jumps[static_cast<size_t>(grid.ToIndex(x, y)) * STRAIGHT_COUNT + d] = value;
+            }
+        }
+    }
+}
+
+int GridAStar::JumpStraight(const NavGrid& grid, int x, int y, int dx, int dy, const GridPoint& goal)
+{
+    ++m_stats.scanned;
+    const int value = m_jumps[static_cast<size_t>(grid.ToIndex(x, y)) * STRAIGHT_COUNT + StraightIndex(dx, dy)];
+    const int reach = value > 0 ? value : -value;
+    // 途中に goal があればそこで止まる
+    const int toGoal = dx != 0 ? (goal.y == y ? (goal.x - x) * dx : -1) : (goal.x == x ? (goal.y - y) * dy : -1);
+    if (toGoal > 0 && toGoal <= reach) {
+        return grid.ToIndex(goal);
+    }
+    return value > 0 ? grid.ToIndex(x + dx * value, y + dy * value) : -1;
+}
+
+int GridAStar::JumpDiagonal(const NavGrid& grid, int x, int y, int dx, int dy, const GridPoint& goal)
+{
+    // 角を切らないので、斜めの移動そのものには強制隣接が出ない。
+    // 一歩ごとに縦横の成分へジャンプして、何か見つかればそこで止まる
+    for (;;) {
+        if (!grid.IsWalkable(x + dx, y + dy) || !grid.IsWalkable(x + dx, y) || !grid.IsWalkable(x, y + dy)) {
+            return -1;
+        }
+        x += dx;
+        y += dy;
+        ++m_stats.scanned;
+        if (x == goal.x && y == goal.y) {
+            return grid.ToIndex(x, y);
+        }
+        if (JumpStraight(grid, x, y, dx, 0, goal) >= 0 || JumpStraight(grid, x, y, 0, dy, goal) >= 0) {
+            return grid.ToIndex(x, y);
+        }
+    }
+}
+
+void GridAStar::ExpandJump(const NavGrid& grid, int index)
+{
+    const GridPoint& goal = m_searchGoal;
+    const GridPoint p = grid.ToPoint(index);
+    const int g = m_g[index];
+
+    // 親から来た向きで、調べる方向を絞る（start は 8 方向すべて）
+    int dirX[NavGrid::DIRECTION_COUNT];
+    int dirY[NavGrid::DIRECTION_COUNT];
+    int dirCount = 0;
+    const auto add = [&](int dx, int dy) {
+        dirX[dirCount] = dx;
+        dirY[dirCount] = dy;
+        ++dirCount;
+    };
+    const int parent = m_parent[index];
+    if (parent < 0) {
+        for (int d = 0; d < NavGrid::DIRECTION_COUNT; ++d) {
+            add(NavGrid::DX[d], NavGrid::DY[d]);
+        }
+    }
+    else {
+        const GridPoint from = grid.ToPoint(parent);
+        const int dx = Sign(p.x - from.x);
+        const int dy = Sign(p.y - from.y);
+        if (dx != 0 && dy != 0) {
+            add(dx, 0);
+            add(0, dy);
+            add(dx, dy);
+        }
+        else if (dx != 0) {
+            add(dx, 0);
+            for (int s = -1; s <= 1; s += 2) {
+                if (grid.IsWalkable(p.x, p.y + s) && !grid.IsWalkable(p.x - dx, p.y + s)) {
+                    add(0, s);
+                    add(dx, s);
+                }
+            }
+        }
+        else {
+            add(0, dy);
+            for (int s = -1; s <= 1; s += 2) {
+                if (grid.IsWalkable(p.x + s, p.y) && !grid.IsWalkable(p.x + s, p.y - dy)) {
+                    add(s, 0);
+                    add(s, dy);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < dirCount; ++i) {
+        const int jp = dirX[i] != 0 && dirY[i] != 0
+            ? JumpDiagonal(grid, p.x, p.y, dirX[i], dirY[i], goal)
+            : JumpStraight(grid, p.x, p.y, dirX[i], dirY[i], goal);
+        if (jp >= 0) {
+            const GridPoint n = grid.ToPoint(jp);
+            Push(jp, index, g + NavGrid::Octile(p, n), n, goal);
+        }
+    }
+}
@@ -0,0 +1,195 @@
+﻿/*****************************************************************//**
+ * @file   NavGrid.h
+ * @brief  タイル単位の通行可否グリッドと、その上の A* / Jump Point Search 探索
+ *
+ * @details
+ * - 8 方向移動。縦横のコスト 10・斜め 14（整数にしておき、探索方式が違っても
+ *   経路コストを == で比べられるようにする）
+ * - 斜めは両脇の縦横どちらも通れるときだけ（壁の角を切らない）
+ * - SetWalkable のたびにリビジョンが進む。経路や派生データのキャッシュはこれで古さを判定する
+ * - GridAStar は作業領域を使い回す（世代番号で初期化を省く）ので、1 インスタンスを
+ *   同じスレッドで何度も呼ぶ使い方を想定している
+ * - NavSearchMode::JumpPoint は JPS（Harabor & Grastien の角を切らない版）。
+ *   直線・斜めにまっすぐ飛んで、曲がる必要がある点（ジャンプポイント）だけを open list に積む。
+ *   広い廊下や大部屋をセル単位で展開しなくて済む。経路コストは A* と同じ最短になる
+ *   （同コストの別経路を選ぶことはある）
+ * - 縦横のジャンプは JPS+ と同じく前計算した表（セルごと 4 方向の、次のジャンプポイントか壁までの距離）を
+ *   引くだけにしている。表はインスタンスごとに持ち、グリッドのリビジョンが変わった次の探索で作り直す
+ *   （マップの幅・高さは 32767 まで）
+ * - Begin / Resume で探索を途中で止めて、次の呼び出しで続きから進められる（1 tick の持ち時間に合わせて刻む用）。
+ *   止めている間はグリッドを書き換えないこと。結果は FindPath で一度に解いた場合と同じ
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+struct GridPoint
+{
+    int x = 0;
+    int y = 0;
+
+    bool operator==(const GridPoint& other) const { return x == other.x && y == other.y; }
+    bool operator!=(const GridPoint& other) const { return !(*this == other); }
+};
+
+class NavGrid
+{
+public:
+    static constexpr int STRAIGHT_COST = 10;
+    static constexpr int DIAGONAL_COST = 14;
+
+    // 8 方向（縦横 4 つ → 斜め 4 つの順）
+    static constexpr int DIRECTION_COUNT = 8;
+    static const int DX[DIRECTION_COUNT];
+    static const int DY[DIRECTION_COUNT];
+
+    NavGrid() = default;
+    NavGrid(int width, int height, bool walkable = false) { Resize(width, height, walkable); }
+
+    void Resize(int width, int height, bool walkable);
+
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetCellCount() const { return m_width * m_height; }
+
+    bool InBounds(int x, int y) const { return x >= 0 && y >= 0 && x < m_width && y < m_height; }
+    bool IsWalkable(int x, int y) const { return InBounds(x, y) && m_cells[ToIndex(x, y)] != 0; }
+    bool IsWalkable(const GridPoint& p) const { return IsWalkable(p.x, p.y); }
+
+    // 値が変わったときだけリビジョンを進める
+    void SetWalkable(int x, int y, bool walkable);
+    void FillRect(int x, int y, int width, int height, bool walkable);
+
+    uint32_t GetRevision() const { return m_revision; }
+
+    int ToIndex(int x, int y) const { return y * m_width + x; }
+    int ToIndex(const GridPoint& p) const { return ToIndex(p.x, p.y); }
+    GridPoint ToPoint(int index) const { return GridPoint{ index % m_width, index / m_width }; }
+
+    // (x, y) から direction 方向へ 1 歩進めるか（斜めは角を切らない）
+    bool CanStep(int x, int y, int direction) const
+    {
+        const int dx = DX[direction];
+        const int dy = DY[direction];
+        if (!IsWalkable(x + dx, y + dy)) {
+            return false;
+        }
+        return dx == 0 || dy == 0 || (IsWalkable(x + dx, y) && IsWalkable(x, y + dy));
+    }
+
+    static int StepCost(int direction) { return direction < 4 ? STRAIGHT_COST : DIAGONAL_COST; }
+
+    // 8 方向移動での最短距離（障害物なし）。A* の許容ヒューリスティック
+    static int Octile(const GridPoint& a, const GridPoint& b)
+    {
+        const int dx = std::abs(a.x - b.x);
+        const int dy = std::abs(a.y - b.y);
+        const int diagonal = dx < dy ? dx : dy;
+        return STRAIGHT_COST * (dx + dy) + (DIAGONAL_COST - 2 * STRAIGHT_COST) * diagonal;
+    }
+
+    // a から b への視線が壁に遮られないか（Bresenham で通るセルがすべて通行可能）
+    bool HasLineOfSight(const GridPoint& a, const GridPoint& b) const;
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<uint8_t> m_cells; // 0 = 壁、1 = 通行可
+    uint32_t m_revision = 0;
+};
+
+struct NavPath
+{
+    std::vector<GridPoint> points; // start〜goal（両端を含む）
+    int cost = 0;
+
+    void Clear()
+    {
+        points.clear();
+        cost = 0;
+    }
+    bool IsEmpty() const { return points.empty(); }
+};
+
+struct NavSearchStats
+{
+    uint32_t expanded = 0; // open list から取り出したノード数
+    uint32_t pushed = 0;   // open list に積んだ回数
+    uint32_t scanned = 0;  // JumpPoint のとき、斜めに進んだセル数＋縦横のジャンプ表を引いた回数（AStar では 0）
+};
+
+enum class NavSearchMode
+{
+    AStar,     // 8 近傍をすべて展開する
+    JumpPoint, // JPS。ジャンプポイントだけを展開する
+};
+
+enum class NavSearchStatus
+{
+    Running,  // 途中（Resume で続ける）
+    Found,
+    NotFound,
+};
+
+class GridAStar
+{
+public:
+    explicit GridAStar(NavSearchMode mode = NavSearchMode::AStar) : m_mode(mode) {}
+
+    void SetMode(NavSearchMode mode) { m_mode = mode; }
+    NavSearchMode GetMode() const { return m_mode; }
+
+    // 見つからなければ false（out は空）。start == goal なら 1 点の経路
+    // どちらのモードでも out はセル単位の経路（隣り合うセルの列）
+    bool FindPath(const NavGrid& grid, GridPoint start, GridPoint goal, NavPath& out);
+
+    // 探索を始める（まだ展開はしない）。grid は探索が終わるまで書き換えず、生かしておくこと
+    void Begin(const NavGrid& grid, GridPoint start, GridPoint goal);
+    // 最大 maxExpansions ノード展開して止める。Found になったら out に経路を入れる（Running の間 out は触らない）
+    // GetLastStats は Begin からの合計
+    NavSearchStatus Resume(uint32_t maxExpansions, NavPath& out);
+
+    const NavSearchStats& GetLastStats() const { return m_stats; }
+
+private:
+    struct OpenEntry
+    {
+        int f;
+        int h;
+        int index;
+    };
+
+    void Prepare(int cellCount);
+    // open list に積む（すでにもっと短い距離で積んでいれば何もしない）
+    void Push(int index, int parent, int g, const GridPoint& p, const GridPoint& goal);
+    void BuildPath(const NavGrid& grid, int goalIndex, NavPath& out) const;
+    void ExpandNeighbors(const NavGrid& grid, int index);
+    void ExpandJump(const NavGrid& grid, int index);
+    void PrepareJumpTable(const NavGrid& grid);
+    // ジャンプポイント（goal を含む）のインデックス。なければ -1
+    int JumpStraight(const NavGrid& grid, int x, int y, int dx, int dy, const GridPoint& goal);
+    int JumpDiagonal(const NavGrid& grid, int x, int y, int dx, int dy, const GridPoint& goal);
+
+    std::vector<int> m_g;
+    std::vector<int> m_parent;
+    std::vector<uint32_t> m_visited; // m_generation と同じなら今回の探索で触ったセル
+    std::vector<uint32_t> m_closed;
+    std::vector<OpenEntry> m_open;
+    uint32_t m_generation = 0;
+    NavSearchMode m_mode = NavSearchMode::AStar;
+    NavSearchStats m_stats;
+
+    // Begin から Resume へ引き継ぐ
+    const NavGrid* m_searchGrid = nullptr;
+    GridPoint m_searchGoal;
+    int m_goalIndex = -1;
+    NavSearchStatus m_status = NavSearchStatus::NotFound;
+
+    // JumpPoint 用。セルごとに 4 方向：正なら その距離にジャンプポイント、0 以下なら -(壁の手前まで進める歩数)
+    std::vector<int16_t> m_jumps;
+    const NavGrid* m_jumpGrid = nullptr;
+    uint32_t m_jumpRevision = 0;
+    int m_jumpWidth = 0;
+    int m_jumpHeight = 0;
+};
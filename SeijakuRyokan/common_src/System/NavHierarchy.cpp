@@ -0,0 +1,509 @@
+﻿/*****************************************************************//**
+ * @file   NavHierarchy.cpp
+ * @brief  階層グラフ（HPA*）の構築・部分的な作り直し・探索の実装
+ *********************************************************************/
+#include "NavHierarchy.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+namespace
+{
+    // これより長い入口は両端に遷移を置く
+    constexpr int ENTRANCE_SPLIT = 6;
+
+    template <typename Entry>
+    struct PriorityGreater
+    {
+        bool operator()(const Entry& a, const Entry& b) const { return a.priority > b.priority; }
+    };
+
+    template <typename Entry>
+    struct OpenGreater
+    {
+        // f が小さい順、同じなら goal に近い（h が小さい）順
+        bool operator()(const Entry& a, const Entry& b) const
+        {
+            return a.f != b.f ? a.f > b.f : a.h > b.h;
+        }
+    };
+
+    double MicrosSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+// ==============================
+// RectSearch
+// ==============================
+void NavHierarchy::RectSearch::Run(const NavGrid& grid, const Rect& rect, GridPoint source, const GridPoint* target)
+{
+    m_rect = rect;
+    const size_t size = static_cast<size_t>(rect.width) * rect.height;
+    m_distance.assign(size, INT_MAX);
+    m_parent.assign(size, -1);
+    m_closed.assign(size, 0);
+    m_heap.clear();
+    if (!rect.Contains(source.x, source.y)) {
+        return;
+    }
+    const auto toLocal = [&rect](int x, int y) { return (y - rect.y) * rect.width + (x - rect.x); };
+    const int targetIndex = target && rect.Contains(target->x, target->y) ? toLocal(target->x, target->y) : -1;
+    const PriorityGreater<Entry> greater;
+    // target があれば A*（Octile は一貫性があるので、閉じたセルは最短で確定している）
+    const auto heuristic = [target, targetIndex](int x, int y) {
+        return targetIndex >= 0 ? NavGrid::Octile(GridPoint{ x, y }, *target) : 0;
+    };
+
+    const int sourceIndex = toLocal(source.x, source.y);
+    m_distance[sourceIndex] = 0;
+    m_heap.push_back(Entry{ heuristic(source.x, source.y), sourceIndex });
+    while (!m_heap.empty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), greater);
+        const Entry current = m_heap.back();
+        m_heap.pop_back();
+        if (m_closed[current.index]) {
+            continue;
+        }
+        m_closed[current.index] = 1;
+        if (current.index == targetIndex) {
+            break;
+        }
+        const int px = rect.x + current.index % rect.width;
+        const int py = rect.y + current.index / rect.width;
+        for (int d = 0; d < NavGrid::DIRECTION_COUNT; ++d) {
+            const int nx = px + NavGrid::DX[d];
+            const int ny = py + NavGrid::DY[d];
+            if (!rect.Contains(nx, ny) || !grid.CanStep(px, py, d)) {
+                continue;
+            }
+            const int ni = toLocal(nx, ny);
+            const int nd = m_distance[current.index] + NavGrid::StepCost(d);
+            if (nd < m_distance[ni]) {
+                m_distance[ni] = nd;
+                m_parent[ni] = current.index;
+                m_heap.push_back(Entry{ nd + heuristic(nx, ny), ni });
+                std::push_heap(m_heap.begin(), m_heap.end(), greater);
+            }
+        }
+    }
+}
+
+int NavHierarchy::RectSearch::GetDistance(const GridPoint& p) const
+{
+    if (!m_rect.Contains(p.x, p.y)) {
+        return INT_MAX;
+    }
+    return m_distance[(p.y - m_rect.y) * m_rect.width + (p.x - m_rect.x)];
+}
+
+void NavHierarchy::RectSearch::AppendPath(const GridPoint& p, std::vector<GridPoint>& out) const
+{
+    const size_t first = out.size();
+    // 親をたどると source が最後に来る（source 自身は足さない）
+    for (int i = (p.y - m_rect.y) * m_rect.width + (p.x - m_rect.x); m_parent[i] >= 0; i = m_parent[i]) {
+        out.push_back(GridPoint{ m_rect.x + i % m_rect.width, m_rect.y + i / m_rect.width });
+    }
+    std::reverse(out.begin() + first, out.end());
+}
+
+// ==============================
+// 構築
+// ==============================
+NavHierarchy::NavHierarchy(int clusterSize)
+    : m_clusterSize((std::max)(clusterSize, 4))
+    , m_local(NavSearchMode::JumpPoint)
+{
+}
+
+int NavHierarchy::AllocateNode(const GridPoint& cell, int cluster)
+{
+    int id = 0;
+    if (!m_freeNodes.empty()) {
+        id = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+    else {
+        id = static_cast<int>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+    Node& node = m_nodes[id];
+    node.cell = cell;
+    node.cluster = cluster;
+    node.partner = -1;
+    node.edges.clear();
+    return id;
+}
+
+void NavHierarchy::BuildBorder(const NavGrid& grid, int border)
+{
+    std::vector<int>& list = m_borders[border];
+    for (int id : list) {
+        Node& node = m_nodes[id];
+        node.cluster = -1;
+        node.partner = -1;
+        node.edges.clear();
+        m_freeNodes.push_back(id);
+    }
+    list.clear();
+
+    const int clusterCount = m_clustersX * m_clustersY;
+    const bool vertical = border < clusterCount;
+    const int local = vertical ? border : border - clusterCount;
+    const int cx = local % m_clustersX;
+    const int cy = local / m_clustersX;
+    if (vertical ? cx + 1 >= m_clustersX : cy + 1 >= m_clustersY) {
+        return;
+    }
+
+    // 境界の手前の列（行）の座標と、境界に沿った範囲
+    const int line = vertical ? (cx + 1) * m_clusterSize - 1 : (cy + 1) * m_clusterSize - 1;
+    const int begin = vertical ? cy * m_clusterSize : cx * m_clusterSize;
+    const int end = (std::min)(begin + m_clusterSize, vertical ? m_height : m_width);
+    const int nearCluster = vertical ? GetClusterIndex(line, begin) : GetClusterIndex(begin, line);
+    const int farCluster = vertical ? GetClusterIndex(line + 1, begin) : GetClusterIndex(begin, line + 1);
+    const auto cellAt = [vertical, line](int along, int side) {
+        return vertical ? GridPoint{ line + side, along } : GridPoint{ along, line + side };
+    };
+    const auto addTransition = [&](int along) {
+        const int a = AllocateNode(cellAt(along, 0), nearCluster);
+        const int b = AllocateNode(cellAt(along, 1), farCluster);
+        m_nodes[a].partner = b;
+        m_nodes[b].partner = a;
+        list.push_back(a);
+        list.push_back(b);
+    };
+
+    int runStart = -1;
+    for (int along = begin; along <= end; ++along) {
+        const bool open = along < end && grid.IsWalkable(cellAt(along, 0)) && grid.IsWalkable(cellAt(along, 1));
+        if (open && runStart < 0) {
+            runStart = along;
+        }
+        else if (!open && runStart >= 0) {
+            const int runEnd = along - 1;
+            if (runEnd - runStart + 1 < ENTRANCE_SPLIT) {
+                addTransition((runStart + runEnd) / 2);
+            }
+            else {
+                addTransition(runStart);
+                addTransition(runEnd);
+            }
+            runStart = -1;
+        }
+    }
+}
+
+void NavHierarchy::BuildClusterEdges(const NavGrid& grid, int cluster)
+{
+    Cluster& c = m_clusters[cluster];
+    c.nodes.clear();
+    const int cx = cluster % m_clustersX;
+    const int cy = cluster / m_clustersX;
+    const int borders[] = {
+        cx > 0 ? GetVerticalBorder(cx - 1, cy) : -1,
+        cx + 1 < m_clustersX ? GetVerticalBorder(cx, cy) : -1,
+        cy > 0 ? GetHorizontalBorder(cx, cy - 1) : -1,
+        cy + 1 < m_clustersY ? GetHorizontalBorder(cx, cy) : -1,
+    };
+    for (int border : borders) {
+        if (border < 0) {
+            continue;
+        }
+        for (int id : m_borders[border]) {
+            if (m_nodes[id].cluster == cluster) {
+                c.nodes.push_back(id);
+            }
+        }
+    }
+
+    for (int id : c.nodes) {
+        m_nodes[id].edges.clear();
+    }
+    // グリッドの移動は向きによらないので、i から j の距離を j から i の辺にも使う（探索は半分で済む）
+    for (size_t i = 0; i + 1 < c.nodes.size(); ++i) {
+        m_rectSearch.Run(grid, c.rect, m_nodes[c.nodes[i]].cell);
+        for (size_t j = i + 1; j < c.nodes.size(); ++j) {
+            const int d = m_rectSearch.GetDistance(m_nodes[c.nodes[j]].cell);
+            if (d != INT_MAX) {
+                m_nodes[c.nodes[i]].edges.push_back(Edge{ c.nodes[j], d });
+                m_nodes[c.nodes[j]].edges.push_back(Edge{ c.nodes[i], d });
+            }
+        }
+    }
+}
+
+void NavHierarchy::CountGraph()
+{
+    m_stats.clusters = m_clusters.size();
+    m_stats.nodes = 0;
+    m_stats.edges = 0;
+    for (const Node& node : m_nodes) {
+        if (node.cluster >= 0) {
+            ++m_stats.nodes;
+            m_stats.edges += node.edges.size();
+        }
+    }
+}
+
+void NavHierarchy::Build(const NavGrid& grid)
+{
+    const auto start = std::chrono::steady_clock::now();
+    m_width = grid.GetWidth();
+    m_height = grid.GetHeight();
+    m_clustersX = (m_width + m_clusterSize - 1) / m_clusterSize;
+    m_clustersY = (m_height + m_clusterSize - 1) / m_clusterSize;
+    const int clusterCount = m_clustersX * m_clustersY;
+
+    m_clusters.assign(clusterCount, Cluster{});
+    for (int i = 0; i < clusterCount; ++i) {
+        Rect& rect = m_clusters[i].rect;
+        rect.x = (i % m_clustersX) * m_clusterSize;
+        rect.y = (i / m_clustersX) * m_clusterSize;
+        rect.width = (std::min)(m_clusterSize, m_width - rect.x);
+        rect.height = (std::min)(m_clusterSize, m_height - rect.y);
+    }
+    m_borders.assign(static_cast<size_t>(clusterCount) * 2, std::vector<int>());
+    m_nodes.clear();
+    m_freeNodes.clear();
+
+    for (int border = 0; border < clusterCount * 2; ++border) {
+        BuildBorder(grid, border);
+    }
+    for (int cluster = 0; cluster < clusterCount; ++cluster) {
+        BuildClusterEdges(grid, cluster);
+    }
+    m_revision = grid.GetRevision();
+    m_built = true;
+
+    CountGraph();
+    m_stats.rebuiltClusters = static_cast<uint32_t>(clusterCount);
+    m_stats.rebuiltEntrances = static_cast<uint32_t>(clusterCount * 2);
+    m_stats.rebuildMicros = MicrosSince(start);
+}
+
+void NavHierarchy::Update(const NavGrid& grid, int x, int y, int width, int height)
+{
+    if (!m_built || grid.GetWidth() != m_width || grid.GetHeight() != m_height) {
+        Build(grid);
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const int x0 = (std::max)(x, 0);
+    const int y0 = (std::max)(y, 0);
+    const int x1 = (std::min)(x + width, m_width) - 1;
+    const int y1 = (std::min)(y + height, m_height) - 1;
+    m_stats.rebuiltClusters = 0;
+    m_stats.rebuiltEntrances = 0;
+    if (x0 > x1 || y0 > y1) {
+        m_revision = grid.GetRevision();
+        m_stats.rebuildMicros = MicrosSince(start);
+        return;
+    }
+
+    const int cx0 = x0 / m_clusterSize;
+    const int cx1 = x1 / m_clusterSize;
+    const int cy0 = y0 / m_clusterSize;
+    const int cy1 = y1 / m_clusterSize;
+    std::vector<int> dirty;
+    const auto markDirty = [&dirty](int cluster) {
+        if (std::find(dirty.begin(), dirty.end(), cluster) == dirty.end()) {
+            dirty.push_back(cluster);
+        }
+    };
+
+    // 矩形が境界の両側の列（行）にかかる入口だけ作り直す
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = (std::max)(cx0 - 1, 0); cx <= (std::min)(cx1, m_clustersX - 2); ++cx) {
+            const int line = (cx + 1) * m_clusterSize - 1;
+            if (x0 <= line + 1 && x1 >= line) {
+                BuildBorder(grid, GetVerticalBorder(cx, cy));
+                markDirty(cy * m_clustersX + cx);
+                markDirty(cy * m_clustersX + cx + 1);
+                ++m_stats.rebuiltEntrances;
+            }
+        }
+    }
+    for (int cy = (std::max)(cy0 - 1, 0); cy <= (std::min)(cy1, m_clustersY - 2); ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            const int line = (cy + 1) * m_clusterSize - 1;
+            if (y0 <= line + 1 && y1 >= line) {
+                BuildBorder(grid, GetHorizontalBorder(cx, cy));
+                markDirty(cy * m_clustersX + cx);
+                markDirty((cy + 1) * m_clustersX + cx);
+                ++m_stats.rebuiltEntrances;
+            }
+        }
+    }
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            markDirty(cy * m_clustersX + cx);
+        }
+    }
+    for (int cluster : dirty) {
+        BuildClusterEdges(grid, cluster);
+    }
+    m_revision = grid.GetRevision();
+
+    CountGraph();
+    m_stats.rebuiltClusters = static_cast<uint32_t>(dirty.size());
+    m_stats.rebuildMicros = MicrosSince(start);
+}
+
+// ==============================
+// 探索
+// ==============================
+void NavHierarchy::EnsureBuilt(const NavGrid& grid)
+{
+    if (!m_built || m_revision != grid.GetRevision() || grid.GetWidth() != m_width || grid.GetHeight() != m_height) {
+        Build(grid);
+    }
+}
+
+bool NavHierarchy::FindAbstractPath(const NavGrid& grid, GridPoint start, GridPoint goal, std::vector<GridPoint>& waypoints, int& cost)
+{
+    waypoints.clear();
+    cost = 0;
+    m_queryStats = NavHierarchyQueryStats{};
+    EnsureBuilt(grid);
+    if (!grid.IsWalkable(start) || !grid.IsWalkable(goal)) {
+        return false;
+    }
+
+    const int startCluster = GetClusterIndex(start.x, start.y);
+    const int goalCluster = GetClusterIndex(goal.x, goal.y);
+    if (startCluster == goalCluster) {
+        NavPath path;
+        m_queryStats.usedLocal = true;
+        if (!m_local.FindPath(grid, start, goal, path)) {
+            return false;
+        }
+        waypoints.push_back(start);
+        waypoints.push_back(goal);
+        cost = path.cost;
+        return true;
+    }
+
+    // start / goal を仮のノードとして末尾に置く
+    const int startNode = static_cast<int>(m_nodes.size());
+    const int goalNode = startNode + 1;
+    const size_t size = m_nodes.size() + 2;
+    if (m_g.size() < size) {
+        m_g.resize(size);
+        m_parent.resize(size);
+        m_goalDistance.resize(size);
+        m_visited.resize(size, 0);
+        m_closed.resize(size, 0);
+        m_goalStamp.resize(size, 0);
+    }
+    if (++m_generation == 0) {
+        std::fill(m_visited.begin(), m_visited.end(), 0);
+        std::fill(m_closed.begin(), m_closed.end(), 0);
+        std::fill(m_goalStamp.begin(), m_goalStamp.end(), 0);
+        m_generation = 1;
+    }
+    m_open.clear();
+
+    // goal のクラスタのノードから goal までの距離（向きを入れ替えても同じコスト）
+    m_rectSearch.Run(grid, m_clusters[goalCluster].rect, goal);
+    for (int id : m_clusters[goalCluster].nodes) {
+        const int d = m_rectSearch.GetDistance(m_nodes[id].cell);
+        if (d != INT_MAX) {
+            m_goalDistance[id] = d;
+            m_goalStamp[id] = m_generation;
+        }
+    }
+    // start からの距離は start を展開するときに使う（以降 m_rectSearch は触らない）
+    m_rectSearch.Run(grid, m_clusters[startCluster].rect, start);
+
+    const OpenGreater<OpenEntry> greater;
+    const auto push = [&](int node, int parent, int g) {
+        if (m_closed[node] == m_generation || (m_visited[node] == m_generation && g >= m_g[node])) {
+            return;
+        }
+        m_visited[node] = m_generation;
+        m_g[node] = g;
+        m_parent[node] = parent;
+        const int h = node == goalNode ? 0 : NavGrid::Octile(m_nodes[node].cell, goal);
+        m_open.push_back(OpenEntry{ g + h, h, node });
+        std::push_heap(m_open.begin(), m_open.end(), greater);
+    };
+    push(startNode, -1, 0);
+
+    while (!m_open.empty()) {
+        std::pop_heap(m_open.begin(), m_open.end(), greater);
+        const OpenEntry current = m_open.back();
+        m_open.pop_back();
+        if (m_closed[current.node] == m_generation) {
+            continue;
+        }
+        m_closed[current.node] = m_generation;
+        ++m_queryStats.expanded;
+
+        if (current.node == goalNode) {
+            cost = m_g[goalNode];
+            for (int n = goalNode; n >= 0; n = m_parent[n]) {
+                waypoints.push_back(n == goalNode ? goal : n == startNode ? start : m_nodes[n].cell);
+            }
+            std::reverse(waypoints.begin(), waypoints.end());
+            return true;
+        }
+
+        const int g = m_g[current.node];
+        if (current.node == startNode) {
+            for (int id : m_clusters[startCluster].nodes) {
+                const int d = m_rectSearch.GetDistance(m_nodes[id].cell);
+                if (d != INT_MAX) {
+                    push(id, startNode, d);
+                }
+            }
+            continue;
+        }
+        const Node& node = m_nodes[current.node];
+        for (const Edge& edge : node.edges) {
+            push(edge.to, current.node, g + edge.cost);
+        }
+        if (node.partner >= 0) {
+            push(node.partner, current.node, g + NavGrid::STRAIGHT_COST);
+        }
+        if (m_goalStamp[current.node] == m_generation) {
+            push(goalNode, current.node, g + m_goalDistance[current.node]);
+        }
+    }
+    return false;
+}
+
+bool NavHierarchy::FindPath(const NavGrid& grid, GridPoint start, GridPoint goal, NavPath& out)
+{
+    out.Clear();
+    EnsureBuilt(grid);
+    if (grid.IsWalkable(start) && GetClusterIndex(start.x, start.y) == GetClusterIndex(goal.x, goal.y)) {
+        m_queryStats = NavHierarchyQueryStats{};
+        m_queryStats.usedLocal = true;
+        return m_local.FindPath(grid, start, goal, out);
+    }
+    int cost = 0;
+    if (!FindAbstractPath(grid, start, goal, m_waypoints, cost)) {
+        return false;
+    }
+    const std::vector<GridPoint>& waypoints = m_waypoints;
+
+    out.cost = cost;
+    out.points.push_back(start);
+    for (size_t i = 1; i < waypoints.size(); ++i) {
+        const GridPoint& from = waypoints[i - 1];
+        const GridPoint& to = waypoints[i];
+        if (from == to) {
+            continue; // クラスタの角で 2 つの遷移が同じセルにあるとき
+        }
+        const int cluster = GetClusterIndex(from.x, from.y);
+        if (cluster != GetClusterIndex(to.x, to.y)) {
+            out.points.push_back(to); // 境界をまたぐ 1 歩
+            continue;
+        }
+        m_rectSearch.Run(grid, m_clusters[cluster].rect, from, &to);
+        m_rectSearch.AppendPath(to, out.points);
+    }
+    return true;
+}
@@ -0,0 +1,159 @@
+﻿/*****************************************************************//**
+ * @file   NavHierarchy.h
+ * @brief  NavGrid の上の階層グラフ（HPA*）。マップが広くても長い経路を短時間で探す
+ *
+ * @details
+ * - グリッドを clusterSize 四方のクラスタに分け、隣り合うクラスタの境界で両側とも通れるセルの並び
+ *   （入口）ごとに、遷移（境界をまたぐ 2 セルの組）を置く。短い入口は真ん中に 1 つ、長い入口は両端に 2 つ
+ * - 遷移のセルが抽象グラフのノード。同じクラスタのノードどうしは、そのクラスタの中だけを通る
+ *   最短コストを前計算した辺で結ぶ。遷移の 2 セルの間はコスト 10（縦横 1 歩）
+ * - 探索は start / goal を自分のクラスタのノードにつないで抽象グラフを A* で解き、
+ *   クラスタごとに中だけを探してセル単位の経路に詰める
+ * - 経路は最短とは限らない（入口の中の通る位置が固定なので、多くは数 % 長くなる）。
+ *   start と goal が同じクラスタなら GridAStar（JumpPoint）で最短を返す
+ * - マップを書き換えたら Update に書き換えた矩形を渡す。その矩形にかかるクラスタと、
+ *   矩形が境界の両側の列（行）にかかる入口だけを作り直す。Update を呼ばずにリビジョンが進んでいたら
+ *   次の探索で全体を作り直す
+ *********************************************************************/
+#pragma once
+#include "NavGrid.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct NavHierarchyStats
+{
+    size_t clusters = 0;
+    size_t nodes = 0;              // 抽象ノード（遷移のセル）
+    size_t edges = 0;              // クラスタ内の辺（向きつき）
+    uint32_t rebuiltClusters = 0;  // 直近の Build / Update で辺を作り直したクラスタ数
+    uint32_t rebuiltEntrances = 0; // 〃 で作り直した境界の数
+    double rebuildMicros = 0.0;    // 〃 の所要時間
+};
+
+struct NavHierarchyQueryStats
+{
+    uint32_t expanded = 0;  // 抽象グラフで展開したノード数
+    bool usedLocal = false; // 同じクラスタだったので GridAStar で解いた
+};
+
+class NavHierarchy
+{
+public:
+    static constexpr int DEFAULT_CLUSTER_SIZE = 16;
+
+    explicit NavHierarchy(int clusterSize = DEFAULT_CLUSTER_SIZE);
+
+    void Build(const NavGrid& grid);
+    // (x, y, width, height) のセルを書き換えた後に呼ぶ
+    void Update(const NavGrid& grid, int x, int y, int width, int height);
+
+    // 抽象グラフまでの探索。waypoints は start・通る遷移のセル・goal の列、cost はその合計
+    bool FindAbstractPath(const NavGrid& grid, GridPoint start, GridPoint goal, std::vector<GridPoint>& waypoints, int& cost);
+    // セル単位の経路まで詰める
+    bool FindPath(const NavGrid& grid, GridPoint start, GridPoint goal, NavPath& out);
+
+    int GetClusterSize() const { return m_clusterSize; }
+    const NavHierarchyStats& GetStats() const { return m_stats; }
+    const NavHierarchyQueryStats& GetLastQueryStats() const { return m_queryStats; }
+
+private:
+    struct Rect
+    {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+
+        bool Contains(int px, int py) const { return px >= x && py >= y && px < x + width && py < y + height; }
+    };
+
+    struct Edge
+    {
+        int to;
+        int cost;
+    };
+
+    struct Node
+    {
+        GridPoint cell;
+        int cluster = -1;  // -1 なら空き（使い回し待ち）
+        int partner = -1;  // 境界の向こう側のノード
+        std::vector<Edge> edges; // 同じクラスタのノードへ
+    };
+
+    struct Cluster
+    {
+        Rect rect;
+        std::vector<int> nodes;
+    };
+
+    // クラスタの矩形の中だけを通る Dijkstra（辺の前計算と経路の詰めに使う）
+    class RectSearch
+    {
+    public:
+        // target を指定すると A* にして、そこに着いたところで止める（GetDistance は target のみ確定）
+        void Run(const NavGrid& grid, const Rect& rect, GridPoint source, const GridPoint* target = nullptr);
+        int GetDistance(const GridPoint& p) const;
+        // source の次のセルから p までを out に足す
+        void AppendPath(const GridPoint& p, std::vector<GridPoint>& out) const;
+
+    private:
+        struct Entry
+        {
+            int priority; // 距離（A* なら + ヒューリスティック）
+            int index;
+        };
+
+        Rect m_rect;
+        std::vector<int> m_distance;
+        std::vector<int> m_parent;
+        std::vector<uint8_t> m_closed;
+        std::vector<Entry> m_heap;
+    };
+
+    int GetClusterIndex(int x, int y) const { return (y / m_clusterSize) * m_clustersX + x / m_clusterSize; }
+    // 境界の番号。縦の境界（cx と cx + 1 の間）が先、横の境界（cy と cy + 1 の間）が後
+    int GetVerticalBorder(int cx, int cy) const { return cy * m_clustersX + cx; }
+    int GetHorizontalBorder(int cx, int cy) const { return m_clustersX * m_clustersY + cy * m_clustersX + cx; }
+
+    void EnsureBuilt(const NavGrid& grid);
+    int AllocateNode(const GridPoint& cell, int cluster);
+    void BuildBorder(const NavGrid& grid, int border);
+    void BuildClusterEdges(const NavGrid& grid, int cluster);
+    void CountGraph();
+
+    int m_clusterSize = DEFAULT_CLUSTER_SIZE;
+    int m_width = 0;
+    int m_height = 0;
+    int m_clustersX = 0;
+    int m_clustersY = 0;
+    uint32_t m_revision = 0;
+    bool m_built = false;
+
+    std::vector<Cluster> m_clusters;
+    std::vector<std::vector<int>> m_borders; // 境界ごとのノード（遷移の組が 2 つずつ並ぶ）
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freeNodes;
+    NavHierarchyStats m_stats;
+
+    // 探索用（世代番号で初期化を省く）
+    struct OpenEntry
+    {
+        int f;
+        int h;
+        int node;
+    };
+    std::vector<int> m_g;
+    std::vector<int> m_parent;
+    std::vector<int> m_goalDistance;
+    std::vector<uint32_t> m_visited;
+    std::vector<uint32_t> m_closed;
+    std::vector<uint32_t> m_goalStamp;
+    std::vector<OpenEntry> m_open;
+    uint32_t m_generation = 0;
+    RectSearch m_rectSearch;
+    GridAStar m_local;
+    std::vector<GridPoint> m_waypoints;
+    NavHierarchyQueryStats m_queryStats;
+};
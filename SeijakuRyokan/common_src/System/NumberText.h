@@ -0,0 +1,61 @@
+﻿/*****************************************************************//**
+ * @file   NumberText.h
+ * @brief  数値 → 文字列の変換（ヒープ確保なし）
+ *
+ * @details
+ * - スコアやタイマーなど毎フレーム変わる数値を std::to_chars で固定バッファに書く
+ * - 戻り値の string_view は次に Format を呼ぶまで有効
+ *********************************************************************/
+#pragma once
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+class NumberText
+{
+public:
+    static constexpr size_t CAPACITY = 48;
+
+    std::string_view Format(long long value)
+    {
+        const auto result = std::to_chars(m_buffer, m_buffer + CAPACITY, value);
+        return std::string_view(m_buffer, result.ptr - m_buffer);
+    }
+
+    // 小数点以下 precision 桁の固定小数表記
+    std::string_view Format(double value, int precision)
+    {
+        const auto result = std::to_chars(m_buffer, m_buffer + CAPACITY, value, std::chars_format::fixed, precision);
+        if (result.ec != std::errc()) {
+            return std::string_view();
+        }
+        return std::string_view(m_buffer, result.ptr - m_buffer);
+    }
+
+    // prefix + 数値 + suffix（"Score: 1234" "残り 12秒" など）
+    std::string_view Format(std::string_view prefix, long long value, std::string_view suffix = std::string_view())
+    {
+        char* p = m_buffer;
+        char* end = m_buffer + CAPACITY;
+        if (prefix.size() > CAPACITY) {
+            return std::string_view();
+        }
+        if (!prefix.empty()) {
+            std::memcpy(p, prefix.data(), prefix.size());
+            p += prefix.size();
+        }
+        const auto result = std::to_chars(p, end, value);
+        if (result.ec != std::errc() || static_cast<size_t>(end - result.ptr) < suffix.size()) {
+            return std::string_view();
+        }
+        p = result.ptr;
+        if (!suffix.empty()) {
+            std::memcpy(p, suffix.data(), suffix.size());
+            p += suffix.size();
+        }
+        return std::string_view(m_buffer, p - m_buffer);
+    }
+
+private:
+    char m_buffer[CAPACITY];
+};
@@ -0,0 +1,237 @@
+﻿/*****************************************************************//**
+ * @file   PathRequestService.cpp
+ * @brief  経路探索の依頼サービスの実装
+ *
+ * @details
+ * - 依頼は Queued → Solving → Solved の一方向にしか進まない。Queued から Solving への
+ *   compare_exchange に勝った 1 人（ワーカーかメインスレッド）だけが解き、result を書く
+ * - メインスレッドで刻んで解く依頼（m_slicing）は、いつも届けていない依頼のうち解けていない最初のもの。
+ *   届ける tick に解けていない依頼があれば、それは m_slicing 自身か、まだ誰も手をつけていない依頼なので、
+ *   m_search を途中の探索と取り合うことはない
+ * - 依頼は shared_ptr で持つ。ワーカーのキューに残ったまま届け終わった（取り消した）依頼も、
+ *   ワーカーが取り出して捨てるまで生きている
+ *********************************************************************/
+#include "PathRequestService.h"
+#include "FramePacer.h"
+#include "Profiler.h"
+#include <algorithm>
+
+PathRequestService::PathRequestService(const PathServiceConfig& config)
+    : m_config(config)
+    , m_search(config.mode)
+{
+    m_config.latencyTicks = (std::max)(m_config.latencyTicks, 1u);
+    m_config.deliveriesPerTick = (std::max)(m_config.deliveriesPerTick, 1u);
+    for (unsigned i = 0; i < m_config.workerCount; ++i) {
+        m_workers.emplace_back(&PathRequestService::WorkerMain, this);
+    }
+}
+
+PathRequestService::~PathRequestService()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_quit = true;
+    }
+    m_queueCv.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+PathTicket PathRequestService::Submit(const NavGrid& grid, GridPoint start, GridPoint goal, uint32_t tick)
+{
+    if (!m_grid || m_gridSource != &grid || m_gridRevision != grid.GetRevision()) {
+        m_grid = std::make_shared<const NavGrid>(grid);
+        m_gridSource = &grid;
+        m_gridRevision = grid.GetRevision();
+    }
+
+    // 届く tick は依頼の順に決める（前の依頼より早くはしない。上限に達していたら次の tick へ）
+    uint32_t delivery = tick + m_config.latencyTicks;
+    if (delivery <= m_lastDeliveryTick) {
+        delivery = m_lastDeliveryTick;
+        if (m_lastDeliveryCount >= m_config.deliveriesPerTick) {
+            ++delivery;
+        }
+    }
+    if (delivery != m_lastDeliveryTick) {
+        m_lastDeliveryTick = delivery;
+        m_lastDeliveryCount = 0;
+    }
+    ++m_lastDeliveryCount;
+
+    auto request = std::make_shared<Request>();
+    request->ticket = m_nextTicket++;
+    if (m_nextTicket == 0) {
+        m_nextTicket = 1;
+    }
+    request->submitTick = tick;
+    request->deliveryTick = delivery;
+    request->start = start;
+    request->goal = goal;
+    request->grid = m_grid;
+    request->result.ticket = request->ticket;
+    request->result.revision = m_gridRevision;
+    m_requests.push_back(request);
+
+    ++m_stats.submitted;
+    m_stats.peakPending = (std::max)(m_stats.peakPending, m_requests.size());
+
+    if (!m_workers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_queue.push_back(std::move(request));
+        }
+        m_queueCv.notify_one();
+    }
+    return m_requests.back()->ticket;
+}
+
+void PathRequestService::Cancel(PathTicket ticket)
+{
+    auto it = std::lower_bound(m_requests.begin(), m_requests.end(), ticket,
+        [](const std::shared_ptr<Request>& request, PathTicket t) { return request->ticket < t; });
+    if (it == m_requests.end() || (*it)->ticket != ticket) {
+        return;
+    }
+    // 解いている途中ならそのまま解かせて捨てる（ワーカーのキューに残っていれば取り出したときに飛ばす）
+    (*it)->cancelled.store(true, std::memory_order_release);
+    if (*it == m_slicing) {
+        m_slicing.reset();
+    }
+    m_requests.erase(it);
+    ++m_stats.cancelled;
+}
+
+uint32_t PathRequestService::GetDeliveryTick(PathTicket ticket) const
+{
+    auto it = std::lower_bound(m_requests.begin(), m_requests.end(), ticket,
+        [](const std::shared_ptr<Request>& request, PathTicket t) { return request->ticket < t; });
+    return it != m_requests.end() && (*it)->ticket == ticket ? (*it)->deliveryTick : 0;
+}
+
+bool PathRequestService::TrySolve(Request& request, GridAStar& search)
+{
+    RequestState expected = RequestState::Queued;
+    if (!request.state.compare_exchange_strong(expected, RequestState::Solving, std::memory_order_acq_rel)) {
+        return false;
+    }
+    if (!request.cancelled.load(std::memory_order_acquire)) {
+        PROFILE_ZONE("PathRequestService::Solve");
+        PathResult& result = request.result;
+        result.found = search.FindPath(*request.grid, request.start, request.goal, result.path);
+        result.expanded = search.GetLastStats().expanded;
+    }
+    request.state.store(RequestState::Solved, std::memory_order_release);
+    return true;
+}
+
+bool PathRequestService::ContinueSlice(uint32_t maxExpansions)
+{
+    PROFILE_ZONE("PathRequestService::Slice");
+    PathResult& result = m_slicing->result;
+    const NavSearchStatus status = m_search.Resume(maxExpansions, result.path);
+    if (status == NavSearchStatus::Running) {
+        return false;
+    }
+    result.found = status == NavSearchStatus::Found;
+    result.expanded = m_search.GetLastStats().expanded;
+    m_slicing->state.store(RequestState::Solved, std::memory_order_release);
+    m_slicing.reset();
+    return true;
+}
+
+void PathRequestService::WorkerMain()
+{
+    PROFILE_THREAD_NAME("path worker");
+    GridAStar search(m_config.mode);
+    for (;;) {
+        std::shared_ptr<Request> request;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCv.wait(lock, [this] { return m_quit || !m_queue.empty(); });
+            if (m_quit) {
+                return;
+            }
+            request = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        if (TrySolve(*request, search)) {
+            // Update が待っているかもしれない（待つ側は m_doneMutex の中で state を見る）
+            std::lock_guard<std::mutex> lock(m_doneMutex);
+            m_doneCv.notify_all();
+        }
+    }
+}
+
+void PathRequestService::Update(uint32_t tick, std::vector<PathResult>& out)
+{
+    PROFILE_ZONE("PathRequestService::Update");
+    const int64_t start = PacerClock::NowNs();
+    out.clear();
+
+    while (!m_requests.empty() && m_requests.front()->deliveryTick <= tick) {
+        std::shared_ptr<Request> request = std::move(m_requests.front());
+        m_requests.pop_front();
+        if (request->state.load(std::memory_order_acquire) == RequestState::Solved) {
+            ++m_stats.solvedAhead;
+        }
+        else {
+            // 間に合わなかった。まだ誰も手をつけていなければここで解き、ワーカーが解いている途中なら待つ
+            ++m_stats.forced;
+            if (request == m_slicing) {
+                ContinueSlice(UINT32_MAX);
+            }
+            else if (!TrySolve(*request, m_search)) {
+                std::unique_lock<std::mutex> lock(m_doneMutex);
+                m_doneCv.wait(lock, [&request] {
+                    return request->state.load(std::memory_order_acquire) == RequestState::Solved;
+                });
+            }
+        }
+        ++m_stats.delivered;
+        m_stats.expanded += request->result.expanded;
+        m_stats.maxDelayTicks = (std::max)(m_stats.maxDelayTicks, tick - request->submitTick);
+        out.push_back(std::move(request->result));
+    }
+
+    if (!m_workers.empty()) {
+        return;
+    }
+    // 持ち時間が残っていれば、先の依頼を届く順に少しずつ解いておく
+    const int64_t budgetNs = static_cast<int64_t>(m_config.budgetMs * 1000000.0);
+    size_t next = 0;
+    while (PacerClock::NowNs() - start < budgetNs) {
+        if (!m_slicing) {
+            while (next < m_requests.size() && m_requests[next]->state.load(std::memory_order_acquire) != RequestState::Queued) {
+                ++next;
+            }
+            if (next == m_requests.size()) {
+                break;
+            }
+            m_slicing = m_requests[next];
+            m_slicing->state.store(RequestState::Solving, std::memory_order_release);
+            m_search.Begin(*m_slicing->grid, m_slicing->start, m_slicing->goal);
+        }
+        ContinueSlice(SLICE_EXPANSIONS);
+    }
+}
+
+GridPoint PathRequestService::GetProvisionalStep(const NavGrid& grid, const GridPoint& from, const GridPoint& goal)
+{
+    GridPoint best = from;
+    int bestDistance = NavGrid::Octile(from, goal);
+    for (int d = 0; d < NavGrid::DIRECTION_COUNT; ++d) {
+        if (!grid.CanStep(from.x, from.y, d)) {
+            continue;
+        }
+        const GridPoint next{ from.x + NavGrid::DX[d], from.y + NavGrid::DY[d] };
+        const int distance = NavGrid::Octile(next, goal);
+        if (distance < bestDistance) {
+            best = next;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
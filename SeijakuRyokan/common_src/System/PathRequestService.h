@@ -0,0 +1,146 @@
+﻿/*****************************************************************//**
+ * @file   PathRequestService.h
+ * @brief  経路探索の依頼を受け付け、ワーカースレッドか tick ごとの持ち時間の中で解いて、後の tick に届ける
+ *
+ * @details
+ * - 到着が重なった tick に探索が集中して処理落ちしないように、探索を依頼と結果の受け取りに分ける。
+ *   依頼した客は結果が届くまで GetProvisionalStep の仮の向きに進んでおく
+ * - 結果が届く tick は Submit の時点で決まる（Submit の tick + latencyTicks。1 tick に届ける数は deliveriesPerTick までで、
+ *   あふれた分は次の tick 以降に回す）。探索がいつ終わったかには左右されないので、ワーカーの数や持ち時間、
+ *   マシンの速さが違っても、同じ依頼の列なら同じ tick に同じ結果が届く（リプレイ・比較がずれない）
+ * - 解く場所は 2 通り
+ *   - workerCount が 0: Update の中で、持ち時間 budgetMs を使い切るまで先の依頼まで解いておく。
+ *     1 つの探索も GridAStar::Resume で SLICE_EXPANSIONS ノードずつ刻むので、長い探索 1 本で持ち時間を大きく超えない
+ *   - workerCount が 1 以上: ワーカースレッドが依頼の順に解く。Update は届ける分を集めるだけ
+ *   どちらでも、届ける tick までに解けていない依頼はその Update の中で解く（ワーカーが解いている途中なら待つ）。
+ *   GetStats().forced が増えるなら、deliveriesPerTick が持ち時間（ワーカーの数）に対して多すぎる
+ * - 探索は Submit の時点のグリッドの複製の上で行う（ワーカーと書き換えが競合しないように）。
+ *   リビジョンが変わったグリッドで Submit したときだけ複製を取り直す。
+ *   届いた結果の revision が今のグリッドと違えば、その間の書き換えで経路がふさがれていないか呼び出し側で確かめること
+ * - Submit / Cancel / Update はメインスレッドからだけ呼ぶ
+ *********************************************************************/
+#pragma once
+#include "NavGrid.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 0 は無効（依頼していない）
+using PathTicket = uint32_t;
+
+struct PathServiceConfig
+{
+    NavSearchMode mode = NavSearchMode::JumpPoint;
+    unsigned workerCount = 0;        // 0 ならメインスレッドの Update で解く
+    double budgetMs = 1.0;           // workerCount が 0 のとき、1 回の Update で先の依頼を解く持ち時間
+    uint32_t latencyTicks = 6;       // Submit から結果が届くまでの tick 数（1 以上。60 tick/秒で 0.1 秒）
+    uint32_t deliveriesPerTick = 8;  // 1 tick に届ける結果の上限
+};
+
+struct PathServiceStats
+{
+    uint64_t submitted = 0;
+    uint64_t delivered = 0;
+    uint64_t cancelled = 0;
+    uint64_t expanded = 0;      // 届けた結果の探索で展開したノード数
+    uint64_t solvedAhead = 0;   // 届ける tick より前に解けていた
+    uint64_t forced = 0;        // 届ける tick になっても解けておらず、Update の中で解いた（待った）
+    uint32_t maxDelayTicks = 0; // Submit から届くまでの最大（上限であふれると latencyTicks より延びる）
+    size_t peakPending = 0;     // 届けていない依頼の最大数
+};
+
+struct PathResult
+{
+    PathTicket ticket = 0;
+    bool found = false;
+    uint32_t revision = 0;  // 解いたグリッドのリビジョン
+    uint32_t expanded = 0;
+    NavPath path;           // start〜goal。見つからなければ空
+};
+
+class PathRequestService
+{
+public:
+    // メインスレッドで解くとき、持ち時間を確かめる間隔（展開ノード数）
+    static constexpr uint32_t SLICE_EXPANSIONS = 128;
+
+    explicit PathRequestService(const PathServiceConfig& config = PathServiceConfig());
+    ~PathRequestService();
+
+    PathRequestService(const PathRequestService&) = delete;
+    PathRequestService& operator=(const PathRequestService&) = delete;
+
+    // tick は呼び出し側の今の tick（前回の Submit / Update より戻さないこと）
+    PathTicket Submit(const NavGrid& grid, GridPoint start, GridPoint goal, uint32_t tick);
+    // 届く前の依頼を取り消す（結果は届かない）。届けた後や知らない番号なら何もしない
+    void Cancel(PathTicket ticket);
+    // 届く予定の tick（知らない番号なら 0）
+    uint32_t GetDeliveryTick(PathTicket ticket) const;
+
+    // tick に届く結果を ticket の順に out に入れる（out は先に空にする）
+    void Update(uint32_t tick, std::vector<PathResult>& out);
+
+    size_t GetPendingCount() const { return m_requests.size(); }
+    const PathServiceConfig& GetConfig() const { return m_config; }
+    const PathServiceStats& GetStats() const { return m_stats; }
+
+    // 結果が届くまでの仮の一歩: from から goal へ Octile 距離がいちばん縮む隣のセル（縮まなければ from のまま）
+    static GridPoint GetProvisionalStep(const NavGrid& grid, const GridPoint& from, const GridPoint& goal);
+
+private:
+    enum class RequestState : int
+    {
+        Queued,  // まだ誰も解いていない
+        Solving, // ワーカーかメインスレッドが解いている
+        Solved,
+    };
+
+    struct Request
+    {
+        PathTicket ticket = 0;
+        uint32_t submitTick = 0;
+        uint32_t deliveryTick = 0;
+        GridPoint start;
+        GridPoint goal;
+        std::shared_ptr<const NavGrid> grid;
+        std::atomic<RequestState> state{ RequestState::Queued };
+        std::atomic<bool> cancelled{ false };
+        PathResult result;
+    };
+
+    // Queued なら取って解く。ほかで解いている・解き終わっていれば false
+    bool TrySolve(Request& request, GridAStar& search);
+    // m_slicing を最大 maxExpansions ノード進める。解き終わったら true
+    bool ContinueSlice(uint32_t maxExpansions);
+    void WorkerMain();
+
+    PathServiceConfig m_config;
+    PathServiceStats m_stats;
+    PathTicket m_nextTicket = 1;
+    uint32_t m_lastDeliveryTick = 0;
+    uint32_t m_lastDeliveryCount = 0; // m_lastDeliveryTick に割り当てた数
+
+    std::shared_ptr<const NavGrid> m_grid; // 直近の Submit で使った複製
+    const NavGrid* m_gridSource = nullptr;
+    uint32_t m_gridRevision = 0;
+
+    // 届けていない依頼（ticket の順 = 届く tick の順）。メインスレッドだけが触る
+    std::deque<std::shared_ptr<Request>> m_requests;
+    GridAStar m_search; // メインスレッドで解く用
+    std::shared_ptr<Request> m_slicing; // m_search で途中まで解いている依頼（workerCount が 0 のときだけ）
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCv;
+    std::deque<std::shared_ptr<Request>> m_queue; // ワーカーが取る依頼
+    bool m_quit = false;
+
+    std::mutex m_doneMutex;
+    std::condition_variable m_doneCv;
+};
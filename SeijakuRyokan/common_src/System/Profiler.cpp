@@ -0,0 +1,261 @@
+﻿/*****************************************************************//**
+ * @file   Profiler.cpp
+ * @brief  スコープ単位の軽量 CPU プロファイラ実装
+ *********************************************************************/
+#include "Profiler.h"
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_USE_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PROFILER_USE_RDTSC 1
+#else
+#define PROFILER_USE_RDTSC 0
+#endif
+
+std::atomic<bool> Profiler::g_enabled{ false };
+
+namespace
+{
+    constexpr size_t EVENT_MASK = Profiler::EVENTS_PER_THREAD - 1;
+    static_assert((Profiler::EVENTS_PER_THREAD & EVENT_MASK) == 0, "EVENTS_PER_THREAD must be a power of two");
+
+    struct Event
+    {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    struct ThreadBuffer
+    {
+        uint32_t tid = 0;
+        char name[32] = {};
+        std::atomic<uint64_t> head{ 0 }; // これまでに書いた数（書き込み位置は head & EVENT_MASK）
+        std::unique_ptr<Event[]> events{ new Event[Profiler::EVENTS_PER_THREAD] };
+    };
+
+    // スレッドが終わってもバッファは残す（終了したワーカーの記録も書き出せるように）。
+    // ただし終了したスレッドのバッファは g_freeBuffers に戻し、次に記録を始めたスレッドが使い回す
+    // （そのとき前の記録は消える）。バッファの数は同時に記録したスレッド数で頭打ちになる
+    std::mutex g_registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> g_threads;
+    std::vector<ThreadBuffer*> g_freeBuffers;
+    uint32_t g_nextTid = 1;
+
+    // バッファは最初の Record で確保する。それまでは SetThreadName の名前だけ覚えておく
+    thread_local ThreadBuffer* t_buffer = nullptr;
+    thread_local char t_name[32] = {};
+
+    // スレッド終了時にバッファを g_freeBuffers に戻す
+    struct ThreadBufferReleaser
+    {
+        bool armed = false;
+
+        ~ThreadBufferReleaser()
+        {
+            if (armed && t_buffer) {
+                std::lock_guard<std::mutex> lock(g_registryMutex);
+                g_freeBuffers.push_back(t_buffer);
+                t_buffer = nullptr;
+            }
+        }
+    };
+
+    thread_local ThreadBufferReleaser t_releaser;
+
+    ThreadBuffer* GetThreadBuffer()
+    {
+        if (!t_buffer) {
+            MemoryTagScope memoryTag(MemoryTag::System);
+            std::lock_guard<std::mutex> lock(g_registryMutex);
+            ThreadBuffer* buffer = nullptr;
+            if (!g_freeBuffers.empty()) {
+                buffer = g_freeBuffers.back();
+                g_freeBuffers.pop_back();
+                buffer->head.store(0, std::memory_order_relaxed);
+            }
+            else {
+                g_threads.push_back(std::make_unique<ThreadBuffer>());
+                buffer = g_threads.back().get();
+            }
+            buffer->tid = g_nextTid++;
+            if (t_name[0]) {
+                std::snprintf(buffer->name, sizeof(buffer->name), "%s", t_name);
+            }
+            else {
+                std::snprintf(buffer->name, sizeof(buffer->name), "thread %u", buffer->tid);
+            }
+            t_buffer = buffer;
+            t_releaser.armed = true;
+        }
+        return t_buffer;
+    }
+
+    // Now() のカウントとマイクロ秒の対応（起動時と書き出し時の 2 点から求める）
+    struct ClockOrigin
+    {
+        uint64_t ticks;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    const ClockOrigin g_origin{ Profiler::Now(), std::chrono::steady_clock::now() };
+
+    double TicksPerMicrosecond()
+    {
+#if PROFILER_USE_RDTSC
+        const uint64_t ticks = Profiler::Now();
+        const auto time = std::chrono::steady_clock::now();
+        const double us = std::chrono::duration<double, std::micro>(time - g_origin.time).count();
+        if (us < 1000.0) {
+            return 1000.0; // 起動直後は測れないので仮の 1GHz
+        }
+        return static_cast<double>(ticks - g_origin.ticks) / us;
+#else
+        return 1000.0; // steady_clock のナノ秒
+#endif
+    }
+
+    // 記録中でも読めるように写してから、写している間に上書きされた分を捨てる
+    void CopyEvents(const ThreadBuffer& buffer, std::vector<Event>& events)
+    {
+        const uint64_t head = buffer.head.load(std::memory_order_acquire);
+        const uint64_t count = (std::min<uint64_t>)(head, Profiler::EVENTS_PER_THREAD);
+        events.clear();
+        for (uint64_t i = head - count; i < head; ++i) {
+            events.push_back(buffer.events[i & EVENT_MASK]);
+        }
+        // 書き手が after まで進んでいれば、番号 after - EVENTS_PER_THREAD 未満のスロットは書き換わっている
+        const uint64_t after = buffer.head.load(std::memory_order_acquire);
+        const uint64_t firstValid = after > Profiler::EVENTS_PER_THREAD ? after - Profiler::EVENTS_PER_THREAD : 0;
+        const uint64_t firstCopied = head - count;
+        if (firstValid > firstCopied) {
+            const size_t skip = static_cast<size_t>((std::min<uint64_t>)(firstValid - firstCopied, events.size()));
+            events.erase(events.begin(), events.begin() + skip);
+        }
+    }
+
+    void WriteEscaped(FILE* fp, const char* s)
+    {
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') {
+                std::fputc('\\', fp);
+            }
+            if (static_cast<unsigned char>(*s) >= 0x20) {
+                std::fputc(*s, fp);
+            }
+        }
+    }
+}
+
+void Profiler::SetEnabled(bool enable)
+{
+    g_enabled.store(enable, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::Now()
+{
+#if PROFILER_USE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t end)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    Event& e = buffer->events[head & EVENT_MASK];
+    e.name = name;
+    e.start = start;
+    e.end = end;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+    std::snprintf(t_name, sizeof(t_name), "%s", name);
+    if (t_buffer) {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        std::snprintf(t_buffer->name, sizeof(t_buffer->name), "%s", name);
+    }
+}
+
+bool Profiler::WriteChromeTrace(const char* path)
+{
+    FILE* fp = std::fopen(path, "w");
+    if (!fp) {
+        return false;
+    }
+    const double ticksPerUs = TicksPerMicrosecond();
+
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    std::fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    std::vector<Event> events;
+    for (const auto& buffer : g_threads) {
+        std::fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+            first ? "" : ",\n", buffer->tid);
+        WriteEscaped(fp, buffer->name);
+        std::fprintf(fp, "\"}}");
+        first = false;
+
+        CopyEvents(*buffer, events);
+        for (const Event& e : events) {
+            const double ts = static_cast<double>(static_cast<int64_t>(e.start - g_origin.ticks)) / ticksPerUs;
+            const double dur = static_cast<double>(e.end - e.start) / ticksPerUs;
+            std::fprintf(fp, ",\n{\"name\":\"");
+            WriteEscaped(fp, e.name);
+            std::fprintf(fp, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->tid, ts, dur);
+        }
+    }
+    std::fprintf(fp, "\n]}\n");
+    const bool ok = std::ferror(fp) == 0;
+    std::fclose(fp);
+    return ok;
+}
+
+std::vector<Profiler::ZoneSample> Profiler::CollectSlowestZones(uint64_t begin, uint64_t end, size_t maxCount)
+{
+    std::vector<ZoneSample> samples;
+    if (maxCount == 0) {
+        return samples;
+    }
+    const double ticksPerUs = TicksPerMicrosecond();
+
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    std::vector<Event> events;
+    for (const auto& buffer : g_threads) {
+        CopyEvents(*buffer, events);
+        // 新しいものから見て、begin より前に終わったところで打ち切る
+        for (auto it = events.rbegin(); it != events.rend() && it->end >= begin; ++it) {
+            if (it->end < end) {
+                samples.push_back({ it->name, buffer->tid, static_cast<double>(it->end - it->start) / ticksPerUs });
+            }
+        }
+    }
+    const size_t keep = (std::min)(maxCount, samples.size());
+    std::partial_sort(samples.begin(), samples.begin() + keep, samples.end(),
+        [](const ZoneSample& a, const ZoneSample& b) { return a.durationUs > b.durationUs; });
+    samples.resize(keep);
+    return samples;
+}
+
+void Profiler::Clear()
+{
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    for (const auto& buffer : g_threads) {
+        buffer->head.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,97 @@
+﻿/*****************************************************************//**
+ * @file   Profiler.h
+ * @brief  スコープ単位の軽量 CPU プロファイラ（Chrome トレース形式で書き出し）
+ *
+ * @details
+ * - PROFILE_ZONE("名前") を置いたスコープの開始・終了時刻を記録する
+ * - 記録先はスレッドごとのリングバッファ（書き込みはそのスレッドだけなのでロック無し）。
+ *   古い記録から上書きされるので、ヒッチの直後に書き出せば直前の数秒が残っている
+ * - リングバッファはそのスレッドの最初の記録で確保する。終了したスレッドのバッファは
+ *   次に記録を始めたスレッドが使い回す（終了したスレッドの記録はそれまで書き出せる）
+ * - 時刻は x86/x64 なら rdtsc、それ以外は steady_clock。書き出すときに換算する
+ * - WriteChromeTrace の JSON は chrome://tracing や Perfetto でそのまま開ける
+ * - 無効中（既定）のコストは atomic<bool> の読み込み 1 回と分岐だけ。
+ *   SEIJAKU_PROFILER を 0 にするとマクロごと消える
+ * - 名前は文字列リテラルなど、書き出しまで生きているものを渡す
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef SEIJAKU_PROFILER
+#define SEIJAKU_PROFILER 1
+#endif
+
+namespace Profiler
+{
+    // 1 スレッドのリングバッファに残る区間の数
+    constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+    extern std::atomic<bool> g_enabled;
+
+    inline bool IsEnabled() { return g_enabled.load(std::memory_order_relaxed); }
+    void SetEnabled(bool enable);
+
+    // 今の時刻（rdtsc または steady_clock のカウント）
+    uint64_t Now();
+
+    // 区間を 1 つ記録する（PROFILE_ZONE から呼ばれる）
+    void Record(const char* name, uint64_t start, uint64_t end);
+
+    // トレース上のスレッド名（呼んだスレッドに付く）。無効中は名前を覚えるだけでバッファは確保しない
+    void SetThreadName(const char* name);
+
+    // 全スレッドの記録を Chrome トレース形式の JSON で書き出す
+    bool WriteChromeTrace(const char* path);
+
+    // 記録を捨てる（記録中のスレッドがいない時に呼ぶ）
+    void Clear();
+
+    struct ZoneSample
+    {
+        const char* name;
+        uint32_t tid;      // トレース上のスレッド番号
+        double durationUs;
+    };
+
+    // [begin, end)（Now() のカウント）の間に終わった区間を全スレッドから集め、長い順に maxCount 個返す。
+    // ヒッチしたフレームで何が長かったかを残すため
+    std::vector<ZoneSample> CollectSlowestZones(uint64_t begin, uint64_t end, size_t maxCount);
+
+    // スコープの開始・終了を記録する
+    class Zone
+    {
+    public:
+        explicit Zone(const char* name)
+            : m_name(IsEnabled() ? name : nullptr)
+            , m_start(m_name ? Now() : 0)
+        {
+        }
+
+        ~Zone()
+        {
+            if (m_name) {
+                Record(m_name, m_start, Now());
+            }
+        }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* m_name;
+        uint64_t m_start;
+    };
+}
+
+#if SEIJAKU_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ::Profiler::Zone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) ::Profiler::SetThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
@@ -0,0 +1,155 @@
+﻿#include "NullGraphics.h"
+#include "../../common_src/System/FrameArena.h"
+#include "../../common_src/System/FrameCounters.h"
+#include "../../common_src/System/MemoryTracker.h"
+#include <cstdio>
+
+NullGraphics::~NullGraphics()
+{
+    Finalize();
+}
+
+bool NullGraphics::Initialize(void* /*windowHandle*/, int /*screenWidth*/, int /*screenHeight*/)
+{
+    ResetStats();
+    m_trace.clear();
+    m_sdfMode = false;
+    return true;
+}
+
+void NullGraphics::Finalize()
+{
+    m_textures.clear();
+}
+
+void NullGraphics::BeginDraw()
+{
+    FrameArena::ForThisThread().Reset();
+    m_current = NullDrawStats();
+    m_current.frames = 1;
+    m_hasLastTexture = false;
+    m_lastTexture = nullptr;
+    m_quadRun = 0;
+    m_inFrame = true;
+
+    if (m_traceEnabled) {
+        m_trace.push_back({ DrawTraceOp::BeginFrame, static_cast<uint32_t>(m_total.frames) });
+    }
+}
+
+void NullGraphics::EndDraw()
+{
+    if (!m_inFrame) {
+        return;
+    }
+    FlushQuadRun();
+    m_inFrame = false;
+    m_frame = m_current;
+    m_total.Add(m_current);
+
+    FrameCounters::Add(FrameCounter::Quads, m_current.quads);
+    FrameCounters::Add(FrameCounter::TextureSwitches, m_current.textureSwitches);
+    FrameCounters::Add(FrameCounter::SdfToggles, m_current.sdfToggles);
+}
+
+TextureHandle NullGraphics::LoadTexture(const char* filePath)
+{
+    if (!filePath) {
+        return nullptr;
+    }
+    MemoryTagScope memoryTag(MemoryTag::Texture);
+    // 同じパスは同じハンドル（実機の見た目上の切り替え回数に合わせる）
+    auto it = m_textures.find(filePath);
+    if (it != m_textures.end()) {
+        return it->second.get();
+    }
+    auto texture = std::make_unique<Texture>();
+    texture->id = m_nextTextureId++;
+    texture->path = filePath;
+    TextureHandle handle = texture.get();
+    m_textures.emplace(filePath, std::move(texture));
+    return handle;
+}
+
+void NullGraphics::UnloadTexture(TextureHandle handle)
+{
+    // ハンドルはパス単位で共有しているので、Finalize までまとめて持っておく
+    (void)handle;
+}
+
+void NullGraphics::DrawQuad(const Quad& quad)
+{
+    if (!m_inFrame) {
+        return;
+    }
+    if (!m_hasLastTexture || quad.texture != m_lastTexture) {
+        FlushQuadRun();
+        if (m_hasLastTexture) {
+            ++m_current.textureSwitches;
+        }
+        m_hasLastTexture = true;
+        m_lastTexture = quad.texture;
+        if (m_traceEnabled) {
+            m_trace.push_back({ DrawTraceOp::Texture, TextureId(quad.texture) });
+        }
+    }
+    ++m_current.quads;
+    ++m_quadRun;
+}
+
+void NullGraphics::SetSdfMode(bool enable)
+{
+    if (enable == m_sdfMode) {
+        return;
+    }
+    FlushQuadRun();
+    m_sdfMode = enable;
+    ++m_current.sdfToggles;
+    if (m_traceEnabled) {
+        m_trace.push_back({ DrawTraceOp::Sdf, enable ? 1u : 0u });
+    }
+}
+
+bool NullGraphics::SaveTrace(const char* path) const
+{
+    FILE* fp = std::fopen(path, "w");
+    if (!fp) {
+        return false;
+    }
+    for (const DrawTraceEvent& e : m_trace) {
+        switch (e.op) {
+        case DrawTraceOp::BeginFrame: std::fprintf(fp, "frame %u\n", e.value); break;
+        case DrawTraceOp::Texture:    std::fprintf(fp, "  tex %u\n", e.value); break;
+        case DrawTraceOp::Quads:      std::fprintf(fp, "  quads %u\n", e.value); break;
+        case DrawTraceOp::Sdf:        std::fprintf(fp, "  sdf %u\n", e.value); break;
+        }
+    }
+    const bool ok = std::ferror(fp) == 0;
+    std::fclose(fp);
+    return ok;
+}
+
+void NullGraphics::ResetStats()
+{
+    m_current = NullDrawStats();
+    m_frame = NullDrawStats();
+    m_total = NullDrawStats();
+}
+
+uint32_t NullGraphics::TextureId(TextureHandle handle) const
+{
+    return handle ? static_cast<const Texture*>(handle)->id : 0;
+}
+
+void NullGraphics::FlushQuadRun()
+{
+    if (m_quadRun == 0) {
+        return;
+    }
+    if (m_traceEnabled) {
+        m_trace.push_back({ DrawTraceOp::Quads, m_quadRun });
+    }
+    // 実機ならテクスチャか SDF が切り替わるたびに 1 ドローになる
+    FrameCounters::Add(FrameCounter::DrawCalls);
+    m_quadRun = 0;
+}
@@ -0,0 +1,104 @@
+﻿/*****************************************************************//**
+ * @file   NullGraphics.h
+ * @brief  何も描かずに描画呼び出しだけを記録する IGraphics（ヘッドレス実行用）
+ *
+ * @details
+ * - DrawQuad / SetSdfMode を数えるだけなので、Game::Draw の CPU 側コストだけが残る
+ * - 記録は「同じテクスチャが続く Quad の本数」「テクスチャ切り替え」「SDF 切り替え」
+ *   の3種類のイベントに詰めて持つ（1イベント 8 バイト）
+ * - LoadTexture はファイルを開かず、パスごとに番号を振ったダミーのハンドルを返す
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../../common_src/IGraphics.h"
+
+// 描画統計（フレーム単位・累計の両方に使う）
+struct NullDrawStats
+{
+    uint64_t frames = 0;
+    uint64_t quads = 0;
+    uint64_t textureSwitches = 0; // 直前の Quad とテクスチャが異なった回数
+    uint64_t sdfToggles = 0;      // SetSdfMode で状態が実際に変わった回数
+
+    void Add(const NullDrawStats& other)
+    {
+        frames += other.frames;
+        quads += other.quads;
+        textureSwitches += other.textureSwitches;
+        sdfToggles += other.sdfToggles;
+    }
+};
+
+enum class DrawTraceOp : uint8_t
+{
+    BeginFrame, // value = フレーム番号
+    Texture,    // value = テクスチャ番号（0 は nullptr）
+    Quads,      // value = 同じテクスチャで続いた Quad の本数
+    Sdf,        // value = 0 / 1
+};
+
+struct DrawTraceEvent
+{
+    DrawTraceOp op;
+    uint32_t value;
+};
+
+class NullGraphics : public IGraphics
+{
+public:
+    NullGraphics() = default;
+    ~NullGraphics() override;
+
+    // IGraphicsインターフェースの実装
+    bool Initialize(void* windowHandle, int screenWidth, int screenHeight) override;
+    void Finalize() override;
+    void BeginDraw() override;
+    void EndDraw() override;
+    TextureHandle LoadTexture(const char* filePath) override;
+    void UnloadTexture(TextureHandle handle) override;
+    void DrawQuad(const Quad& quad) override;
+    void SetSdfMode(bool enable) override;
+
+    // true の間はイベント列を記録する（統計は常に取る）
+    void SetTraceEnabled(bool enable) { m_traceEnabled = enable; }
+    const std::vector<DrawTraceEvent>& GetTrace() const { return m_trace; }
+    void ClearTrace() { m_trace.clear(); }
+    // 1行1イベントのテキストで書き出す
+    bool SaveTrace(const char* path) const;
+
+    const NullDrawStats& GetFrameStats() const { return m_frame; } // 直前に EndDraw したフレーム
+    const NullDrawStats& GetTotalStats() const { return m_total; }
+    void ResetStats();
+
+    size_t GetTextureCount() const { return m_textures.size(); }
+
+private:
+    struct Texture
+    {
+        uint32_t id = 0;
+        std::string path;
+    };
+
+    uint32_t TextureId(TextureHandle handle) const;
+    void FlushQuadRun();
+
+    std::unordered_map<std::string, std::unique_ptr<Texture>> m_textures;
+    uint32_t m_nextTextureId = 1;
+
+    bool m_sdfMode = false;
+    bool m_inFrame = false;
+    bool m_hasLastTexture = false;
+    TextureHandle m_lastTexture = nullptr;
+    uint32_t m_quadRun = 0;
+
+    bool m_traceEnabled = false;
+    std::vector<DrawTraceEvent> m_trace;
+
+    NullDrawStats m_current;
+    NullDrawStats m_frame;
+    NullDrawStats m_total;
+};
@@ -0,0 +1,610 @@
+﻿/*****************************************************************//**
+ * @file   SoftwareGraphics.cpp
+ * @brief  CPU だけで描く IGraphics の実装
+ *********************************************************************/
+#include "SoftwareGraphics.h"
+#include "../../tools/Common/JpegIO.h"
+#include "../../common_src/System/FrameArena.h"
+#include "../../common_src/System/MemoryTracker.h"
+#include "../../common_src/System/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    constexpr float DEG_TO_RAD = 3.14159265358979f / 180.0f;
+
+    using Clock = std::chrono::steady_clock;
+
+    double Micros(Clock::time_point from)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - from).count();
+    }
+
+    // 0 <= a * xc + b < 1 を満たすピクセル中心 xc の範囲を [lo, hi) に絞る
+    bool ClipSpan(float a, float b, float& lo, float& hi)
+    {
+        if (std::fabs(a) < 1e-12f) {
+            return b >= 0.0f && b < 1.0f;
+        }
+        float e0 = -b / a;
+        float e1 = (1.0f - b) / a;
+        if (e0 > e1) std::swap(e0, e1);
+        lo = (std::max)(lo, e0);
+        hi = (std::min)(hi, e1);
+        return lo < hi;
+    }
+
+    static_assert(SoftwareGraphics::TILE_SIZE <= 64, "タイルの 1 行を uint64_t のビットで持つ");
+
+    // タイル内の [begin, end) のビット（end <= 64）
+    inline uint64_t SpanBits(int begin, int end)
+    {
+        const uint64_t upTo = end >= 64 ? ~0ull : ((1ull << end) - 1);
+        return upTo & ~((1ull << begin) - 1);
+    }
+
+    inline int LowestBit(uint64_t v)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, v);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+
+    inline int HighestBit(uint64_t v)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, v);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(v);
+#endif
+    }
+
+    // 2x2 の平均で半分の大きさにする。色はアルファで重み付けする（透明部分の色が縁に滲まない）
+    std::vector<uint32_t> Downsample(const uint32_t* src, int width, int height, int& outWidth, int& outHeight)
+    {
+        outWidth = (std::max)(1, width / 2);
+        outHeight = (std::max)(1, height / 2);
+        std::vector<uint32_t> dst(static_cast<size_t>(outWidth) * outHeight);
+        for (int y = 0; y < outHeight; ++y) {
+            const int sy0 = (std::min)(y * 2, height - 1), sy1 = (std::min)(y * 2 + 1, height - 1);
+            for (int x = 0; x < outWidth; ++x) {
+                const int sx0 = (std::min)(x * 2, width - 1), sx1 = (std::min)(x * 2 + 1, width - 1);
+                const uint32_t px[4] = {
+                    src[static_cast<size_t>(sy0) * width + sx0], src[static_cast<size_t>(sy0) * width + sx1],
+                    src[static_cast<size_t>(sy1) * width + sx0], src[static_cast<size_t>(sy1) * width + sx1] };
+                uint32_t sum[3] = {}, plain[3] = {}, alpha = 0;
+                for (uint32_t p : px) {
+                    const uint32_t a = p >> 24;
+                    for (int c = 0; c < 3; ++c) {
+                        const uint32_t v = (p >> (c * 8)) & 0xFF;
+                        sum[c] += v * a;
+                        plain[c] += v;
+                    }
+                    alpha += a;
+                }
+                uint32_t out = ((alpha + 2) / 4) << 24;
+                for (int c = 0; c < 3; ++c) {
+                    const uint32_t v = alpha > 0 ? (sum[c] + alpha / 2) / alpha : (plain[c] + 2) / 4;
+                    out |= v << (c * 8);
+                }
+                dst[static_cast<size_t>(y) * outWidth + x] = out;
+            }
+        }
+        return dst;
+    }
+}
+
+SoftwareGraphics::SoftwareGraphics(unsigned workerCount)
+    : m_requestedWorkers(workerCount)
+{
+}
+
+SoftwareGraphics::~SoftwareGraphics()
+{
+    Finalize();
+}
+
+bool SoftwareGraphics::Initialize(void* /*windowHandle*/, int screenWidth, int screenHeight)
+{
+    MemoryTagScope memoryTag(MemoryTag::Graphics);
+    if (screenWidth <= 0 || screenHeight <= 0) {
+        return false;
+    }
+    m_width = screenWidth;
+    m_height = screenHeight;
+    m_tilesX = (screenWidth + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY = (screenHeight + TILE_SIZE - 1) / TILE_SIZE;
+    m_framebuffer.assign(static_cast<size_t>(screenWidth) * screenHeight, 0);
+    m_tileQuads.assign(static_cast<size_t>(m_tilesX) * m_tilesY, std::vector<uint32_t>());
+    m_scratch = TileScratch();
+
+    // DirectXGraphics::BeginDraw と同じ (0.1, 0.1, 0.1, 1)
+    m_clearColor = 0xFF1A1A1Au;
+
+    // 白テクスチャ（ファイルは読まない）
+    const uint32_t white = 0xFFFFFFFFu;
+    m_defaultTexture = CreateTexture(1, 1, &white);
+
+    unsigned threads = m_requestedWorkers;
+    if (threads == 0) {
+        threads = (std::max)(1u, std::thread::hardware_concurrency());
+    }
+    m_quit = false;
+    for (unsigned i = 1; i < threads; ++i) {
+        m_workers.emplace_back(&SoftwareGraphics::WorkerMain, this);
+    }
+    return true;
+}
+
+void SoftwareGraphics::Finalize()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_startCv.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    m_textures.clear();
+    m_defaultTexture = nullptr;
+    m_framebuffer.clear();
+    m_tileQuads.clear();
+    m_rasterQuads.clear();
+}
+
+void SoftwareGraphics::BeginDraw()
+{
+    FrameArena::ForThisThread().Reset();
+    m_commands.Reset();
+}
+
+void SoftwareGraphics::EndDraw()
+{
+    PROFILE_ZONE("SoftwareGraphics::EndDraw");
+    m_stats = SoftwareRasterStats();
+
+    Clock::time_point start = Clock::now();
+    m_commands.Sort();
+    BinQuads();
+    m_stats.binMicros = Micros(start);
+
+    // 画面クリアもタイル単位でラスタライズと一緒に行う
+    start = Clock::now();
+    RasterizeTiles();
+    m_stats.rasterMicros = Micros(start);
+    m_stats.pixels = m_counts.pixels;
+    m_stats.copiedPixels = m_counts.copiedPixels;
+    m_stats.culledRefs = m_counts.culledRefs;
+}
+
+TextureHandle SoftwareGraphics::LoadTexture(const char* filePath)
+{
+    MemoryTagScope memoryTag(MemoryTag::Texture);
+    RgbaImage image;
+    if (!filePath || !LoadImageRgba(filePath, image)) {
+        std::fprintf(stderr, "[ERROR] SoftwareGraphics: failed to load %s\n", filePath ? filePath : "(null)");
+        return nullptr;
+    }
+    // RgbaImage は R,G,B,A のバイト列なので、リトルエンディアンではそのまま RGBA8
+    std::vector<uint32_t> texels(static_cast<size_t>(image.width) * image.height);
+    for (size_t i = 0; i < texels.size(); ++i) {
+        const uint8_t* px = &image.pixels[i * 4];
+        texels[i] = px[0] | (px[1] << 8) | (px[2] << 16) | (static_cast<uint32_t>(px[3]) << 24);
+    }
+    return CreateTexture(image.width, image.height, texels.data());
+}
+
+TextureHandle SoftwareGraphics::CreateTexture(int width, int height, const uint32_t* rgba)
+{
+    MemoryTagScope memoryTag(MemoryTag::Texture);
+    if (width <= 0 || height <= 0 || !rgba) {
+        return nullptr;
+    }
+    auto tex = std::make_unique<Texture>();
+    tex->width = width;
+    tex->height = height;
+    tex->texels.assign(rgba, rgba + static_cast<size_t>(width) * height);
+    tex->opaque = std::all_of(tex->texels.begin(), tex->texels.end(), [](uint32_t t) { return (t >> 24) == 0xFF; });
+    for (int w = width, h = height; w > 1 || h > 1;) {
+        const std::vector<uint32_t>& src = tex->mips.empty() ? tex->texels : tex->mips.back().texels;
+        MipLevel level;
+        level.texels = Downsample(src.data(), w, h, level.width, level.height);
+        w = level.width;
+        h = level.height;
+        tex->mips.push_back(std::move(level));
+    }
+    TextureHandle handle = tex.get();
+    m_textures[handle] = std::move(tex);
+    return handle;
+}
+
+void SoftwareGraphics::UnloadTexture(TextureHandle handle)
+{
+    if (handle && handle != m_defaultTexture) {
+        m_textures.erase(handle);
+    }
+}
+
+void SoftwareGraphics::DrawQuad(const Quad& quad)
+{
+    Quad resolved = quad;
+    if (!resolved.texture) {
+        resolved.texture = m_defaultTexture;
+    }
+    m_commands.Record(resolved, m_sdfMode);
+}
+
+bool SoftwareGraphics::SaveFramebuffer(const char* path) const
+{
+    RgbaImage image;
+    image.width = m_width;
+    image.height = m_height;
+    image.pixels.resize(m_framebuffer.size() * 4);
+    for (size_t i = 0; i < m_framebuffer.size(); ++i) {
+        const uint32_t px = m_framebuffer[i];
+        image.pixels[i * 4 + 0] = static_cast<uint8_t>(px);
+        image.pixels[i * 4 + 1] = static_cast<uint8_t>(px >> 8);
+        image.pixels[i * 4 + 2] = static_cast<uint8_t>(px >> 16);
+        image.pixels[i * 4 + 3] = 0xFF;
+    }
+    return SavePng(path, image);
+}
+
+bool SoftwareGraphics::SetupQuad(const DrawCommand& cmd, RasterQuad& out) const
+{
+    const Quad& q = cmd.quad;
+    auto found = m_textures.find(q.texture);
+    if (found == m_textures.end()) {
+        return false; // 解放済み・不明なハンドル
+    }
+    const Texture* tex = found->second.get();
+
+    const float w = q.size.x;
+    const float h = q.size.y;
+    if (q.color.w <= 0.0f || std::fabs(w) < 1e-6f || std::fabs(h) < 1e-6f) {
+        return false;
+    }
+
+    float cs = 1.0f, sn = 0.0f;
+    if (q.angleDeg != 0.0f) {
+        cs = std::cos(q.angleDeg * DEG_TO_RAD);
+        sn = std::sin(q.angleDeg * DEG_TO_RAD);
+    }
+
+    // 外接矩形（SpriteBatch::Add と同じ変換）
+    float minX = q.position.x, maxX = q.position.x;
+    float minY = q.position.y, maxY = q.position.y;
+    for (int i = 0; i < 4; ++i) {
+        const float lx = ((i & 1) ? 0.5f : -0.5f) * w;
+        const float ly = ((i & 2) ? 0.5f : -0.5f) * h;
+        const float px = lx * cs - ly * sn + q.position.x;
+        const float py = lx * sn + ly * cs + q.position.y;
+        minX = (std::min)(minX, px); maxX = (std::max)(maxX, px);
+        minY = (std::min)(minY, py); maxY = (std::max)(maxY, py);
+    }
+    out.minX = (std::max)(0, static_cast<int>(std::floor(minX)));
+    out.minY = (std::max)(0, static_cast<int>(std::floor(minY)));
+    out.maxX = (std::min)(m_width, static_cast<int>(std::ceil(maxX)));
+    out.maxY = (std::min)(m_height, static_cast<int>(std::ceil(maxY)));
+    if (out.minX >= out.maxX || out.minY >= out.maxY) {
+        return false;
+    }
+
+    // 画面 → ローカルの逆変換
+    out.sx = cs / w;
+    out.sy = sn / w;
+    out.s0 = 0.5f - (q.position.x * cs + q.position.y * sn) / w;
+    out.tx = -sn / h;
+    out.ty = cs / h;
+    out.t0 = 0.5f - (-q.position.x * sn + q.position.y * cs) / h;
+
+    out.texture = tex;
+    out.sdf = cmd.sdf;
+    out.sample.texels = tex->texels.data();
+    out.sample.width = tex->width;
+    out.sample.height = tex->height;
+    out.uScale = q.uvSize.x * static_cast<float>(tex->width);
+    out.uOffset = q.uvPos.x * static_cast<float>(tex->width) - 0.5f;
+    out.vScale = q.uvSize.y * static_cast<float>(tex->height);
+    out.vOffset = q.uvPos.y * static_cast<float>(tex->height) - 0.5f;
+
+    // 乗算色はクランプしない（テクセルとの積をカーネルが 0～255 に切り詰める）
+    const float color[4] = { q.color.x, q.color.y, q.color.z, q.color.w };
+    out.solid = !cmd.sdf && tex->width == 1 && tex->height == 1;
+    if (out.solid) {
+        // テクセル × 乗算色を先に掛けて単色スパンで描く
+        const uint32_t t = tex->texels[0];
+        const float texel[4] = {
+            static_cast<float>(t & 0xFF), static_cast<float>((t >> 8) & 0xFF),
+            static_cast<float>((t >> 16) & 0xFF), static_cast<float>(t >> 24) };
+        for (int i = 0; i < 4; ++i) {
+            out.color[i] = (std::min)((std::max)(texel[i] * color[i], 0.0f), 255.0f);
+        }
+        if (out.color[3] <= 0.0f) {
+            return false;
+        }
+    }
+    else {
+        for (int i = 0; i < 4; ++i) {
+            out.color[i] = color[i];
+        }
+    }
+
+    // 不透明なら下に描いたものは見えない（後ろから見て、隠れるスパンを削る）
+    out.opaque = !cmd.sdf && color[3] >= 1.0f && tex->opaque;
+
+    // 回転なし・等倍で、ピクセル中心がテクセル中心に重なるなら、バイリニアの結果はテクセルそのもの
+    const bool white = color[0] == 1.0f && color[1] == 1.0f && color[2] == 1.0f;
+    const bool unitUv = q.uvPos.x >= 0.0f && q.uvPos.y >= 0.0f
+        && q.uvPos.x + q.uvSize.x <= 1.0f && q.uvPos.y + q.uvSize.y <= 1.0f;
+    if (out.opaque && !out.solid && white && unitUv && q.angleDeg == 0.0f) {
+        const float du = out.sx * out.uScale;
+        const float dv = out.ty * out.vScale;
+        const float u = (out.sx * 0.5f + out.s0) * out.uScale + out.uOffset;
+        const float v = (out.ty * 0.5f + out.t0) * out.vScale + out.vOffset;
+        if (std::fabs(du - 1.0f) < 1e-5f && std::fabs(dv - 1.0f) < 1e-5f
+            && std::fabs(u - std::round(u)) < 1e-3f && std::fabs(v - std::round(v)) < 1e-3f) {
+            out.copy = true;
+            out.copyX = static_cast<int>(std::lround(u));
+            out.copyY = static_cast<int>(std::lround(v));
+        }
+    }
+
+    // 縮小なら、1 ピクセルあたりのテクセル数が 2 未満になるミップまで下りる。
+    // SDF は距離の勾配を見るので 0 段目のまま（アトラスのページにもミップは無い）
+    if (!out.copy && !out.solid && !cmd.sdf) {
+        const float dx = std::hypot(out.sx * out.uScale, out.tx * out.vScale);
+        const float dy = std::hypot(out.sy * out.uScale, out.ty * out.vScale);
+        float rho = (std::max)(dx, dy);
+        size_t level = 0;
+        while (rho >= 2.0f && level < tex->mips.size()) {
+            rho *= 0.5f;
+            ++level;
+        }
+        if (level > 0) {
+            const MipLevel& mip = tex->mips[level - 1];
+            out.sample.texels = mip.texels.data();
+            out.sample.width = mip.width;
+            out.sample.height = mip.height;
+            out.uScale = q.uvSize.x * static_cast<float>(mip.width);
+            out.uOffset = q.uvPos.x * static_cast<float>(mip.width) - 0.5f;
+            out.vScale = q.uvSize.y * static_cast<float>(mip.height);
+            out.vOffset = q.uvPos.y * static_cast<float>(mip.height) - 0.5f;
+        }
+    }
+    return true;
+}
+
+bool SoftwareGraphics::RowSpan(const RasterQuad& q, int y, int x0, int x1, int& xs, int& xe)
+{
+    const float yc = static_cast<float>(y) + 0.5f;
+
+    // s,t が [0,1) に入るピクセル中心の範囲（回転していても1行では1区間）
+    float lo = static_cast<float>(x0) + 0.5f;
+    float hi = static_cast<float>(x1) + 0.5f;
+    if (!ClipSpan(q.sx, q.sy * yc + q.s0, lo, hi) || !ClipSpan(q.tx, q.ty * yc + q.t0, lo, hi)) {
+        return false;
+    }
+    xs = (std::max)(x0, static_cast<int>(std::ceil(lo - 0.5f)));
+    xe = (std::min)(x1, static_cast<int>(std::ceil(hi - 0.5f)));
+    return xs < xe;
+}
+
+void SoftwareGraphics::BinQuads()
+{
+    PROFILE_ZONE("SoftwareGraphics::BinQuads");
+    for (std::vector<uint32_t>& list : m_tileQuads) {
+        list.clear();
+    }
+    m_rasterQuads.clear();
+
+    const size_t count = m_commands.Size();
+    for (size_t i = 0; i < count; ++i) {
+        RasterQuad rq;
+        if (!SetupQuad(m_commands.GetSorted(i), rq)) {
+            continue;
+        }
+        const uint32_t index = static_cast<uint32_t>(m_rasterQuads.size());
+        m_rasterQuads.push_back(rq);
+
+        const int tx0 = rq.minX / TILE_SIZE, tx1 = (rq.maxX - 1) / TILE_SIZE;
+        const int ty0 = rq.minY / TILE_SIZE, ty1 = (rq.maxY - 1) / TILE_SIZE;
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                m_tileQuads[static_cast<size_t>(ty) * m_tilesX + tx].push_back(index);
+            }
+        }
+        m_stats.tileRefs += static_cast<uint32_t>((tx1 - tx0 + 1) * (ty1 - ty0 + 1));
+    }
+    m_stats.quads = static_cast<uint32_t>(m_rasterQuads.size());
+}
+
+void SoftwareGraphics::RasterizeTiles()
+{
+    PROFILE_ZONE("SoftwareGraphics::RasterizeTiles");
+    m_nextTile.store(0);
+    m_counts = RasterCounts();
+
+    if (!m_workers.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_frameId;
+        m_finishedWorkers = 0;
+    }
+    m_startCv.notify_all();
+
+    // 呼び出しスレッドもタイルを取る
+    RasterCounts counts;
+    const int tileCount = m_tilesX * m_tilesY;
+    for (int t = m_nextTile.fetch_add(1); t < tileCount; t = m_nextTile.fetch_add(1)) {
+        RasterizeTile(t, m_scratch, counts);
+    }
+    AddCounts(counts);
+
+    if (!m_workers.empty()) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCv.wait(lock, [this] { return m_finishedWorkers == m_workers.size(); });
+    }
+}
+
+void SoftwareGraphics::WorkerMain()
+{
+    PROFILE_THREAD_NAME("raster worker");
+    uint64_t seenFrame = 0;
+    TileScratch scratch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_startCv.wait(lock, [&] { return m_quit || m_frameId != seenFrame; });
+            if (m_quit) {
+                return;
+            }
+            seenFrame = m_frameId;
+        }
+
+        RasterCounts counts;
+        {
+            PROFILE_ZONE("SoftwareGraphics::RasterizeTiles");
+            const int tileCount = m_tilesX * m_tilesY;
+            for (int t = m_nextTile.fetch_add(1); t < tileCount; t = m_nextTile.fetch_add(1)) {
+                RasterizeTile(t, scratch, counts);
+            }
+        }
+        AddCounts(counts);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_finishedWorkers;
+        }
+        m_doneCv.notify_one();
+    }
+}
+
+void SoftwareGraphics::AddCounts(const RasterCounts& counts)
+{
+    std::lock_guard<std::mutex> lock(m_countsMutex);
+    m_counts.pixels += counts.pixels;
+    m_counts.copiedPixels += counts.copiedPixels;
+    m_counts.culledRefs += counts.culledRefs;
+}
+
+void SoftwareGraphics::RasterizeTile(int tileIndex, TileScratch& scratch, RasterCounts& counts)
+{
+    const int x0 = (tileIndex % m_tilesX) * TILE_SIZE;
+    const int y0 = (tileIndex / m_tilesX) * TILE_SIZE;
+    const int x1 = (std::min)(x0 + TILE_SIZE, m_width);
+    const int y1 = (std::min)(y0 + TILE_SIZE, m_height);
+    const int rows = y1 - y0;
+    const uint64_t full = SpanBits(0, x1 - x0);
+
+    const std::vector<uint32_t>& list = m_tileQuads[tileIndex];
+    scratch.spans.resize(list.size() * TILE_SIZE);
+    std::fill(scratch.covered, scratch.covered + rows, 0ull);
+
+    // 後ろから見て、後に描く不透明な Quad で隠れるピクセルをスパンの両端から削る。
+    // タイルが埋まったら、それより前の Quad とクリアは見えない
+    int fullRows = 0;
+    size_t first = list.size();
+    while (first > 0 && fullRows < rows) {
+        --first;
+        const RasterQuad& q = m_rasterQuads[list[first]];
+        TileSpan* spans = &scratch.spans[first * TILE_SIZE];
+        const int qx0 = (std::max)(x0, q.minX), qx1 = (std::min)(x1, q.maxX);
+        const int r0 = (std::max)(y0, q.minY) - y0, r1 = (std::min)(y1, q.maxY) - y0;
+        bool visible = false;
+        for (int r = r0; r < r1; ++r) {
+            spans[r] = TileSpan();
+            int xs, xe;
+            if (!RowSpan(q, y0 + r, qx0, qx1, xs, xe)) {
+                continue;
+            }
+            const uint64_t bits = SpanBits(xs - x0, xe - x0);
+            const uint64_t open = bits & ~scratch.covered[r];
+            if (open) {
+                spans[r].begin = static_cast<uint8_t>(LowestBit(open));
+                spans[r].end = static_cast<uint8_t>(HighestBit(open) + 1);
+                visible = true;
+            }
+            if (q.opaque && open) {
+                scratch.covered[r] |= bits;
+                fullRows += scratch.covered[r] == full ? 1 : 0;
+            }
+        }
+        counts.culledRefs += visible ? 0 : 1;
+    }
+    counts.culledRefs += static_cast<uint32_t>(first);
+
+    // クリアは埋まっていない行だけ（一部が覆われた行も、覆った Quad が後から上書きする）
+    if (fullRows < rows) {
+        for (int r = 0; r < rows; ++r) {
+            if (scratch.covered[r] != full) {
+                uint32_t* row = &m_framebuffer[static_cast<size_t>(y0 + r) * m_width];
+                std::fill(row + x0, row + x1, m_clearColor);
+            }
+        }
+    }
+    for (size_t k = first; k < list.size(); ++k) {
+        const RasterQuad& q = m_rasterQuads[list[k]];
+        const TileSpan* spans = &scratch.spans[k * TILE_SIZE];
+        const int r0 = (std::max)(y0, q.minY) - y0, r1 = (std::min)(y1, q.maxY) - y0;
+        for (int r = r0; r < r1; ++r) {
+            if (spans[r].begin < spans[r].end) {
+                DrawSpan(q, y0 + r, x0 + spans[r].begin, x0 + spans[r].end, counts);
+            }
+        }
+    }
+}
+
+void SoftwareGraphics::DrawSpan(const RasterQuad& q, int y, int xs, int xe, RasterCounts& counts)
+{
+    uint32_t* dst = &m_framebuffer[static_cast<size_t>(y) * m_width + xs];
+    const int count = xe - xs;
+    counts.pixels += static_cast<uint64_t>(count);
+
+    if (q.copy) {
+        const int u = q.copyX + xs;
+        const int v = q.copyY + y;
+        if (u >= 0 && u + count <= q.texture->width && v >= 0 && v < q.texture->height) {
+            std::memcpy(dst, &q.texture->texels[static_cast<size_t>(v) * q.texture->width + u], sizeof(uint32_t) * count);
+            counts.copiedPixels += static_cast<uint64_t>(count);
+            return;
+        }
+    }
+    if (q.solid) {
+        BlendSpanSolid(dst, count, q.color);
+        return;
+    }
+
+    const float xc = static_cast<float>(xs) + 0.5f;
+    const float yc = static_cast<float>(y) + 0.5f;
+    SpanParams params;
+    for (int i = 0; i < 4; ++i) {
+        params.color[i] = q.color[i];
+    }
+    params.tu = (q.sy * yc + q.s0 + q.sx * xc) * q.uScale + q.uOffset;
+    params.tv = (q.ty * yc + q.t0 + q.tx * xc) * q.vScale + q.vOffset;
+    params.dtu = q.sx * q.uScale;
+    params.dtv = q.tx * q.vScale;
+    params.opaque = q.opaque;
+    if (q.sdf) {
+        BlendSpanSdf(dst, count, q.sample, params, q.sy * q.uScale, q.ty * q.vScale);
+    }
+    else {
+        BlendSpanTextured(dst, count, q.sample, params);
+    }
+}
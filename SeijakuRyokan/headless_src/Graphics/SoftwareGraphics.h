@@ -0,0 +1,188 @@
+﻿/*****************************************************************//**
+ * @file   SoftwareGraphics.h
+ * @brief  CPU だけで描く IGraphics（GPU の無い CI・バランス調整用）
+ *
+ * @details
+ * - DirectXGraphics と同じ Quad モデル（回転・UV 矩形・乗算色・Straight Alpha・SDF）
+ * - DrawQuad は DrawCommandBuffer に記録し、EndDraw でまとめてラスタライズする
+ *     1. Quad ごとに画面→ローカル座標の逆変換を作り、64x64 のタイルに振り分け
+ *     2. 全コアでタイルを取り合い、タイル内は記録順に横スパン単位で描く
+ *        （タイルの書き込み先は重ならないのでロック不要）
+ * - 重ね描きを減らす
+ *   - タイルごとに Quad を後ろから見て、後に描く不透明な Quad で隠れるスパンを両端から削る
+ *     （タイルの行ごとの覆われたピクセルのビット）。タイルが埋まったらそれより前の Quad とクリアは描かない
+ *   - 回転なし・等倍で不透明な Quad（背景など）はブレンドせずテクセルの行をそのままコピーする
+ *   - テクスチャにはミップ（アルファで重み付けした 2x2 平均）を作り、縮小して描く Quad は
+ *     1 ピクセルが 1～2 テクセルになるミップからバイリニアで読む。GPU 側もクックしたミップを
+ *     MIN_MAG_MIP_LINEAR で読む（こちらは段の間を補間しない）
+ * - 描画結果はメモリ上のフレームバッファ（RGBA8、R が最下位バイト）
+ * - IGraphicsExtensions の非同期読み込みは同期読み込みで済ませる（返った時点で Ready か Failed）
+ *
+ * - 画像読み込みに tools/Common（libpng / libjpeg）を使う。ビルド例は tools/SoftwareRasterBench を参照
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../../common_src/IGraphics.h"
+#include "../../common_src/Graphics/DrawCommandBuffer.h"
+#include "../../common_src/Graphics/GraphicsExtensions.h"
+#include "SpanKernels.h"
+
+struct SoftwareRasterStats
+{
+    uint32_t quads = 0;      // ラスタライズした Quad 数（画面外・透明は除く）
+    uint32_t tileRefs = 0;   // タイルへの振り分け数（Quad × 重なるタイル）
+    uint32_t culledRefs = 0; // 後の不透明な Quad に隠れて 1 ピクセルも描かなかったタイルへの振り分け数
+    uint64_t pixels = 0;     // 描いたピクセル数（ブレンド＋コピー）
+    uint64_t copiedPixels = 0; // そのうちテクセルのコピーで済ませたピクセル数
+    double binMicros = 0.0;
+    double rasterMicros = 0.0;
+};
+
+class SoftwareGraphics : public IGraphics, public IGraphicsExtensions
+{
+public:
+    static constexpr int TILE_SIZE = 64;
+
+    // workerCount が 0 ならコア数（呼び出しスレッドも1本として数える）
+    explicit SoftwareGraphics(unsigned workerCount = 0);
+    ~SoftwareGraphics() override;
+
+    // IGraphicsインターフェースの実装（windowHandle は使わない）
+    bool Initialize(void* windowHandle, int screenWidth, int screenHeight) override;
+    void Finalize() override;
+    void BeginDraw() override;
+    void EndDraw() override;
+    TextureHandle LoadTexture(const char* filePath) override;
+    void UnloadTexture(TextureHandle handle) override;
+    void DrawQuad(const Quad& quad) override;
+    void SetSdfMode(bool enable) override { m_sdfMode = enable; }
+
+    // IGraphicsExtensionsの実装
+    void SetDrawLayer(uint8_t layer) override { m_commands.SetLayer(layer); }
+    void SetLayerSortMode(uint8_t layer, LayerSortMode mode) override { m_commands.SetLayerSortMode(layer, mode); }
+    TextureHandle LoadTextureAsync(const char* filePath) override { return LoadTexture(filePath); }
+    TextureLoadState GetTextureState(TextureHandle handle) const override
+    {
+        return handle ? TextureLoadState::Ready : TextureLoadState::Failed;
+    }
+    void WaitForTextures() override {}
+
+    // メモリ上の RGBA8 画像からテクスチャを作る（テスト・計測用）
+    TextureHandle CreateTexture(int width, int height, const uint32_t* rgba);
+
+    const uint32_t* GetFramebuffer() const { return m_framebuffer.data(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    unsigned GetThreadCount() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+    const SoftwareRasterStats& GetStats() const { return m_stats; }
+
+    // フレームバッファを PNG で保存（アルファは不透明として書く）
+    bool SaveFramebuffer(const char* path) const;
+
+private:
+    struct MipLevel
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<uint32_t> texels;
+    };
+
+    struct Texture
+    {
+        int width = 0;
+        int height = 0;
+        bool opaque = false; // 全テクセルのアルファが 255
+        std::vector<uint32_t> texels;
+        std::vector<MipLevel> mips; // 1/2, 1/4, …, 1x1
+    };
+
+    // ワーカーごとに数えて、描き終えたら足し込む
+    struct RasterCounts
+    {
+        uint64_t pixels = 0;
+        uint64_t copiedPixels = 0;
+        uint32_t culledRefs = 0;
+    };
+
+    // タイル内の 1 行分の描く範囲（タイル左端からの [begin, end)）
+    struct TileSpan
+    {
+        uint8_t begin = 0;
+        uint8_t end = 0;
+    };
+
+    // ワーカーごとの作業領域
+    struct TileScratch
+    {
+        std::vector<TileSpan> spans; // タイルの Quad × TILE_SIZE 行
+        uint64_t covered[TILE_SIZE] = {}; // 行ごとの、不透明な Quad で埋まったピクセル
+    };
+
+    // ラスタライズ用に前計算した Quad
+    struct RasterQuad
+    {
+        const Texture* texture = nullptr;
+        SpanTexture sample;     // サンプリングするミップ（copy は texture の 0 段目を読む）
+        bool sdf = false;
+        bool solid = false;     // 1x1 テクスチャ（白テクスチャの矩形など）
+        bool opaque = false;    // すべてのピクセルをアルファ 255 で上書きする（下に何があっても見えない）
+        bool copy = false;      // 回転なし・等倍・白の乗算色の不透明 Quad。テクセルの行をコピーする
+        int copyX = 0, copyY = 0; // copy のとき、画面 (0, 0) に当たるテクセル
+        float color[4] = {};    // 乗算色（solid の場合はテクセル込みの 0～255）
+        // ピクセル中心 (x, y) → ローカル座標 s,t ∈ [0,1)： s = sx*x + sy*y + s0
+        float sx = 0, sy = 0, s0 = 0;
+        float tx = 0, ty = 0, t0 = 0;
+        // s,t → sample のテクセル座標： u = s * uScale + uOffset
+        float uScale = 0, uOffset = 0;
+        float vScale = 0, vOffset = 0;
+        int minX = 0, minY = 0, maxX = 0, maxY = 0; // 画面内に切り詰めた外接矩形（max は含まない）
+    };
+
+    bool SetupQuad(const DrawCommand& cmd, RasterQuad& out) const;
+    // 行 y で q の内側にあるピクセルを [x0, x1) の中に絞る
+    static bool RowSpan(const RasterQuad& q, int y, int x0, int x1, int& xs, int& xe);
+    void BinQuads();
+    void RasterizeTiles();
+    void AddCounts(const RasterCounts& counts);
+    void RasterizeTile(int tileIndex, TileScratch& scratch, RasterCounts& counts);
+    void DrawSpan(const RasterQuad& q, int y, int xs, int xe, RasterCounts& counts);
+    void WorkerMain();
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    std::vector<uint32_t> m_framebuffer;
+    uint32_t m_clearColor = 0;
+
+    DrawCommandBuffer m_commands;
+    bool m_sdfMode = false;
+    TextureHandle m_defaultTexture = nullptr;
+    std::unordered_map<TextureHandle, std::unique_ptr<Texture>> m_textures;
+
+    std::vector<RasterQuad> m_rasterQuads;
+    std::vector<std::vector<uint32_t>> m_tileQuads; // タイル → m_rasterQuads の番号（描画順）
+    TileScratch m_scratch; // 呼び出しスレッド用
+
+    // ワーカー（EndDraw ごとにタイルを取り合う）
+    unsigned m_requestedWorkers = 0;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_startCv;
+    std::condition_variable m_doneCv;
+    uint64_t m_frameId = 0;
+    unsigned m_finishedWorkers = 0;
+    bool m_quit = false;
+    std::atomic<int> m_nextTile{ 0 };
+    std::mutex m_countsMutex;
+    RasterCounts m_counts;
+
+    SoftwareRasterStats m_stats;
+};
@@ -0,0 +1,527 @@
+﻿/*****************************************************************//**
+ * @file   SpanKernels.cpp
+ * @brief  ソフトウェアラスタライザのスパン描画カーネル実装
+ *
+ * @details
+ * - AVX2 版は関数単位で target 属性を付けてビルドし、実行時に CPU を見て選ぶ
+ *   （-mavx2 なしでも動き、AVX2 の無い CPU では SSE2 版に落ちる）
+ * - 端数（SIMD 幅に満たない末尾）は、SSE2 版はスカラ版で、AVX2 版はマスク付きの読み書きで処理する
+ *   （AVX2 の関数から VEX でない SSE2 のコードに落ちると、上位レーンの状態の切り替えで
+ *   数十サイクル単位の遅れが出る。小さいスプライトほど末尾の割合が大きい）
+ * - Textured は SIMD 幅のピクセルがすべて透明ならブレンドも書き込みもしない（スプライトの余白）
+ *********************************************************************/
+#include "SpanKernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SPAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SPAN_TARGET_AVX2
+#else
+#define SPAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+    // ==============================
+    // スカラ
+    // ==============================
+
+    struct Texel
+    {
+        float r, g, b, a;
+    };
+
+    inline Texel Unpack(uint32_t px)
+    {
+        return {
+            static_cast<float>(px & 0xFF),
+            static_cast<float>((px >> 8) & 0xFF),
+            static_cast<float>((px >> 16) & 0xFF),
+            static_cast<float>(px >> 24),
+        };
+    }
+
+    inline uint32_t ToByte(float v)
+    {
+        v = (std::min)((std::max)(v, 0.0f), 255.0f);
+        return static_cast<uint32_t>(v + 0.5f);
+    }
+
+    inline Texel SampleBilinear(const SpanTexture& tex, float u, float v)
+    {
+        const float fx0 = std::floor(u);
+        const float fy0 = std::floor(v);
+        const float fx = u - fx0;
+        const float fy = v - fy0;
+        const int x0 = (std::min)((std::max)(static_cast<int>(fx0), 0), tex.width - 1);
+        const int y0 = (std::min)((std::max)(static_cast<int>(fy0), 0), tex.height - 1);
+        const int x1 = (std::min)((std::max)(static_cast<int>(fx0) + 1, 0), tex.width - 1);
+        const int y1 = (std::min)((std::max)(static_cast<int>(fy0) + 1, 0), tex.height - 1);
+        const uint32_t* row0 = tex.texels + static_cast<size_t>(y0) * tex.width;
+        const uint32_t* row1 = tex.texels + static_cast<size_t>(y1) * tex.width;
+        const Texel c00 = Unpack(row0[x0]), c10 = Unpack(row0[x1]);
+        const Texel c01 = Unpack(row1[x0]), c11 = Unpack(row1[x1]);
+        auto lerp2 = [&](float a, float b, float c, float d) {
+            const float top = a + (b - a) * fx;
+            const float bottom = c + (d - c) * fx;
+            return top + (bottom - top) * fy;
+        };
+        return {
+            lerp2(c00.r, c10.r, c01.r, c11.r),
+            lerp2(c00.g, c10.g, c01.g, c11.g),
+            lerp2(c00.b, c10.b, c01.b, c11.b),
+            lerp2(c00.a, c10.a, c01.a, c11.a),
+        };
+    }
+
+    // src はテクセル × 乗算色。GPU が UNORM のターゲットに書く前と同じく 0～255 に切り詰めてからブレンドする
+    inline float ClampSrc(float v)
+    {
+        return (std::min)((std::max)(v, 0.0f), 255.0f);
+    }
+
+    inline uint32_t Blend(uint32_t dstPx, float r, float g, float b, float a)
+    {
+        const Texel d = Unpack(dstPx);
+        r = ClampSrc(r); g = ClampSrc(g); b = ClampSrc(b); a = ClampSrc(a);
+        const float sa = a / 255.0f; // 掛け算だと 255 が 1 にならず、不透明でも下の色が混ざる
+        const float da = 1.0f - sa;
+        return ToByte(r * sa + d.r * da)
+            | (ToByte(g * sa + d.g * da) << 8)
+            | (ToByte(b * sa + d.b * da) << 16)
+            | (ToByte(a) << 24);
+    }
+
+    void TexturedScalar(uint32_t* dst, int count, const SpanTexture& tex, const SpanParams& p)
+    {
+        for (int i = 0; i < count; ++i) {
+            const Texel t = SampleBilinear(tex, p.tu + p.dtu * i, p.tv + p.dtv * i);
+            if (t.a * p.color[3] <= 0.0f) {
+                continue; // 透明なテクセルは書かない
+            }
+            // 不透明なら下の色は 0 倍なので読まない（Blend に 0 を渡しても結果は同じ）
+            dst[i] = Blend(p.opaque ? 0u : dst[i], t.r * p.color[0], t.g * p.color[1], t.b * p.color[2], t.a * p.color[3]);
+        }
+    }
+
+    void SolidScalar(uint32_t* dst, int count, const float c[4])
+    {
+        for (int i = 0; i < count; ++i) {
+            dst[i] = Blend(dst[i], c[0], c[1], c[2], c[3]);
+        }
+    }
+
+    void SdfScalar(uint32_t* dst, int count, const SpanTexture& tex, const SpanParams& p, float dtuY, float dtvY)
+    {
+        // PS_SDF と同じ：sd = tex.a, w = fwidth(sd), a = smoothstep(0.5 - w, 0.5 + w, sd)
+        // fwidth は右隣・下隣との差で近似する
+        for (int i = 0; i < count; ++i) {
+            const float u = p.tu + p.dtu * i;
+            const float v = p.tv + p.dtv * i;
+            const float sd = SampleBilinear(tex, u, v).a * (1.0f / 255.0f);
+            const float sdX = SampleBilinear(tex, u + p.dtu, v + p.dtv).a * (1.0f / 255.0f);
+            const float sdY = SampleBilinear(tex, u + dtuY, v + dtvY).a * (1.0f / 255.0f);
+            const float w = (std::max)(std::fabs(sdX - sd) + std::fabs(sdY - sd), 1e-5f);
+            float t = (sd - (0.5f - w)) / (2.0f * w);
+            t = (std::min)((std::max)(t, 0.0f), 1.0f);
+            const float coverage = t * t * (3.0f - 2.0f * t);
+            const float alpha = p.color[3] * coverage * 255.0f;
+            if (alpha <= 0.0f) {
+                continue;
+            }
+            dst[i] = Blend(dst[i], p.color[0] * 255.0f, p.color[1] * 255.0f, p.color[2] * 255.0f, alpha);
+        }
+    }
+
+#if defined(SPAN_X86)
+    // ==============================
+    // SSE2（4px）
+    // ==============================
+
+    inline __m128i PackSSE2(__m128 r, __m128 g, __m128 b, __m128 a)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 max = _mm_set1_ps(255.0f);
+        const __m128i ri = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(r, zero), max));
+        const __m128i gi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(g, zero), max));
+        const __m128i bi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(b, zero), max));
+        const __m128i ai = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(a, zero), max));
+        return _mm_or_si128(_mm_or_si128(ri, _mm_slli_epi32(gi, 8)),
+            _mm_or_si128(_mm_slli_epi32(bi, 16), _mm_slli_epi32(ai, 24)));
+    }
+
+    inline void UnpackSSE2(__m128i px, __m128& r, __m128& g, __m128& b, __m128& a)
+    {
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        r = _mm_cvtepi32_ps(_mm_and_si128(px, mask));
+        g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 8), mask));
+        b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 16), mask));
+        a = _mm_cvtepi32_ps(_mm_srli_epi32(px, 24));
+    }
+
+    inline __m128 ClampSrcSSE2(__m128 v)
+    {
+        return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    }
+
+    inline __m128i BlendSSE2(__m128i dstPx, __m128 r, __m128 g, __m128 b, __m128 a)
+    {
+        __m128 dr, dg, db, dalpha;
+        UnpackSSE2(dstPx, dr, dg, db, dalpha);
+        r = ClampSrcSSE2(r); g = ClampSrcSSE2(g); b = ClampSrcSSE2(b); a = ClampSrcSSE2(a);
+        const __m128 sa = _mm_div_ps(a, _mm_set1_ps(255.0f));
+        const __m128 da = _mm_sub_ps(_mm_set1_ps(1.0f), sa);
+        return PackSSE2(
+            _mm_add_ps(_mm_mul_ps(r, sa), _mm_mul_ps(dr, da)),
+            _mm_add_ps(_mm_mul_ps(g, sa), _mm_mul_ps(dg, da)),
+            _mm_add_ps(_mm_mul_ps(b, sa), _mm_mul_ps(db, da)),
+            a);
+    }
+
+    // SSE2 には floor が無い（SSE4.1）ので切り捨て後に補正
+    inline __m128 FloorSSE2(__m128 v)
+    {
+        const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, v), _mm_set1_ps(1.0f)));
+    }
+
+    void TexturedSSE2(uint32_t* dst, int count, const SpanTexture& tex, const SpanParams& p)
+    {
+        const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        const __m128 dtu = _mm_set1_ps(p.dtu), dtv = _mm_set1_ps(p.dtv);
+        const __m128 maxX = _mm_set1_ps(static_cast<float>(tex.width - 1));
+        const __m128 maxY = _mm_set1_ps(static_cast<float>(tex.height - 1));
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        const __m128 cr = _mm_set1_ps(p.color[0]), cg = _mm_set1_ps(p.color[1]);
+        const __m128 cb = _mm_set1_ps(p.color[2]), ca = _mm_set1_ps(p.color[3]);
+
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 fi = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lane);
+            const __m128 u = _mm_add_ps(_mm_set1_ps(p.tu), _mm_mul_ps(fi, dtu));
+            const __m128 v = _mm_add_ps(_mm_set1_ps(p.tv), _mm_mul_ps(fi, dtv));
+            const __m128 u0 = FloorSSE2(u), v0 = FloorSSE2(v);
+            const __m128 fx = _mm_sub_ps(u, u0), fy = _mm_sub_ps(v, v0);
+
+            alignas(16) int x0[4], x1[4], y0[4], y1[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(x0), _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(u0, zero), maxX)));
+            _mm_store_si128(reinterpret_cast<__m128i*>(x1), _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(u0, one), zero), maxX)));
+            _mm_store_si128(reinterpret_cast<__m128i*>(y0), _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v0, zero), maxY)));
+            _mm_store_si128(reinterpret_cast<__m128i*>(y1), _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(v0, one), zero), maxY)));
+
+            alignas(16) uint32_t t00[4], t10[4], t01[4], t11[4];
+            for (int k = 0; k < 4; ++k) {
+                const uint32_t* row0 = tex.texels + static_cast<size_t>(y0[k]) * tex.width;
+                const uint32_t* row1 = tex.texels + static_cast<size_t>(y1[k]) * tex.width;
+                t00[k] = row0[x0[k]]; t10[k] = row0[x1[k]];
+                t01[k] = row1[x0[k]]; t11[k] = row1[x1[k]];
+            }
+
+            __m128 r00, g00, b00, a00, r10, g10, b10, a10, r01, g01, b01, a01, r11, g11, b11, a11;
+            UnpackSSE2(_mm_load_si128(reinterpret_cast<const __m128i*>(t00)), r00, g00, b00, a00);
+            UnpackSSE2(_mm_load_si128(reinterpret_cast<const __m128i*>(t10)), r10, g10, b10, a10);
+            UnpackSSE2(_mm_load_si128(reinterpret_cast<const __m128i*>(t01)), r01, g01, b01, a01);
+            UnpackSSE2(_mm_load_si128(reinterpret_cast<const __m128i*>(t11)), r11, g11, b11, a11);
+            auto lerp2 = [&](__m128 c00, __m128 c10, __m128 c01, __m128 c11) {
+                const __m128 top = _mm_add_ps(c00, _mm_mul_ps(_mm_sub_ps(c10, c00), fx));
+                const __m128 bottom = _mm_add_ps(c01, _mm_mul_ps(_mm_sub_ps(c11, c01), fx));
+                return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy));
+            };
+            const __m128 r = _mm_mul_ps(lerp2(r00, r10, r01, r11), cr);
+            const __m128 g = _mm_mul_ps(lerp2(g00, g10, g01, g11), cg);
+            const __m128 b = _mm_mul_ps(lerp2(b00, b10, b01, b11), cb);
+            const __m128 a = _mm_mul_ps(lerp2(a00, a10, a01, a11), ca);
+            if (_mm_movemask_ps(_mm_cmpgt_ps(a, zero)) == 0) {
+                continue; // 4px とも透明
+            }
+
+            __m128i* out = reinterpret_cast<__m128i*>(dst + i);
+            _mm_storeu_si128(out, BlendSSE2(p.opaque ? _mm_setzero_si128() : _mm_loadu_si128(out), r, g, b, a));
+        }
+        if (i < count) {
+            SpanParams tail = p;
+            tail.tu += p.dtu * i;
+            tail.tv += p.dtv * i;
+            TexturedScalar(dst + i, count - i, tex, tail);
+        }
+    }
+
+    void SolidSSE2(uint32_t* dst, int count, const float c[4])
+    {
+        const __m128 r = _mm_set1_ps(c[0]), g = _mm_set1_ps(c[1]);
+        const __m128 b = _mm_set1_ps(c[2]), a = _mm_set1_ps(c[3]);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i* out = reinterpret_cast<__m128i*>(dst + i);
+            _mm_storeu_si128(out, BlendSSE2(_mm_loadu_si128(out), r, g, b, a));
+        }
+        SolidScalar(dst + i, count - i, c);
+    }
+
+    // ==============================
+    // AVX2（8px、テクセルは gather）
+    // ==============================
+
+    SPAN_TARGET_AVX2 inline void UnpackAVX2(__m256i px, __m256& r, __m256& g, __m256& b, __m256& a)
+    {
+        const __m256i mask = _mm256_set1_epi32(0xFF);
+        r = _mm256_cvtepi32_ps(_mm256_and_si256(px, mask));
+        g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), mask));
+        b = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), mask));
+        a = _mm256_cvtepi32_ps(_mm256_srli_epi32(px, 24));
+    }
+
+    SPAN_TARGET_AVX2 inline __m256i ToByteAVX2(__m256 v)
+    {
+        return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(255.0f)));
+    }
+
+    SPAN_TARGET_AVX2 inline __m256 Lerp2AVX2(__m256 c00, __m256 c10, __m256 c01, __m256 c11, __m256 fx, __m256 fy)
+    {
+        const __m256 top = _mm256_add_ps(c00, _mm256_mul_ps(_mm256_sub_ps(c10, c00), fx));
+        const __m256 bottom = _mm256_add_ps(c01, _mm256_mul_ps(_mm256_sub_ps(c11, c01), fx));
+        return _mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), fy));
+    }
+
+    SPAN_TARGET_AVX2 inline __m256 ClampSrcAVX2(__m256 v)
+    {
+        return _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+    }
+
+    SPAN_TARGET_AVX2 inline __m256i BlendAVX2(__m256i dstPx, __m256 r, __m256 g, __m256 b, __m256 a)
+    {
+        __m256 dr, dg, db, dalpha;
+        UnpackAVX2(dstPx, dr, dg, db, dalpha);
+        r = ClampSrcAVX2(r); g = ClampSrcAVX2(g); b = ClampSrcAVX2(b); a = ClampSrcAVX2(a);
+        const __m256 sa = _mm256_div_ps(a, _mm256_set1_ps(255.0f));
+        const __m256 da = _mm256_sub_ps(_mm256_set1_ps(1.0f), sa);
+        const __m256i ri = ToByteAVX2(_mm256_add_ps(_mm256_mul_ps(r, sa), _mm256_mul_ps(dr, da)));
+        const __m256i gi = ToByteAVX2(_mm256_add_ps(_mm256_mul_ps(g, sa), _mm256_mul_ps(dg, da)));
+        const __m256i bi = ToByteAVX2(_mm256_add_ps(_mm256_mul_ps(b, sa), _mm256_mul_ps(db, da)));
+        const __m256i ai = ToByteAVX2(a);
+        return _mm256_or_si256(_mm256_or_si256(ri, _mm256_slli_epi32(gi, 8)),
+            _mm256_or_si256(_mm256_slli_epi32(bi, 16), _mm256_slli_epi32(ai, 24)));
+    }
+
+    // 末尾の 8 未満のレーンだけ読み書きする
+    SPAN_TARGET_AVX2 inline __m256i TailMaskAVX2(int remaining)
+    {
+        return _mm256_cmpgt_epi32(_mm256_set1_epi32(remaining), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    }
+
+    SPAN_TARGET_AVX2 inline void StoreBlendAVX2(uint32_t* dst, int remaining, __m256 r, __m256 g, __m256 b, __m256 a)
+    {
+        int* out = reinterpret_cast<int*>(dst);
+        if (remaining >= 8) {
+            __m256i* out8 = reinterpret_cast<__m256i*>(dst);
+            _mm256_storeu_si256(out8, BlendAVX2(_mm256_loadu_si256(out8), r, g, b, a));
+            return;
+        }
+        const __m256i mask = TailMaskAVX2(remaining);
+        _mm256_maskstore_epi32(out, mask, BlendAVX2(_mm256_maskload_epi32(out, mask), r, g, b, a));
+    }
+
+    // 不透明（a = 255）なら下の色は 0 倍なので、読まずに書く
+    SPAN_TARGET_AVX2 inline void StoreOpaqueAVX2(uint32_t* dst, int remaining, __m256 r, __m256 g, __m256 b, __m256 a)
+    {
+        const __m256i px = BlendAVX2(_mm256_setzero_si256(), r, g, b, a);
+        if (remaining >= 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), px);
+            return;
+        }
+        _mm256_maskstore_epi32(reinterpret_cast<int*>(dst), TailMaskAVX2(remaining), px);
+    }
+
+    SPAN_TARGET_AVX2 void TexturedAVX2(uint32_t* dst, int count, const SpanTexture& tex, const SpanParams& p)
+    {
+        const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        const __m256 dtu = _mm256_set1_ps(p.dtu), dtv = _mm256_set1_ps(p.dtv);
+        const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+        const __m256i maxX = _mm256_set1_epi32(tex.width - 1);
+        const __m256i maxY = _mm256_set1_epi32(tex.height - 1);
+        const __m256i pitch = _mm256_set1_epi32(tex.width);
+        const __m256 cr = _mm256_set1_ps(p.color[0]), cg = _mm256_set1_ps(p.color[1]);
+        const __m256 cb = _mm256_set1_ps(p.color[2]), ca = _mm256_set1_ps(p.color[3]);
+        const int* texels = reinterpret_cast<const int*>(tex.texels);
+
+        // 末尾のレーンも u,v はテクスチャ内に切り詰めるので gather は範囲外を読まない
+        for (int i = 0; i < count; i += 8) {
+            const __m256 fi = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lane);
+            const __m256 u = _mm256_add_ps(_mm256_set1_ps(p.tu), _mm256_mul_ps(fi, dtu));
+            const __m256 v = _mm256_add_ps(_mm256_set1_ps(p.tv), _mm256_mul_ps(fi, dtv));
+            const __m256 u0 = _mm256_floor_ps(u), v0 = _mm256_floor_ps(v);
+            const __m256 fx = _mm256_sub_ps(u, u0), fy = _mm256_sub_ps(v, v0);
+
+            const __m256i iu = _mm256_cvttps_epi32(u0), iv = _mm256_cvttps_epi32(v0);
+            const __m256i x0 = _mm256_min_epi32(_mm256_max_epi32(iu, zero), maxX);
+            const __m256i x1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(iu, one), zero), maxX);
+            const __m256i row0 = _mm256_mullo_epi32(_mm256_min_epi32(_mm256_max_epi32(iv, zero), maxY), pitch);
+            const __m256i row1 = _mm256_mullo_epi32(_mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(iv, one), zero), maxY), pitch);
+
+            __m256 r00, g00, b00, a00, r10, g10, b10, a10, r01, g01, b01, a01, r11, g11, b11, a11;
+            UnpackAVX2(_mm256_i32gather_epi32(texels, _mm256_add_epi32(row0, x0), 4), r00, g00, b00, a00);
+            UnpackAVX2(_mm256_i32gather_epi32(texels, _mm256_add_epi32(row0, x1), 4), r10, g10, b10, a10);
+            UnpackAVX2(_mm256_i32gather_epi32(texels, _mm256_add_epi32(row1, x0), 4), r01, g01, b01, a01);
+            UnpackAVX2(_mm256_i32gather_epi32(texels, _mm256_add_epi32(row1, x1), 4), r11, g11, b11, a11);
+            const __m256 r = _mm256_mul_ps(Lerp2AVX2(r00, r10, r01, r11, fx, fy), cr);
+            const __m256 g = _mm256_mul_ps(Lerp2AVX2(g00, g10, g01, g11, fx, fy), cg);
+            const __m256 b = _mm256_mul_ps(Lerp2AVX2(b00, b10, b01, b11, fx, fy), cb);
+            const __m256 a = _mm256_mul_ps(Lerp2AVX2(a00, a10, a01, a11, fx, fy), ca);
+            if (_mm256_movemask_ps(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GT_OQ)) == 0) {
+                continue; // 8px とも透明なら読み書きしない
+            }
+            if (p.opaque) {
+                StoreOpaqueAVX2(dst + i, count - i, r, g, b, a);
+                continue;
+            }
+            StoreBlendAVX2(dst + i, count - i, r, g, b, a);
+        }
+    }
+
+    SPAN_TARGET_AVX2 void SolidAVX2(uint32_t* dst, int count, const float c[4])
+    {
+        const __m256 r = _mm256_set1_ps(c[0]), g = _mm256_set1_ps(c[1]);
+        const __m256 b = _mm256_set1_ps(c[2]), a = _mm256_set1_ps(c[3]);
+        for (int i = 0; i < count; i += 8) {
+            StoreBlendAVX2(dst + i, count - i, r, g, b, a);
+        }
+    }
+
+    // バイリニアでアルファだけ読む（0～255）
+    SPAN_TARGET_AVX2 inline __m256 SampleAlphaAVX2(const int* texels, __m256i pitch, __m256i maxX, __m256i maxY, __m256 u, __m256 v)
+    {
+        const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+        const __m256 u0 = _mm256_floor_ps(u), v0 = _mm256_floor_ps(v);
+        const __m256 fx = _mm256_sub_ps(u, u0), fy = _mm256_sub_ps(v, v0);
+        const __m256i iu = _mm256_cvttps_epi32(u0), iv = _mm256_cvttps_epi32(v0);
+        const __m256i x0 = _mm256_min_epi32(_mm256_max_epi32(iu, zero), maxX);
+        const __m256i x1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(iu, one), zero), maxX);
+        const __m256i row0 = _mm256_mullo_epi32(_mm256_min_epi32(_mm256_max_epi32(iv, zero), maxY), pitch);
+        const __m256i row1 = _mm256_mullo_epi32(_mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(iv, one), zero), maxY), pitch);
+        const __m256 a00 = _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_i32gather_epi32(texels, _mm256_add_epi32(row0, x0), 4), 24));
+        const __m256 a10 = _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_i32gather_epi32(texels, _mm256_add_epi32(row0, x1), 4), 24));
+        const __m256 a01 = _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_i32gather_epi32(texels, _mm256_add_epi32(row1, x0), 4), 24));
+        const __m256 a11 = _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_i32gather_epi32(texels, _mm256_add_epi32(row1, x1), 4), 24));
+        return Lerp2AVX2(a00, a10, a01, a11, fx, fy);
+    }
+
+    // SdfScalar と同じ式を 8px ずつ
+    SPAN_TARGET_AVX2 void SdfAVX2(uint32_t* dst, int count, const SpanTexture& tex, const SpanParams& p, float dtuY, float dtvY)
+    {
+        const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        const __m256 dtu = _mm256_set1_ps(p.dtu), dtv = _mm256_set1_ps(p.dtv);
+        const __m256 duY = _mm256_set1_ps(dtuY), dvY = _mm256_set1_ps(dtvY);
+        const __m256i maxX = _mm256_set1_epi32(tex.width - 1);
+        const __m256i maxY = _mm256_set1_epi32(tex.height - 1);
+        const __m256i pitch = _mm256_set1_epi32(tex.width);
+        const __m256 inv255 = _mm256_set1_ps(1.0f / 255.0f);
+        const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+        const __m256 half = _mm256_set1_ps(0.5f), two = _mm256_set1_ps(2.0f), three = _mm256_set1_ps(3.0f);
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        const __m256 r = _mm256_set1_ps(p.color[0] * 255.0f), g = _mm256_set1_ps(p.color[1] * 255.0f);
+        const __m256 b = _mm256_set1_ps(p.color[2] * 255.0f), ca = _mm256_set1_ps(p.color[3]);
+        const __m256 scale = _mm256_set1_ps(255.0f);
+        const int* texels = reinterpret_cast<const int*>(tex.texels);
+
+        for (int i = 0; i < count; i += 8) {
+            const __m256 fi = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lane);
+            const __m256 u = _mm256_add_ps(_mm256_set1_ps(p.tu), _mm256_mul_ps(fi, dtu));
+            const __m256 v = _mm256_add_ps(_mm256_set1_ps(p.tv), _mm256_mul_ps(fi, dtv));
+            const __m256 sd = _mm256_mul_ps(SampleAlphaAVX2(texels, pitch, maxX, maxY, u, v), inv255);
+            const __m256 sdX = _mm256_mul_ps(SampleAlphaAVX2(texels, pitch, maxX, maxY, _mm256_add_ps(u, dtu), _mm256_add_ps(v, dtv)), inv255);
+            const __m256 sdY = _mm256_mul_ps(SampleAlphaAVX2(texels, pitch, maxX, maxY, _mm256_add_ps(u, duY), _mm256_add_ps(v, dvY)), inv255);
+            const __m256 w = _mm256_max_ps(_mm256_add_ps(_mm256_and_ps(_mm256_sub_ps(sdX, sd), absMask),
+                _mm256_and_ps(_mm256_sub_ps(sdY, sd), absMask)), _mm256_set1_ps(1e-5f));
+            __m256 t = _mm256_div_ps(_mm256_sub_ps(sd, _mm256_sub_ps(half, w)), _mm256_mul_ps(two, w));
+            t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+            const __m256 coverage = _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_sub_ps(three, _mm256_mul_ps(two, t)));
+            const __m256 a = _mm256_mul_ps(_mm256_mul_ps(ca, coverage), scale);
+            if (_mm256_movemask_ps(_mm256_cmp_ps(a, zero, _CMP_GT_OQ)) == 0) {
+                continue; // 8px とも輪郭の外
+            }
+            StoreBlendAVX2(dst + i, count - i, r, g, b, a);
+        }
+    }
+
+    bool CpuHasAVX2()
+    {
+#if defined(_MSC_VER)
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif // SPAN_X86
+
+    SpanKernelLevel DetectLevel()
+    {
+#if defined(SPAN_X86)
+        return CpuHasAVX2() ? SpanKernelLevel::AVX2 : SpanKernelLevel::SSE2;
+#else
+        return SpanKernelLevel::Scalar;
+#endif
+    }
+
+    const SpanKernelLevel g_bestLevel = DetectLevel();
+    SpanKernelLevel g_level = g_bestLevel;
+}
+
+void BlendSpanTextured(uint32_t* dst, int count, const SpanTexture& tex, const SpanParams& p)
+{
+#if defined(SPAN_X86)
+    if (g_level == SpanKernelLevel::AVX2) { TexturedAVX2(dst, count, tex, p); return; }
+    if (g_level == SpanKernelLevel::SSE2) { TexturedSSE2(dst, count, tex, p); return; }
+#endif
+    TexturedScalar(dst, count, tex, p);
+}
+
+void BlendSpanSolid(uint32_t* dst, int count, const float rgba255[4])
+{
+#if defined(SPAN_X86)
+    if (g_level == SpanKernelLevel::AVX2) { SolidAVX2(dst, count, rgba255); return; }
+    if (g_level == SpanKernelLevel::SSE2) { SolidSSE2(dst, count, rgba255); return; }
+#endif
+    SolidScalar(dst, count, rgba255);
+}
+
+void BlendSpanSdf(uint32_t* dst, int count, const SpanTexture& tex, const SpanParams& p, float dtuY, float dtvY)
+{
+#if defined(SPAN_X86)
+    if (g_level == SpanKernelLevel::AVX2) { SdfAVX2(dst, count, tex, p, dtuY, dtvY); return; }
+#endif
+    SdfScalar(dst, count, tex, p, dtuY, dtvY);
+}
+
+SpanKernelLevel GetSpanKernelLevel()
+{
+    return g_level;
+}
+
+void SetSpanKernelLevel(SpanKernelLevel level)
+{
+    // CPU が対応していないものは選べない
+    g_level = (static_cast<int>(level) <= static_cast<int>(g_bestLevel)) ? level : g_bestLevel;
+}
+
+const char* GetSpanKernelName(SpanKernelLevel level)
+{
+    switch (level) {
+    case SpanKernelLevel::AVX2: return "AVX2";
+    case SpanKernelLevel::SSE2: return "SSE2";
+    default:                    return "Scalar";
+    }
+}
@@ -0,0 +1,52 @@
+﻿/*****************************************************************//**
+ * @file   SpanKernels.h
+ * @brief  ソフトウェアラスタライザの横1列（スパン）描画カーネル
+ *
+ * @details
+ * - ピクセル・テクセルは RGBA8（R が最下位バイト）
+ * - ブレンドは D3D 側と同じ Straight Alpha
+ *     rgb = src.rgb * src.a + dst.rgb * (1 - src.a),  a = src.a
+ *   src（テクセル × 乗算色）は D3D が UNORM のターゲットに書く前と同じく 0～255 に切り詰める。
+ *   src.a が 0 のピクセルは書かない（フレームバッファのアルファは表示に使わない）
+ * - サンプリングはバイリニア・クランプ（SpriteDrawer のサンプラと同じ）
+ * - Textured / Solid は AVX2（8px）→ SSE2（4px）→ スカラの順で、使える最速のものを選ぶ。
+ *   SDF は AVX2 とスカラのみ（1 ピクセルで 3 回サンプリングするので、文字が多いとスカラでは重い）
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+
+struct SpanTexture
+{
+    const uint32_t* texels = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
+struct SpanParams
+{
+    float tu = 0.0f, tv = 0.0f;   // 先頭ピクセル中心のテクセル座標（テクセル中心が整数）
+    float dtu = 0.0f, dtv = 0.0f; // 1ピクセル右に進んだときの増分
+    float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; // 乗算色（1 を超えてもよい。積を切り詰める）
+    bool opaque = false; // テクスチャも乗算色も不透明（フレームバッファを読まずに上書きする）
+};
+
+enum class SpanKernelLevel
+{
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+// テクスチャ × 乗算色をブレンド
+void BlendSpanTextured(uint32_t* dst, int count, const SpanTexture& tex, const SpanParams& p);
+
+// 単色（0～255 の RGBA）をブレンド。白テクスチャの矩形など
+void BlendSpanSolid(uint32_t* dst, int count, const float rgba255[4]);
+
+// SDF（距離はアルファ）。dtuY / dtvY は1ピクセル下に進んだときの増分（fwidth の近似に使う）
+void BlendSpanSdf(uint32_t* dst, int count, const SpanTexture& tex, const SpanParams& p, float dtuY, float dtvY);
+
+// CPU が対応する最速のものが初期値。計測・比較用に下げられる
+SpanKernelLevel GetSpanKernelLevel();
+void SetSpanKernelLevel(SpanKernelLevel level);
+const char* GetSpanKernelName(SpanKernelLevel level);
@@ -0,0 +1,164 @@
+﻿#include "ScriptedGamepad.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    struct ButtonName {
+        const char* name;
+        Button button;
+    };
+
+    const ButtonName BUTTON_NAMES[] = {
+        { "A", Button::A }, { "B", Button::B }, { "X", Button::X }, { "Y", Button::Y },
+        { "LB", Button::LB }, { "RB", Button::RB }, { "BACK", Button::BACK }, { "START", Button::START },
+        { "L_THUMB", Button::L_THUMB }, { "R_THUMB", Button::R_THUMB },
+        { "DPAD_UP", Button::DPAD_UP }, { "DPAD_DOWN", Button::DPAD_DOWN },
+        { "DPAD_LEFT", Button::DPAD_LEFT }, { "DPAD_RIGHT", Button::DPAD_RIGHT },
+    };
+
+    bool FindButton(const char* name, Button& out) {
+        for (const ButtonName& b : BUTTON_NAMES) {
+            if (std::strcmp(b.name, name) == 0) {
+                out = b.button;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+bool ScriptedGamepad::LoadScript(const char* path) {
+    FILE* fp = std::fopen(path, "r");
+    if (!fp) {
+        return false;
+    }
+    Clear();
+
+    char line[256];
+    bool ok = true;
+    bool firstLine = true;
+    while (ok && std::fgets(line, sizeof(line), fp)) {
+        // UTF-8 の BOM を読み飛ばす
+        if (firstLine && std::strncmp(line, "\xEF\xBB\xBF", 3) == 0) {
+            std::memmove(line, line + 3, std::strlen(line + 3) + 1);
+        }
+        firstLine = false;
+        if (char* comment = std::strchr(line, '#')) {
+            *comment = '\0';
+        }
+        char name[32] = {};
+        unsigned start = 0, frames = 0;
+        float a = 0.0f, b = 0.0f;
+
+        if (std::sscanf(line, " %31s", name) != 1) {
+            continue; // 空行
+        }
+        if (std::strcmp(name, "loop") == 0) {
+            ok = std::sscanf(line, " loop %u", &frames) == 1;
+            m_loopFrames = frames;
+            continue;
+        }
+
+        const int n = std::sscanf(line, " %u %u %31s %f %f", &start, &frames, name, &a, &b);
+        Button button;
+        if (n >= 3 && FindButton(name, button)) {
+            AddButton(start, frames, button);
+        }
+        else if (n == 5 && (std::strcmp(name, "LSTICK") == 0 || std::strcmp(name, "RSTICK") == 0)) {
+            AddStick(start, frames, name[0] == 'R', a, b);
+        }
+        else if (n >= 4 && (std::strcmp(name, "LT") == 0 || std::strcmp(name, "RT") == 0)) {
+            AddTrigger(start, frames, name[0] == 'R', a);
+        }
+        else {
+            ok = false;
+        }
+    }
+    std::fclose(fp);
+
+    if (!ok) {
+        Clear();
+    }
+    return ok;
+}
+
+void ScriptedGamepad::Clear() {
+    m_steps.clear();
+    m_loopFrames = 0;
+    Rewind();
+}
+
+void ScriptedGamepad::AddButton(uint32_t startFrame, uint32_t frames, Button button) {
+    Step s;
+    s.start = startFrame;
+    s.frames = frames;
+    s.kind = StepKind::Button;
+    s.buttonMask = ToMask(button);
+    m_steps.push_back(s);
+}
+
+void ScriptedGamepad::AddStick(uint32_t startFrame, uint32_t frames, bool right, float x, float y) {
+    Step s;
+    s.start = startFrame;
+    s.frames = frames;
+    s.kind = right ? StepKind::RightStick : StepKind::LeftStick;
+    s.x = (std::clamp)(x, -1.0f, 1.0f);
+    s.y = (std::clamp)(y, -1.0f, 1.0f);
+    m_steps.push_back(s);
+}
+
+void ScriptedGamepad::AddTrigger(uint32_t startFrame, uint32_t frames, bool right, float value) {
+    Step s;
+    s.start = startFrame;
+    s.frames = frames;
+    s.kind = right ? StepKind::RightTrigger : StepKind::LeftTrigger;
+    s.x = (std::clamp)(value, 0.0f, 1.0f);
+    m_steps.push_back(s);
+}
+
+void ScriptedGamepad::Rewind() {
+    m_frame = 0;
+    m_started = false;
+    m_state = State{};
+    m_prevState = State{};
+}
+
+void ScriptedGamepad::Update() {
+    // 前回状態を退避してから、今のフレームに掛かっている入力を重ねる
+    m_prevState = m_state;
+    if (m_started) {
+        ++m_frame;
+    }
+    m_started = true;
+
+    const uint32_t t = m_loopFrames ? m_frame % m_loopFrames : m_frame;
+    State s{};
+    for (const Step& step : m_steps) {
+        if (t < step.start || t - step.start >= step.frames) {
+            continue;
+        }
+        switch (step.kind) {
+        case StepKind::Button:       s.buttons |= step.buttonMask; break;
+        case StepKind::LeftStick:    s.leftStick = { step.x, step.y }; break;
+        case StepKind::RightStick:   s.rightStick = { step.x, step.y }; break;
+        case StepKind::LeftTrigger:  s.leftTrigger = step.x; break;
+        case StepKind::RightTrigger: s.rightTrigger = step.x; break;
+        }
+    }
+    m_state = s;
+}
+
+bool ScriptedGamepad::IsButtonDown(Button button) {
+    return (m_state.buttons & ToMask(button)) != 0;
+}
+
+bool ScriptedGamepad::WasButtonPressed(Button button) {
+    return ((~m_prevState.buttons) & m_state.buttons & ToMask(button)) != 0;
+}
+
+bool ScriptedGamepad::WasButtonReleased(Button button) {
+    return (m_prevState.buttons & (~m_state.buttons) & ToMask(button)) != 0;
+}
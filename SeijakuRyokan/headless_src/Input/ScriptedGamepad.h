@@ -0,0 +1,87 @@
+﻿#pragma once
+#ifndef SCRIPTED_GAMEPAD_H
+#define SCRIPTED_GAMEPAD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../../common_src/IGamepad.h"
+
+// 台本どおりに入力を返すゲームパッド（ヘッドレス実行・再現テスト用）
+//
+// 台本ファイルは1行1入力：  <開始フレーム> <フレーム数> <入力> [値...]
+//   入力 = A / B / X / Y / LB / RB / BACK / START / L_THUMB / R_THUMB / DPAD_UP ...
+//          LSTICK x y / RSTICK x y / LT v / RT v
+//   "loop <フレーム数>" で台本を繰り返す（0 なら繰り返さない）
+//   '#' 以降はコメント
+class ScriptedGamepad final : public IGamepad {
+public:
+    ScriptedGamepad() = default;
+
+    bool LoadScript(const char* path);
+    void Clear();
+
+    void AddButton(uint32_t startFrame, uint32_t frames, Button button);
+    void AddStick(uint32_t startFrame, uint32_t frames, bool right, float x, float y);
+    void AddTrigger(uint32_t startFrame, uint32_t frames, bool right, float value);
+    void SetLoop(uint32_t frames) { m_loopFrames = frames; }
+
+    // 0 フレーム目から台本をやり直す
+    void Rewind();
+    uint32_t GetFrame() const { return m_frame; }
+
+    bool IsConnected() const override { return true; }
+    void Update() override; // 1 回呼ぶごとに台本を 1 フレーム進める
+
+    float   GetLeftStickX()  override { return m_state.leftStick.x; }
+    float   GetLeftStickY()  override { return m_state.leftStick.y; }
+    float   GetRightStickX() override { return m_state.rightStick.x; }
+    float   GetRightStickY() override { return m_state.rightStick.y; }
+    Stick2D GetLeftStick()   override { return m_state.leftStick; }
+    Stick2D GetRightStick()  override { return m_state.rightStick; }
+
+    float GetLeftTrigger()  override { return m_state.leftTrigger; }
+    float GetRightTrigger() override { return m_state.rightTrigger; }
+
+    bool IsButtonDown(Button button) override;
+    bool WasButtonPressed(Button button)  override;
+    bool WasButtonReleased(Button button) override;
+
+    unsigned int GetUserIndex() const override { return 0; }
+
+    // 台本の値をそのまま返すのでデッドゾーン・振動は無視
+    void SetDeadzone(short, short, unsigned char) override {}
+    void SetVibration(float, float) override {}
+
+private:
+    enum class StepKind : uint8_t { Button, LeftStick, RightStick, LeftTrigger, RightTrigger };
+
+    struct Step {
+        uint32_t start = 0;
+        uint32_t frames = 0;
+        StepKind kind = StepKind::Button;
+        uint32_t buttonMask = 0;
+        float x = 0.0f;
+        float y = 0.0f;
+    };
+
+    struct State {
+        uint32_t buttons = 0;
+        Stick2D  leftStick{};
+        Stick2D  rightStick{};
+        float    leftTrigger = 0.0f;
+        float    rightTrigger = 0.0f;
+    };
+
+    static uint32_t ToMask(Button b) { return 1u << static_cast<uint32_t>(b); }
+
+    std::vector<Step> m_steps;
+    uint32_t m_loopFrames = 0;
+    uint32_t m_frame = 0;
+    bool     m_started = false; // 最初の Update で 0 フレーム目になる
+
+    State m_state{};
+    State m_prevState{};
+};
+
+#endif // SCRIPTED_GAMEPAD_H
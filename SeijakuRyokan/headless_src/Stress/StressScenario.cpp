@@ -0,0 +1,958 @@
+﻿/*****************************************************************//**
+ * @file   StressScenario.cpp
+ * @brief  負荷試験用のマップ・スケジュール合成とシミュレーションの実装
+ *********************************************************************/
+#include "StressScenario.h"
+#include "../../common_src/System/FrameCounters.h"
+#include "../../common_src/System/FramePacer.h"
+#include "../../common_src/System/Profiler.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    // 1 本の帯 = 上の部屋列 / 壁 / 廊下 / 壁 / 下の部屋列 / 壁
+    constexpr int ROOM_DEPTH = 5;
+    constexpr int CORRIDOR_WIDTH = 3;
+    constexpr int BAND_HEIGHT = ROOM_DEPTH * 2 + CORRIDOR_WIDTH + 3;
+    constexpr int SPINE_WIDTH = 3;    // 帯どうしをつなぐ縦の通路
+    constexpr int SPINE_SPACING = 40;
+    constexpr int MIN_ROOM_WIDTH = 4;
+
+    constexpr size_t SUBSYSTEM_COUNT = static_cast<size_t>(StressSubsystem::Count);
+
+    const char* const ROOM_KIND_NAMES[] = { "front", "guest", "bath", "dining", "inn" };
+    const char* const ROOM_TEXTURES[] = {
+        "rom/images/room_front.png",
+        "rom/images/room_guest.png",
+        "rom/images/room_bath.png",
+        "rom/images/room_dining.png",
+        "rom/images/room_INN.png",
+    };
+    const char* const SUBSYSTEM_NAMES[] = { "schedule", "editing", "pathing", "movement", "vision", "drawing" };
+    const char* const PATHING_NAMES[] = { "astar", "flow", "jps", "hpa" };
+
+    uint32_t Random(std::mt19937& rng, uint32_t count)
+    {
+        return count > 0 ? static_cast<uint32_t>(rng() % count) : 0;
+    }
+
+    // シミュレーション中の書き換え用（状態 1 語で足りる xorshift）
+    uint32_t NextRandom(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    void AddRooms(StressMap& map, std::mt19937& rng, int roomY, int doorY, bool doorBelow, const std::vector<int>& spines)
+    {
+        for (size_t s = 0; s + 1 < spines.size(); ++s) {
+            const int segmentEnd = spines[s + 1] - 1; // 通路の手前 1 列は壁
+            int x = spines[s] + SPINE_WIDTH + 1;
+            while (x + MIN_ROOM_WIDTH <= segmentEnd) {
+                const int width = (std::min)(5 + static_cast<int>(Random(rng, 5)), segmentEnd - x);
+                StressRoom room;
+                room.x = x;
+                room.y = roomY;
+                room.width = width;
+                room.height = ROOM_DEPTH;
+                room.door = GridPoint{ x + width / 2, doorY };
+                // 扉から遠い側の列を目指す
+                room.spot = GridPoint{ x + width / 2, doorBelow ? roomY + 1 : roomY + ROOM_DEPTH - 2 };
+                map.grid.FillRect(room.x, room.y, room.width, room.height, true);
+                map.grid.SetWalkable(room.door.x, room.door.y, true);
+                if (width >= 6) {
+                    // 家具 1 つ（部屋の隅寄り。扉と目的地はふさがない）
+                    map.grid.SetWalkable(x + 1, roomY + ROOM_DEPTH / 2, false);
+                }
+                map.rooms.push_back(room);
+                x += width + 1;
+            }
+        }
+    }
+
+    // 隣のセルへ角を切らずに 1 歩で進めるか
+    bool CanStepTo(const NavGrid& grid, const GridPoint& a, const GridPoint& b)
+    {
+        for (int d = 0; d < NavGrid::DIRECTION_COUNT; ++d) {
+            if (a.x + NavGrid::DX[d] == b.x && a.y + NavGrid::DY[d] == b.y) {
+                return grid.CanStep(a.x, a.y, d);
+            }
+        }
+        return false;
+    }
+
+    StressCost Summarize(std::vector<int64_t>& samples)
+    {
+        StressCost cost;
+        if (samples.empty()) {
+            return cost;
+        }
+        double sum = 0.0;
+        for (int64_t ns : samples) {
+            sum += static_cast<double>(ns);
+        }
+        cost.meanUs = sum / samples.size() / 1000.0;
+        const size_t p99 = (std::min)(samples.size() - 1, samples.size() * 99 / 100);
+        std::nth_element(samples.begin(), samples.begin() + p99, samples.end());
+        cost.p99Us = samples[p99] / 1000.0;
+        cost.maxUs = *std::max_element(samples.begin(), samples.end()) / 1000.0;
+        return cost;
+    }
+}
+
+// ==============================
+// 合成
+// ==============================
+const char* StressScenario::GetRoomKindName(StressRoomKind kind)
+{
+    const size_t index = static_cast<size_t>(kind);
+    return index < static_cast<size_t>(StressRoomKind::Count) ? ROOM_KIND_NAMES[index] : "?";
+}
+
+const char* StressScenario::GetSubsystemName(StressSubsystem subsystem)
+{
+    const size_t index = static_cast<size_t>(subsystem);
+    return index < SUBSYSTEM_COUNT ? SUBSYSTEM_NAMES[index] : "?";
+}
+
+const char* StressScenario::GetPathingName(StressPathing pathing)
+{
+    const size_t index = static_cast<size_t>(pathing);
+    return index < static_cast<size_t>(StressPathing::Count) ? PATHING_NAMES[index] : "?";
+}
+
+StressMap StressScenario::GenerateMap(int width, int height, uint32_t seed)
+{
+    width = (std::max)(width, 32);
+    height = (std::max)(height, 24);
+    std::mt19937 rng(seed);
+
+    StressMap map;
+    map.grid.Resize(width, height, false);
+
+    const int bands = (std::max)(1, (height - 2) / BAND_HEIGHT);
+    const int spineHeight = bands * BAND_HEIGHT - 1;
+
+    std::vector<int> spines = { 1 };
+    const int rightSpine = width - 1 - SPINE_WIDTH;
+    for (int x = 1 + SPINE_SPACING; x + SPINE_WIDTH + 8 < rightSpine; x += SPINE_SPACING) {
+        spines.push_back(x);
+    }
+    spines.push_back(rightSpine);
+
+    for (int b = 0; b < bands; ++b) {
+        const int top = 1 + b * BAND_HEIGHT;
+        map.grid.FillRect(1, top + ROOM_DEPTH + 1, width - 2, CORRIDOR_WIDTH, true);
+    }
+    for (int x : spines) {
+        map.grid.FillRect(x, 1, SPINE_WIDTH, spineHeight, true);
+    }
+    for (int b = 0; b < bands; ++b) {
+        const int top = 1 + b * BAND_HEIGHT;
+        AddRooms(map, rng, top, top + ROOM_DEPTH, true, spines);
+        AddRooms(map, rng, top + ROOM_DEPTH + CORRIDOR_WIDTH + 2, top + ROOM_DEPTH + CORRIDOR_WIDTH + 1, false, spines);
+    }
+    map.entrance = GridPoint{ spines[0] + 1, spineHeight };
+
+    // 種類を割り振る（玄関にいちばん近い部屋をフロントにする）
+    int counts[static_cast<size_t>(StressRoomKind::Count)] = {};
+    size_t front = 0;
+    for (size_t i = 0; i < map.rooms.size(); ++i) {
+        StressRoom& room = map.rooms[i];
+        const uint32_t roll = Random(rng, 100);
+        room.kind = roll < 62 ? StressRoomKind::Guest
+            : roll < 74 ? StressRoomKind::Bath
+            : roll < 87 ? StressRoomKind::Dining
+            : StressRoomKind::Inn;
+        if (NavGrid::Octile(room.door, map.entrance) < NavGrid::Octile(map.rooms[front].door, map.entrance)) {
+            front = i;
+        }
+    }
+    if (!map.rooms.empty()) {
+        map.rooms[front].kind = StressRoomKind::Front;
+    }
+    for (const StressRoom& room : map.rooms) {
+        ++counts[static_cast<size_t>(room.kind)];
+    }
+    // 施設が 1 つもない種類は客室から作る
+    for (StressRoomKind kind : { StressRoomKind::Bath, StressRoomKind::Dining, StressRoomKind::Inn }) {
+        if (counts[static_cast<size_t>(kind)] > 0) {
+            continue;
+        }
+        for (StressRoom& room : map.rooms) {
+            if (room.kind == StressRoomKind::Guest && counts[static_cast<size_t>(StressRoomKind::Guest)] > 1) {
+                room.kind = kind;
+                --counts[static_cast<size_t>(StressRoomKind::Guest)];
+                ++counts[static_cast<size_t>(kind)];
+                break;
+            }
+        }
+    }
+    return map;
+}
+
+std::vector<StressGuestPlan> StressScenario::GenerateSchedule(const StressMap& map, int guests, uint32_t arrivalSpan, uint32_t seed,
+    uint32_t burstSize)
+{
+    std::vector<uint16_t> byKind[static_cast<size_t>(StressRoomKind::Count)];
+    for (size_t i = 0; i < map.rooms.size(); ++i) {
+        byKind[static_cast<size_t>(map.rooms[i].kind)].push_back(static_cast<uint16_t>(i));
+    }
+    const std::vector<uint16_t>& fronts = byKind[static_cast<size_t>(StressRoomKind::Front)];
+    const std::vector<uint16_t>& guestRooms = byKind[static_cast<size_t>(StressRoomKind::Guest)];
+    const StressRoomKind amenities[] = { StressRoomKind::Bath, StressRoomKind::Dining, StressRoomKind::Inn };
+
+    std::mt19937 rng(seed);
+    std::vector<StressGuestPlan> plans;
+    if (fronts.empty() || guestRooms.empty()) {
+        return plans;
+    }
+    plans.resize((std::max)(guests, 0));
+    for (StressGuestPlan& plan : plans) {
+        plan.arrivalTick = Random(rng, arrivalSpan);
+        plan.dwellTicks = static_cast<uint16_t>(60 + Random(rng, 240));
+        const uint16_t front = fronts[Random(rng, static_cast<uint32_t>(fronts.size()))];
+        const uint16_t own = guestRooms[Random(rng, static_cast<uint32_t>(guestRooms.size()))];
+        plan.itinerary.push_back(front);
+        plan.itinerary.push_back(own);
+        const uint32_t visits = 1 + Random(rng, 3);
+        for (uint32_t v = 0; v < visits; ++v) {
+            const std::vector<uint16_t>& rooms = byKind[static_cast<size_t>(amenities[Random(rng, 3)])];
+            if (!rooms.empty()) {
+                plan.itinerary.push_back(rooms[Random(rng, static_cast<uint32_t>(rooms.size()))]);
+            }
+        }
+        plan.itinerary.push_back(own);
+        plan.itinerary.push_back(front);
+        plan.itinerary.push_back(StressGuestPlan::EXIT);
+    }
+    std::stable_sort(plans.begin(), plans.end(),
+        [](const StressGuestPlan& a, const StressGuestPlan& b) { return a.arrivalTick < b.arrivalTick; });
+    if (burstSize > 0) {
+        for (size_t i = 0; i < plans.size(); ++i) {
+            plans[i].arrivalTick = plans[i - i % burstSize].arrivalTick;
+        }
+    }
+    return plans;
+}
+
+// ==============================
+// シミュレーション
+// ==============================
+StressSimulation::StressSimulation(const StressMap& map, const std::vector<StressGuestPlan>& schedule, StressPathing pathing,
+    uint32_t editInterval, const PathServiceConfig* async)
+    : m_map(map)
+    , m_schedule(schedule)
+    , m_grid(map.grid)
+    , m_pathing(pathing)
+    , m_editInterval(editInterval)
+    , m_editSeed(0x9E3779B9u)
+{
+    if (m_pathing == StressPathing::JumpPoint) {
+        m_search.SetMode(NavSearchMode::JumpPoint);
+    }
+    if (async && (m_pathing == StressPathing::AStar || m_pathing == StressPathing::JumpPoint)) {
+        PathServiceConfig config = *async;
+        config.mode = m_search.GetMode();
+        m_service = std::make_unique<PathRequestService>(config);
+    }
+    m_bucketsX = (map.grid.GetWidth() + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    m_bucketsY = (map.grid.GetHeight() + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    m_bucketStart.resize(static_cast<size_t>(m_bucketsX) * m_bucketsY + 1);
+
+    if (m_pathing == StressPathing::FlowField) {
+        // 部屋の番号 = 流れ場のキー。最後の 1 つは玄関
+        m_roomCells.resize(map.rooms.size() + 1);
+        for (size_t i = 0; i < map.rooms.size(); ++i) {
+            const StressRoom& room = map.rooms[i];
+            for (int y = room.y; y < room.y + room.height; ++y) {
+                for (int x = room.x; x < room.x + room.width; ++x) {
+                    if (map.grid.IsWalkable(x, y)) {
+                        m_roomCells[i].push_back(GridPoint{ x, y });
+                    }
+                }
+            }
+        }
+        m_roomCells.back().push_back(map.entrance);
+        if (m_editInterval > 0) {
+            m_fields.SetUpdateBudget(FIELD_UPDATE_BUDGET_MS);
+        }
+    }
+
+    if (m_editInterval > 0) {
+        // 部屋の中と、扉・玄関とその周り 1 マスにはついたてを置かない（角を切れないので、扉の前をふさぐと出入りできなくなる）
+        const int width = map.grid.GetWidth();
+        const int height = map.grid.GetHeight();
+        m_blockedForScreens.assign(static_cast<size_t>(width) * height, 0);
+        auto blockAround = [&](const GridPoint& p) {
+            for (int y = (std::max)(p.y - 1, 0); y <= (std::min)(p.y + 1, height - 1); ++y) {
+                for (int x = (std::max)(p.x - 1, 0); x <= (std::min)(p.x + 1, width - 1); ++x) {
+                    m_blockedForScreens[static_cast<size_t>(y) * width + x] = 1;
+                }
+            }
+        };
+        for (const StressRoom& room : map.rooms) {
+            for (int y = room.y; y < room.y + room.height; ++y) {
+                for (int x = room.x; x < room.x + room.width; ++x) {
+                    m_blockedForScreens[static_cast<size_t>(y) * width + x] = 1;
+                }
+            }
+            blockAround(room.door);
+        }
+        blockAround(map.entrance);
+    }
+}
+
+void StressSimulation::PreparePathing()
+{
+    for (size_t i = 0; i < m_roomCells.size(); ++i) {
+        GetField(static_cast<uint16_t>(i));
+    }
+    if (m_pathing == StressPathing::Hierarchy) {
+        m_hierarchy.Build(m_grid);
+    }
+}
+
+const FlowField& StressSimulation::GetField(uint16_t room)
+{
+    const uint32_t key = room == StressGuestPlan::EXIT ? static_cast<uint32_t>(m_map.rooms.size()) : room;
+    const std::vector<GridPoint>& cells = m_roomCells[key];
+    return m_fields.Get(m_grid, key, cells.data(), cells.size());
+}
+
+void StressSimulation::Arrive(Guest& guest)
+{
+    const StressGuestPlan& plan = m_schedule[guest.plan];
+    guest.path.Clear();
+    guest.field = nullptr;
+    if (plan.itinerary[guest.leg] == StressGuestPlan::EXIT) {
+        guest.leg = static_cast<uint16_t>(plan.itinerary.size()); // 次の Schedule で帰す
+    }
+    else {
+        guest.dwellUntil = m_tick + plan.dwellTicks;
+    }
+}
+
+void StressSimulation::LoadTextures(IGraphics& graphics)
+{
+    m_floorTexture = graphics.LoadTexture("rom/images/tile_floor.png");
+    m_wallTexture = graphics.LoadTexture("rom/images/tile_wall.png");
+    m_guestTexture = graphics.LoadTexture("rom/images/guest.png");
+    for (size_t i = 0; i < static_cast<size_t>(StressRoomKind::Count); ++i) {
+        m_roomTextures[i] = graphics.LoadTexture(ROOM_TEXTURES[i]);
+    }
+}
+
+void StressSimulation::UnloadTextures(IGraphics& graphics)
+{
+    for (TextureHandle* texture : { &m_floorTexture, &m_wallTexture, &m_guestTexture }) {
+        if (*texture) {
+            graphics.UnloadTexture(*texture);
+            *texture = nullptr;
+        }
+    }
+    for (TextureHandle& texture : m_roomTextures) {
+        if (texture) {
+            graphics.UnloadTexture(texture);
+            texture = nullptr;
+        }
+    }
+}
+
+GridPoint StressSimulation::GetTarget(const Guest& guest) const
+{
+    const uint16_t room = m_schedule[guest.plan].itinerary[guest.leg];
+    return room == StressGuestPlan::EXIT ? m_map.entrance : m_map.rooms[room].spot;
+}
+
+void StressSimulation::Tick()
+{
+    struct Step
+    {
+        StressSubsystem subsystem;
+        void (StressSimulation::*update)();
+    };
+    static const Step STEPS[] = {
+        { StressSubsystem::Schedule, &StressSimulation::UpdateSchedule },
+        { StressSubsystem::Editing, &StressSimulation::UpdateEditing },
+        { StressSubsystem::Pathing, &StressSimulation::UpdatePathing },
+        { StressSubsystem::Movement, &StressSimulation::UpdateMovement },
+        { StressSubsystem::Vision, &StressSimulation::UpdateVision },
+    };
+    for (const Step& step : STEPS) {
+        const int64_t start = PacerClock::NowNs();
+        (this->*step.update)();
+        m_lastNs[static_cast<size_t>(step.subsystem)] = PacerClock::NowNs() - start;
+    }
+    m_lastNs[static_cast<size_t>(StressSubsystem::Drawing)] = 0;
+    ++m_tick;
+}
+
+void StressSimulation::UpdateSchedule()
+{
+    PROFILE_ZONE("Stress::Schedule");
+    while (m_nextArrival < m_schedule.size() && m_schedule[m_nextArrival].arrivalTick <= m_tick) {
+        Guest guest;
+        guest.plan = static_cast<uint32_t>(m_nextArrival++);
+        guest.pos = m_map.entrance;
+        m_active.push_back(std::move(guest));
+    }
+
+    for (size_t i = 0; i < m_active.size();) {
+        Guest& guest = m_active[i];
+        if (guest.dwellUntil != 0 && m_tick >= guest.dwellUntil) {
+            guest.dwellUntil = 0;
+            ++guest.leg;
+            guest.needsPath = true;
+        }
+        if (guest.leg >= m_schedule[guest.plan].itinerary.size()) {
+            // 回り終えた客は帰る（順序は問わないので末尾と入れ替えて消す）
+            guest = std::move(m_active.back());
+            m_active.pop_back();
+            ++m_finished;
+            continue;
+        }
+        ++i;
+    }
+}
+
+void StressSimulation::UpdateEditing()
+{
+    PROFILE_ZONE("Stress::Editing");
+    if (m_pathing == StressPathing::FlowField && m_editInterval > 0) {
+        // 書き換えで古くなった場を、持ち時間の分だけ直す
+        const size_t refreshed = m_fields.Update(m_grid);
+        if (refreshed > 0) {
+            m_routeRepairs += refreshed;
+            CheckFieldRoutes();
+        }
+    }
+    if (m_editInterval == 0 || (m_tick + 1) % m_editInterval != 0) {
+        return;
+    }
+    const uint32_t revisionBefore = m_grid.GetRevision();
+    Screen screen;
+    if (m_screenPlaced) {
+        screen = m_screen;
+        m_grid.FillRect(screen.x, screen.y, screen.width, screen.height, true);
+        m_screenPlaced = false;
+    }
+    else if (PlaceScreen(screen)) {
+        m_grid.FillRect(screen.x, screen.y, screen.width, screen.height, false);
+        m_screen = screen;
+        m_screenPlaced = true;
+    }
+    else {
+        return;
+    }
+    ++m_edits;
+    RepairRoutes(screen, revisionBefore);
+}
+
+bool StressSimulation::PlaceScreen(Screen& screen)
+{
+    // 2 マスのついたてを縦か横に置く（幅 3 の廊下・通路なら 1 マスの隙間が残るので、ふさぎ切りはしない）
+    const int width = m_grid.GetWidth();
+    const int height = m_grid.GetHeight();
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        const bool vertical = (NextRandom(m_editSeed) & 1) != 0;
+        screen.width = vertical ? 1 : 2;
+        screen.height = vertical ? 2 : 1;
+        screen.x = static_cast<int>(NextRandom(m_editSeed) % static_cast<uint32_t>(width - screen.width));
+        screen.y = static_cast<int>(NextRandom(m_editSeed) % static_cast<uint32_t>(height - screen.height));
+        bool free = true;
+        for (int y = screen.y; free && y < screen.y + screen.height; ++y) {
+            for (int x = screen.x; free && x < screen.x + screen.width; ++x) {
+                free = m_grid.IsWalkable(x, y) && m_blockedForScreens[static_cast<size_t>(y) * width + x] == 0;
+            }
+        }
+        for (const Guest& guest : m_active) {
+            if (!free) {
+                break;
+            }
+            free = guest.pos.x < screen.x || guest.pos.x >= screen.x + screen.width
+                || guest.pos.y < screen.y || guest.pos.y >= screen.y + screen.height;
+        }
+        if (free) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StressSimulation::IsPathBlocked(const Guest& guest, const Screen& screen) const
+{
+    // 書き換えで変わる一歩は、どちらかの端が矩形と周り 1 マスの中にある
+    const auto nearScreen = [&screen](const GridPoint& p) {
+        return p.x >= screen.x - 1 && p.x <= screen.x + screen.width && p.y >= screen.y - 1 && p.y <= screen.y + screen.height;
+    };
+    const std::vector<GridPoint>& points = guest.path.points;
+    for (size_t i = guest.pathIndex; i + 1 < points.size(); ++i) {
+        const GridPoint& a = points[i];
+        const GridPoint& b = points[i + 1];
+        if (!nearScreen(a) && !nearScreen(b)) {
+            continue;
+        }
+        for (int d = 0; d < NavGrid::DIRECTION_COUNT; ++d) {
+            if (a.x + NavGrid::DX[d] == b.x && a.y + NavGrid::DY[d] == b.y && !m_grid.CanStep(a.x, a.y, d)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void StressSimulation::CheckFieldRoutes()
+{
+    for (Guest& guest : m_active) {
+        if (!guest.IsWalking() || !guest.field || guest.field->GetRevision() != m_grid.GetRevision()) {
+            continue;
+        }
+        if (!guest.field->IsReachable(guest.pos)) {
+            ++m_pathFailures;
+            ++guest.leg;
+            guest.needsPath = true;
+            guest.field = nullptr;
+        }
+    }
+}
+
+void StressSimulation::RepairRoutes(const Screen& screen, uint32_t revisionBefore)
+{
+    const auto fail = [this](Guest& guest) {
+        ++m_pathFailures;
+        ++guest.leg;
+        guest.needsPath = true;
+        guest.path.Clear();
+        guest.field = nullptr;
+    };
+
+    if (m_pathing == StressPathing::FlowField) {
+        // 場は UpdateEditing が次の tick から少しずつ直す（場は容量無制限なので、客が持つ参照はそのまま使える）
+        m_fields.OnGridEdited(m_grid, revisionBefore, screen.x, screen.y, screen.width, screen.height);
+        return;
+    }
+
+    // 客ごとの経路は、通れなくなった客だけ今いるセルから解き直す
+    if (m_pathing == StressPathing::Hierarchy) {
+        m_hierarchy.Update(m_grid, screen.x, screen.y, screen.width, screen.height);
+    }
+    for (Guest& guest : m_active) {
+        if (!guest.IsWalking() || guest.path.IsEmpty() || !IsPathBlocked(guest, screen)) {
+            continue;
+        }
+        bool found = false;
+        if (m_pathing == StressPathing::Hierarchy) {
+            found = m_hierarchy.FindPath(m_grid, guest.pos, GetTarget(guest), guest.path);
+            m_repairExpandedNodes += m_hierarchy.GetLastQueryStats().expanded;
+        }
+        else {
+            found = m_search.FindPath(m_grid, guest.pos, GetTarget(guest), guest.path);
+            m_repairExpandedNodes += m_search.GetLastStats().expanded;
+        }
+        if (found) {
+            guest.pathIndex = 0;
+            ++m_routeRepairs;
+        }
+        else {
+            fail(guest);
+        }
+    }
+}
+
+void StressSimulation::ApplyPathResult(Guest& guest, PathResult& result)
+{
+    guest.ticket = 0;
+    m_expandedNodes += result.expanded;
+    if (!result.found) {
+        ++m_pathFailures;
+        ++guest.leg;
+        guest.needsPath = true;
+        return;
+    }
+
+    // 仮の向きに進んだ道を今いるセルから戻り、経路の先頭の近くのなるべく先の点へつなぐ。
+    // 道の先頭は経路の始点なので、必ずどこかでつながる（つないだ分の cost は直さない。移動には使わないので）
+    constexpr size_t JOIN_WINDOW = 8;
+    const std::vector<GridPoint>& trail = guest.trail;
+    const std::vector<GridPoint>& points = result.path.points;
+    size_t back = 0;
+    size_t join = points.size();
+    for (size_t t = trail.size(); t-- > 0 && join == points.size();) {
+        for (size_t i = 0; i < (std::min)(points.size(), JOIN_WINDOW); ++i) {
+            if (points[i] == trail[t] || CanStepTo(m_grid, trail[t], points[i])) {
+                join = i;
+            }
+        }
+        back = t;
+    }
+    std::vector<GridPoint>& joined = guest.path.points;
+    joined.assign(trail.rbegin(), trail.rbegin() + (trail.size() - back));
+    joined.insert(joined.end(), points.begin() + join + (points[join] == trail[back] ? 1 : 0), points.end());
+    guest.path.cost = result.path.cost;
+    guest.pathIndex = 0;
+    guest.trail.clear();
+
+    // 依頼の後にマップを書き換えていたら、ふさがれていないか全体を見る（ふさがれていたら次の tick に依頼し直す）
+    if (result.revision != m_grid.GetRevision()) {
+        for (size_t i = 0; i + 1 < joined.size(); ++i) {
+            if (!CanStepTo(m_grid, joined[i], joined[i + 1])) {
+                guest.path.Clear();
+                guest.needsPath = true;
+                return;
+            }
+        }
+    }
+}
+
+void StressSimulation::UpdatePathingAsync()
+{
+    // 行き先が変わった客の依頼を出してから、届いた分を受け取る（受け取りで失敗・依頼し直しになった客は次の tick に依頼する）
+    uint64_t queries = 0;
+    for (Guest& guest : m_active) {
+        if (!guest.needsPath) {
+            continue;
+        }
+        guest.needsPath = false;
+        guest.pathIndex = 0;
+        guest.moveTimer = 0;
+        guest.path.Clear();
+        guest.trail.assign(1, guest.pos);
+        guest.ticket = m_service->Submit(m_grid, guest.pos, GetTarget(guest), m_tick);
+        ++queries;
+    }
+    m_pathQueries += queries;
+    FrameCounters::Add(FrameCounter::PathQueries, queries);
+
+    m_service->Update(m_tick, m_pathResults);
+    if (m_pathResults.empty()) {
+        return;
+    }
+    for (Guest& guest : m_active) {
+        if (guest.ticket == 0) {
+            continue;
+        }
+        auto it = std::lower_bound(m_pathResults.begin(), m_pathResults.end(), guest.ticket,
+            [](const PathResult& result, PathTicket ticket) { return result.ticket < ticket; });
+        if (it != m_pathResults.end() && it->ticket == guest.ticket) {
+            ApplyPathResult(guest, *it);
+        }
+    }
+}
+
+void StressSimulation::UpdatePathing()
+{
+    PROFILE_ZONE("Stress::Pathing");
+    if (m_service) {
+        UpdatePathingAsync();
+        return;
+    }
+    uint64_t queries = 0;
+    for (Guest& guest : m_active) {
+        if (!guest.needsPath) {
+            continue;
+        }
+        guest.needsPath = false;
+        guest.pathIndex = 0;
+        guest.moveTimer = 0;
+        ++queries;
+        bool found = false;
+        if (m_pathing == StressPathing::FlowField) {
+            // 場はマップが変わらない限り作り直されない。ここは引くだけ
+            guest.field = &GetField(m_schedule[guest.plan].itinerary[guest.leg]);
+            found = guest.field->IsReachable(guest.pos);
+        }
+        else if (m_pathing == StressPathing::Hierarchy) {
+            found = m_hierarchy.FindPath(m_grid, guest.pos, GetTarget(guest), guest.path);
+            m_expandedNodes += m_hierarchy.GetLastQueryStats().expanded;
+        }
+        else {
+            found = m_search.FindPath(m_grid, guest.pos, GetTarget(guest), guest.path);
+            m_expandedNodes += m_search.GetLastStats().expanded;
+        }
+        if (!found) {
+            // 行けない行き先は飛ばして次へ
+            ++m_pathFailures;
+            ++guest.leg;
+            guest.needsPath = true;
+        }
+    }
+    m_pathQueries += queries;
+    FrameCounters::Add(FrameCounter::PathQueries, queries);
+}
+
+void StressSimulation::UpdateMovement()
+{
+    PROFILE_ZONE("Stress::Movement");
+    for (Guest& guest : m_active) {
+        if (guest.dwellUntil != 0 || guest.needsPath) {
+            continue;
+        }
+        if (guest.field) {
+            if (++guest.moveTimer >= MOVE_TICKS) {
+                // 作り直し待ちの古い場が壁を指していたら、作り直されるまでその場で待つ
+                const GridPoint next = guest.field->GetNextStep(guest.pos);
+                if (next == guest.pos || CanStepTo(m_grid, guest.pos, next)) {
+                    guest.moveTimer = 0;
+                    guest.pos = next;
+                }
+            }
+            if (guest.field->IsGoal(guest.pos)) {
+                Arrive(guest);
+            }
+            continue;
+        }
+        if (guest.ticket != 0) {
+            // 経路が届くまでは行き先の方へ進んでおく
+            if (++guest.moveTimer >= MOVE_TICKS) {
+                guest.moveTimer = 0;
+                const GridPoint next = PathRequestService::GetProvisionalStep(m_grid, guest.pos, GetTarget(guest));
+                if (next != guest.pos) {
+                    guest.pos = next;
+                    guest.trail.push_back(next);
+                    ++m_provisionalSteps;
+                }
+            }
+            continue;
+        }
+        if (guest.path.IsEmpty()) {
+            continue;
+        }
+        if (++guest.moveTimer >= MOVE_TICKS) {
+            guest.moveTimer = 0;
+            if (guest.pathIndex + 1 < guest.path.points.size()) {
+                guest.pos = guest.path.points[++guest.pathIndex];
+            }
+        }
+        if (guest.pathIndex + 1 >= guest.path.points.size()) {
+            Arrive(guest);
+        }
+    }
+    FrameCounters::Add(FrameCounter::GuestsUpdated, m_active.size());
+}
+
+void StressSimulation::UpdateVision()
+{
+    PROFILE_ZONE("Stress::Vision");
+    // バケットごとの客を数え上げソートで並べる
+    const size_t bucketCount = static_cast<size_t>(m_bucketsX) * m_bucketsY;
+    std::fill(m_bucketStart.begin(), m_bucketStart.end(), 0);
+    for (const Guest& guest : m_active) {
+        ++m_bucketStart[(guest.pos.y / BUCKET_SIZE) * m_bucketsX + guest.pos.x / BUCKET_SIZE + 1];
+    }
+    for (size_t b = 0; b < bucketCount; ++b) {
+        m_bucketStart[b + 1] += m_bucketStart[b];
+    }
+    m_bucketGuests.resize(m_active.size());
+    for (uint32_t i = 0; i < m_active.size(); ++i) {
+        const GridPoint& p = m_active[i].pos;
+        m_bucketGuests[m_bucketStart[(p.y / BUCKET_SIZE) * m_bucketsX + p.x / BUCKET_SIZE]++] = i;
+    }
+    // 詰めるときに進めた先頭を戻す
+    for (size_t b = bucketCount; b > 0; --b) {
+        m_bucketStart[b] = m_bucketStart[b - 1];
+    }
+    m_bucketStart[0] = 0;
+
+    static_assert(VISION_RADIUS <= BUCKET_SIZE, "vision only looks at neighbouring buckets");
+    uint64_t sightings = 0;
+    for (uint32_t i = 0; i < m_active.size(); ++i) {
+        const GridPoint& a = m_active[i].pos;
+        const int bx = a.x / BUCKET_SIZE;
+        const int by = a.y / BUCKET_SIZE;
+        for (int y = (std::max)(by - 1, 0); y <= (std::min)(by + 1, m_bucketsY - 1); ++y) {
+            for (int x = (std::max)(bx - 1, 0); x <= (std::min)(bx + 1, m_bucketsX - 1); ++x) {
+                const size_t bucket = static_cast<size_t>(y) * m_bucketsX + x;
+                for (uint32_t k = m_bucketStart[bucket]; k < m_bucketStart[bucket + 1]; ++k) {
+                    const uint32_t j = m_bucketGuests[k];
+                    if (j <= i) {
+                        continue; // 組は 1 回だけ
+                    }
+                    const GridPoint& b = m_active[j].pos;
+                    const int dx = a.x - b.x;
+                    const int dy = a.y - b.y;
+                    if (dx * dx + dy * dy <= VISION_RADIUS * VISION_RADIUS && m_grid.HasLineOfSight(a, b)) {
+                        ++sightings;
+                    }
+                }
+            }
+        }
+    }
+    m_sightings += sightings;
+}
+
+void StressSimulation::Draw(IGraphics& graphics, int screenWidth, int screenHeight)
+{
+    PROFILE_ZONE("Stress::Draw");
+    const int64_t start = PacerClock::NowNs();
+    const NavGrid& grid = m_grid;
+    const int viewWidth = screenWidth / TILE_PIXELS;
+    const int viewHeight = screenHeight / TILE_PIXELS;
+
+    // カメラはマップの上を往復させる（毎回同じ場所だけを描かないように）
+    auto pingPong = [](uint32_t t, int range) {
+        if (range <= 0) {
+            return 0;
+        }
+        const int phase = static_cast<int>(t % static_cast<uint32_t>(range * 2));
+        return phase < range ? phase : range * 2 - phase;
+    };
+    const int cameraX = pingPong(m_tick / 4, grid.GetWidth() - viewWidth);
+    const int cameraY = pingPong(m_tick / 6, grid.GetHeight() - viewHeight);
+    const float tile = static_cast<float>(TILE_PIXELS);
+    auto toScreen = [&](float x, float y) {
+        return Vec2f{ (x - cameraX + 0.5f) * tile, (y - cameraY + 0.5f) * tile };
+    };
+
+    graphics.BeginDraw();
+    Quad quad;
+    quad.size = Vec2f{ tile, tile };
+    for (int y = cameraY; y < (std::min)(cameraY + viewHeight + 1, grid.GetHeight()); ++y) {
+        for (int x = cameraX; x < (std::min)(cameraX + viewWidth + 1, grid.GetWidth()); ++x) {
+            quad.texture = grid.IsWalkable(x, y) ? m_floorTexture : m_wallTexture;
+            quad.position = toScreen(static_cast<float>(x), static_cast<float>(y));
+            graphics.DrawQuad(quad);
+        }
+    }
+
+    quad.color = MyGame::Float4(1.0f, 1.0f, 1.0f, 0.35f);
+    for (const StressRoom& room : m_map.rooms) {
+        if (room.x + room.width < cameraX || room.x > cameraX + viewWidth ||
+            room.y + room.height < cameraY || room.y > cameraY + viewHeight) {
+            continue;
+        }
+        quad.texture = m_roomTextures[static_cast<size_t>(room.kind)];
+        quad.position = toScreen(room.x + (room.width - 1) * 0.5f, room.y + (room.height - 1) * 0.5f);
+        quad.size = Vec2f{ room.width * tile, room.height * tile };
+        graphics.DrawQuad(quad);
+    }
+
+    quad.color = MyGame::Float4(1.0f, 1.0f, 1.0f, 1.0f);
+    quad.size = Vec2f{ tile, tile };
+    quad.texture = m_guestTexture;
+    for (const Guest& guest : m_active) {
+        const GridPoint& p = guest.pos;
+        if (p.x < cameraX || p.x > cameraX + viewWidth || p.y < cameraY || p.y > cameraY + viewHeight) {
+            continue;
+        }
+        quad.position = toScreen(static_cast<float>(p.x), static_cast<float>(p.y));
+        graphics.DrawQuad(quad);
+    }
+    graphics.EndDraw();
+    m_lastNs[static_cast<size_t>(StressSubsystem::Drawing)] = PacerClock::NowNs() - start;
+}
+
+// ==============================
+// 実行と出力
+// ==============================
+StressReport RunStressScenario(IGraphics& graphics, int width, int height, int guests, StressPathing pathing,
+    uint32_t ticks, int drawEvery, uint32_t seed, int screenWidth, int screenHeight, uint32_t editInterval,
+    uint32_t burstSize, const PathServiceConfig* async)
+{
+    const StressMap map = StressScenario::GenerateMap(width, height, seed);
+    const std::vector<StressGuestPlan> schedule = StressScenario::GenerateSchedule(map, guests, ticks / 3, seed + 1, burstSize);
+
+    StressReport report;
+    report.width = map.grid.GetWidth();
+    report.height = map.grid.GetHeight();
+    report.guests = guests;
+    report.pathing = pathing;
+    report.ticks = ticks;
+    report.editInterval = editInterval;
+    report.rooms = map.rooms.size();
+    report.burstSize = burstSize;
+
+    std::vector<int64_t> samples[SUBSYSTEM_COUNT];
+    std::vector<int64_t> totals;
+    for (std::vector<int64_t>& s : samples) {
+        s.reserve(ticks);
+    }
+    totals.reserve(ticks);
+
+    StressSimulation simulation(map, schedule, pathing, editInterval, async);
+    simulation.PreparePathing();
+    if (pathing == StressPathing::FlowField) {
+        const FlowFieldCache& fields = simulation.GetFlowFields();
+        report.flowFields = fields.GetFieldCount();
+        report.flowFieldBuildMs = fields.GetStats().buildMicros / 1000.0;
+        report.flowFieldBytes = fields.GetMemorySize();
+    }
+    else if (pathing == StressPathing::Hierarchy) {
+        const NavHierarchyStats& stats = simulation.GetHierarchy().GetStats();
+        report.hierarchyNodes = stats.nodes;
+        report.hierarchyBuildMs = stats.rebuildMicros / 1000.0;
+    }
+    simulation.LoadTextures(graphics);
+    for (uint32_t t = 0; t < ticks; ++t) {
+        simulation.Tick();
+        if (drawEvery > 0 && (t + 1) % drawEvery == 0) {
+            simulation.Draw(graphics, screenWidth, screenHeight);
+        }
+        FrameCounters::EndFrame();
+
+        int64_t total = 0;
+        for (size_t i = 0; i < SUBSYSTEM_COUNT; ++i) {
+            const int64_t ns = simulation.GetLastCost(static_cast<StressSubsystem>(i));
+            samples[i].push_back(ns);
+            total += ns;
+        }
+        totals.push_back(total);
+        report.peakActive = (std::max)(report.peakActive, simulation.GetActiveGuestCount());
+    }
+    simulation.UnloadTextures(graphics);
+
+    for (size_t i = 0; i < SUBSYSTEM_COUNT; ++i) {
+        report.costs[i] = Summarize(samples[i]);
+    }
+    report.total = Summarize(totals);
+    report.pathQueries = simulation.GetPathQueries();
+    report.pathFailures = simulation.GetPathFailures();
+    report.expandedNodes = simulation.GetExpandedNodes();
+    report.sightings = simulation.GetSightings();
+    report.finished = simulation.GetFinishedCount();
+    report.edits = simulation.GetEditCount();
+    report.routeRepairs = simulation.GetRouteRepairs();
+    report.flowFieldPatches = simulation.GetFlowFields().GetStats().patches;
+    report.repairExpandedNodes = simulation.GetRepairExpandedNodes();
+    report.provisionalSteps = simulation.GetProvisionalSteps();
+    if (const PathRequestService* service = simulation.GetPathService()) {
+        report.async = true;
+        report.asyncConfig = service->GetConfig();
+        report.asyncForced = service->GetStats().forced;
+        report.asyncMaxDelay = service->GetStats().maxDelayTicks;
+    }
+    return report;
+}
+
+void WriteStressCsvHeader(FILE* fp)
+{
+    std::fprintf(fp, "width,height,guests,pathing,ticks,edit_interval,rooms,peak_active,path_queries,path_failures,expanded_nodes,sightings,finished,"
+        "flow_fields,flow_field_build_ms,flow_field_kb,flow_field_patches,hpa_nodes,hpa_build_ms,edits,route_repairs,repair_expanded_nodes,"
+        "burst,async,async_workers,async_budget_ms,async_forced,async_max_delay,provisional_steps");
+    for (size_t i = 0; i < SUBSYSTEM_COUNT; ++i) {
+        const char* name = SUBSYSTEM_NAMES[i];
+        std::fprintf(fp, ",%s_mean_us,%s_p99_us,%s_max_us", name, name, name);
+    }
+    std::fprintf(fp, ",total_mean_us,total_p99_us,total_max_us\n");
+}
+
+void WriteStressCsvRow(FILE* fp, const StressReport& r)
+{
+    std::fprintf(fp, "%d,%d,%d,%s,%u,%u,%zu,%zu,%llu,%llu,%llu,%llu,%llu,%zu,%.3f,%zu,%llu,%zu,%.3f,%llu,%llu,%llu,%u,%d,%u,%.3f,%llu,%u,%llu",
+        r.width, r.height, r.guests, StressScenario::GetPathingName(r.pathing), r.ticks, r.editInterval, r.rooms, r.peakActive,
+        static_cast<unsigned long long>(r.pathQueries), static_cast<unsigned long long>(r.pathFailures),
+        static_cast<unsigned long long>(r.expandedNodes), static_cast<unsigned long long>(r.sightings),
+        static_cast<unsigned long long>(r.finished), r.flowFields, r.flowFieldBuildMs, r.flowFieldBytes / 1024,
+        static_cast<unsigned long long>(r.flowFieldPatches), r.hierarchyNodes, r.hierarchyBuildMs, static_cast<unsigned long long>(r.edits),
+        static_cast<unsigned long long>(r.routeRepairs), static_cast<unsigned long long>(r.repairExpandedNodes),
+        r.burstSize, r.async ? 1 : 0, r.async ? r.asyncConfig.workerCount : 0u,
+        r.async ? r.asyncConfig.budgetMs : 0.0, static_cast<unsigned long long>(r.asyncForced), r.asyncMaxDelay,
+        static_cast<unsigned long long>(r.provisionalSteps));
+    for (const StressCost& c : r.costs) {
+        std::fprintf(fp, ",%.3f,%.3f,%.3f", c.meanUs, c.p99Us, c.maxUs);
+    }
+    std::fprintf(fp, ",%.3f,%.3f,%.3f\n", r.total.meanUs, r.total.p99Us, r.total.maxUs);
+}
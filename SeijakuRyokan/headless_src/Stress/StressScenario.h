@@ -0,0 +1,295 @@
+﻿/*****************************************************************//**
+ * @file   StressScenario.h
+ * @brief  大きさ・客数を指定して旅館マップとスケジュールを合成し、tick ごとの処理コストを測る
+ *
+ * @details
+ * - どこまでの規模で処理落ちするかを、推測ではなく規模ごとの実測値で見るためのもの
+ * - マップ: 廊下の帯（上下に客室などが並ぶ）を縦に重ね、縦の通路でつなぐ。
+ *   部屋の種類は フロント / 客室 / 風呂 / 食事処 / 宴会場（INN）で、rom/images/room_*.png に対応する
+ * - スケジュール: 客ごとに 到着 → フロント → 自室 → 施設 1〜3 か所 → 自室 → フロント → 玄関 を回る。
+ *   burstSize を指定すると、その人数ずつ同じ tick にまとめて到着させる（団体客。経路探索が 1 tick に集中する）
+ * - シミュレーション 1 tick を サブシステムごとに計測する
+ *   - Schedule : 到着・滞在の終了・次の行き先への切り替え
+ *   - Editing  : 建築モードの置き換えに相当する書き換え（廊下のついたての設置・撤去）と、それで通れなくなった経路の直し。
+ *                editInterval tick ごと（0 なら書き換えない）。直し方は経路の求め方ごとに、
+ *                A* / JPS / HPA* は影響を受けた客だけ解き直し（HPA* は先に階層を Update）、
+ *                流れ場は書き換えを FlowFieldCache に知らせるだけで、tick ごとに FIELD_UPDATE_BUDGET_MS まで
+ *                最近使った場から直す（距離の変わるセルだけ解き直し、直せない場は作り直す。
+ *                それまで古い向きが壁を指す客はその場で待つ）。
+ *                客ごとの D* Lite（前回の探索結果から直す）も試したが、256x192・500 人で 1 回の書き換えは JPS の解き直しより
+ *                速くならず、客ごとの状態が合計 92 MB になったので外した。行き先ごとに探索結果を持って
+ *                書き換えた所だけ直すのは流れ場（FlowField::ApplyEdit）が受け持つ
+ *   - Pathing  : 行き先が変わった客の経路探索（GridAStar の A* / JPS、NavHierarchy）か、行き先の流れ場の取得（FlowField）。
+ *                A* / JPS は PathServiceConfig を渡すと PathRequestService に依頼して後の tick に受け取る。
+ *                待つ間は仮の向きに進み、届いた経路には仮に歩いた道を戻ってつなぐ（書き換えの直しはその tick のうちに解く）
+ *   - Movement : 経路に沿って 1 マスずつ進める
+ *   - Vision   : 近くの客が見えるか（空間バケット＋視線判定）
+ *   - Drawing  : 画面内のタイル・部屋・客を IGraphics に描く
+ * - 乱数は seed 固定。同じ引数なら同じマップ・同じ客の動きになる
+ *********************************************************************/
+#pragma once
+#include "../../common_src/IGraphics.h"
+#include "../../common_src/System/FlowField.h"
+#include "../../common_src/System/NavGrid.h"
+#include "../../common_src/System/NavHierarchy.h"
+#include "../../common_src/System/PathRequestService.h"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+enum class StressRoomKind : uint8_t
+{
+    Front,
+    Guest,
+    Bath,
+    Dining,
+    Inn,
+    Count,
+};
+
+struct StressRoom
+{
+    StressRoomKind kind = StressRoomKind::Guest;
+    int x = 0; // 内側の矩形
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    GridPoint door; // 廊下との境の開口
+    GridPoint spot; // 客が目指す部屋の中の 1 点
+};
+
+struct StressMap
+{
+    NavGrid grid;
+    std::vector<StressRoom> rooms;
+    GridPoint entrance;
+};
+
+struct StressGuestPlan
+{
+    static constexpr uint16_t EXIT = 0xFFFF; // 玄関へ向かって帰る
+
+    uint32_t arrivalTick = 0;
+    uint16_t dwellTicks = 0;        // 各部屋での滞在
+    std::vector<uint16_t> itinerary; // rooms の番号（最後は EXIT）
+};
+
+// 客の経路の求め方
+enum class StressPathing
+{
+    AStar,     // 客ごとに GridAStar（部屋の中の 1 点まで）
+    FlowField, // 行き先の部屋ごとの流れ場をたどる（部屋に入ったら到着）
+    JumpPoint, // 客ごとに GridAStar の JumpPoint モード（経路は AStar と同じコスト）
+    Hierarchy, // 客ごとに NavHierarchy（HPA*。経路は最短より少し長いことがある）
+    Count,
+};
+
+enum class StressSubsystem
+{
+    Schedule,
+    Editing,
+    Pathing,
+    Movement,
+    Vision,
+    Drawing,
+    Count,
+};
+
+struct StressCost
+{
+    double meanUs = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+struct StressReport
+{
+    int width = 0;
+    int height = 0;
+    int guests = 0;
+    StressPathing pathing = StressPathing::AStar;
+    uint32_t ticks = 0;
+    uint32_t editInterval = 0;
+    size_t rooms = 0;
+    size_t peakActive = 0;   // 同時にいた客の最大数
+    uint64_t pathQueries = 0;
+    uint64_t pathFailures = 0;
+    uint64_t expandedNodes = 0;
+    uint64_t sightings = 0;  // 見えた客の組の数（延べ）
+    uint64_t finished = 0;   // 予定を回り終えて帰った客
+    size_t flowFields = 0;   // FlowField のとき: 作った場の数・所要時間・メモリ
+    double flowFieldBuildMs = 0.0;
+    size_t flowFieldBytes = 0;
+    uint64_t flowFieldPatches = 0; // 書き換えのあと、作り直さずに直した場の数（延べ）
+    size_t hierarchyNodes = 0; // Hierarchy のとき: 抽象ノード数と構築時間
+    double hierarchyBuildMs = 0.0;
+    uint64_t edits = 0;        // マップの書き換えの回数
+    uint64_t routeRepairs = 0; // 書き換えで経路を直した回数（流れ場なら直した・作り直した場の数）
+    uint64_t repairExpandedNodes = 0; // その直しで展開したノード数（流れ場は 0）
+    uint32_t burstSize = 0;    // 到着をまとめた人数（0 ならばらばら）
+    bool async = false;        // 経路を PathRequestService に依頼した（A* / JPS のときだけ）
+    PathServiceConfig asyncConfig;
+    uint64_t asyncForced = 0;      // 届ける tick までに解けておらず、その tick に解いた（待った）依頼
+    uint32_t asyncMaxDelay = 0;    // 依頼から届くまでの最大 tick 数
+    uint64_t provisionalSteps = 0; // 結果を待つ間に仮の向きへ進んだ歩数
+    StressCost costs[static_cast<size_t>(StressSubsystem::Count)];
+    StressCost total;        // 1 tick の合計
+};
+
+namespace StressScenario
+{
+    const char* GetRoomKindName(StressRoomKind kind);
+    const char* GetSubsystemName(StressSubsystem subsystem);
+    const char* GetPathingName(StressPathing pathing);
+
+    // width / height は 32 x 24 以上に切り上げる
+    StressMap GenerateMap(int width, int height, uint32_t seed);
+
+    // 到着は [0, arrivalSpan) に散らす。burstSize が 1 以上なら到着順にその人数ずつ先頭の客の tick にそろえる。到着順に並べて返す
+    std::vector<StressGuestPlan> GenerateSchedule(const StressMap& map, int guests, uint32_t arrivalSpan, uint32_t seed,
+        uint32_t burstSize = 0);
+}
+
+class StressSimulation
+{
+public:
+    // editInterval tick ごとにマップを書き換える（0 なら書き換えない）。マップのグリッドは複製して持つ
+    // async を渡すと、AStar / JumpPoint の経路探索を PathRequestService に依頼する（mode は pathing に合わせる）
+    StressSimulation(const StressMap& map, const std::vector<StressGuestPlan>& schedule,
+        StressPathing pathing = StressPathing::AStar, uint32_t editInterval = 0, const PathServiceConfig* async = nullptr);
+
+    // 経路の前計算（マップ読み込み時に相当。tick には含めない）
+    // FlowField なら全部屋と玄関の流れ場、Hierarchy なら階層グラフを作る
+    void PreparePathing();
+    const FlowFieldCache& GetFlowFields() const { return m_fields; }
+    const NavHierarchy& GetHierarchy() const { return m_hierarchy; }
+
+    void LoadTextures(IGraphics& graphics);
+    void UnloadTextures(IGraphics& graphics);
+
+    // Schedule → Editing → Pathing → Movement → Vision を 1 回
+    void Tick();
+    void Draw(IGraphics& graphics, int screenWidth, int screenHeight);
+
+    // 直近の Tick / Draw の所要時間（ナノ秒）
+    int64_t GetLastCost(StressSubsystem subsystem) const { return m_lastNs[static_cast<size_t>(subsystem)]; }
+
+    uint32_t GetTick() const { return m_tick; }
+    size_t GetActiveGuestCount() const { return m_active.size(); }
+    uint64_t GetPathQueries() const { return m_pathQueries; }
+    uint64_t GetPathFailures() const { return m_pathFailures; }
+    uint64_t GetExpandedNodes() const { return m_expandedNodes; }
+    uint64_t GetSightings() const { return m_sightings; }
+    uint64_t GetFinishedCount() const { return m_finished; }
+    uint64_t GetEditCount() const { return m_edits; }
+    uint64_t GetRouteRepairs() const { return m_routeRepairs; }
+    uint64_t GetRepairExpandedNodes() const { return m_repairExpandedNodes; }
+    uint64_t GetProvisionalSteps() const { return m_provisionalSteps; }
+    // 依頼サービスを使っていなければ nullptr
+    const PathRequestService* GetPathService() const { return m_service.get(); }
+
+private:
+    static constexpr int MOVE_TICKS = 6;     // 1 マス進むのにかかる tick（10 マス/秒）
+    static constexpr int VISION_RADIUS = 8;  // マス
+    static constexpr int BUCKET_SIZE = 8;    // 空間バケットの一辺（マス）
+    static constexpr int TILE_PIXELS = 32;
+    static constexpr double FIELD_UPDATE_BUDGET_MS = 1.0; // 書き換えで古くなった流れ場を 1 tick に直す持ち時間
+
+    struct Guest
+    {
+        uint32_t plan = 0;       // schedule の番号
+        uint16_t leg = 0;        // itinerary の何番目へ向かっているか
+        uint16_t moveTimer = 0;
+        uint32_t dwellUntil = 0; // この tick まで部屋に留まる（0 なら移動中）
+        uint32_t pathIndex = 0;
+        bool needsPath = true;
+        GridPoint pos;
+        NavPath path;
+        const FlowField* field = nullptr; // FlowField のときだけ
+        PathTicket ticket = 0;            // 依頼した経路を待っている（届くまで仮の向きに進む）
+        std::vector<GridPoint> trail;     // 依頼したセルから仮の向きに進んだ道（先頭は依頼したセル）
+
+        bool IsWalking() const { return dwellUntil == 0 && !needsPath; }
+    };
+
+    struct Screen
+    {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    GridPoint GetTarget(const Guest& guest) const;
+    const FlowField& GetField(uint16_t room);
+    void Arrive(Guest& guest);
+    bool PlaceScreen(Screen& screen);
+    // 経路が書き換えた矩形の中で通れなくなったか（残りの部分だけ見る）
+    bool IsPathBlocked(const Guest& guest, const Screen& screen) const;
+    // revisionBefore は書き換える前のグリッドのリビジョン（流れ場を直すのに使う）
+    void RepairRoutes(const Screen& screen, uint32_t revisionBefore);
+    // 直した流れ場で、移動中の客が行き先へつながっているか見直す
+    void CheckFieldRoutes();
+    // 届いた経路を客に渡す。書き換えでふさがれていたら依頼し直す
+    void ApplyPathResult(Guest& guest, PathResult& result);
+    void UpdatePathingAsync();
+
+    void UpdateSchedule();
+    void UpdateEditing();
+    void UpdatePathing();
+    void UpdateMovement();
+    void UpdateVision();
+
+    const StressMap& m_map;
+    const std::vector<StressGuestPlan>& m_schedule;
+    NavGrid m_grid; // 書き換えるので m_map.grid の複製を使う
+    size_t m_nextArrival = 0;
+    uint32_t m_tick = 0;
+
+    std::vector<Guest> m_active;
+    StressPathing m_pathing = StressPathing::AStar;
+    GridAStar m_search;
+    FlowFieldCache m_fields;
+    std::unique_ptr<PathRequestService> m_service;
+    std::vector<PathResult> m_pathResults;
+    NavHierarchy m_hierarchy;
+    std::vector<std::vector<GridPoint>> m_roomCells; // 部屋ごとの内側のセル（流れ場の行き先）
+
+    // Editing 用。ついたては 1 つだけで、置いたら次の書き換えで撤去する
+    uint32_t m_editInterval = 0;
+    uint32_t m_editSeed = 0;
+    bool m_screenPlaced = false;
+    Screen m_screen;
+    std::vector<uint8_t> m_blockedForScreens; // 部屋の中・扉・玄関（ついたてを置かない）
+
+    // Vision 用の空間バケット（毎 tick 作り直す）
+    int m_bucketsX = 0;
+    int m_bucketsY = 0;
+    std::vector<uint32_t> m_bucketStart;
+    std::vector<uint32_t> m_bucketGuests;
+
+    TextureHandle m_floorTexture = nullptr;
+    TextureHandle m_wallTexture = nullptr;
+    TextureHandle m_guestTexture = nullptr;
+    TextureHandle m_roomTextures[static_cast<size_t>(StressRoomKind::Count)] = {};
+
+    int64_t m_lastNs[static_cast<size_t>(StressSubsystem::Count)] = {};
+    uint64_t m_pathQueries = 0;
+    uint64_t m_pathFailures = 0;
+    uint64_t m_expandedNodes = 0;
+    uint64_t m_sightings = 0;
+    uint64_t m_finished = 0;
+    uint64_t m_edits = 0;
+    uint64_t m_routeRepairs = 0;
+    uint64_t m_repairExpandedNodes = 0;
+    uint64_t m_provisionalSteps = 0;
+};
+
+// マップ・スケジュールを作り、ticks 回まわして集計する（drawEvery が 0 なら描画しない）
+StressReport RunStressScenario(IGraphics& graphics, int width, int height, int guests, StressPathing pathing,
+    uint32_t ticks, int drawEvery, uint32_t seed, int screenWidth, int screenHeight, uint32_t editInterval = 0,
+    uint32_t burstSize = 0, const PathServiceConfig* async = nullptr);
+
+void WriteStressCsvHeader(FILE* fp);
+void WriteStressCsvRow(FILE* fp, const StressReport& report);
@@ -0,0 +1,549 @@
+﻿/*****************************************************************//**
+ * @file   headless_main.cpp
+ * @brief  ウィンドウ無しで Game を全速で回し、シミュレーションの処理量を測る
+ *
+ * @details
+ * - pc_main.cpp の Window / DirectXGraphics / XInputGamepad を
+ *   NullGraphics（または SoftwareGraphics）/ ScriptedGamepad に差し替えたもの
+ * - 待ち合わせをせず Update(1/60) → Draw を繰り返し、ticks/sec と描画統計を出す
+ * - rom/ を相対パスで読むので SeijakuRyokan ディレクトリで実行する
+ *
+ * - 使い方
+ *     SeijakuRyokanHeadless [--ticks N] [--runs N] [--script file] [--trace file]
+ *                           [--draw-every N] [--software] [--pace FPS] [--render-thread]
+ *                           [--profile file] [--counters file] [--frametime file]
+ *                           [--memory file] [--stress WxH,...] [--stress-guests N,...] [--stress-pathing astar|flow|jps|hpa,...]
+ *                           [--stress-edits N] [--stress-burst N] [--stress-async MS] [--stress-async-workers N]
+ *                           [--stress-async-slots N] [--stress-async-latency N] [--stress-csv file]
+ *       --ticks      1回あたりの Update 回数（既定 36000 = ゲーム内 10 分）
+ *       --runs       計測の回数（毎回 Game を作り直す）
+ *       --script     ScriptedGamepad の台本（例: headless_src/scripts/sample_play.txt）
+ *       --trace      最後の回の描画トレースを書き出す
+ *       --draw-every N tick ごとに Draw（0 で描画しない）
+ *       --software   SoftwareGraphics で実際にラスタライズする
+ *       --pace       全速ではなく FramePacer で FPS に合わせて回し、起床のずれと CPU 使用率を出す
+ *       --render-thread ThreadedGraphics で描画を別スレッドに回す（Update と並行）
+ *       --profile    プロファイラを有効にし、最後に Chrome トレース（JSON）を書き出す
+ *       --counters   FrameCounters を 1 tick 1 行の CSV で書き出す（全回を通し番号で）。
+ *                    --render-thread のときは描画スレッドが描き終えたフレームごとに 1 行
+ *                    （frame は ThreadedGraphics のフレーム番号。飛ばされたフレームの分は次の行に入る）
+ *       --frametime  1 tick ごとの所要時間のヒストグラムとヒッチ（全回分）を書き出す
+ *       --memory     回ごとのリーク（Game の生成から破棄までに確保して残ったもの）と
+ *                    タグ別のメモリ使用量を書き出す（-DSEIJAKU_MEMORY_TRACKING=1 でビルドする）
+ *       --stress     Game の代わりに合成マップ（WxH をカンマ区切りで複数）× 客数で負荷試験を回し、
+ *                    サブシステムごとの 1 tick のコストを出す（--ticks の既定は 3600、--runs は使わない）
+ *       --stress-guests 負荷試験の客数（カンマ区切り。既定 50,200,500）
+ *       --stress-pathing 負荷試験の経路の求め方（astar: 客ごとに A*、flow: 行き先ごとの流れ場、
+ *                    jps: 客ごとに Jump Point Search、hpa: 客ごとに階層グラフ（HPA*）。
+ *                    カンマ区切りで並べて同じシナリオで比べられる。既定 astar）
+ *       --stress-edits 負荷試験で N tick ごとに廊下のついたてを置く・撤去する（建築モードの書き換えに相当）。
+ *                    通れなくなった経路はその tick のうちに直し、editing の行に出る（既定 0 = 書き換えない）。
+ *                    flow は古くなった流れ場を次の tick から 1 tick 1 ms まで、距離の変わるセルだけ解き直して直す
+ *       --stress-burst 負荷試験の客を N 人ずつ同じ tick にまとめて到着させる（団体客。既定 0 = ばらばら）
+ *       --stress-async astar / jps の経路探索を PathRequestService に依頼し、メインスレッドで 1 tick あたり MS ミリ秒まで
+ *                    先の依頼を解く。結果は依頼の 6 tick 後（混んでいればさらに後）に届き、待つ間は仮の向きに進む
+ *       --stress-async-workers --stress-async の代わりに N 本のワーカースレッドで解く（届く tick と結果は同じ）
+ *       --stress-async-slots 1 tick に届ける経路の上限（既定 8）。1 本の探索が重いほど小さくしないと、
+ *                    届ける tick に解き切れない分をその tick に解くことになり平らにならない
+ *       --stress-async-latency 依頼から結果が届くまでの tick 数（既定 6）。長くすると先に解いておける時間が増える
+ *       --stress-csv 負荷試験の結果を 1 シナリオ 1 行の CSV で書き出す（規模ごとの曲線用）
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -pthread -I. \
+ *         $(find headless_src common_src -name '*.cpp') tools/Common/PngIO.cpp tools/Common/JpegIO.cpp \
+ *         -lpng -ljpeg -o SeijakuRyokanHeadless
+ *********************************************************************/
+#include "Graphics/NullGraphics.h"
+#include "Graphics/SoftwareGraphics.h"
+#include "Input/ScriptedGamepad.h"
+#include "Stress/StressScenario.h"
+#include "../common_src/Game/Game.h"
+#include "../common_src/Graphics/ThreadedGraphics.h"
+#include "../common_src/System/FramePacer.h"
+#include "../common_src/System/FrameCounters.h"
+#include "../common_src/System/FrameTimeHistogram.h"
+#include "../common_src/System/MemoryTracker.h"
+#include "../common_src/System/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr int SCREEN_WIDTH = 1920;
+    constexpr int SCREEN_HEIGHT = 1080;
+    constexpr double FRAME_RATE = 60.0;
+
+    struct Options
+    {
+        uint64_t ticks = 36000;
+        int runs = 1;
+        int drawEvery = 1;
+        const char* scriptPath = nullptr;
+        const char* tracePath = nullptr;
+        const char* profilePath = nullptr;
+        const char* countersPath = nullptr;
+        const char* frameTimePath = nullptr;
+        const char* memoryPath = nullptr;
+        const char* stressSizes = nullptr; // 指定があれば負荷試験モード
+        const char* stressGuests = "50,200,500";
+        const char* stressPathing = "astar";
+        const char* stressCsvPath = nullptr;
+        uint32_t stressEdits = 0; // 書き換えの間隔（tick）
+        uint32_t stressBurst = 0;
+        double stressAsyncMs = -1.0; // 0 以上なら経路の依頼サービスを使う
+        unsigned stressAsyncWorkers = 0;
+        uint32_t stressAsyncSlots = 0;   // 0 なら PathServiceConfig の既定
+        uint32_t stressAsyncLatency = 0; // 〃
+        bool ticksGiven = false;
+        bool software = false;
+        bool renderThread = false;
+        double paceFps = 0.0; // 0 なら待たない
+    };
+
+    bool ParseOptions(int argc, char** argv, Options& opt)
+    {
+        for (int i = 1; i < argc; ++i) {
+            const char* arg = argv[i];
+            const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            if (std::strcmp(arg, "--software") == 0) {
+                opt.software = true;
+                continue;
+            }
+            if (std::strcmp(arg, "--render-thread") == 0) {
+                opt.renderThread = true;
+                continue;
+            }
+            if (!value) {
+                return false;
+            }
+            if (std::strcmp(arg, "--ticks") == 0) {
+                opt.ticks = std::strtoull(value, nullptr, 10);
+                opt.ticksGiven = true;
+            }
+            else if (std::strcmp(arg, "--runs") == 0)       opt.runs = std::atoi(value);
+            else if (std::strcmp(arg, "--draw-every") == 0) opt.drawEvery = std::atoi(value);
+            else if (std::strcmp(arg, "--script") == 0)     opt.scriptPath = value;
+            else if (std::strcmp(arg, "--trace") == 0)      opt.tracePath = value;
+            else if (std::strcmp(arg, "--pace") == 0)       opt.paceFps = std::atof(value);
+            else if (std::strcmp(arg, "--profile") == 0)    opt.profilePath = value;
+            else if (std::strcmp(arg, "--counters") == 0)   opt.countersPath = value;
+            else if (std::strcmp(arg, "--frametime") == 0)  opt.frameTimePath = value;
+            else if (std::strcmp(arg, "--memory") == 0)     opt.memoryPath = value;
+            else if (std::strcmp(arg, "--stress") == 0)     opt.stressSizes = value;
+            else if (std::strcmp(arg, "--stress-guests") == 0) opt.stressGuests = value;
+            else if (std::strcmp(arg, "--stress-pathing") == 0) opt.stressPathing = value;
+            else if (std::strcmp(arg, "--stress-csv") == 0) opt.stressCsvPath = value;
+            else if (std::strcmp(arg, "--stress-edits") == 0) opt.stressEdits = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (std::strcmp(arg, "--stress-burst") == 0) opt.stressBurst = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (std::strcmp(arg, "--stress-async") == 0) opt.stressAsyncMs = std::atof(value);
+            else if (std::strcmp(arg, "--stress-async-workers") == 0) opt.stressAsyncWorkers = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            else if (std::strcmp(arg, "--stress-async-slots") == 0) opt.stressAsyncSlots = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (std::strcmp(arg, "--stress-async-latency") == 0) opt.stressAsyncLatency = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else return false;
+            ++i;
+        }
+        return opt.runs > 0 && opt.drawEvery >= 0 && opt.paceFps >= 0.0;
+    }
+
+    struct RunResult
+    {
+        uint64_t ticks = 0;
+        uint64_t draws = 0;
+        double seconds = 0.0;
+        double cpuSeconds = 0.0; // プロセスの CPU 時間
+        FramePacingStats pacing; // --pace のときだけ意味がある
+        FrameTimeHistogram tickTimes; // 1 tick（Update + Draw + 待ち）の所要時間
+        bool quit = false; // Game 側が終了を要求した
+    };
+
+    RunResult RunOnce(IGraphics& graphics, ThreadedGraphics* threaded, ScriptedGamepad& gamepad, const Options& opt,
+        FILE* countersCsv, FrameTimeMonitor& frameTimes)
+    {
+        RunResult result;
+
+        // 描画スレッドがあればフレームは ThreadedGraphics が確定するので、確定した分を順に書く
+        uint64_t countersWritten = FrameCounters::GetCommittedCount();
+        auto writeCommittedCounters = [&] {
+            FrameCounters::Snapshot snapshot;
+            for (const uint64_t committed = FrameCounters::GetCommittedCount(); countersWritten < committed; ++countersWritten) {
+                if (countersCsv && FrameCounters::GetCommitted(countersWritten, snapshot)) {
+                    FrameCounters::WriteCsvRow(countersCsv, snapshot);
+                }
+            }
+        };
+
+        auto game = std::make_unique<Game>(&graphics);
+        game->SetGamepad(&gamepad);
+        gamepad.Rewind();
+        game->Initialize();
+
+        const float dt = static_cast<float>(1.0 / FRAME_RATE);
+        FramePacer pacer;
+        pacer.Reset(opt.paceFps > 0.0 ? opt.paceFps : FRAME_RATE);
+        const std::clock_t cpuStart = std::clock();
+        const auto start = std::chrono::steady_clock::now();
+        int64_t tickStart = PacerClock::NowNs();
+        while (result.ticks < opt.ticks) {
+            if (opt.paceFps > 0.0) {
+                pacer.WaitForNextFrame();
+            }
+            if (game->ShouldQuit()) {
+                result.quit = true;
+                break;
+            }
+            gamepad.Update();
+            {
+                PROFILE_ZONE("Game::Update");
+                game->Update(dt);
+            }
+            ++result.ticks;
+
+            if (opt.drawEvery > 0 && result.ticks % opt.drawEvery == 0) {
+                PROFILE_ZONE("Game::Draw");
+                game->Draw(); // Update 直後に描くので補間は不要（FixedStepLoop を使わないので alpha は 1 のまま）
+                ++result.draws;
+            }
+
+            if (threaded) {
+                writeCommittedCounters();
+            }
+            else {
+                FrameCounters::EndFrame();
+                if (countersCsv) {
+                    FrameCounters::WriteCsvRow(countersCsv, FrameCounters::GetLastFrame());
+                }
+            }
+
+            const int64_t tickEnd = PacerClock::NowNs();
+            const double tickSeconds = static_cast<double>(tickEnd - tickStart) * 1.0e-9;
+            tickStart = tickEnd;
+            result.tickTimes.RecordSeconds(tickSeconds);
+            frameTimes.AddFrame(tickSeconds);
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        result.pacing = pacer.GetStats();
+
+        game->Terminate();
+        if (threaded) {
+            threaded->Flush();
+            writeCommittedCounters();
+        }
+        return result;
+    }
+
+    // "128x96,256x192" / "50,200" のようなカンマ区切りを読む
+    bool ParseSizes(const char* text, std::vector<std::pair<int, int>>& out)
+    {
+        for (const char* p = text; *p;) {
+            char* end = nullptr;
+            const long w = std::strtol(p, &end, 10);
+            if (end == p || (*end != 'x' && *end != 'X')) {
+                return false;
+            }
+            p = end + 1;
+            const long h = std::strtol(p, &end, 10);
+            if (end == p || w <= 0 || h <= 0 || (*end != ',' && *end != '\0')) {
+                return false;
+            }
+            out.emplace_back(static_cast<int>(w), static_cast<int>(h));
+            p = *end == ',' ? end + 1 : end;
+        }
+        return !out.empty();
+    }
+
+    bool ParseCounts(const char* text, std::vector<int>& out)
+    {
+        for (const char* p = text; *p;) {
+            char* end = nullptr;
+            const long n = std::strtol(p, &end, 10);
+            if (end == p || n < 0 || (*end != ',' && *end != '\0')) {
+                return false;
+            }
+            out.push_back(static_cast<int>(n));
+            p = *end == ',' ? end + 1 : end;
+        }
+        return !out.empty();
+    }
+
+    bool ParsePathings(const char* text, std::vector<StressPathing>& out)
+    {
+        for (const char* p = text; *p;) {
+            const char* end = std::strchr(p, ',');
+            const size_t length = end ? static_cast<size_t>(end - p) : std::strlen(p);
+            bool found = false;
+            for (size_t i = 0; i < static_cast<size_t>(StressPathing::Count); ++i) {
+                const StressPathing pathing = static_cast<StressPathing>(i);
+                const char* name = StressScenario::GetPathingName(pathing);
+                if (std::strlen(name) == length && std::strncmp(p, name, length) == 0) {
+                    out.push_back(pathing);
+                    found = true;
+                }
+            }
+            if (!found) {
+                return false;
+            }
+            p = end ? end + 1 : p + length;
+        }
+        return !out.empty();
+    }
+
+    int RunStress(IGraphics& graphics, const Options& opt)
+    {
+        std::vector<std::pair<int, int>> sizes;
+        std::vector<int> guestCounts;
+        std::vector<StressPathing> pathings;
+        if (!ParseSizes(opt.stressSizes, sizes) || !ParseCounts(opt.stressGuests, guestCounts)
+            || !ParsePathings(opt.stressPathing, pathings)) {
+            std::fprintf(stderr, "bad --stress / --stress-guests / --stress-pathing (expected e.g. 128x96,256x192 and 50,200,500 and astar,flow,jps,hpa)\n");
+            return 1;
+        }
+        FILE* csv = nullptr;
+        if (opt.stressCsvPath) {
+            csv = std::fopen(opt.stressCsvPath, "w");
+            if (!csv) {
+                std::fprintf(stderr, "failed to open stress csv: %s\n", opt.stressCsvPath);
+                return 1;
+            }
+            WriteStressCsvHeader(csv);
+        }
+
+        const uint32_t ticks = static_cast<uint32_t>(opt.ticksGiven ? opt.ticks : 3600);
+        std::printf("stress: %zu map size(s) x %zu guest count(s), %u ticks each, draw every %d tick(s), edit every %u tick(s), arrivals in groups of %u\n",
+            sizes.size(), guestCounts.size(), ticks, opt.drawEvery, opt.stressEdits, (std::max)(opt.stressBurst, 1u));
+
+        PathServiceConfig asyncConfig;
+        const bool async = opt.stressAsyncMs >= 0.0 || opt.stressAsyncWorkers > 0;
+        asyncConfig.workerCount = opt.stressAsyncWorkers;
+        asyncConfig.budgetMs = (std::max)(opt.stressAsyncMs, 0.0);
+        if (opt.stressAsyncSlots > 0) {
+            asyncConfig.deliveriesPerTick = opt.stressAsyncSlots;
+        }
+        if (opt.stressAsyncLatency > 0) {
+            asyncConfig.latencyTicks = opt.stressAsyncLatency;
+        }
+        for (const std::pair<int, int>& size : sizes) {
+            for (int guests : guestCounts) {
+                for (StressPathing pathing : pathings) {
+                    const StressReport r = RunStressScenario(graphics, size.first, size.second, guests, pathing, ticks,
+                        opt.drawEvery, 1, SCREEN_WIDTH, SCREEN_HEIGHT, opt.stressEdits, opt.stressBurst, async ? &asyncConfig : nullptr);
+                    std::printf("%dx%d, %d guests, %s: %zu rooms, peak %zu active, %llu finished, %llu path queries (%llu failed, %.0f nodes/query), %llu sightings\n",
+                        r.width, r.height, r.guests, StressScenario::GetPathingName(r.pathing), r.rooms, r.peakActive,
+                        static_cast<unsigned long long>(r.finished),
+                        static_cast<unsigned long long>(r.pathQueries), static_cast<unsigned long long>(r.pathFailures),
+                        r.pathQueries ? static_cast<double>(r.expandedNodes) / r.pathQueries : 0.0,
+                        static_cast<unsigned long long>(r.sightings));
+                    if (r.flowFields > 0) {
+                        std::printf("  flow fields: %zu built in %.1f ms (%zu KB)\n",
+                            r.flowFields, r.flowFieldBuildMs, r.flowFieldBytes / 1024);
+                    }
+                    if (r.hierarchyNodes > 0) {
+                        std::printf("  hierarchy: %zu nodes built in %.1f ms\n", r.hierarchyNodes, r.hierarchyBuildMs);
+                    }
+                    if (r.edits > 0) {
+                        const StressCost& editing = r.costs[static_cast<size_t>(StressSubsystem::Editing)];
+                        std::printf("  edits: %llu (%.3f ms each), %llu route repair(s) (%.0f nodes/repair)",
+                            static_cast<unsigned long long>(r.edits), editing.meanUs * r.ticks / r.edits / 1000.0,
+                            static_cast<unsigned long long>(r.routeRepairs),
+                            r.routeRepairs ? static_cast<double>(r.repairExpandedNodes) / r.routeRepairs : 0.0);
+                        if (r.pathing == StressPathing::FlowField) {
+                            std::printf(", %llu of them patched in place", static_cast<unsigned long long>(r.flowFieldPatches));
+                        }
+                        std::printf("\n");
+                    }
+                    if (r.async) {
+                        if (r.asyncConfig.workerCount > 0) {
+                            std::printf("  path service: %u worker(s)", r.asyncConfig.workerCount);
+                        }
+                        else {
+                            std::printf("  path service: main thread, %.2f ms/tick", r.asyncConfig.budgetMs);
+                        }
+                        std::printf(", %u tick(s) later, %u/tick, %llu solved late, max delay %u tick(s), %llu provisional step(s)\n",
+                            r.asyncConfig.latencyTicks, r.asyncConfig.deliveriesPerTick,
+                            static_cast<unsigned long long>(r.asyncForced), r.asyncMaxDelay,
+                            static_cast<unsigned long long>(r.provisionalSteps));
+                    }
+                    for (size_t i = 0; i < static_cast<size_t>(StressSubsystem::Count); ++i) {
+                        const StressCost& c = r.costs[i];
+                        std::printf("  %-9s mean %8.3f ms  p99 %8.3f ms  max %8.3f ms\n",
+                            StressScenario::GetSubsystemName(static_cast<StressSubsystem>(i)),
+                            c.meanUs / 1000.0, c.p99Us / 1000.0, c.maxUs / 1000.0);
+                    }
+                    std::printf("  %-9s mean %8.3f ms  p99 %8.3f ms  max %8.3f ms\n", "total",
+                        r.total.meanUs / 1000.0, r.total.p99Us / 1000.0, r.total.maxUs / 1000.0);
+                    if (csv) {
+                        WriteStressCsvRow(csv, r);
+                        std::fflush(csv);
+                    }
+                }
+            }
+        }
+        if (csv) {
+            std::fclose(csv);
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!ParseOptions(argc, argv, opt)) {
+        std::fprintf(stderr,
+            "usage: %s [--ticks N] [--runs N] [--script file] [--trace file] [--draw-every N] [--software] [--pace FPS] [--render-thread] [--profile file] [--counters file] [--frametime file] [--memory file] [--stress WxH,...] [--stress-guests N,...] [--stress-pathing astar|flow|jps|hpa,...] [--stress-edits N] [--stress-burst N] [--stress-async MS] [--stress-async-workers N] [--stress-async-slots N] [--stress-async-latency N] [--stress-csv file]\n",
+            argv[0]);
+        return 1;
+    }
+
+    Profiler::SetEnabled(opt.profilePath != nullptr);
+    PROFILE_THREAD_NAME("main");
+
+    // --- 各モジュールの生成 ---
+    std::unique_ptr<IGraphics> graphics;
+    NullGraphics* nullGraphics = nullptr;
+    SoftwareGraphics* softwareGraphics = nullptr;
+    if (opt.software) {
+        auto g = std::make_unique<SoftwareGraphics>();
+        softwareGraphics = g.get();
+        graphics = std::move(g);
+    }
+    else {
+        auto g = std::make_unique<NullGraphics>();
+        nullGraphics = g.get();
+        graphics = std::move(g);
+    }
+
+    ScriptedGamepad gamepad;
+    if (opt.scriptPath && !gamepad.LoadScript(opt.scriptPath)) {
+        std::fprintf(stderr, "failed to load script: %s\n", opt.scriptPath);
+        return 1;
+    }
+
+    // --render-thread のときは Game からは ThreadedGraphics を見せ、実体は描画スレッドが使う
+    std::unique_ptr<ThreadedGraphics> threaded;
+    IGraphics* gameGraphics = graphics.get();
+    if (opt.renderThread) {
+        threaded = std::make_unique<ThreadedGraphics>(*graphics);
+        gameGraphics = threaded.get();
+    }
+
+    if (!gameGraphics->Initialize(nullptr, SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        std::fprintf(stderr, "graphics initialization failed\n");
+        return 1;
+    }
+
+    if (opt.stressSizes) {
+        const int status = RunStress(*gameGraphics, opt);
+        gameGraphics->Finalize();
+        if (opt.profilePath && !Profiler::WriteChromeTrace(opt.profilePath)) {
+            std::fprintf(stderr, "failed to write profile: %s\n", opt.profilePath);
+        }
+        return status;
+    }
+
+    FILE* memoryReport = nullptr;
+    if (opt.memoryPath) {
+        memoryReport = std::fopen(opt.memoryPath, "w");
+        if (!memoryReport) {
+            std::fprintf(stderr, "failed to open memory report: %s\n", opt.memoryPath);
+            return 1;
+        }
+    }
+
+    FrameTimeMonitor frameTimes;
+    frameTimes.SetWarmupFrames(0); // 全速で回すので起動直後の読み込みは tick に入らない
+
+    FILE* countersCsv = nullptr;
+    if (opt.countersPath) {
+        countersCsv = std::fopen(opt.countersPath, "w");
+        if (!countersCsv) {
+            std::fprintf(stderr, "failed to open counters csv: %s\n", opt.countersPath);
+            return 1;
+        }
+        FrameCounters::WriteCsvHeader(countersCsv);
+    }
+
+    std::printf("headless: %s%s, %llu ticks x %d runs, draw every %d tick(s)\n",
+        opt.software ? "SoftwareGraphics" : "NullGraphics", opt.renderThread ? " on a render thread" : "",
+        static_cast<unsigned long long>(opt.ticks), opt.runs, opt.drawEvery);
+
+    for (int run = 0; run < opt.runs; ++run) {
+        if (nullGraphics) {
+            nullGraphics->ResetStats();
+            // トレースは最後の回だけ取る（長時間の計測でメモリを食わないように）
+            nullGraphics->ClearTrace();
+            nullGraphics->SetTraceEnabled(opt.tracePath && run == opt.runs - 1);
+        }
+
+        const uint64_t memoryMark = MemoryTracker::GetSerial();
+        const RunResult r = RunOnce(*gameGraphics, threaded.get(), gamepad, opt, countersCsv, frameTimes);
+        if (memoryReport) {
+            // RunOnce を抜けた時点で Game は破棄済み
+            std::fprintf(memoryReport, "run %d: ", run + 1);
+            const size_t leaks = MemoryTracker::DumpLeaks(memoryReport, memoryMark);
+            std::printf("  memory: %zu allocation(s) left after Terminate\n", leaks);
+        }
+        if (threaded) {
+            // 統計は描画スレッドが書くので、描き終わるのを待ってから読む
+            threaded->Flush();
+        }
+        const double tps = r.seconds > 0.0 ? r.ticks / r.seconds : 0.0;
+        std::printf("run %d: %llu ticks in %.3f s = %.0f ticks/s (x%.1f realtime)%s\n",
+            run + 1, static_cast<unsigned long long>(r.ticks), r.seconds, tps, tps / FRAME_RATE,
+            r.quit ? " [game quit]" : "");
+        std::printf("  tick: p50 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms\n",
+            r.tickTimes.GetPercentile(50.0) / 1000.0, r.tickTimes.GetPercentile(99.0) / 1000.0,
+            r.tickTimes.GetPercentile(99.9) / 1000.0, r.tickTimes.GetMax() / 1000.0);
+
+        if (opt.paceFps > 0.0) {
+            const FramePacingStats& p = r.pacing;
+            std::printf("  pace: %.1f fps, jitter mean %.3f ms / sd %.3f ms / max %.3f ms, %llu late (>0.2 ms), %llu resyncs\n",
+                opt.paceFps, p.jitterMeanMs, p.jitterStdDevMs, p.jitterMaxMs,
+                static_cast<unsigned long long>(p.lateFrames), static_cast<unsigned long long>(p.resyncs));
+            std::printf("  pace: spin %.1f%% of waiting, cpu %.1f%% of one core\n",
+                p.SpinRatio() * 100.0, r.seconds > 0.0 ? r.cpuSeconds / r.seconds * 100.0 : 0.0);
+        }
+        if (nullGraphics && r.draws > 0) {
+            const NullDrawStats& s = nullGraphics->GetTotalStats();
+            const double frames = static_cast<double>((std::max<uint64_t>)(s.frames, 1));
+            std::printf("  draw: %llu frames, %.1f quads/frame, %.1f texture switches/frame, %.2f sdf toggles/frame, %zu textures\n",
+                static_cast<unsigned long long>(s.frames), s.quads / frames, s.textureSwitches / frames,
+                s.sdfToggles / frames, nullGraphics->GetTextureCount());
+        }
+        if (softwareGraphics && r.draws > 0) {
+            const SoftwareRasterStats& s = softwareGraphics->GetStats();
+            std::printf("  raster (last frame): %u quads, %.1f Mpx (%.1f copied), %u culled, bin %.2f ms, raster %.2f ms\n",
+                s.quads, s.pixels / 1e6, s.copiedPixels / 1e6, s.culledRefs, s.binMicros / 1000.0, s.rasterMicros / 1000.0);
+        }
+    }
+
+    if (nullGraphics && opt.tracePath) {
+        if (!nullGraphics->SaveTrace(opt.tracePath)) {
+            std::fprintf(stderr, "failed to write trace: %s\n", opt.tracePath);
+        }
+    }
+
+    // --- 終了処理 ---
+    gameGraphics->Finalize();
+    if (countersCsv) {
+        std::fclose(countersCsv);
+    }
+    if (memoryReport) {
+        MemoryTracker::WriteReport(memoryReport);
+        std::fclose(memoryReport);
+    }
+    if (opt.frameTimePath && !frameTimes.WriteSummary(opt.frameTimePath)) {
+        std::fprintf(stderr, "failed to write frame time summary: %s\n", opt.frameTimePath);
+    }
+    if (opt.profilePath && !Profiler::WriteChromeTrace(opt.profilePath)) {
+        std::fprintf(stderr, "failed to write profile: %s\n", opt.profilePath);
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+﻿/*****************************************************************//**
+ * @file   D3D11TextureBackend.cpp
+ * @brief  AsyncTextureLoader 用の D3D11 バックエンド実装
+ *********************************************************************/
+#include "D3D11TextureBackend.h"
+#include "texture.h"
+#include "../../DirectXTex/DirectXTex.h"
+#include <objbase.h>
+#include <memory>
+
+using namespace DirectX;
+
+void* D3D11TextureBackend::Decode(const std::string& path)
+{
+    const int size = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (size <= 0) {
+        return nullptr;
+    }
+    std::wstring widePath(size - 1, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], size);
+
+    // WIC はスレッドごとに COM の初期化が要る
+    const HRESULT co = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    auto image = std::make_unique<ScratchImage>();
+    const bool ok = DecodeTexture(widePath.c_str(), *image);
+
+    if (SUCCEEDED(co)) {
+        CoUninitialize();
+    }
+    return ok ? image.release() : nullptr;
+}
+
+TextureHandle D3D11TextureBackend::Create(void* decoded)
+{
+    return CreateTexture(*static_cast<ScratchImage*>(decoded));
+}
+
+void D3D11TextureBackend::ReleaseDecoded(void* decoded)
+{
+    delete static_cast<ScratchImage*>(decoded);
+}
+
+void D3D11TextureBackend::Destroy(TextureHandle texture)
+{
+    UnloadTexture(static_cast<ID3D11ShaderResourceView*>(texture));
+}
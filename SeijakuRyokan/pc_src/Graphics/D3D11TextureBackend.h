@@ -0,0 +1,19 @@
+﻿/*****************************************************************//**
+ * @file   D3D11TextureBackend.h
+ * @brief  AsyncTextureLoader 用の D3D11 バックエンド
+ *
+ * @details
+ * - Decode   : DDS / WIC デコードと RGBA8 変換（ワーカースレッド）
+ * - Create   : CreateShaderResourceView（描画スレッド）
+ *********************************************************************/
+#pragma once
+#include "../../common_src/Graphics/AsyncTextureLoader.h"
+
+class D3D11TextureBackend : public ITextureBackend
+{
+public:
+    void* Decode(const std::string& path) override;
+    TextureHandle Create(void* decoded) override;
+    void ReleaseDecoded(void* decoded) override;
+    void Destroy(TextureHandle texture) override;
+};
@@ -3,10 +3,14 @@
 #include "texture.h"
 #include "../System/DirectX.h"
 #include "../../common_src/VectorTypes.h"
+#include "../../common_src/System/FrameArena.h"
+#include "../../common_src/System/MemoryTracker.h"
 #include "../../common_src/System/PathFinder.h"
+#include "../../common_src/System/Profiler.h"
 #include <d3d11.h>
 #include <DirectXMath.h>
 #include <wrl/client.h>
+#include <algorithm>
 #include <vector>
 #include <cmath>
 #include <d3dcompiler.h>
@@ -15,22 +19,33 @@
 
 
 // char*wchar_t*ւ̕ϊ[eBeBiWindows APIgpj
-static std::wstring to_wstring(const char* str) {
-    if (!str || *str == '\0') return L"";
+// ʂ͌Ă񂾃Xbh FrameArena ɒui BeginDraw ܂ŗLj
+static FrameWString to_wstring(const char* str) {
+    if (!str || *str == '\0') return FrameWString();
 
     // Kvȃobt@TCY擾
     int size = MultiByteToWideChar(CP_UTF8, 0, str, -1, nullptr, 0);
-    if (size <= 0) return L"";
+    if (size <= 0) return FrameWString();
 
     // ϊ
-    std::wstring result(size - 1, L'\0'); // -1 for null terminator
+    FrameWString result(size - 1, L'\0'); // -1 for null terminator
     MultiByteToWideChar(CP_UTF8, 0, str, -1, &result[0], size);
 
     return result;
 }
 
+// UV ` [0,1] Ɏ܂Ă邩i]w̕ uvSize lj
+static bool IsUnitUv(const MyGame::Float2& uvPos, const MyGame::Float2& uvSize)
+{
+    const float u0 = uvPos.x, u1 = uvPos.x + uvSize.x;
+    const float v0 = uvPos.y, v1 = uvPos.y + uvSize.y;
+    return (std::min)(u0, u1) >= 0.0f && (std::max)(u0, u1) <= 1.0f
+        && (std::min)(v0, v1) >= 0.0f && (std::max)(v0, v1) <= 1.0f;
+}
+
 bool DirectXGraphics::Initialize(void* windowHandle, int screenWidth, int screenHeight)
 {
+    MemoryTagScope memoryTag(MemoryTag::Graphics);
     // DirectXfoCX̂̏`FbN
     if (!InitDirectX(static_cast<HWND>(windowHandle))) {
         OutputDebugStringA("[ERROR] InitDirectX() failed.\n");
@@ -40,8 +55,18 @@ bool DirectXGraphics::Initialize(void* windowHandle, int screenWidth, int screen
     // SpriteiŎs\͒ႢÔ߁j
     InitSprite(GetDevice(), GetContext());
 
+    // 񓯊eNX`ǂݍ݂̃[J[
+    m_asyncLoader = std::make_unique<AsyncTextureLoader>(m_textureBackend);
+
+    // eNX`AgX̃}jtFXgiΏ]ǂʃeNX`œǂށj
+    if (m_atlasManifest.Load("rom/images/atlas/atlas.json")) {
+        m_atlasPages.assign(m_atlasManifest.GetPages().size(), nullptr);
+        OutputDebugStringA("[INFO] Texture atlas manifest loaded.\n");
+    }
+
     // ftHgeNX`̓ǂݍ݂`FbN
-    m_defaultTexture = LoadTexture("rom/images/white.png");
+    // wEǂݍݒ̃eNX`̑ SRV ̂܂ SpriteDrawer ɓn̂ŁAAgXʂP̂œǂ
+    m_defaultTexture = ::LoadTexture(L"rom/images/white.png");
     if (!m_defaultTexture) {
         OutputDebugStringA("[ERROR] Failed to load default texture 'rom/images/white.png'. Make sure the file exists.\n");
         return false;
@@ -206,6 +231,11 @@ void DirectXGraphics::Finalize()
         UnloadTexture(m_defaultTexture);
         m_defaultTexture = nullptr;
     }
+    UnloadAtlas();
+
+    // ǂݍݒ̂̂܂߁A񓯊eNX`ji[J[~܂j
+    m_asyncTextures.clear();
+    m_asyncLoader.reset();
 
     UninitSprite();
     CleanupDirectX();
@@ -213,22 +243,171 @@ void DirectXGraphics::Finalize()
 
 void DirectXGraphics::BeginDraw()
 {
+    FrameArena::ForThisThread().Reset();
     ::BeginDraw(0.1f, 0.1f, 0.1f, 1.0f);
+    m_commands.Reset();
+
+    // fR[h̍ς񂾔񓯊eNX` GPU ɍ쐬
+    if (m_asyncLoader) {
+        m_asyncLoader->FinalizePending(ASYNC_FINALIZE_PER_FRAME);
+    }
 }
 
 void DirectXGraphics::EndDraw()
 {
+    PROFILE_ZONE("DirectXGraphics::EndDraw");
+    // L^R}h\[gL[ɕבւAob`ɂ܂Ƃ߂ĕ`悵Ă Present
+    m_commands.Sort();
+
+    m_spriteDrawer.Begin();
+    const size_t count = m_commands.Size();
+    for (size_t i = 0; i < count; ++i) {
+        const DrawCommand& cmd = m_commands.GetSorted(i);
+        const Quad& quad = cmd.quad;
+
+        // SWEXP[Quad̂܂
+        m_spriteDrawer.SetSdfMode(cmd.sdf);
+        m_spriteDrawer.Draw(
+            static_cast<ID3D11ShaderResourceView*>(quad.texture),
+            MyGame::Float2(quad.position.x, quad.position.y),
+            MyGame::Float2(quad.size.x, quad.size.y),
+            quad.color,
+            quad.angleDeg,
+            quad.uvPos,
+            quad.uvSize
+        );
+    }
+    m_spriteDrawer.End();
+
     ::EndDraw();
 }
 
 TextureHandle DirectXGraphics::LoadTexture(const char* filePath)
 {
-    std::wstring widePath = to_wstring(filePath);
+    PROFILE_ZONE("LoadTexture");
+    MemoryTagScope memoryTag(MemoryTag::Texture);
+    // AgXɊ܂܂摜̓AgẌ̗wnhԂ
+    if (const AtlasSprite* sprite = m_atlasManifest.Find(filePath)) {
+        if (TextureHandle handle = LoadAtlasTexture(*sprite, false)) {
+            return handle;
+        }
+    }
+
+    const FrameWString widePath = to_wstring(filePath);
     return ::LoadTexture(widePath.c_str());
 }
 
+TextureHandle DirectXGraphics::LoadTextureAsync(const char* filePath)
+{
+    if (!m_asyncLoader) {
+        return LoadTexture(filePath);
+    }
+
+    // AgX̃y[W񓯊œǂށiXvCg̃nh͂Ԃj
+    if (const AtlasSprite* sprite = m_atlasManifest.Find(filePath)) {
+        if (TextureHandle handle = LoadAtlasTexture(*sprite, true)) {
+            return handle;
+        }
+    }
+
+    TextureHandle handle = m_asyncLoader->Request(filePath);
+    m_asyncTextures.insert(handle);
+    return handle;
+}
+
+TextureLoadState DirectXGraphics::GetTextureState(TextureHandle handle) const
+{
+    auto atlas = m_atlasLookup.find(handle);
+    if (atlas != m_atlasLookup.end()) {
+        handle = atlas->second->page;
+    }
+    if (m_asyncTextures.count(handle)) {
+        return static_cast<const AsyncTexture*>(handle)->state.load(std::memory_order_acquire);
+    }
+    return handle ? TextureLoadState::Ready : TextureLoadState::Failed;
+}
+
+void DirectXGraphics::WaitForTextures()
+{
+    if (m_asyncLoader) {
+        m_asyncLoader->WaitAll();
+    }
+}
+
+TextureHandle DirectXGraphics::LoadAtlasTexture(const AtlasSprite& sprite, bool async)
+{
+    auto found = m_atlasTextures.find(sprite.key);
+    if (found != m_atlasTextures.end()) {
+        return found->second.get();
+    }
+
+    TextureHandle& page = m_atlasPages[sprite.page];
+    if (!page && async) {
+        page = m_asyncLoader->Request(m_atlasManifest.GetPages()[sprite.page].file.c_str());
+        m_asyncTextures.insert(page);
+    }
+    if (!page) {
+        const FrameWString widePath = to_wstring(m_atlasManifest.GetPages()[sprite.page].file.c_str());
+        page = ::LoadTexture(widePath.c_str());
+        if (!page) {
+            OutputDebugStringA("[WARN] Failed to load atlas page. Falling back to individual texture.\n");
+            return nullptr;
+        }
+    }
+
+    auto tex = std::make_unique<AtlasTexture>();
+    tex->page = page;
+    tex->uvPos = sprite.uvPos;
+    tex->uvSize = sprite.uvSize;
+    tex->source = sprite.source;
+
+    TextureHandle handle = tex.get();
+    m_atlasLookup[handle] = tex.get();
+    m_atlasTextures[sprite.key] = std::move(tex);
+    return handle;
+}
+
+TextureHandle DirectXGraphics::GetStandaloneTexture(AtlasTexture& tex)
+{
+    // 񂾂ǂށisȍ~̓AgX̂܂ܕ`j
+    if (!tex.standaloneTried) {
+        tex.standaloneTried = true;
+        OutputDebugStringA("[WARN] Atlas sprite drawn with UV outside [0,1]. Loading its source image standalone.\n");
+        MemoryTagScope memoryTag(MemoryTag::Texture);
+        const FrameWString widePath = to_wstring(tex.source.c_str());
+        tex.standalone = ::LoadTexture(widePath.c_str());
+    }
+    return tex.standalone;
+}
+
+void DirectXGraphics::UnloadAtlas()
+{
+    for (auto& entry : m_atlasTextures) {
+        if (entry.second->standalone) {
+            ::UnloadTexture(static_cast<ID3D11ShaderResourceView*>(entry.second->standalone));
+        }
+    }
+    m_atlasLookup.clear();
+    m_atlasTextures.clear();
+    for (TextureHandle& page : m_atlasPages) {
+        if (page) {
+            UnloadTexture(page);
+            page = nullptr;
+        }
+    }
+}
+
 void DirectXGraphics::UnloadTexture(TextureHandle handle)
 {
+    // AgẌ̗̓y[W Finalize ŉ
+    if (m_atlasLookup.count(handle)) {
+        return;
+    }
+    // 񓯊eNX`͓ǂݍݒłLZł
+    if (m_asyncTextures.erase(handle)) {
+        m_asyncLoader->Release(static_cast<AsyncTexture*>(handle));
+        return;
+    }
     if (handle) {
         ::UnloadTexture(static_cast<ID3D11ShaderResourceView*>(handle));
     }
@@ -236,17 +415,37 @@ void DirectXGraphics::UnloadTexture(TextureHandle handle)
 
 void DirectXGraphics::DrawQuad(const Quad& quad)
 {
-    TextureHandle th = quad.texture ? quad.texture : m_defaultTexture;
-    ID3D11ShaderResourceView* srv = static_cast<ID3D11ShaderResourceView*>(th);
-
-    // SWEXP[Quad̂܂
-    m_spriteDrawer.Draw(
-        srv,
-        MyGame::Float2(quad.position.x, quad.position.y),
-        MyGame::Float2(quad.size.x, quad.size.y),
-        quad.color,
-        quad.angleDeg,
-        quad.uvPos,
-        quad.uvSize
-    );
+    // eNX`w͔eNX`iAgXO SRVjɉĂL^i\[gL[ɂfj
+    Quad resolved = quad;
+    if (!resolved.texture) {
+        resolved.texture = m_defaultTexture;
+    }
+
+    // AgX̉摜̓y[W SRV ƁAy[WɎʑ UV ɒuB
+    // UV  [0,1] ͂ݏo`ׂ͗̉摜EĂ܂̂ŁA摜P̂œǂ񂾃eNX`ŕ`
+    auto atlas = m_atlasLookup.find(resolved.texture);
+    if (atlas != m_atlasLookup.end() && !IsUnitUv(quad.uvPos, quad.uvSize)) {
+        if (TextureHandle standalone = GetStandaloneTexture(*atlas->second)) {
+            resolved.texture = standalone;
+            atlas = m_atlasLookup.end();
+        }
+    }
+    if (atlas != m_atlasLookup.end()) {
+        const AtlasTexture& tex = *atlas->second;
+        resolved.texture = tex.page;
+        resolved.uvPos = MyGame::Float2(
+            tex.uvPos.x + quad.uvPos.x * tex.uvSize.x,
+            tex.uvPos.y + quad.uvPos.y * tex.uvSize.y);
+        resolved.uvSize = MyGame::Float2(
+            quad.uvSize.x * tex.uvSize.x,
+            quad.uvSize.y * tex.uvSize.y);
+    }
+
+    // 񓯊eNX`͓ǂݍ݊܂ŃftHgeNX`őp
+    if (m_asyncTextures.count(resolved.texture)) {
+        const AsyncTexture* async = static_cast<const AsyncTexture*>(resolved.texture);
+        const bool ready = async->state.load(std::memory_order_acquire) == TextureLoadState::Ready;
+        resolved.texture = ready ? async->texture : m_defaultTexture;
+    }
+    m_commands.Record(resolved, m_sdfMode);
 }
\ No newline at end of file
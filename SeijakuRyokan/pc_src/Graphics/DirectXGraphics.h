@@ -3,9 +3,20 @@
 #include "../../common_src/VectorTypes.h" // Vec2f, Float4 などの型を利用するため
 #include <d3d11.h>
 #include <wrl/client.h> // ComPtr を使うため追加
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "SpriteDrawer.h"
+#include "D3D11TextureBackend.h"
+#include "../../common_src/Graphics/DrawCommandBuffer.h"
+#include "../../common_src/Graphics/TextureAtlas.h"
+#include "../../common_src/Graphics/AsyncTextureLoader.h"
+#include "../../common_src/Graphics/GraphicsExtensions.h"
+#include "../../common_src/System/FrameCounters.h"
 
-class DirectXGraphics : public IGraphics
+class DirectXGraphics : public IGraphics, public IGraphicsExtensions
 {
 public:
     DirectXGraphics() = default;
@@ -19,12 +30,55 @@ public:
     TextureHandle LoadTexture(const char* filePath) override;
     void UnloadTexture(TextureHandle handle) override;
     void DrawQuad(const Quad& quad) override;
-    void SetSdfMode(bool enable) override { m_spriteDrawer.SetSdfMode(enable); }
+    void SetSdfMode(bool enable) override
+    {
+        if (enable != m_sdfMode) {
+            FrameCounters::Add(FrameCounter::SdfToggles);
+        }
+        m_sdfMode = enable;
+    }
+
+    // IGraphicsExtensionsの実装
+    void SetDrawLayer(uint8_t layer) override { m_commands.SetLayer(layer); }
+    void SetLayerSortMode(uint8_t layer, LayerSortMode mode) override { m_commands.SetLayerSortMode(layer, mode); }
+    TextureHandle LoadTextureAsync(const char* filePath) override;
+    TextureLoadState GetTextureState(TextureHandle handle) const override; // LoadTexture で読んだものは常に Ready
+    void WaitForTextures() override;
 
 private:
+    // アトラス上のスプライト（LoadTexture が返すハンドルの実体）
+    struct AtlasTexture
+    {
+        TextureHandle page = nullptr; // アトラスページ（SRV、または非同期読み込みのハンドル）
+        MyGame::Float2 uvPos;
+        MyGame::Float2 uvSize;
+        std::string source;                 // 元画像のパス
+        TextureHandle standalone = nullptr; // UV が [0,1] をはみ出す描画用に元画像を単体で読んだ SRV
+        bool standaloneTried = false;
+    };
+
+    TextureHandle LoadAtlasTexture(const AtlasSprite& sprite, bool async);
+    // 元画像を単体で読んだ SRV（初回に読む。読めなければ nullptr）
+    TextureHandle GetStandaloneTexture(AtlasTexture& tex);
+    void UnloadAtlas();
+
     SpriteDrawer m_spriteDrawer;
+    DrawCommandBuffer m_commands; // DrawQuad はここに記録し、EndDraw でソートして描画
+    bool m_sdfMode = false;
     TextureHandle m_defaultTexture = nullptr;
 
+    // テクスチャアトラス（rom/images/atlas/atlas.json があれば使う）
+    AtlasManifest m_atlasManifest;
+    std::vector<TextureHandle> m_atlasPages; // 初回参照時に読み込む
+    std::unordered_map<std::string, std::unique_ptr<AtlasTexture>> m_atlasTextures; // 検索キー → 実体
+    std::unordered_map<TextureHandle, AtlasTexture*> m_atlasLookup;                 // ハンドル → 実体
+
+    // 非同期読み込み（ハンドルは AsyncTexture*。GPU 作成は BeginDraw で行う）
+    static constexpr size_t ASYNC_FINALIZE_PER_FRAME = 4; // 1フレームの作成数上限（スパイク防止）
+    D3D11TextureBackend m_textureBackend;
+    std::unique_ptr<AsyncTextureLoader> m_asyncLoader;
+    std::unordered_set<TextureHandle> m_asyncTextures;
+
     // 頂点構造体
     struct ArcVertex
     {
@@ -3,31 +3,23 @@
  * @brief  PCSprite`
  *********************************************************************/
 #include "SpriteDrawer.h"
+#include "../../common_src/System/FrameCounters.h"
+#include "../../common_src/System/Profiler.h"
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 #include <d3d11.h>
 #include <wrl/client.h>
+#include <vector>
 #pragma comment(lib, "d3dcompiler.lib")
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
 
-struct SpriteVertex
+// _ SpriteBatch ŉ]EUVϊ܂ōς܂XN[W
+struct ScreenParam
 {
-    XMFLOAT3 pos;
-    XMFLOAT2 uv;
-};
-
-struct SpriteParam
-{
-    XMFLOAT2 pos;
-    XMFLOAT2 scale;
-    XMFLOAT2 uvPos;
-    XMFLOAT2 uvScale;
-    XMFLOAT4 color;
     XMFLOAT2 screen;
-    float    rad;
-    float    dummy;
+    float    dummy[2];
 };
 
 SpriteDrawer::SpriteDrawer() {}
@@ -42,27 +34,21 @@ bool SpriteDrawer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
 
     // ===== VS =====
     const char* VS = R"EOT(
-    struct VS_IN { float3 pos:POSITION0; float2 uv:TEXCOORD0; };
+    struct VS_IN { float2 pos:POSITION0; float2 uv:TEXCOORD0; float4 color:COLOR0; };
     struct VS_OUT{ float4 pos:SV_POSITION; float2 uv:TEXCOORD0; float4 color:COLOR0; };
 
-    cbuffer SpriteParamCB : register(b0) {
-        float2 gPos; float2 gScale;
-        float2 gUvPos; float2 gUvScale;
-        float4 gColor; float2 gScreen;
-        float  gRad; float  _pad;
+    cbuffer ScreenCB : register(b0) {
+        float2 gScreen; float2 _pad;
     };
 
     VS_OUT main(VS_IN i)
     {
         VS_OUT o;
-        float2 p = i.pos.xy * gScale;
-        float cs = cos(gRad), sn = sin(gRad);
-        p = float2(p.x * cs - p.y * sn, p.x * sn + p.y * cs) + gPos;
-        float ndcX = (p.x / gScreen.x) * 2.0f - 1.0f;
-        float ndcY = 1.0f - (p.y / gScreen.y) * 2.0f;
+        float ndcX = (i.pos.x / gScreen.x) * 2.0f - 1.0f;
+        float ndcY = 1.0f - (i.pos.y / gScreen.y) * 2.0f;
         o.pos = float4(ndcX, ndcY, 0.0f, 1.0f);
-        o.uv  = i.uv * gUvScale + gUvPos;
-        o.color = gColor;
+        o.uv  = i.uv;
+        o.color = i.color;
         return o;
     })EOT";
 
@@ -90,8 +76,22 @@ bool SpriteDrawer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
         return float4(i.color.rgb, i.color.a * a);
     })EOT";
 
+    // ===== PS (SDF, 1`l) =====
+    // R8 / BC4 ɏĂAgXpB .r ɓĂ
+    const char* PS_SDF_R = R"EOT(
+    struct PS_IN { float4 pos:SV_POSITION; float2 uv:TEXCOORD0; float4 color:COLOR0; };
+    Texture2D<float> tex0 : register(t0);
+    SamplerState samp0 : register(s0);
+    float4 main(PS_IN i) : SV_TARGET
+    {
+        float sd = tex0.Sample(samp0, i.uv);
+        float w  = fwidth(sd);
+        float a  = smoothstep(0.5 - w, 0.5 + w, sd);
+        return float4(i.color.rgb, i.color.a * a);
+    })EOT";
+
     // --- RpC ---
-    ComPtr<ID3DBlob> vsb, psb, psbSdf, err;
+    ComPtr<ID3DBlob> vsb, psb, psbSdf, psbSdfR, err;
     UINT flags = 0;
 #ifdef _DEBUG
     flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
@@ -110,39 +110,60 @@ bool SpriteDrawer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
         if (err) OutputDebugStringA((const char*)err->GetBufferPointer());
         return false;
     }
+    err.Reset();
+    if (FAILED(D3DCompile(PS_SDF_R, strlen(PS_SDF_R), nullptr, nullptr, nullptr, "main", "ps_5_0", flags, 0, psbSdfR.GetAddressOf(), err.GetAddressOf()))) {
+        if (err) OutputDebugStringA((const char*)err->GetBufferPointer());
+        return false;
+    }
 
     // --- VF[_ ---
     if (FAILED(m_device->CreateVertexShader(vsb->GetBufferPointer(), vsb->GetBufferSize(), nullptr, &m_vs))) return false;
     if (FAILED(m_device->CreatePixelShader(psb->GetBufferPointer(), psb->GetBufferSize(), nullptr, &m_ps))) return false;
     if (FAILED(m_device->CreatePixelShader(psbSdf->GetBufferPointer(), psbSdf->GetBufferSize(), nullptr, &m_psSdf))) return false;
+    if (FAILED(m_device->CreatePixelShader(psbSdfR->GetBufferPointer(), psbSdfR->GetBufferSize(), nullptr, &m_psSdfR))) return false;
 
-    // --- ̓CAEg ---
+    // --- ̓CAEgiF float4 ̂܂ܓnB̒萔obt@ gColor Ɠۂ߂NvȂj ---
     D3D11_INPUT_ELEMENT_DESC layout[] = {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT,       0,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,       0,  8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "COLOR",    0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
     };
     if (FAILED(m_device->CreateInputLayout(layout, _countof(layout), vsb->GetBufferPointer(), vsb->GetBufferSize(), &m_inputLayout))) return false;
 
-    // --- 萔obt@ ---
+    // --- 萔obt@iXN[TCŶ݁B1񂾂XVj ---
     D3D11_BUFFER_DESC cbd = {};
-    cbd.ByteWidth = sizeof(SpriteParam); // 16{
+    cbd.ByteWidth = sizeof(ScreenParam); // 16{
     cbd.Usage = D3D11_USAGE_DEFAULT;
     cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
     if (FAILED(m_device->CreateBuffer(&cbd, nullptr, &m_constBuffer))) return false;
 
-    // --- _obt@iTRIANGLESTRIP 4_j ---
-    SpriteVertex verts[4] = {
-        { XMFLOAT3(-0.5f,  0.5f, 0), XMFLOAT2(0,1) },
-        { XMFLOAT3(-0.5f, -0.5f, 0), XMFLOAT2(0,0) },
-        { XMFLOAT3(0.5f,  0.5f, 0), XMFLOAT2(1,1) },
-        { XMFLOAT3(0.5f, -0.5f, 0), XMFLOAT2(1,0) },
-    };
+    ScreenParam sp = {};
+    sp.screen = XMFLOAT2(m_screen.x, m_screen.y);
+    m_context->UpdateSubresource(m_constBuffer, 0, nullptr, &sp, 0, 0);
+
+    // --- _obt@iIBob`őQuad ~ 4_j ---
+    const UINT maxQuads = m_batch.GetMaxQuads();
     D3D11_BUFFER_DESC vbd = {};
-    vbd.ByteWidth = sizeof(verts);
-    vbd.Usage = D3D11_USAGE_IMMUTABLE;
+    vbd.ByteWidth = sizeof(SpriteBatchVertex) * SpriteBatch::VERTICES_PER_QUAD * maxQuads;
+    vbd.Usage = D3D11_USAGE_DYNAMIC;
     vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    D3D11_SUBRESOURCE_DATA srd = { verts };
-    if (FAILED(m_device->CreateBuffer(&vbd, &srd, &m_vtxBuffer))) return false;
+    vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(m_device->CreateBuffer(&vbd, nullptr, &m_vtxBuffer))) return false;
+
+    // --- CfbNXobt@iTRIANGLESTRIP 4_ TRIANGLELIST 6CfbNXɓWJj ---
+    std::vector<uint16_t> indices(SpriteBatch::INDICES_PER_QUAD * maxQuads);
+    for (UINT q = 0; q < maxQuads; ++q) {
+        const uint16_t base = static_cast<uint16_t>(q * SpriteBatch::VERTICES_PER_QUAD);
+        uint16_t* idx = &indices[q * SpriteBatch::INDICES_PER_QUAD];
+        idx[0] = base + 0; idx[1] = base + 1; idx[2] = base + 2;
+        idx[3] = base + 2; idx[4] = base + 1; idx[5] = base + 3;
+    }
+    D3D11_BUFFER_DESC ibd = {};
+    ibd.ByteWidth = static_cast<UINT>(sizeof(uint16_t) * indices.size());
+    ibd.Usage = D3D11_USAGE_IMMUTABLE;
+    ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    D3D11_SUBRESOURCE_DATA isrd = { indices.data() };
+    if (FAILED(m_device->CreateBuffer(&ibd, &isrd, &m_idxBuffer))) return false;
 
     // --- X^CU ---
     D3D11_RASTERIZER_DESC rs = {};
@@ -153,10 +174,10 @@ bool SpriteDrawer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
 
     // --- Tv ---
     D3D11_SAMPLER_DESC smp = {};
-    smp.Filter = D3D11_FILTER_MIN_MAG_LINEAR_MIP_POINT;
+    smp.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
     smp.AddressU = smp.AddressV = smp.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
     smp.MinLOD = 0.0f;
-    smp.MaxLOD = 0.0f; // ~bvsv
+    smp.MaxLOD = D3D11_FLOAT32_MAX; // Ă DDS ̃~bvgiAgX̃y[W̓~bvŏĂ̂ŗׂ̉摜͍Ȃj
     if (FAILED(m_device->CreateSamplerState(&smp, &m_sampler))) return false;
 
     // --- uhiStraight Alpha Oj ---
@@ -172,6 +193,7 @@ bool SpriteDrawer::Initialize(ID3D11Device* device, ID3D11DeviceContext* context
     if (FAILED(m_device->CreateBlendState(&b, &m_blendState))) return false;
 
     m_useSdf = false;
+    m_batch.SetSink(this);
     return true;
 }
 
@@ -181,6 +203,8 @@ void SpriteDrawer::Finalize()
     if (m_rasterizer) { m_rasterizer->Release();   m_rasterizer = nullptr; }
     if (m_constBuffer) { m_constBuffer->Release();  m_constBuffer = nullptr; }
     if (m_vtxBuffer) { m_vtxBuffer->Release();    m_vtxBuffer = nullptr; }
+    if (m_idxBuffer) { m_idxBuffer->Release();    m_idxBuffer = nullptr; }
+    if (m_psSdfR) { m_psSdfR->Release();       m_psSdfR = nullptr; }
     if (m_psSdf) { m_psSdf->Release();        m_psSdf = nullptr; } //  ǉ
     if (m_ps) { m_ps->Release();           m_ps = nullptr; }
     if (m_vs) { m_vs->Release();           m_vs = nullptr; }
@@ -188,40 +212,119 @@ void SpriteDrawer::Finalize()
     if (m_blendState) { m_blendState->Release();   m_blendState = nullptr; }
 }
 
+void SpriteDrawer::Begin()
+{
+    m_batch.Begin();
+}
+
+void SpriteDrawer::End()
+{
+    m_batch.End();
+}
+
 void SpriteDrawer::Draw(ID3D11ShaderResourceView* texture,
     const MyGame::Float2& pos, const MyGame::Float2& scale,
     const MyGame::Float4& color, float angleDeg,
     const MyGame::Float2& uvPos, const MyGame::Float2& uvScale)
 {
-    //   OM ɃuhZbg 
+    PROFILE_ZONE("SpriteDrawer::Draw");
+    // Begin`End ̊OĂ΂ꂽꍇiDrawSpriteQuad Ȃǁj͏]ǂ葦`
+    if (!m_batch.IsActive()) {
+        m_batch.Begin();
+        m_batch.Add(texture, m_useSdf, pos, scale, color, angleDeg, uvPos, uvScale);
+        m_batch.End();
+        return;
+    }
+
+    m_batch.Add(texture, m_useSdf, pos, scale, color, angleDeg, uvPos, uvScale);
+}
+
+void SpriteDrawer::OnFlush(const SpriteBatchVertex* vertices, uint32_t quadCount,
+    const SpriteBatchRun* runs, uint32_t runCount)
+{
+    PROFILE_ZONE("SpriteDrawer::Flush");
+    // _܂Ƃ߂ē]i1tbVɂ Map 1j
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(m_context->Map(m_vtxBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        OutputDebugStringA("[SpriteDrawer] Failed to map vertex buffer.\n");
+        return;
+    }
+    const size_t vertexBytes = sizeof(SpriteBatchVertex) * SpriteBatch::VERTICES_PER_QUAD * quadCount;
+    memcpy(mapped.pData, vertices, vertexBytes);
+    m_context->Unmap(m_vtxBuffer, 0);
+    FrameCounters::Add(FrameCounter::Flushes);
+    FrameCounters::Add(FrameCounter::Quads, quadCount);
+    FrameCounters::Add(FrameCounter::DrawCalls, runCount);
+    FrameCounters::Add(FrameCounter::BytesUploaded, vertexBytes);
+
+    // ʃXe[g̓tbVƂ1񂾂ݒ
     float blendFactor[4] = { 0,0,0,0 };
     UINT  mask = 0xffffffff;
     m_context->OMSetBlendState(m_blendState, blendFactor, mask); //  ꂪƓ߂Ȃ
 
-    SpriteParam p = {};
-    p.pos = XMFLOAT2(pos.x, pos.y);
-    p.scale = XMFLOAT2(scale.x, scale.y);
-    p.uvPos = XMFLOAT2(uvPos.x, uvPos.y);
-    p.uvScale = XMFLOAT2(uvScale.x, uvScale.y);
-    p.color = XMFLOAT4(color.x, color.y, color.z, color.w);
-    p.screen = XMFLOAT2(m_screen.x, m_screen.y);
-    p.rad = XMConvertToRadians(angleDeg);
-
     m_context->IASetInputLayout(m_inputLayout);
-    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-    UINT stride = sizeof(SpriteVertex), offset = 0;
+    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    UINT stride = sizeof(SpriteBatchVertex), offset = 0;
     m_context->IASetVertexBuffers(0, 1, &m_vtxBuffer, &stride, &offset);
+    m_context->IASetIndexBuffer(m_idxBuffer, DXGI_FORMAT_R16_UINT, 0);
 
     m_context->VSSetShader(m_vs, nullptr, 0);
-    m_context->PSSetShader(m_useSdf ? m_psSdf : m_ps, nullptr, 0);
     m_context->VSSetConstantBuffers(0, 1, &m_constBuffer);
     m_context->PSSetSamplers(0, 1, &m_sampler);
-    m_context->PSSetShaderResources(0, 1, &texture);
     m_context->RSSetState(m_rasterizer);
 
-    m_context->UpdateSubresource(m_constBuffer, 0, nullptr, &p, 0, 0);
-    m_context->Draw(4, 0);
+    // Run Ƃɕς̂̓eNX`ƃsNZVF[_
+    // iς SRV ̃AhXėpEȂ悤AtH[}bg̃LbV̓tbVPʁj
+    m_formatCacheSrv = nullptr;
+    m_formatCacheSingle = false;
+    ID3D11PixelShader* boundPs = nullptr;
+    ID3D11ShaderResourceView* boundSrv = nullptr;
+    for (uint32_t r = 0; r < runCount; ++r) {
+        const SpriteBatchRun& run = runs[r];
+
+        ID3D11ShaderResourceView* srv = static_cast<ID3D11ShaderResourceView*>(run.texture);
+        ID3D11PixelShader* ps = m_ps;
+        if (run.sdf) {
+            ps = IsSingleChannel(srv) ? m_psSdfR : m_psSdf;
+        }
+        if (ps != boundPs || r == 0) {
+            if (r != 0) {
+                FrameCounters::Add(FrameCounter::ShaderSwitches);
+            }
+            m_context->PSSetShader(ps, nullptr, 0);
+            boundPs = ps;
+        }
+        if (srv != boundSrv || r == 0) {
+            if (r != 0) {
+                FrameCounters::Add(FrameCounter::TextureSwitches);
+            }
+            m_context->PSSetShaderResources(0, 1, &srv);
+            boundSrv = srv;
+        }
+
+        m_context->DrawIndexed(run.quadCount * SpriteBatch::INDICES_PER_QUAD,
+            run.firstQuad * SpriteBatch::INDICES_PER_QUAD, 0);
+    }
 
     // KvȂԂ߂
     // m_context->OMSetBlendState(nullptr, nullptr, 0xffffffff);
 }
+
+bool SpriteDrawer::IsSingleChannel(ID3D11ShaderResourceView* srv)
+{
+    // SDF ̃eNX`͂قږ񓯂Ȃ̂ŁAǑʂg񂷁iGetDesc  Run ƂɌĂ΂Ȃj
+    if (srv == m_formatCacheSrv) {
+        return m_formatCacheSingle;
+    }
+    m_formatCacheSrv = srv;
+    m_formatCacheSingle = false;
+    if (srv) {
+        D3D11_SHADER_RESOURCE_VIEW_DESC desc = {};
+        srv->GetDesc(&desc);
+        m_formatCacheSingle =
+            desc.Format == DXGI_FORMAT_R8_UNORM ||
+            desc.Format == DXGI_FORMAT_BC4_UNORM ||
+            desc.Format == DXGI_FORMAT_BC4_TYPELESS;
+    }
+    return m_formatCacheSingle;
+}
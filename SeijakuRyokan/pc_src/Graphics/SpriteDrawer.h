@@ -8,8 +8,9 @@
 #pragma once
 #include <d3d11.h>
 #include "../../common_src/VectorTypes.h"
+#include "../../common_src/Graphics/SpriteBatch.h"
 
-class SpriteDrawer
+class SpriteDrawer : private ISpriteBatchSink
 {
 public:
     SpriteDrawer();
@@ -18,6 +19,10 @@ public:
     bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, UINT screenWidth, UINT screenHeight, bool isYup = false);
     void Finalize();
 
+    // Begin`End ̊Ԃ Draw ̓ob`ɐς܂AEndi܂͗eʒ߁jł܂Ƃ߂ĕ`悳
+    void Begin();
+    void End();
+
     void Draw(ID3D11ShaderResourceView* texture,
         const MyGame::Float2& pos,
         const MyGame::Float2& scale,
@@ -28,6 +33,14 @@ public:
 
 public:
     void SetSdfMode(bool enable) { m_useSdf = enable; }
+    const SpriteBatchStats& GetBatchStats() const { return m_batch.GetStats(); }
+
+private:
+    void OnFlush(const SpriteBatchVertex* vertices, uint32_t quadCount,
+        const SpriteBatchRun* runs, uint32_t runCount) override;
+
+    // R8 / BC4 Ȃ trueiSDF ̃VF[_IԂ߁j
+    bool IsSingleChannel(ID3D11ShaderResourceView* srv);
 
 private:
     ID3D11Device* m_device = nullptr;
@@ -36,15 +49,22 @@ private:
     ID3D11InputLayout* m_inputLayout = nullptr;
     ID3D11VertexShader* m_vs = nullptr;
     ID3D11PixelShader* m_ps = nullptr;
-    ID3D11Buffer* m_vtxBuffer = nullptr;
+    ID3D11Buffer* m_vtxBuffer = nullptr;   // Iiob`_j
+    ID3D11Buffer* m_idxBuffer = nullptr;   // ŒiQuadƂ 0,1,2,2,1,3j
     ID3D11Buffer* m_constBuffer = nullptr;
     ID3D11RasterizerState* m_rasterizer = nullptr;
     ID3D11SamplerState* m_sampler = nullptr;
 
-    ID3D11PixelShader* m_psSdf = nullptr;
+    ID3D11PixelShader* m_psSdf = nullptr;  // RGBA AgXi .aj
+    ID3D11PixelShader* m_psSdfR = nullptr; // R8 / BC4 AgXi .rj
     bool m_useSdf = false;
 
+    ID3D11ShaderResourceView* m_formatCacheSrv = nullptr;
+    bool m_formatCacheSingle = false;
+
     ID3D11BlendState* m_blendState = nullptr;
 
     MyGame::Float2 m_screen;
+
+    SpriteBatch m_batch;
 };
\ No newline at end of file
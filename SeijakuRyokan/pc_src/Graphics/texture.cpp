@@ -5,7 +5,10 @@
 #include "texture.h"
 #include "../System/DirectX.h" // GetDevice(), GetContext()
 #include "../../DirectXTex/DirectXTex.h"
+#include "../../common_src/System/FrameCounters.h"
+#include "../../common_src/System/MemoryTracker.h"
 #include <cassert>
+#include <string>
 
 using namespace DirectX;
 
@@ -15,20 +18,54 @@ using namespace DirectX;
 #pragma comment(lib, "DirectXTex/x64/Release/DirectXTex.lib")
 #endif
 
-ID3D11ShaderResourceView* LoadTexture(const wchar_t* filename)
+//  .ddsitools/TextureCooker ŏẮj̃pX
+static std::wstring GetCookedPath(const wchar_t* filename)
 {
-    ID3D11Device* device = GetDevice();
-    assert(device != nullptr);
+    std::wstring path = filename;
+    const size_t dot = path.find_last_of(L'.');
+    const size_t sep = path.find_last_of(L"/\\");
+    if (dot != std::wstring::npos && (sep == std::wstring::npos || dot > sep)) {
+        path.erase(dot);
+    }
+    return path + L".dds";
+}
+
+// Ăt@CA摜ÂȂ truei摜ꍇ DDS gj
+static bool IsCookedUpToDate(const wchar_t* source, const std::wstring& cooked)
+{
+    WIN32_FILE_ATTRIBUTE_DATA cookedAttr = {};
+    if (!GetFileAttributesExW(cooked.c_str(), GetFileExInfoStandard, &cookedAttr)) {
+        return false;
+    }
+    WIN32_FILE_ATTRIBUTE_DATA sourceAttr = {};
+    if (!GetFileAttributesExW(source, GetFileExInfoStandard, &sourceAttr)) {
+        return true;
+    }
+    return CompareFileTime(&cookedAttr.ftLastWriteTime, &sourceAttr.ftLastWriteTime) >= 0;
+}
 
+bool DecodeTexture(const wchar_t* filename, ScratchImage& scratch)
+{
     TexMetadata metadata = {};
-    ScratchImage scratch = {};
+
+    // BCkE~bvς݂ DDS  WIC fR[hƕϊۂƏȂ
+    const std::wstring cooked = GetCookedPath(filename);
+    if (IsCookedUpToDate(filename, cooked)) {
+        HRESULT hr = LoadFromDDSFile(cooked.c_str(), DDS_FLAGS_NONE, &metadata, scratch);
+        if (SUCCEEDED(hr)) {
+            return true;
+        }
+        OutputDebugString(L"[LoadTexture] Failed to load cooked DDS, falling back to source image\n");
+        metadata = {};
+        scratch.Release();
+    }
 
     // WIC_FLAGS_FORCE_RGBA32 ݂͑ȂBW[hɖϊB
     HRESULT hr = LoadFromWICFile(filename, WIC_FLAGS_IGNORE_SRGB, &metadata, scratch);
     if (FAILED(hr))
     {
         OutputDebugString(L"[LoadTexture] Failed to load image file\n");
-        return nullptr;
+        return false;
     }
 
     // 32bit RGBA ֖ϊiStraight Alpha Oj
@@ -46,20 +83,42 @@ ID3D11ShaderResourceView* LoadTexture(const wchar_t* filename)
         if (SUCCEEDED(hr))
         {
             scratch = std::move(converted);
-            metadata = scratch.GetMetadata();
         }
         else
         {
             OutputDebugString(L"[LoadTexture] Convert to RGBA8 failed, continue with original format.\n");
         }
     }
+    return true;
+}
 
-    ID3D11ShaderResourceView* textureView = nullptr;
-    hr = CreateShaderResourceView(device, scratch.GetImages(), scratch.GetImageCount(), metadata, &textureView);
+ID3D11ShaderResourceView* CreateTexture(const ScratchImage& scratch)
+{
+    ID3D11Device* device = GetDevice();
+    assert(device != nullptr);
 
+    ID3D11ShaderResourceView* textureView = nullptr;
+    HRESULT hr = CreateShaderResourceView(device, scratch.GetImages(), scratch.GetImageCount(), scratch.GetMetadata(), &textureView);
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[LoadTexture] CreateShaderResourceView failed\n");
+        return nullptr;
+    }
+    // GPU ̑傫i ~  ~ bppA~bv݁jBUnloadTexture ŊO
+    FrameCounters::Add(FrameCounter::BytesUploaded, scratch.GetPixelsSize());
+    MemoryTracker::TrackExternal(textureView, MemoryTag::Texture, scratch.GetPixelsSize());
     return textureView;
 }
 
+ID3D11ShaderResourceView* LoadTexture(const wchar_t* filename)
+{
+    ScratchImage scratch;
+    if (!DecodeTexture(filename, scratch)) {
+        return nullptr;
+    }
+    return CreateTexture(scratch);
+}
+
 void SetTexture(ID3D11ShaderResourceView* texture)
 {
     ID3D11DeviceContext* context = GetContext();
@@ -71,6 +130,7 @@ void UnloadTexture(ID3D11ShaderResourceView* texture)
 {
     if (texture)
     {
+        MemoryTracker::UntrackExternal(texture);
         texture->Release();
     }
 }
@@ -8,9 +8,17 @@
 #pragma once
 #include <d3d11.h>
 
+namespace DirectX { class ScratchImage; }
+
 // eNX`̓ǂݍ݁ifilenameL"sample.png" ̂悤ȃpXj
 ID3D11ShaderResourceView* LoadTexture(const wchar_t* filename);
 
+// 摜t@C̃fR[ĥ݁iGPU ɐGȂ̂Ń[J[XbhĂׂj
+bool DecodeTexture(const wchar_t* filename, DirectX::ScratchImage& image);
+
+// fR[hς݂̉摜 SRV 쐬
+ID3D11ShaderResourceView* CreateTexture(const DirectX::ScratchImage& image);
+
 // eNX`̃ZbgisNZVF[_ɃoChj
 void SetTexture(ID3D11ShaderResourceView* texture);
 
@@ -1,5 +1,6 @@
 // Minimal XInput-only implementation
 #include "XInputGamepad.h"
+#include "../../common_src/System/GamepadAxis.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -108,23 +109,11 @@ void XInputGamepad::SetVibration(float leftMotor, float rightMotor) {
 }
 
 float XInputGamepad::NormalizeThumb(short v, short deadzone) {
-    int iv = static_cast<int>(v);
-    int dz = (std::max<int>)(0, deadzone);
-    int mag = std::abs(iv);
-    if (mag <= dz) return 0.0f;
-    const float sign = (iv < 0) ? -1.0f : 1.0f;
-    const float range = 32767.0f - dz;
-    float n = (static_cast<float>(mag - dz)) / range;
-    n = (std::clamp)(n, 0.0f, 1.0f);
-    return sign * n;
+    return GamepadAxis::NormalizeThumb(v, deadzone);
 }
 
 float XInputGamepad::NormalizeTrigger(unsigned char v, unsigned char deadzone) {
-    int iv = static_cast<int>(v);
-    int dz = static_cast<int>(deadzone);
-    if (iv <= dz) return 0.0f;
-    float n = static_cast<float>(iv - dz) / static_cast<float>(255 - dz);
-    return (std::clamp)(n, 0.0f, 1.0f);
+    return GamepadAxis::NormalizeTrigger(v, deadzone);
 }
 
 WORD XInputGamepad::ToXInputButton(Button b) {
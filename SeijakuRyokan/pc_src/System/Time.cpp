@@ -4,8 +4,10 @@
  *
  * @details
  * - x^C}[iQueryPerformanceCounterjgp
- * - busy waitiX[vȂjɂAwFPSŏs
+ * - t[҂ FramePacer ɔCiv FramePacer  PacerClockjBڕW̏O܂
+ *   X[vAc肾 busy wait ̂ŁACPU 1RAg؂炸ɎwFPSŏs
  * - Q[[v `ShouldUpdateFrame()` gāA^C~Os
+ * - UpdateTime ŌvoߎԂ FrameTimeMonitor ɂAp99 qb`Ō悤ɂ
  *
  * @author E
  *****************************************************************************************/
@@ -16,9 +18,9 @@
 static LARGE_INTEGER g_frequency;             ///< gib̃JEgj
 static LARGE_INTEGER g_prevTick;              ///< Ot[Tick
 static LARGE_INTEGER g_currentTick;           ///< ݂Tick
-static LARGE_INTEGER g_nextTick;              ///< ̃t[̖ڕWTick
+static FramePacer g_pacer;                    ///< t[҂iڕW͂zȂj
 static double g_elapsedTime = 0.0;            ///< oߎԁibj
-static double g_frameTimeTarget = 1.0 / 60.0; ///< ڕWt[Ԋui:60FPSj
+static FrameTimeMonitor g_frameTimes;         ///< t[Ԃ̃qXgOEqb`
 
 
 /**
@@ -32,8 +34,11 @@ void InitTime()
     QueryPerformanceFrequency(&g_frequency);
     QueryPerformanceCounter(&g_prevTick);
     g_currentTick = g_prevTick;
+    g_elapsedTime = 0.0;
 
-    g_nextTick.QuadPart = g_prevTick.QuadPart + static_cast<LONGLONG>(g_frameTimeTarget * g_frequency.QuadPart);
+    g_pacer.Reset(g_pacer.GetTargetFps());
+    g_pacer.ResetStats();
+    g_frameTimes.Reset();
 }
 
 /**
@@ -50,34 +55,29 @@ void UpdateTime()
         ) / g_frequency.QuadPart;
 
     g_prevTick = g_currentTick;
+    g_frameTimes.AddFrame(g_elapsedTime);
 }
 
 /**
- * @brief wFPSԊuŏs邩肷ibusy waitj
+ * @brief wFPSԊuŏs邩肷iX[v{Zbusy waitj
  *
- * @param targetFps ]t[[giF30.0  30FPSj
+ * @param targetFps ]t[[giF30.0  30FPSj
  * @return true ԂBȀsׂ^C~O
  *
  * @details
- * - X[vpAw莞Ԃ܂CPUgđҋ@
- * - oߌɎ̖ڕWԂXV
+ * - ڕW̎O܂ł̓X[vAŌ 0.1`4ms CPUgđҋ@
+ * - ̖ڕẂuO̖ڕW + 1t[vȂ̂ŁAN̒xꂪςݏdȂȂ
+ * - ȑO busy wait łƈႢ g_prevTick ͏ȂBUpdateTime ̌oߎԂ
+ *   ҂Ԃ܂߂̊ԊuɂȂȂƁAFixedStepLoop ɓnԂȂȂ邽
  */
 bool ShouldUpdateFrame(double targetFps)
 {
-    g_frameTimeTarget = 1.0 / targetFps;
-
-    while (true)
+    if (targetFps != g_pacer.GetTargetFps())
     {
-        LARGE_INTEGER now;
-        QueryPerformanceCounter(&now);
-
-        if (now.QuadPart >= g_nextTick.QuadPart)
-        {
-            g_prevTick = now;
-            g_nextTick.QuadPart = now.QuadPart + static_cast<LONGLONG>(g_frameTimeTarget * g_frequency.QuadPart);
-            return true;
-        }
+        g_pacer.SetTargetFps(targetFps);
     }
+    g_pacer.WaitForNextFrame();
+    return true;
 }
 
 /**
@@ -99,3 +99,31 @@ uint64_t GetCurrentTick()
 {
     return static_cast<uint64_t>(g_currentTick.QuadPart);
 }
+
+/**
+ * @brief t[҂̓v擾
+ *
+ * @return N̂iρEW΍EőjAxꂽ񐔁AX[v/Xs
+ */
+const FramePacingStats& GetFramePacingStats()
+{
+    return g_pacer.GetStats();
+}
+
+/**
+ * @brief t[҂̓vZbg
+ */
+void ResetFramePacingStats()
+{
+    g_pacer.ResetStats();
+}
+
+/**
+ * @brief t[Ԃ̃qXgOƃqb`̋L^擾
+ *
+ * @return UpdateTime Ƃ̌oߎԂWv́ilEReLXg̐ݒj
+ */
+FrameTimeMonitor& GetFrameTimeMonitor()
+{
+    return g_frameTimes;
+}
@@ -7,6 +7,8 @@
  *********************************************************************/
 #pragma once
 #include <stdint.h>
+#include "../../common_src/System/FramePacer.h"
+#include "../../common_src/System/FrameTimeHistogram.h"
 
 // ==============================
 // Ԑix^C}[j
@@ -19,11 +21,20 @@ void InitTime();
 // t[ĂяoF݂TickƌoߎԂXV
 void UpdateTime();
 
-// wFPS̃t[Ԃ𒴂Hi60fps  16.66msj
+// wFPS̎̃t[܂ő҂Ă true Ԃi60fps  16.66msj
+// 唼̓X[vő҂AŌ̏XsBQ[[v̎񂲂Ƃ1Ă
+// UpdateTime ̊iOt[Tickj͕ςȂ̂ŁAoߎԂɂ͑҂Ԃ
 bool ShouldUpdateFrame(double targetFps = 60.0);
 
 // O񂩂̌oߎԁibj擾iF0.016bj
 double GetElapsedTime();
 
-// ݂TicklԂifobOL^pj
+// ݂TicklԂifobOL^pAQueryPerformanceCounter ̃JEgj
 uint64_t GetCurrentTick();
+
+// ShouldUpdateFrame ̋N̂EX[v/XsԂ̓v
+const FramePacingStats& GetFramePacingStats();
+void ResetFramePacingStats();
+
+// UpdateTime Ōvt[Ԃ̃qXgOƃqb`̋L^iInitTime ŃZbgj
+FrameTimeMonitor& GetFrameTimeMonitor();
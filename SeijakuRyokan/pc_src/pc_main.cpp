@@ -1,19 +1,34 @@
 ﻿#include "System/Window.h"
 #include "Graphics/DirectXGraphics.h"
+#include "../common_src/Graphics/ThreadedGraphics.h"
+#include "../common_src/Graphics/CounterHud.h"
 #include "../common_src/Game/Game.h"
 #include "System/Time.h"
+#include "../common_src/System/FixedStepLoop.h"
+#include "../common_src/System/FrameCounters.h"
+#include "../common_src/System/MemoryTracker.h"
+#include "../common_src/System/Profiler.h"
+#include <cstdio>
+#include <cstring>
 #include <memory>
 #include <combaseapi.h>
 #include "Input/XInputGamepad.h"
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int nCmdShow)
 {
     CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 
+    // -profile で起動するとプロファイラを有効にし、終了時に profile.json（Chrome トレース）を書き出す
+    const bool profile = lpCmdLine && std::strstr(lpCmdLine, "-profile") != nullptr;
+    Profiler::SetEnabled(profile);
+    PROFILE_THREAD_NAME("main");
+
     // --- 各モジュールの生成 ---
     Window window;
     auto graphics = std::make_unique<DirectXGraphics>();
-    auto game = std::make_unique<Game>(graphics.get());
+    // Present は描画スレッドで行い、その間に次のフレームの Update を進める
+    auto renderThread = std::make_unique<ThreadedGraphics>(*graphics);
+    auto game = std::make_unique<Game>(renderThread.get());
 
     // --- ウィンドウ作成（ハンドルが必要） ---
     window.Create(hInstance, nCmdShow, 1920, 1080);
@@ -23,22 +38,47 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
     game->SetGamepad(gamepad.get());
 
     // --- 初期化 ---
-    if (!graphics->Initialize(window.GetHwnd(), 1920, 1080))
+    if (!renderThread->Initialize(window.GetHwnd(), 1920, 1080))
     {
         MessageBox(nullptr, L"Graphics initialization failed!", L"Error", MB_OK);
         return -1;
     }
 
     InitTime();
+    // ここより後に確保して Terminate 後も残っているものをリークとして書き出す
+    const uint64_t memoryMark = MemoryTracker::GetSerial();
     game->Initialize();
 
+    // BACK で描画・シミュレーションのカウンタを重ねて表示する
+    CounterHud counterHud;
+    counterHud.Initialize(*renderThread, "rom/fonts/sdf_atlas.glyphs", "rom/fonts/sdf_atlas.png");
+    renderThread->SetOverlay([&counterHud](IGraphics& g) { counterHud.Draw(g); });
+
     // --- ゲームループ ---
-    const double FRAME_RATE = 60.0;
-    const double TIME_PER_FRAME = 1.0 / FRAME_RATE;
-    double accumulator = 0.0; // 経過時間を溜める変数
+    // Update は固定 60Hz。ヒッチの後も 1 フレームで追いかけるのは maxSubsteps 回まで
+    FixedStepConfig loopConfig;
+    loopConfig.stepSeconds = 1.0 / 60.0;
+    FixedStepLoop loop(loopConfig);
+
+    // ヒッチしたフレームには、そのフレームの Update 回数と描画量を添えて記録する
+    // （UpdateTime が計るのは 1 つ前の周回なので、前の周回の値を渡す。描画量は描画スレッドが
+    //   最後に描き終えたフレームの分で、FrameCounters は ThreadedGraphics がフレームごとに確定する）
+    FixedStepFrame lastFrame;
+    GetFrameTimeMonitor().SetContextProvider([&lastFrame](std::string& context) {
+        const FrameCounters::Snapshot counters = FrameCounters::GetLastFrame();
+        char text[128];
+        std::snprintf(text, sizeof(text), "substeps %d%s, quads %llu, draw calls %llu",
+            lastFrame.substeps, lastFrame.clamped ? " (clamped)" : "",
+            static_cast<unsigned long long>(counters[FrameCounter::Quads]),
+            static_cast<unsigned long long>(counters[FrameCounter::DrawCalls]));
+        context = text;
+    });
 
     while (!window.ShouldQuit())
     {
+        // 次のフレーム時刻まで待つ（スリープ＋短いスピン）。入力はこの後で読むので遅れが増えない
+        ShouldUpdateFrame(60.0);
+
         window.ProcessMessage();
 
         if (game->ShouldQuit()) {
@@ -47,25 +87,40 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 
         // 入力をフレーム先頭で更新
         gamepad->Update();
+        counterHud.Update(*gamepad);
 
         UpdateTime();
-        // 前のフレームからの経過時間を accumulator に加算
-        accumulator += GetElapsedTime();
+        // 前のフレームからの経過時間を溜め、1フレーム分ごとに Update を固定時間で実行
+        const FixedStepFrame frame = loop.Advance(GetElapsedTime(), [&](double step) {
+            PROFILE_ZONE("Game::Update");
+            game->Update(static_cast<float>(step));
+        });
+        lastFrame = frame;
 
-        // accumulator が1フレーム分の時間を超えている限り、Updateを固定時間で実行
-        while (accumulator >= TIME_PER_FRAME)
+        // 描画は毎フレーム実行する（次の Update までの割合で前回と今回の状態を補間）
         {
-            game->Update(static_cast<float>(TIME_PER_FRAME));
-            accumulator -= TIME_PER_FRAME;
+            PROFILE_ZONE("Game::Draw");
+            game->Draw(); // 補間の割合は GetInterpolationAlpha() で読める
         }
-
-        // 描画は毎フレーム実行する
-        game->Draw();
     }
 
     // --- 終了処理 ---
     game->Terminate();
-    graphics->Finalize();
+    renderThread->SetOverlay(nullptr);
+    counterHud.Finalize(*renderThread);
+    renderThread->Finalize(); // 描画スレッドを止めてから DirectXGraphics を後始末する
+    if (profile) {
+        Profiler::WriteChromeTrace("profile.json");
+    }
+    // 毎回同じ書式で書くので、プレイ同士のカクつきを diff で比べられる
+    GetFrameTimeMonitor().WriteSummary("frametime.txt");
+    if (MemoryTracker::IsEnabled()) {
+        if (FILE* fp = std::fopen("memory.txt", "w")) {
+            MemoryTracker::WriteReport(fp);
+            MemoryTracker::DumpLeaks(fp, memoryMark);
+            std::fclose(fp);
+        }
+    }
     CoUninitialize();
 
     return 0;
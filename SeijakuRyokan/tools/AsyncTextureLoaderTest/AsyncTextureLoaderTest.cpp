@@ -0,0 +1,267 @@
+﻿/*****************************************************************//**
+ * @file   AsyncTextureLoaderTest.cpp
+ * @brief  AsyncTextureLoader の受け渡しを偽のテクスチャデバイスで確かめる（ヘッドレス）
+ *
+ * @details
+ * - FakeBackend は Decode / Create / ReleaseDecoded / Destroy の呼び出しと、生きているデコード結果・
+ *   テクスチャの数を数える。Decode はゲートを開けるまで待たせられる（デコード中の状態を作るため）
+ * - 確かめること
+ *   - Request はすぐハンドルを返し、FinalizePending までは Ready にならない（描画側は代用テクスチャを使う）
+ *   - Create は FinalizePending を呼んだスレッド（描画スレッド）でだけ呼ばれ、1 回の作成数は maxCount まで
+ *   - デコード中に Release したものは Create されず、デコード結果も解放される
+ *   - WaitAll のあとは未完了が 0 で、読めなかったものは Failed になる
+ *   - ローダーを壊したあとにデコード結果・テクスチャが残らない
+ * - 失敗した項目があれば 1 を返す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -pthread -I. tools/AsyncTextureLoaderTest/AsyncTextureLoaderTest.cpp \
+ *         common_src/Graphics/AsyncTextureLoader.cpp common_src/System/Profiler.cpp \
+ *         common_src/System/MemoryTracker.cpp -o AsyncTextureLoaderTest
+ *********************************************************************/
+#include "../../common_src/Graphics/AsyncTextureLoader.h"
+#include "../Common/TestCheck.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using TestCheck::Check;
+
+    // "missing" を含むパスは読めない扱いにする
+    class FakeBackend : public ITextureBackend
+    {
+    public:
+        struct Decoded
+        {
+            std::string path;
+        };
+
+        struct Texture
+        {
+            std::string path;
+        };
+
+        std::atomic<int> decodeCalls{ 0 };
+        std::atomic<int> decodeStarted{ 0 };
+        std::atomic<int> createCalls{ 0 };
+        std::atomic<int> createOffThread{ 0 }; // renderThread 以外からの Create
+        std::atomic<int> liveDecoded{ 0 };
+        std::atomic<int> liveTextures{ 0 };
+        std::thread::id renderThread = std::this_thread::get_id();
+
+        void CloseGate()
+        {
+            std::lock_guard<std::mutex> lock(m_gateMutex);
+            m_gateOpen = false;
+        }
+
+        void OpenGate()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_gateMutex);
+                m_gateOpen = true;
+            }
+            m_gateCv.notify_all();
+        }
+
+        void* Decode(const std::string& path) override
+        {
+            ++decodeStarted;
+            {
+                std::unique_lock<std::mutex> lock(m_gateMutex);
+                m_gateCv.wait(lock, [this] { return m_gateOpen; });
+            }
+            ++decodeCalls;
+            if (path.find("missing") != std::string::npos) {
+                return nullptr;
+            }
+            ++liveDecoded;
+            return new Decoded{ path };
+        }
+
+        TextureHandle Create(void* decoded) override
+        {
+            ++createCalls;
+            if (std::this_thread::get_id() != renderThread) {
+                ++createOffThread;
+            }
+            ++liveTextures;
+            return new Texture{ static_cast<Decoded*>(decoded)->path };
+        }
+
+        void ReleaseDecoded(void* decoded) override
+        {
+            --liveDecoded;
+            delete static_cast<Decoded*>(decoded);
+        }
+
+        void Destroy(TextureHandle texture) override
+        {
+            --liveTextures;
+            delete static_cast<Texture*>(texture);
+        }
+
+    private:
+        std::mutex m_gateMutex;
+        std::condition_variable m_gateCv;
+        bool m_gateOpen = true;
+    };
+
+    // state が want になるまで待つ（デコードはワーカーで進む）
+    bool WaitForState(const AsyncTexture* texture, TextureLoadState want)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (texture->state.load(std::memory_order_acquire) != want) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    bool WaitForCount(const std::atomic<int>& counter, int want)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (counter.load() < want) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    void TestRequest()
+    {
+        std::printf("Request / FinalizePending\n");
+        FakeBackend backend;
+        {
+            AsyncTextureLoader loader(backend, 2);
+            backend.CloseGate();
+            AsyncTexture* tex = loader.Request("rom/images/guest.png");
+            Check(tex != nullptr && tex->path == "rom/images/guest.png", "Request returns a handle immediately");
+            Check(tex->state.load() == TextureLoadState::Pending && tex->texture == nullptr, "pending while the decode is blocked");
+            Check(loader.GetPendingCount() == 1, "pending count is 1");
+
+            // デコードが済んでも、描画スレッドが作成するまでは代用テクスチャのまま
+            backend.OpenGate();
+            Check(WaitForState(tex, TextureLoadState::Decoded), "worker decodes");
+            Check(tex->texture == nullptr && backend.createCalls == 0, "no texture before FinalizePending");
+            Check(!AsyncTextureLoader::IsDone(tex), "not done before FinalizePending");
+
+            Check(loader.FinalizePending() == 1, "FinalizePending creates one texture");
+            Check(tex->state.load() == TextureLoadState::Ready && tex->texture != nullptr, "ready after FinalizePending");
+            Check(static_cast<FakeBackend::Texture*>(tex->texture)->path == "rom/images/guest.png", "texture is the requested image");
+            Check(backend.createOffThread == 0, "Create runs on the render thread only");
+            Check(backend.liveDecoded == 0, "decoded image released after Create");
+            Check(loader.GetPendingCount() == 0, "pending count back to 0");
+
+            loader.Release(tex);
+            Check(backend.liveTextures == 0, "Release destroys a ready texture");
+        }
+    }
+
+    void TestFinalizeLimit()
+    {
+        std::printf("FinalizePending maxCount\n");
+        FakeBackend backend;
+        {
+            constexpr int COUNT = 5;
+            AsyncTextureLoader loader(backend, 2);
+            std::vector<AsyncTexture*> textures;
+            for (int i = 0; i < COUNT; ++i) {
+                textures.push_back(loader.Request(("rom/images/tile" + std::to_string(i) + ".png").c_str()));
+            }
+            bool decoded = true;
+            for (AsyncTexture* tex : textures) {
+                decoded = WaitForState(tex, TextureLoadState::Decoded) && decoded;
+            }
+            Check(decoded, "all decoded");
+            Check(loader.FinalizePending(2) == 2, "first call creates 2");
+            Check(loader.FinalizePending(2) == 2, "second call creates 2");
+            Check(loader.FinalizePending(2) == 1, "third call creates the last one");
+            Check(loader.FinalizePending(2) == 0, "nothing left");
+            int ready = 0;
+            for (AsyncTexture* tex : textures) {
+                ready += tex->state.load() == TextureLoadState::Ready ? 1 : 0;
+            }
+            Check(ready == COUNT, "all ready");
+        }
+        Check(backend.liveTextures == 0 && backend.liveDecoded == 0, "loader destructor destroys unreleased textures");
+    }
+
+    void TestReleaseInFlight()
+    {
+        std::printf("Release while decoding\n");
+        FakeBackend backend;
+        {
+            AsyncTextureLoader loader(backend, 1);
+            backend.CloseGate();
+            AsyncTexture* decoding = loader.Request("rom/images/guest.png");
+            AsyncTexture* queued = loader.Request("rom/images/room.png");
+            Check(WaitForCount(backend.decodeStarted, 1), "worker started the first decode");
+
+            // 1 本目はデコード中、2 本目はワーカーがまだ取り出していない
+            loader.Release(decoding);
+            loader.Release(queued);
+            backend.OpenGate();
+            loader.WaitAll();
+
+            Check(loader.GetPendingCount() == 0, "WaitAll drains released requests");
+            Check(backend.createCalls == 0, "released requests are never created");
+            Check(backend.decodeCalls == 1, "decode skipped for a request released before it started");
+            Check(backend.liveDecoded == 0, "in-flight decode result released");
+        }
+        Check(backend.liveTextures == 0, "no textures left");
+    }
+
+    void TestWaitAll()
+    {
+        std::printf("WaitAll\n");
+        FakeBackend backend;
+        {
+            constexpr int COUNT = 16;
+            AsyncTextureLoader loader(backend, 3);
+            std::vector<AsyncTexture*> textures;
+            for (int i = 0; i < COUNT; ++i) {
+                const std::string path = (i % 5 == 4) ? "rom/images/missing" + std::to_string(i) + ".png"
+                                                      : "rom/images/sprite" + std::to_string(i) + ".png";
+                textures.push_back(loader.Request(path.c_str()));
+            }
+            loader.WaitAll();
+
+            int ready = 0, failed = 0;
+            for (AsyncTexture* tex : textures) {
+                const TextureLoadState state = tex->state.load();
+                ready += state == TextureLoadState::Ready ? 1 : 0;
+                failed += state == TextureLoadState::Failed && tex->texture == nullptr ? 1 : 0;
+            }
+            Check(loader.GetPendingCount() == 0, "nothing pending after WaitAll");
+            Check(ready == COUNT - COUNT / 5 && failed == COUNT / 5, "readable ones ready, missing ones failed");
+            Check(backend.createOffThread == 0, "Create runs on the calling thread");
+
+            // 読み込み済みのものを Release した後も WaitAll はすぐ戻る
+            loader.Release(textures[0]);
+            loader.WaitAll();
+            Check(backend.liveTextures == ready - 1, "Release destroys one texture");
+        }
+        Check(backend.liveTextures == 0 && backend.liveDecoded == 0, "loader destructor leaves nothing alive");
+    }
+}
+
+int main()
+{
+    TestRequest();
+    TestFinalizeLimit();
+    TestReleaseInFlight();
+    TestWaitAll();
+
+    return TestCheck::Finish();
+}
@@ -0,0 +1,231 @@
+﻿/*****************************************************************//**
+ * @file   AtlasPacker.cpp
+ * @brief  rom/images の小さいスプライトをアトラスにまとめるビルドツール
+ *
+ * @details
+ * - 使い方（SeijakuRyokan ディレクトリで実行）
+ *     AtlasPacker rom/images rom/images/atlas [--max-sprite 640] [--max-page 2048] [--padding 2]
+ * - 出力: <outDir>/atlas0.png, atlas1.png ... と <outDir>/atlas.json（マニフェスト）
+ * - マニフェストの source は「<imageDir>/<ファイル名>」なので、ゲームからの
+ *   LoadTexture("rom/images/guest.png") がそのままアトラスに解決される
+ * - max-sprite より大きい画像（背景など）と PNG でないファイルは対象外
+ * - パディング部分には画像の端をコピー（バイリニアで隣の画像が滲まないように）
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/AtlasPacker/AtlasPacker.cpp tools/Common/PngIO.cpp \
+ *         common_src/Graphics/TextureAtlas.cpp -lpng -o AtlasPacker
+ *********************************************************************/
+#include "../Common/PngIO.h"
+#include "../../common_src/Graphics/TextureAtlas.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct Options
+    {
+        std::string imageDir;
+        std::string outDir;
+        int maxSprite = 640;
+        int maxPage = 2048;
+        int padding = 2;
+    };
+
+    struct SourceImage
+    {
+        std::string name;   // ファイル名
+        RgbaImage image;
+        int page = -1;
+        AtlasRect slot;     // パディング込みの配置矩形
+    };
+
+    void PrintUsage()
+    {
+        std::printf("usage: AtlasPacker <imageDir> <outDir> [--max-sprite N] [--max-page N] [--padding N]\n");
+    }
+
+    bool ParseArgs(int argc, char** argv, Options& opt)
+    {
+        if (argc < 3) {
+            return false;
+        }
+        opt.imageDir = argv[1];
+        opt.outDir = argv[2];
+        for (int i = 3; i + 1 < argc; i += 2) {
+            const int value = std::atoi(argv[i + 1]);
+            if (std::strcmp(argv[i], "--max-sprite") == 0) opt.maxSprite = value;
+            else if (std::strcmp(argv[i], "--max-page") == 0) opt.maxPage = value;
+            else if (std::strcmp(argv[i], "--padding") == 0) opt.padding = value;
+            else return false;
+        }
+        while (!opt.imageDir.empty() && (opt.imageDir.back() == '/' || opt.imageDir.back() == '\\')) {
+            opt.imageDir.pop_back();
+        }
+        return opt.maxSprite > 0 && opt.maxPage > 0 && opt.padding >= 0;
+    }
+
+    // 指定サイズのページ群に全スプライトを詰める。page 数を返す（失敗時 -1）
+    int PackAll(std::vector<SourceImage>& images, int pageW, int pageH, int padding, int maxPages)
+    {
+        std::vector<MaxRectsPacker> pages;
+        for (SourceImage& src : images) {
+            const int w = src.image.width + padding * 2;
+            const int h = src.image.height + padding * 2;
+            if (w > pageW || h > pageH) {
+                return -1;
+            }
+            src.page = -1;
+            for (size_t p = 0; p < pages.size() && src.page < 0; ++p) {
+                if (pages[p].Insert(w, h, src.slot)) {
+                    src.page = static_cast<int>(p);
+                }
+            }
+            if (src.page < 0) {
+                if (static_cast<int>(pages.size()) >= maxPages) {
+                    return -1;
+                }
+                pages.emplace_back();
+                pages.back().Init(pageW, pageH);
+                if (!pages.back().Insert(w, h, src.slot)) {
+                    return -1;
+                }
+                src.page = static_cast<int>(pages.size()) - 1;
+            }
+        }
+        return static_cast<int>(pages.size());
+    }
+
+    // スプライト本体を書き込み、パディングに端のピクセルを引き伸ばす
+    void Blit(RgbaImage& dst, const SourceImage& src, int padding)
+    {
+        const RgbaImage& img = src.image;
+        for (int y = -padding; y < img.height + padding; ++y) {
+            const int sy = (std::min)((std::max)(y, 0), img.height - 1);
+            for (int x = -padding; x < img.width + padding; ++x) {
+                const int sx = (std::min)((std::max)(x, 0), img.width - 1);
+                std::memcpy(dst.At(src.slot.x + padding + x, src.slot.y + padding + y), img.At(sx, sy), 4);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!ParseArgs(argc, argv, opt)) {
+        PrintUsage();
+        return 1;
+    }
+
+    // --- 対象画像の収集（ファイル名順で出力を安定させる） ---
+    std::vector<std::string> files;
+    for (const auto& entry : fs::directory_iterator(opt.imageDir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".png") {
+            files.push_back(entry.path().filename().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<SourceImage> images;
+    for (const std::string& name : files) {
+        const std::string path = opt.imageDir + "/" + name;
+        if (!IsPngFile(path)) {
+            std::printf("skip %s (not a PNG)\n", name.c_str());
+            continue;
+        }
+        SourceImage src;
+        src.name = name;
+        if (!LoadPng(path, src.image)) {
+            return 1;
+        }
+        if (src.image.width > opt.maxSprite || src.image.height > opt.maxSprite) {
+            std::printf("skip %s (%dx%d > %d)\n", name.c_str(), src.image.width, src.image.height, opt.maxSprite);
+            continue;
+        }
+        images.push_back(std::move(src));
+    }
+    if (images.empty()) {
+        std::printf("no sprites to pack\n");
+        return 0;
+    }
+
+    // 大きい順に詰めると MaxRects の充填率が上がる
+    std::stable_sort(images.begin(), images.end(), [](const SourceImage& a, const SourceImage& b) {
+        const int ma = (std::max)(a.image.width, a.image.height);
+        const int mb = (std::max)(b.image.width, b.image.height);
+        if (ma != mb) return ma > mb;
+        return a.image.width * a.image.height > b.image.width * b.image.height;
+    });
+
+    // --- まず1枚に収まる最小の 2冪サイズを探し、無理なら最大サイズで複数枚 ---
+    int pageW = 0, pageH = 0, pageCount = -1;
+    for (int area = 64 * 64; area <= opt.maxPage * opt.maxPage && pageCount < 0; area *= 2) {
+        for (int w = 64; w <= opt.maxPage; w *= 2) {
+            const int h = area / w;
+            if (h < 64 || h > opt.maxPage || h > w) {
+                continue;
+            }
+            if (PackAll(images, w, h, opt.padding, 1) == 1) {
+                pageW = w;
+                pageH = h;
+                pageCount = 1;
+                break;
+            }
+        }
+    }
+    if (pageCount < 0) {
+        pageW = pageH = opt.maxPage;
+        pageCount = PackAll(images, pageW, pageH, opt.padding, 64);
+        if (pageCount < 0) {
+            std::fprintf(stderr, "failed to pack sprites into %dx%d pages\n", pageW, pageH);
+            return 1;
+        }
+    }
+
+    // --- アトラス画像とマニフェストの出力 ---
+    fs::create_directories(opt.outDir);
+
+    AtlasManifest manifest;
+    for (int p = 0; p < pageCount; ++p) {
+        RgbaImage atlas;
+        atlas.width = pageW;
+        atlas.height = pageH;
+        atlas.pixels.assign(static_cast<size_t>(pageW) * pageH * 4, 0);
+        for (const SourceImage& src : images) {
+            if (src.page == p) {
+                Blit(atlas, src, opt.padding);
+            }
+        }
+
+        AtlasPage page;
+        page.file = opt.outDir + "/atlas" + std::to_string(p) + ".png";
+        page.width = pageW;
+        page.height = pageH;
+        if (!SavePng(page.file, atlas)) {
+            return 1;
+        }
+        manifest.AddPage(page);
+    }
+
+    for (const SourceImage& src : images) {
+        AtlasRect rect = { src.slot.x + opt.padding, src.slot.y + opt.padding, src.image.width, src.image.height };
+        manifest.AddSprite(opt.imageDir + "/" + src.name, src.page, rect);
+        std::printf("%-20s page %d  (%4d,%4d) %dx%d\n", src.name.c_str(), src.page, rect.x, rect.y, rect.w, rect.h);
+    }
+
+    const std::string manifestPath = opt.outDir + "/atlas.json";
+    if (!manifest.Save(manifestPath.c_str())) {
+        std::fprintf(stderr, "failed to write %s\n", manifestPath.c_str());
+        return 1;
+    }
+    std::printf("%zu sprites -> %d page(s) of %dx%d, manifest %s\n",
+        images.size(), pageCount, pageW, pageH, manifestPath.c_str());
+    return 0;
+}
@@ -0,0 +1,98 @@
+﻿/*****************************************************************//**
+ * @file   JpegIO.cpp
+ * @brief  ツール用の JPEG 読み込み実装
+ *********************************************************************/
+#include "JpegIO.h"
+#include <cstdio>
+#include <csetjmp>
+#include <jpeglib.h>
+
+namespace
+{
+    struct JpegError
+    {
+        jpeg_error_mgr mgr;
+        jmp_buf jump;
+    };
+
+    void OnJpegError(j_common_ptr cinfo)
+    {
+        char message[JMSG_LENGTH_MAX];
+        (*cinfo->err->format_message)(cinfo, message);
+        std::fprintf(stderr, "[JpegIO] %s\n", message);
+        longjmp(reinterpret_cast<JpegError*>(cinfo->err)->jump, 1);
+    }
+}
+
+bool IsJpegFile(const std::string& path)
+{
+    FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp) {
+        return false;
+    }
+    unsigned char sig[3] = {};
+    const size_t n = std::fread(sig, 1, sizeof(sig), fp);
+    std::fclose(fp);
+    return n == sizeof(sig) && sig[0] == 0xFF && sig[1] == 0xD8 && sig[2] == 0xFF;
+}
+
+bool LoadJpeg(const std::string& path, RgbaImage& out)
+{
+    FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp) {
+        return false;
+    }
+
+    jpeg_decompress_struct cinfo = {};
+    JpegError err = {};
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = OnJpegError;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        std::fclose(fp);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, fp);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    out.width = static_cast<int>(cinfo.output_width);
+    out.height = static_cast<int>(cinfo.output_height);
+    out.pixels.assign(static_cast<size_t>(out.width) * out.height * 4, 0xFF);
+
+    // 行バッファは libjpeg のプールから取る。エラーで longjmp しても jpeg_destroy_decompress が解放する
+    // （setjmp の後に作った C++ のオブジェクトはデストラクタが飛ばされる）
+    JSAMPARRAY rows = (*cinfo.mem->alloc_sarray)(reinterpret_cast<j_common_ptr>(&cinfo), JPOOL_IMAGE,
+        static_cast<JDIMENSION>(out.width) * 3, 1);
+    const JSAMPROW row = rows[0];
+    while (cinfo.output_scanline < cinfo.output_height) {
+        const int y = static_cast<int>(cinfo.output_scanline);
+        jpeg_read_scanlines(&cinfo, rows, 1);
+        for (int x = 0; x < out.width; ++x) {
+            uint8_t* px = out.At(x, y);
+            px[0] = row[x * 3 + 0];
+            px[1] = row[x * 3 + 1];
+            px[2] = row[x * 3 + 2];
+        }
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    std::fclose(fp);
+    return true;
+}
+
+bool LoadImageRgba(const std::string& path, RgbaImage& out)
+{
+    if (IsPngFile(path)) {
+        return LoadPng(path, out);
+    }
+    if (IsJpegFile(path)) {
+        return LoadJpeg(path, out);
+    }
+    std::fprintf(stderr, "[JpegIO] %s: unsupported image format\n", path.c_str());
+    return false;
+}
@@ -0,0 +1,16 @@
+﻿/*****************************************************************//**
+ * @file   JpegIO.h
+ * @brief  ツール用の JPEG 読み込み（libjpeg・RGBA8 に展開）
+ *
+ * @details
+ * - rom/images には拡張子が .png の JPEG（title_bg.png）があるため、
+ *   拡張子ではなくシグネチャで判定して読み分ける
+ *********************************************************************/
+#pragma once
+#include "PngIO.h"
+
+bool IsJpegFile(const std::string& path);
+bool LoadJpeg(const std::string& path, RgbaImage& out);
+
+// PNG / JPEG をシグネチャで判別して読み込む
+bool LoadImageRgba(const std::string& path, RgbaImage& out);
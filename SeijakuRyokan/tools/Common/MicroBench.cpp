@@ -0,0 +1,349 @@
+﻿/*****************************************************************//**
+ * @file   MicroBench.cpp
+ * @brief  ツール用マイクロベンチ枠組みの実装
+ *********************************************************************/
+#include "MicroBench.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr uint64_t MAX_ITERATIONS = 1000000000ull;
+
+    struct Entry
+    {
+        std::string name;
+        MicroBench::Function function;
+    };
+
+    std::vector<Entry>& GetRegistry()
+    {
+        static std::vector<Entry> registry;
+        return registry;
+    }
+
+    double CpuSeconds()
+    {
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+    }
+
+    // 1 回分の計測（1 反復あたりに直したもの）
+    struct Run
+    {
+        uint64_t iterations = 0;
+        double realNs = 0.0;
+        double cpuNs = 0.0;
+        double itemsPerSecond = 0.0;
+        double bytesPerSecond = 0.0;
+        std::string label;
+    };
+
+    // min-time に届くまで反復回数を増やして測る（Google Benchmark と同じ考え方）
+    Run Measure(const Entry& entry, double minTime)
+    {
+        uint64_t iterations = 1;
+        for (;;) {
+            MicroBench::State state(iterations);
+            entry.function(state);
+            const double real = state.GetRealSeconds();
+            if (real >= minTime || iterations >= MAX_ITERATIONS) {
+                Run run;
+                run.iterations = iterations;
+                run.realNs = real * 1e9 / iterations;
+                run.cpuNs = state.GetCpuSeconds() * 1e9 / iterations;
+                if (real > 0.0) {
+                    run.itemsPerSecond = state.GetItemsProcessed() / real;
+                    run.bytesPerSecond = state.GetBytesProcessed() / real;
+                }
+                run.label = state.GetLabel();
+                return run;
+            }
+            // 短すぎて当てにならないうちは 10 倍ずつ、それ以降は届きそうな回数へ一気に
+            const double multiplier = real / minTime > 0.1 ? minTime * 1.4 / real : 10.0;
+            const double next = (std::min)(static_cast<double>(iterations) * (std::min)(multiplier, 10.0),
+                static_cast<double>(MAX_ITERATIONS));
+            iterations = (std::max)(iterations + 1, static_cast<uint64_t>(next));
+        }
+    }
+
+    struct Aggregate
+    {
+        const char* name;
+        double realNs;
+        double cpuNs;
+    };
+
+    double Median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        const size_t n = values.size();
+        return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) * 0.5;
+    }
+
+    double Mean(const std::vector<double>& values)
+    {
+        double sum = 0.0;
+        for (double v : values) {
+            sum += v;
+        }
+        return sum / values.size();
+    }
+
+    double StdDev(const std::vector<double>& values)
+    {
+        if (values.size() < 2) {
+            return 0.0;
+        }
+        const double mean = Mean(values);
+        double sum = 0.0;
+        for (double v : values) {
+            sum += (v - mean) * (v - mean);
+        }
+        return std::sqrt(sum / (values.size() - 1));
+    }
+
+    std::vector<Aggregate> MakeAggregates(const std::vector<Run>& runs)
+    {
+        std::vector<double> real;
+        std::vector<double> cpu;
+        for (const Run& run : runs) {
+            real.push_back(run.realNs);
+            cpu.push_back(run.cpuNs);
+        }
+        return {
+            { "mean", Mean(real), Mean(cpu) },
+            { "median", Median(real), Median(cpu) },
+            { "stddev", StdDev(real), StdDev(cpu) },
+        };
+    }
+
+    void WriteJsonString(FILE* fp, const std::string& text)
+    {
+        std::fputc('"', fp);
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                std::fputc('\\', fp);
+            }
+            std::fputc(c, fp);
+        }
+        std::fputc('"', fp);
+    }
+
+    class JsonWriter
+    {
+    public:
+        bool Open(const char* path, const char* executable, int repetitions)
+        {
+            m_fp = std::fopen(path, "w");
+            if (!m_fp) {
+                return false;
+            }
+            char date[32] = {};
+            const std::time_t now = std::time(nullptr);
+            std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+            std::fprintf(m_fp, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"executable\": ", date);
+            WriteJsonString(m_fp, executable);
+            std::fprintf(m_fp, ",\n    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+            std::fprintf(m_fp, "    \"library_build_type\": \"release\",\n");
+#else
+            std::fprintf(m_fp, "    \"library_build_type\": \"debug\",\n");
+#endif
+            std::fprintf(m_fp, "    \"repetitions\": %d\n  },\n  \"benchmarks\": [", repetitions);
+            return true;
+        }
+
+        void WriteRun(const std::string& name, const Run& run, int repetitions, int index)
+        {
+            BeginEntry(name, name);
+            std::fprintf(m_fp, ",\n      \"run_type\": \"iteration\",\n      \"repetitions\": %d,"
+                "\n      \"repetition_index\": %d,\n      \"threads\": 1,\n      \"iterations\": %llu",
+                repetitions, index, static_cast<unsigned long long>(run.iterations));
+            EndEntry(run.realNs, run.cpuNs, run.itemsPerSecond, run.bytesPerSecond, run.label);
+        }
+
+        void WriteAggregate(const std::string& name, const Aggregate& aggregate, const Run& reference, int repetitions)
+        {
+            BeginEntry(name + "_" + aggregate.name, name);
+            std::fprintf(m_fp, ",\n      \"run_type\": \"aggregate\",\n      \"repetitions\": %d,"
+                "\n      \"threads\": 1,\n      \"aggregate_name\": \"%s\",\n      \"iterations\": %d",
+                repetitions, aggregate.name, repetitions);
+            // 件数系はどの回も同じなので、時間の比で直す
+            const double scale = aggregate.realNs > 0.0 && reference.realNs > 0.0 ? reference.realNs / aggregate.realNs : 0.0;
+            const bool rates = std::strcmp(aggregate.name, "stddev") != 0;
+            EndEntry(aggregate.realNs, aggregate.cpuNs,
+                rates ? reference.itemsPerSecond * scale : 0.0,
+                rates ? reference.bytesPerSecond * scale : 0.0, reference.label);
+        }
+
+        void Close()
+        {
+            if (m_fp) {
+                std::fprintf(m_fp, "\n  ]\n}\n");
+                std::fclose(m_fp);
+                m_fp = nullptr;
+            }
+        }
+
+    private:
+        void BeginEntry(const std::string& name, const std::string& runName)
+        {
+            std::fprintf(m_fp, "%s\n    {\n      \"name\": ", m_first ? "" : ",");
+            m_first = false;
+            WriteJsonString(m_fp, name);
+            std::fprintf(m_fp, ",\n      \"run_name\": ");
+            WriteJsonString(m_fp, runName);
+        }
+
+        void EndEntry(double realNs, double cpuNs, double itemsPerSecond, double bytesPerSecond, const std::string& label)
+        {
+            std::fprintf(m_fp, ",\n      \"real_time\": %.4f,\n      \"cpu_time\": %.4f,\n      \"time_unit\": \"ns\"",
+                realNs, cpuNs);
+            if (itemsPerSecond > 0.0) {
+                std::fprintf(m_fp, ",\n      \"items_per_second\": %.4e", itemsPerSecond);
+            }
+            if (bytesPerSecond > 0.0) {
+                std::fprintf(m_fp, ",\n      \"bytes_per_second\": %.4e", bytesPerSecond);
+            }
+            if (!label.empty()) {
+                std::fprintf(m_fp, ",\n      \"label\": ");
+                WriteJsonString(m_fp, label);
+            }
+            std::fprintf(m_fp, "\n    }");
+        }
+
+        FILE* m_fp = nullptr;
+        bool m_first = true;
+    };
+
+    void PrintRow(const std::string& name, double realNs, double cpuNs, uint64_t iterations,
+        double itemsPerSecond, double bytesPerSecond, const std::string& label)
+    {
+        std::printf("%-56s %14.1f %14.1f %12llu", name.c_str(), realNs, cpuNs, static_cast<unsigned long long>(iterations));
+        if (itemsPerSecond > 0.0) {
+            std::printf(" %10.3f M items/s", itemsPerSecond / 1e6);
+        }
+        if (bytesPerSecond > 0.0) {
+            std::printf(" %10.1f MB/s", bytesPerSecond / (1024.0 * 1024.0));
+        }
+        if (!label.empty()) {
+            std::printf(" %s", label.c_str());
+        }
+        std::printf("\n");
+    }
+}
+
+void MicroBench::State::StartTimer()
+{
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_cpuStart = CpuSeconds();
+    m_realStart = std::chrono::steady_clock::now();
+}
+
+void MicroBench::State::StopTimer()
+{
+    if (!m_running) {
+        return;
+    }
+    m_realSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_realStart).count();
+    m_cpuSeconds += CpuSeconds() - m_cpuStart;
+    m_running = false;
+}
+
+void MicroBench::Register(const std::string& name, Function function)
+{
+    GetRegistry().push_back(Entry{ name, std::move(function) });
+}
+
+int MicroBench::RunAll(int argc, char** argv)
+{
+    const char* filter = "";
+    const char* jsonPath = nullptr;
+    double minTime = 0.2;
+    int repetitions = 3;
+    bool listOnly = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            minTime = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--repetitions") == 0 && hasValue) {
+            repetitions = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--list") == 0) {
+            listOnly = true;
+        }
+        else {
+            std::fprintf(stderr, "usage: %s [--filter text] [--min-time sec] [--repetitions n] [--json file] [--list]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (minTime <= 0.0 || repetitions <= 0) {
+        std::fprintf(stderr, "--min-time and --repetitions must be positive\n");
+        return 1;
+    }
+
+    std::vector<const Entry*> selected;
+    for (const Entry& entry : GetRegistry()) {
+        if (entry.name.find(filter) != std::string::npos) {
+            selected.push_back(&entry);
+        }
+    }
+    if (listOnly) {
+        for (const Entry* entry : selected) {
+            std::printf("%s\n", entry->name.c_str());
+        }
+        return 0;
+    }
+
+    JsonWriter json;
+    if (jsonPath && !json.Open(jsonPath, argv[0], repetitions)) {
+        std::fprintf(stderr, "failed to open %s\n", jsonPath);
+        return 1;
+    }
+
+    std::printf("%-56s %14s %14s %12s\n", "benchmark", "real ns", "cpu ns", "iterations");
+    for (const Entry* entry : selected) {
+        std::vector<Run> runs;
+        for (int r = 0; r < repetitions; ++r) {
+            runs.push_back(Measure(*entry, minTime));
+            const Run& run = runs.back();
+            PrintRow(entry->name, run.realNs, run.cpuNs, run.iterations, run.itemsPerSecond, run.bytesPerSecond, run.label);
+            if (jsonPath) {
+                json.WriteRun(entry->name, run, repetitions, r);
+            }
+        }
+        if (repetitions < 2) {
+            continue;
+        }
+        for (const Aggregate& aggregate : MakeAggregates(runs)) {
+            const double scale = aggregate.realNs > 0.0 ? runs[0].realNs / aggregate.realNs : 0.0;
+            const bool rates = std::strcmp(aggregate.name, "stddev") != 0;
+            PrintRow(entry->name + "_" + aggregate.name, aggregate.realNs, aggregate.cpuNs, repetitions,
+                rates ? runs[0].itemsPerSecond * scale : 0.0,
+                rates ? runs[0].bytesPerSecond * scale : 0.0, "");
+            if (jsonPath) {
+                json.WriteAggregate(entry->name, aggregate, runs[0], repetitions);
+            }
+        }
+    }
+    json.Close();
+    return 0;
+}
@@ -0,0 +1,111 @@
+﻿/*****************************************************************//**
+ * @file   MicroBench.h
+ * @brief  ツール用の小さなマイクロベンチ枠組み（Google Benchmark 風）
+ *
+ * @details
+ * - 外部ライブラリなしで Linux / Windows どちらでもビルドできるようにしている
+ * - 書き方は Google Benchmark と同じ
+ *     MicroBench::Register("SpriteBatch/Add/4096", [](MicroBench::State& state) {
+ *         for (auto _ : state) { ... }
+ *         state.SetItemsProcessed(state.Iterations() * 4096);
+ *     });
+ * - 反復回数は min-time に届くまで自動で増やし、repetitions 回測って中央値などを出す
+ * - --json の出力は Google Benchmark の JSON と同じ形
+ *   （context / benchmarks[]。compare.py などの既存ツールでリリース間を比べられる）
+ *********************************************************************/
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace MicroBench
+{
+    class State
+    {
+    public:
+        explicit State(uint64_t iterations) : m_iterations(iterations) {}
+
+        // for (auto _ : state) で回す（Value はデストラクタを持たせ、未使用変数の警告を出さない）
+        struct Value
+        {
+            ~Value() {}
+        };
+        struct Iterator
+        {
+            State* state;
+            uint64_t remaining;
+
+            bool operator!=(const Iterator&) const
+            {
+                if (remaining != 0) {
+                    return true;
+                }
+                state->StopTimer();
+                return false;
+            }
+            void operator++() { --remaining; }
+            Value operator*() const { return Value(); }
+        };
+        Iterator begin()
+        {
+            StartTimer();
+            return Iterator{ this, m_iterations };
+        }
+        Iterator end() { return Iterator{ this, 0 }; }
+
+        // 各反復の準備（並べ直しなど）を計測から外す
+        void PauseTiming() { StopTimer(); }
+        void ResumeTiming() { StartTimer(); }
+
+        void SetItemsProcessed(uint64_t items) { m_items = items; }
+        void SetBytesProcessed(uint64_t bytes) { m_bytes = bytes; }
+        void SetLabel(const std::string& label) { m_label = label; }
+
+        uint64_t Iterations() const { return m_iterations; }
+        double GetRealSeconds() const { return m_realSeconds; }
+        double GetCpuSeconds() const { return m_cpuSeconds; }
+        uint64_t GetItemsProcessed() const { return m_items; }
+        uint64_t GetBytesProcessed() const { return m_bytes; }
+        const std::string& GetLabel() const { return m_label; }
+
+    private:
+        void StartTimer();
+        void StopTimer();
+
+        uint64_t m_iterations = 0;
+        bool m_running = false;
+        std::chrono::steady_clock::time_point m_realStart;
+        double m_cpuStart = 0.0;
+        double m_realSeconds = 0.0;
+        double m_cpuSeconds = 0.0;
+        uint64_t m_items = 0;
+        uint64_t m_bytes = 0;
+        std::string m_label;
+    };
+
+    using Function = std::function<void(State&)>;
+
+    void Register(const std::string& name, Function function);
+
+    // 計算結果を「使った」ことにして、最適化で処理ごと消されないようにする
+    template <typename T>
+    inline void DoNotOptimize(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    // 引数
+    //   --filter <部分文字列>   名前に含むものだけ実行（既定: すべて）
+    //   --min-time <秒>         1 回の計測で最低限回す時間（既定: 0.2）
+    //   --repetitions <回>      計測の繰り返し回数（既定: 3。2 以上で mean/median/stddev を出す）
+    //   --json <ファイル>       結果を Google Benchmark 形式の JSON で書き出す
+    //   --list                  登録されている名前を出して終わる
+    // 引数の誤りは 1、それ以外は 0 を返す
+    int RunAll(int argc, char** argv);
+}
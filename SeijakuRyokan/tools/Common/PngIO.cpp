@@ -0,0 +1,54 @@
+﻿/*****************************************************************//**
+ * @file   PngIO.cpp
+ * @brief  ツール用の PNG 読み書き実装
+ *********************************************************************/
+#include "PngIO.h"
+#include <png.h>
+#include <cstdio>
+
+bool IsPngFile(const std::string& path)
+{
+    FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp) {
+        return false;
+    }
+    png_byte sig[8] = {};
+    const size_t n = std::fread(sig, 1, sizeof(sig), fp);
+    std::fclose(fp);
+    return n == sizeof(sig) && png_sig_cmp(sig, 0, sizeof(sig)) == 0;
+}
+
+bool LoadPng(const std::string& path, RgbaImage& out)
+{
+    png_image image = {};
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, path.c_str())) {
+        std::fprintf(stderr, "[PngIO] %s: %s\n", path.c_str(), image.message);
+        return false;
+    }
+
+    image.format = PNG_FORMAT_RGBA;
+    out.width = static_cast<int>(image.width);
+    out.height = static_cast<int>(image.height);
+    out.pixels.resize(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, nullptr, out.pixels.data(), 0, nullptr)) {
+        std::fprintf(stderr, "[PngIO] %s: %s\n", path.c_str(), image.message);
+        png_image_free(&image);
+        return false;
+    }
+    return true;
+}
+
+bool SavePng(const std::string& path, const RgbaImage& src)
+{
+    png_image image = {};
+    image.version = PNG_IMAGE_VERSION;
+    image.width = static_cast<png_uint_32>(src.width);
+    image.height = static_cast<png_uint_32>(src.height);
+    image.format = PNG_FORMAT_RGBA;
+    if (!png_image_write_to_file(&image, path.c_str(), 0, src.pixels.data(), 0, nullptr)) {
+        std::fprintf(stderr, "[PngIO] %s: %s\n", path.c_str(), image.message);
+        return false;
+    }
+    return true;
+}
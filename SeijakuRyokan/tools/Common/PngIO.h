@@ -0,0 +1,28 @@
+﻿/*****************************************************************//**
+ * @file   PngIO.h
+ * @brief  ツール用の PNG 読み書き（libpng・RGBA8 固定）
+ *
+ * @details
+ * - ゲーム本体は WIC で読むが、ツールは Linux でも動かすため libpng を使う
+ * - グレースケール・パレット・16bit などは読み込み時に RGBA8 へ展開する
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct RgbaImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels; // width * height * 4（Straight Alpha）
+
+    uint8_t* At(int x, int y) { return &pixels[(static_cast<size_t>(y) * width + x) * 4]; }
+    const uint8_t* At(int x, int y) const { return &pixels[(static_cast<size_t>(y) * width + x) * 4]; }
+};
+
+// 先頭8バイトが PNG シグネチャか（拡張子だけ .png の JPEG などを弾く）
+bool IsPngFile(const std::string& path);
+
+bool LoadPng(const std::string& path, RgbaImage& out);
+bool SavePng(const std::string& path, const RgbaImage& image);
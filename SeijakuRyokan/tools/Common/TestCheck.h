@@ -0,0 +1,34 @@
+﻿/*****************************************************************//**
+ * @file   TestCheck.h
+ * @brief  tools のテスト（〜Test）共通の確認と結果の出力
+ *
+ * @details
+ * - Check(条件, 説明) で 1 項目ずつ "[ OK ]" / "[FAIL]" を出し、失敗を数える
+ * - main の最後で return TestCheck::Finish(); とすると、失敗数を出して 1（失敗あり）か 0 を返す
+ * - ヘッダだけなので、各テストのビルド例にソースを足す必要はない
+ *********************************************************************/
+#pragma once
+#include <cstdio>
+
+namespace TestCheck
+{
+    inline int g_failures = 0;
+
+    inline void Check(bool ok, const char* what)
+    {
+        std::printf("  [%s] %s\n", ok ? " OK " : "FAIL", what);
+        if (!ok) {
+            ++g_failures;
+        }
+    }
+
+    inline int Finish()
+    {
+        if (g_failures > 0) {
+            std::printf("%d check(s) failed\n", g_failures);
+            return 1;
+        }
+        std::printf("all checks passed\n");
+        return 0;
+    }
+}
@@ -0,0 +1,162 @@
+﻿/*****************************************************************//**
+ * @file   DrawCommandBench.cpp
+ * @brief  DrawCommandBuffer の記録＋ソートの計測（基数ソート ↔ std::sort）
+ *
+ * @details
+ * - 使い方
+ *     DrawCommandBench [コマンド数(既定 100000)] [フレーム数(既定 200)]
+ * - 1 フレーム分のコマンドを Reset → Record → Sort し、1 フレームあたりの時間（中央値）を出す
+ *   - Ordered : 全レイヤ呼び出し順（既定の設定。キーは layer と sequence だけ。
+ *               レイヤ番号が戻らないので記録順のまま昇順になり、Sort は基数ソートを省く）
+ *   - ByState : 全レイヤをシェーダ→テクスチャでまとめる
+ *   - std::sort : 同じキー列を std::sort（キー比較）で並べた場合。基数ソートとの比較用
+ * - 並べ替えた後、隣り合うコマンドでテクスチャ・シェーダが変わる回数（= バッチの切れ目）も出す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/DrawCommandBench/DrawCommandBench.cpp \
+ *         common_src/Graphics/DrawCommandBuffer.cpp -o DrawCommandBench
+ *********************************************************************/
+#include "../../common_src/Graphics/DrawCommandBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int LAYERS = 4;
+    constexpr int TEXTURES = 64;
+    int g_textures[TEXTURES];
+
+    double Milliseconds(Clock::duration d)
+    {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    double Median(std::vector<double> v)
+    {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    }
+
+    // 実際の画面に近いよう、テクスチャは数枚ごとにばらばらに切り替わり、ときどき SDF（文字）が混ざる
+    struct Source
+    {
+        std::vector<Quad> quads;
+        std::vector<uint8_t> layers;
+        std::vector<bool> sdf;
+    };
+
+    Source MakeSource(int count)
+    {
+        Source source;
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<int> texture(0, TEXTURES - 1);
+        std::uniform_int_distribution<int> run(1, 8);
+        int current = texture(rng);
+        int remaining = run(rng);
+        for (int i = 0; i < count; ++i) {
+            if (--remaining <= 0) {
+                current = texture(rng);
+                remaining = run(rng);
+            }
+            Quad q;
+            q.texture = &g_textures[current];
+            q.position = { float(i % 1920), float(i / 1920) };
+            source.quads.push_back(q);
+            source.layers.push_back(static_cast<uint8_t>(i * LAYERS / count));
+            source.sdf.push_back((rng() % 16) == 0);
+        }
+        return source;
+    }
+
+    void Record(DrawCommandBuffer& buffer, const Source& source)
+    {
+        buffer.Reset();
+        for (size_t i = 0; i < source.quads.size(); ++i) {
+            buffer.SetLayer(source.layers[i]);
+            buffer.Record(source.quads[i], source.sdf[i]);
+        }
+    }
+
+    size_t CountBreaks(const DrawCommandBuffer& buffer)
+    {
+        size_t breaks = 0;
+        for (size_t i = 1; i < buffer.Size(); ++i) {
+            const DrawCommand& a = buffer.GetSorted(i - 1);
+            const DrawCommand& b = buffer.GetSorted(i);
+            if (a.quad.texture != b.quad.texture || a.sdf != b.sdf) {
+                ++breaks;
+            }
+        }
+        return breaks;
+    }
+
+    void RunBuffer(const char* name, LayerSortMode mode, const Source& source, int frames)
+    {
+        DrawCommandBuffer buffer;
+        for (int layer = 0; layer < LAYERS; ++layer) {
+            buffer.SetLayerSortMode(static_cast<uint8_t>(layer), mode);
+        }
+        std::vector<double> recordTimes, sortTimes;
+        for (int f = 0; f < frames; ++f) {
+            const Clock::time_point t0 = Clock::now();
+            Record(buffer, source);
+            const Clock::time_point t1 = Clock::now();
+            buffer.Sort();
+            const Clock::time_point t2 = Clock::now();
+            recordTimes.push_back(Milliseconds(t1 - t0));
+            sortTimes.push_back(Milliseconds(t2 - t1));
+        }
+        std::printf("%-10s record %7.3f ms  sort %7.3f ms  batch breaks %zu\n",
+            name, Median(recordTimes), Median(sortTimes), CountBreaks(buffer));
+    }
+
+    // 基数ソートと同じキー列を std::sort で並べる
+    void RunStdSort(const Source& source, int frames)
+    {
+        std::vector<DrawSortEntry> keys;
+        for (size_t i = 0; i < source.quads.size(); ++i) {
+            const uint32_t texture = static_cast<uint32_t>(static_cast<const int*>(source.quads[i].texture) - g_textures);
+            keys.push_back(DrawSortEntry{ DrawCommandBuffer::MakeKey(source.layers[i], LayerSortMode::ByState,
+                source.sdf[i], texture, static_cast<uint32_t>(i)), static_cast<uint32_t>(i) });
+        }
+
+        std::vector<DrawSortEntry> entries, scratch;
+        std::vector<double> radixTimes, stdTimes;
+        for (int f = 0; f < frames; ++f) {
+            entries = keys;
+            Clock::time_point t0 = Clock::now();
+            DrawCommandBuffer::RadixSort(entries, scratch);
+            radixTimes.push_back(Milliseconds(Clock::now() - t0));
+
+            entries = keys;
+            t0 = Clock::now();
+            std::sort(entries.begin(), entries.end(),
+                [](const DrawSortEntry& a, const DrawSortEntry& b) { return a.key < b.key; });
+            stdTimes.push_back(Milliseconds(Clock::now() - t0));
+        }
+        std::printf("%-10s radix  %7.3f ms  std::sort %7.3f ms\n", "keys only", Median(radixTimes), Median(stdTimes));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 200;
+    if (count < 1 || frames < 1) {
+        std::fprintf(stderr, "usage: DrawCommandBench [commands] [frames]\n");
+        return 1;
+    }
+
+    const Source source = MakeSource(count);
+    std::printf("%d commands, %d layers, %d textures, median of %d frames\n", count, LAYERS, TEXTURES, frames);
+    RunBuffer("Ordered", LayerSortMode::Ordered, source, frames);
+    RunBuffer("ByState", LayerSortMode::ByState, source, frames);
+    RunStdSort(source, frames);
+    return 0;
+}
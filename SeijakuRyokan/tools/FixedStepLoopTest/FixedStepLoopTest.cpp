@@ -0,0 +1,153 @@
+﻿/*****************************************************************//**
+ * @file   FixedStepLoopTest.cpp
+ * @brief  FixedStepLoop にフレーム時間のスパイクを入れて挙動を確かめる（ヘッドレス）
+ *
+ * @details
+ * - 実時間は使わず、フレーム時間の列を与えてシミュレーションする
+ * - Update 自体が重い（1 回 20ms）状況も、「Update の回数 × コスト」を次のフレーム時間に
+ *   足して再現する。上限なしの従来ループと比べて溜まり続けないことを確かめる
+ * - 失敗した項目があれば 1 を返す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/FixedStepLoopTest/FixedStepLoopTest.cpp \
+ *         common_src/System/FixedStepLoop.cpp -o FixedStepLoopTest
+ *********************************************************************/
+#include "../../common_src/System/FixedStepLoop.h"
+#include "../Common/TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+namespace
+{
+    constexpr double STEP = 1.0 / 60.0;
+
+    using TestCheck::Check;
+
+    // 表示 144Hz：1 秒あたり 60 回 Update し、alpha は常に [0, 1]
+    void TestHighRefresh()
+    {
+        std::printf("144Hz display\n");
+        FixedStepLoop loop;
+        bool alphaInRange = true;
+        bool alphaPublished = true;
+        int maxSubsteps = 0;
+        for (int i = 0; i < 144 * 10; ++i) {
+            const FixedStepFrame f = loop.Begin(1.0 / 144.0);
+            alphaInRange &= f.alpha >= 0.0 && f.alpha <= 1.0;
+            alphaPublished &= GetInterpolationAlpha() == f.alpha;
+            maxSubsteps = (std::max)(maxSubsteps, f.substeps);
+        }
+        const FixedStepStats& s = loop.GetStats();
+        Check(s.steps >= 599 && s.steps <= 600, "10 s at 144Hz runs 600 updates");
+        Check(alphaInRange, "alpha stays within [0, 1]");
+        Check(alphaPublished, "GetInterpolationAlpha returns the last frame's alpha");
+        Check(maxSubsteps <= 1, "never more than one update per frame");
+    }
+
+    // 60Hz の途中に 0.5 秒のヒッチ：上限で止まり、次のフレームから元に戻る
+    void TestSingleSpike()
+    {
+        std::printf("single 500 ms hitch (dilate)\n");
+        FixedStepLoop loop;
+        for (int i = 0; i < 60; ++i) {
+            loop.Begin(STEP);
+        }
+        const FixedStepFrame spike = loop.Begin(0.5);
+        const FixedStepFrame after = loop.Begin(STEP);
+        Check(spike.substeps == loop.GetConfig().maxSubsteps, "hitch frame runs maxSubsteps updates");
+        Check(spike.clamped, "hitch frame is reported as clamped");
+        Check(after.substeps == 1, "next frame is back to one update");
+        Check(loop.GetStats().droppedSeconds > 0.4, "the rest of the hitch is dropped");
+    }
+
+    // 同じヒッチを持ち越しで処理：数フレームかけて追いつき、上限を超えない
+    void TestSpikeCatchUp()
+    {
+        std::printf("single 100 ms hitch (carry backlog)\n");
+        FixedStepConfig config;
+        config.maxSubsteps = 3;
+        config.dilateOnOverload = false;
+        FixedStepLoop loop(config);
+
+        loop.Begin(0.1); // 6 ステップ分
+        bool bounded = true;
+        for (int i = 0; i < 10; ++i) {
+            const FixedStepFrame f = loop.Begin(STEP);
+            bounded &= f.substeps <= config.maxSubsteps;
+        }
+        const FixedStepStats& s = loop.GetStats();
+        Check(bounded, "no frame exceeds maxSubsteps");
+        // 0.1 / (1/60) は浮動小数点で 5.999… になり得るので 1 ステップの誤差は許す
+        Check(s.steps >= 15 && s.steps <= 16, "the hitch updates plus 10 normal ones eventually run");
+        Check(s.droppedSeconds < 1e-9, "nothing is dropped");
+    }
+
+    // Update 1 回に 20ms かかる（60Hz を維持できない）状態が続く
+    void TestSustainedOverload()
+    {
+        std::printf("sustained overload (update costs 20 ms)\n");
+        constexpr double UPDATE_COST = 0.020;
+        constexpr double DRAW_COST = 0.002;
+
+        // 従来のループ：accumulator が尽きるまで回す
+        double accumulator = 0.0;
+        double frameTime = STEP;
+        int legacyLastSteps = 0;
+        for (int i = 0; i < 30; ++i) {
+            accumulator += frameTime;
+            int steps = 0;
+            while (accumulator >= STEP) {
+                accumulator -= STEP;
+                ++steps;
+            }
+            legacyLastSteps = steps;
+            frameTime = steps * UPDATE_COST + DRAW_COST;
+        }
+
+        FixedStepLoop loop;
+        frameTime = STEP;
+        double worstFrame = 0.0;
+        for (int i = 0; i < 30; ++i) {
+            const FixedStepFrame f = loop.Begin(frameTime);
+            frameTime = f.substeps * UPDATE_COST + DRAW_COST;
+            worstFrame = (std::max)(worstFrame, frameTime);
+        }
+        std::printf("  legacy loop: %d updates in frame 30; bounded loop: worst frame %.0f ms\n",
+            legacyLastSteps, worstFrame * 1000.0);
+        Check(legacyLastSteps > 100, "the unbounded loop spirals");
+        Check(worstFrame <= loop.GetConfig().maxSubsteps * UPDATE_COST + DRAW_COST + 1e-9,
+            "the bounded loop's frame time stays capped");
+    }
+
+    // ランダムな揺らぎ：合計の Update 数が経過時間と合う
+    void TestJitterConservesTime()
+    {
+        std::printf("jittery frame times\n");
+        FixedStepLoop loop;
+        double total = 0.0;
+        uint32_t seed = 12345;
+        for (int i = 0; i < 10000; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            const double t = 0.008 + (seed >> 8) / double(1u << 24) * 0.018; // 8〜26ms
+            total += t;
+            loop.Begin(t);
+        }
+        const FixedStepStats& s = loop.GetStats();
+        const double simulated = s.steps * STEP + s.droppedSeconds;
+        Check(std::fabs(simulated - total) <= STEP, "updates + dropped time account for all elapsed time");
+        Check(s.clampedFrames == 0, "no frame is clamped");
+    }
+}
+
+int main()
+{
+    TestHighRefresh();
+    TestSingleSpike();
+    TestSpikeCatchUp();
+    TestSustainedOverload();
+    TestJitterConservesTime();
+
+    return TestCheck::Finish();
+}
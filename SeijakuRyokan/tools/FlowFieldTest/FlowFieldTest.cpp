@@ -0,0 +1,301 @@
+﻿/*****************************************************************//**
+ * @file   FlowFieldTest.cpp
+ * @brief  FlowField の向きをたどった経路が A* と同じ長さになるか、キャッシュが作り直すかを確かめる
+ *
+ * @details
+ * - 障害物をばらまいたグリッドで、ランダムな出発点から流れ場をたどったコストを
+ *   GridAStar の最短コストと比べる（行き先が複数なら各行き先への最短の最小）
+ * - 扉 1 つの部屋を行き先にすると、廊下からたどって部屋に入ったところで止まることも見る
+ * - 小さな矩形の書き換えを繰り返し、ApplyEdit で直した場が作り直した場と同じ距離になるか、
+ *   影響の広い書き換えは作り直しへ回すか、キャッシュが直前の書き換えを Get / 予算つきの Update で直すかを見る
+ * - 失敗した項目があれば 1 を返す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/FlowFieldTest/FlowFieldTest.cpp \
+ *         common_src/System/FlowField.cpp common_src/System/NavGrid.cpp -o FlowFieldTest
+ *********************************************************************/
+#include "../../common_src/System/FlowField.h"
+#include "../Common/TestCheck.h"
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using TestCheck::Check;
+
+    // 外周を壁にして、内側の約 1/4 を壁にする
+    NavGrid MakeRandomGrid(int width, int height, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        NavGrid grid;
+        grid.Resize(width, height, false);
+        for (int y = 1; y < height - 1; ++y) {
+            for (int x = 1; x < width - 1; ++x) {
+                grid.SetWalkable(x, y, rng() % 4 != 0);
+            }
+        }
+        return grid;
+    }
+
+    GridPoint RandomWalkable(const NavGrid& grid, std::mt19937& rng)
+    {
+        for (;;) {
+            const GridPoint p{ static_cast<int>(rng() % grid.GetWidth()), static_cast<int>(rng() % grid.GetHeight()) };
+            if (grid.IsWalkable(p)) {
+                return p;
+            }
+        }
+    }
+
+    // 行き先までたどったコスト（向きが途中で切れる・回り続けるなら -1）
+    int FollowCost(const NavGrid& grid, const FlowField& field, GridPoint p)
+    {
+        int cost = 0;
+        for (int steps = 0; steps <= grid.GetCellCount(); ++steps) {
+            if (field.IsGoal(p)) {
+                return cost;
+            }
+            const uint8_t d = field.GetDirection(p);
+            if (d >= NavGrid::DIRECTION_COUNT || !grid.CanStep(p.x, p.y, d)) {
+                return -1;
+            }
+            cost += NavGrid::StepCost(d);
+            p = field.GetNextStep(p);
+        }
+        return -1;
+    }
+
+    void TestMatchesAStar(const GridPoint* goals, size_t goalCount, const char* title)
+    {
+        std::printf("%s\n", title);
+        const NavGrid grid = MakeRandomGrid(96, 64, 7);
+        FlowField field;
+        field.Build(grid, goals, goalCount);
+
+        GridAStar search;
+        NavPath path;
+        std::mt19937 rng(11);
+        int compared = 0;
+        int mismatched = 0;
+        int unreachableAgrees = 0;
+        for (int i = 0; i < 400; ++i) {
+            const GridPoint start = RandomWalkable(grid, rng);
+            int best = INT_MAX;
+            for (size_t g = 0; g < goalCount; ++g) {
+                if (search.FindPath(grid, start, goals[g], path) && path.cost < best) {
+                    best = path.cost;
+                }
+            }
+            if (best == INT_MAX) {
+                unreachableAgrees += field.IsReachable(start) ? 0 : 1;
+                mismatched += field.IsReachable(start) ? 1 : 0;
+                continue;
+            }
+            ++compared;
+            if (FollowCost(grid, field, start) != best) {
+                ++mismatched;
+            }
+        }
+        std::printf("    %d reachable starts compared, %d unreachable\n", compared, unreachableAgrees);
+        Check(compared > 300, "most random starts reach the goal");
+        Check(mismatched == 0, "following the field costs exactly the A* shortest path");
+        Check(!field.IsReachable(GridPoint{ 0, 0 }) && !field.IsReachable(GridPoint{ -1, 3 }),
+            "walls and out-of-range cells are unreachable");
+    }
+
+    void TestCache()
+    {
+        std::printf("cache\n");
+        NavGrid grid;
+        grid.Resize(32, 32, true);
+        const GridPoint goalA{ 2, 2 };
+        const GridPoint goalB{ 29, 29 };
+        FlowFieldCache cache;
+
+        const FlowField* a = &cache.Get(grid, 0, &goalA, 1);
+        const FlowField* again = &cache.Get(grid, 0, &goalA, 1);
+        Check(a == again && cache.GetStats().builds == 1 && cache.GetStats().hits == 1,
+            "same key and map reuses the field");
+
+        cache.Get(grid, 1, &goalB, 1);
+        Check(cache.GetFieldCount() == 2 && cache.GetStats().builds == 2, "another key builds its own field");
+
+        // 行き先のまわりを壁で囲む → 作り直して到達不能になる
+        grid.FillRect(0, 5, 32, 1, false);
+        const FlowField& rebuilt = cache.Get(grid, 0, &goalA, 1);
+        Check(cache.GetStats().builds == 3, "a map edit rebuilds the field on next use");
+        Check(!rebuilt.IsReachable(goalB) && rebuilt.IsGoal(goalA), "rebuilt field sees the new wall");
+
+        cache.Get(grid, 0, &goalA, 1);
+        Check(cache.GetStats().builds == 3, "no rebuild while the map stays the same");
+
+        FlowFieldCache small(2);
+        small.Get(grid, 0, &goalA, 1);
+        small.Get(grid, 1, &goalB, 1);
+        small.Get(grid, 0, &goalA, 1);
+        small.Get(grid, 2, &goalB, 1); // 1 が最も古い
+        Check(small.GetFieldCount() == 2 && small.GetStats().evictions == 1, "capacity evicts one field");
+        small.Get(grid, 0, &goalA, 1);
+        Check(small.GetStats().builds == 3, "the recently used field survives eviction");
+    }
+
+    // 書き換えのたびに ApplyEdit を試し、直せたら作り直した場と全セルで比べる
+    void TestApplyEdit()
+    {
+        std::printf("apply edit\n");
+        NavGrid grid = MakeRandomGrid(64, 48, 5);
+        const GridPoint goals[] = { GridPoint{ 10, 10 }, GridPoint{ 50, 36 } };
+        grid.SetWalkable(goals[0].x, goals[0].y, true);
+        grid.SetWalkable(goals[1].x, goals[1].y, true);
+        FlowField field;
+        field.Build(grid, goals, 2);
+
+        std::mt19937 rng(3);
+        int patched = 0;
+        int rejected = 0;
+        int mismatched = 0;
+        int stayedStale = 0;
+        for (int i = 0; i < 200; ++i) {
+            const int w = 1 + static_cast<int>(rng() % 2);
+            const int h = 1 + static_cast<int>(rng() % 2);
+            const int x = 1 + static_cast<int>(rng() % (grid.GetWidth() - 2 - w));
+            const int y = 1 + static_cast<int>(rng() % (grid.GetHeight() - 2 - h));
+            const uint32_t before = grid.GetRevision();
+            grid.FillRect(x, y, w, h, rng() % 2 == 0);
+            if (!field.ApplyEdit(grid, x, y, w, h)) {
+                ++rejected;
+                stayedStale += field.GetRevision() == before ? 1 : 0;
+                field.Rebuild(grid);
+                continue;
+            }
+            ++patched;
+            FlowField fresh;
+            fresh.Build(grid, goals, 2);
+            for (int index = 0; index < grid.GetCellCount(); ++index) {
+                const GridPoint p = grid.ToPoint(index);
+                if (field.IsReachable(p) != fresh.IsReachable(p)
+                    || (fresh.IsReachable(p) && FollowCost(grid, field, p) != FollowCost(grid, fresh, p))) {
+                    ++mismatched;
+                }
+            }
+        }
+        std::printf("    %d edits patched, %d needed a rebuild\n", patched, rejected);
+        Check(patched > 180, "small edits are repaired in place");
+        Check(mismatched == 0, "patched fields keep exact shortest distances");
+        Check(stayedStale == rejected, "a rejected edit leaves the field at the old revision");
+        Check(field.GetRevision() == grid.GetRevision(), "the field is current after the last edit");
+    }
+
+    // 予算なしなら Get が直前の書き換えを直す。予算つきなら Update が最近使った場から直し、直せない場は作り直す
+    void TestEditRefresh()
+    {
+        std::printf("refresh after edits\n");
+        NavGrid grid;
+        grid.Resize(32, 32, true);
+        const GridPoint goalA{ 2, 2 };
+        const GridPoint goalB{ 29, 29 };
+        {
+            FlowFieldCache cache;
+            cache.Get(grid, 0, &goalA, 1);
+            uint32_t before = grid.GetRevision();
+            grid.SetWalkable(16, 16, false);
+            cache.OnGridEdited(grid, before, 16, 16, 1, 1);
+            const FlowField& field = cache.Get(grid, 0, &goalA, 1);
+            Check(cache.GetStats().builds == 1 && cache.GetStats().patches == 1 && field.GetRevision() == grid.GetRevision(),
+                "without a budget, Get repairs the last edit in place");
+
+            grid.SetWalkable(16, 16, true);
+            grid.SetWalkable(20, 20, false); // 2 回書き換えて、直前の 1 回だけを知らせる
+            before = grid.GetRevision();
+            grid.SetWalkable(24, 24, false);
+            cache.OnGridEdited(grid, before, 24, 24, 1, 1);
+            cache.Get(grid, 0, &goalA, 1);
+            Check(cache.GetStats().builds == 2 && cache.GetStats().patches == 1, "a field two edits behind is rebuilt");
+        }
+
+        grid.Resize(32, 32, true);
+        FlowFieldCache cache;
+        cache.SetUpdateBudget(1e-6); // 1 回の Update で 1 つだけ
+        cache.Get(grid, 0, &goalA, 1);
+        cache.Get(grid, 1, &goalB, 1);
+
+        // 隅の 1 マスはどちらの最短経路にも使われていない
+        uint32_t before = grid.GetRevision();
+        grid.SetWalkable(0, 31, false);
+        cache.OnGridEdited(grid, before, 0, 31, 1, 1);
+        Check(cache.Update(grid) == 1 && cache.Update(grid) == 1 && cache.Update(grid) == 0 && cache.GetStats().patches == 2,
+            "an edit off every shortest path is patched, one field per update");
+
+        // 横一列の壁：A は全体の 3/4 を解き直すことになるので作り直す。B は上の 5 行を到達不能にするだけ
+        before = grid.GetRevision();
+        grid.FillRect(0, 5, 32, 1, false);
+        cache.OnGridEdited(grid, before, 0, 5, 32, 1);
+        const FlowField& fieldA = cache.Get(grid, 0, &goalA, 1);
+        Check(cache.GetStats().builds == 2 && fieldA.GetRevision() != grid.GetRevision(),
+            "with a budget, Get returns the stale field instead of rebuilding");
+        Check(cache.Update(grid) == 1 && fieldA.GetRevision() == grid.GetRevision() && cache.GetStats().invalidations == 1
+            && cache.GetStats().builds == 3 && !fieldA.IsReachable(GridPoint{ 0, 6 }),
+            "the most recently used field goes first, and a wall that reroutes most of the map rebuilds it");
+        const FlowField& fieldB = cache.Get(grid, 1, &goalB, 1);
+        Check(cache.Update(grid) == 1 && cache.GetStats().patches == 3 && cache.GetStats().builds == 3
+            && !fieldB.IsReachable(goalA) && fieldB.IsReachable(GridPoint{ 0, 6 }),
+            "the other field is repaired: cells cut off above the wall become unreachable");
+
+        // 行き先のセルを壁にすると B は作り直し、A は直す
+        before = grid.GetRevision();
+        grid.SetWalkable(goalB.x, goalB.y, false);
+        cache.OnGridEdited(grid, before, goalB.x, goalB.y, 1, 1);
+        Check(cache.Update(grid) == 1 && cache.GetStats().builds == 4 && !fieldB.IsReachable(GridPoint{ 0, 6 }),
+            "an edit on a goal cell rebuilds that field");
+        Check(cache.Update(grid) == 1 && cache.Update(grid) == 0 && cache.GetStats().patches == 4,
+            "the rest is repaired on the next update");
+    }
+
+    // 負荷試験と同じ形の部屋（扉 1 つ）：流れ場は扉から部屋に入って止まる
+    void TestRoomGoal()
+    {
+        std::printf("room with a door\n");
+        NavGrid grid;
+        grid.Resize(40, 20, false);
+        grid.FillRect(1, 10, 38, 3, true);   // 廊下
+        grid.FillRect(20, 2, 6, 5, true);    // 部屋
+        grid.SetWalkable(22, 7, true);       // 扉
+        grid.SetWalkable(22, 8, true);
+        grid.SetWalkable(22, 9, true);
+        std::vector<GridPoint> cells;
+        for (int y = 2; y < 7; ++y) {
+            for (int x = 20; x < 26; ++x) {
+                cells.push_back(GridPoint{ x, y });
+            }
+        }
+        FlowField field;
+        field.Build(grid, cells.data(), cells.size());
+
+        GridPoint p{ 2, 11 };
+        int steps = 0;
+        while (!field.IsGoal(p) && steps < 200) {
+            p = field.GetNextStep(p);
+            ++steps;
+        }
+        Check(field.IsGoal(p) && p.y == 6, "guest stops at the first room cell past the door");
+        Check(field.GetNextStep(p) == p, "a goal cell stays put");
+        Check(field.GetMemorySize() >= static_cast<size_t>(grid.GetCellCount()), "one byte per cell");
+    }
+}
+
+int main()
+{
+    const GridPoint single[] = { GridPoint{ 48, 32 } };
+    const GridPoint several[] = { GridPoint{ 5, 5 }, GridPoint{ 90, 10 }, GridPoint{ 40, 58 } };
+    TestMatchesAStar(single, 1, "single goal vs A*");
+    TestMatchesAStar(several, 3, "three goals vs nearest A*");
+    TestCache();
+    TestApplyEdit();
+    TestEditRefresh();
+    TestRoomGoal();
+
+    return TestCheck::Finish();
+}
@@ -0,0 +1,136 @@
+﻿/*****************************************************************//**
+ * @file   FrameTimeHistogramTest.cpp
+ * @brief  FrameTimeHistogram の分位点の精度と FrameTimeMonitor のヒッチ記録を確かめる
+ *
+ * @details
+ * - 既知の分布（一様・60fps に時々ヒッチ）を入れ、ソートして求めた正確な分位点と比べる
+ * - ヒッチはしきい値ごとの回数・コンテキスト・プロファイラの区間が残ることを確かめる
+ * - 失敗した項目があれば 1 を返す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -pthread -I. tools/FrameTimeHistogramTest/FrameTimeHistogramTest.cpp \
+ *         common_src/System/FrameTimeHistogram.cpp common_src/System/Profiler.cpp \
+ *         common_src/System/MemoryTracker.cpp -o FrameTimeHistogramTest
+ *********************************************************************/
+#include "../../common_src/System/FrameTimeHistogram.h"
+#include "../Common/TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using TestCheck::Check;
+
+    uint64_t ExactPercentile(std::vector<uint64_t> values, double percentile)
+    {
+        std::sort(values.begin(), values.end());
+        size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * values.size()));
+        rank = (std::max<size_t>)(rank, 1);
+        return values[rank - 1];
+    }
+
+    // 1us～10s の対数一様な値で、どの分位点も相対誤差 0.4% 以内
+    void TestAccuracy()
+    {
+        std::printf("percentile accuracy\n");
+        std::mt19937_64 rng(1234);
+        std::uniform_real_distribution<double> exponent(0.0, 7.0);
+        FrameTimeHistogram h;
+        std::vector<uint64_t> values;
+        for (int i = 0; i < 200000; ++i) {
+            const uint64_t v = static_cast<uint64_t>(std::pow(10.0, exponent(rng)));
+            values.push_back(v);
+            h.Record(v);
+        }
+        double worst = 0.0;
+        for (double p : { 1.0, 10.0, 50.0, 90.0, 99.0, 99.9, 99.99 }) {
+            const double exact = static_cast<double>(ExactPercentile(values, p));
+            const double got = static_cast<double>(h.GetPercentile(p));
+            worst = (std::max)(worst, std::fabs(got - exact) / (std::max)(exact, 1.0));
+        }
+        std::printf("  worst relative error %.4f%%\n", worst * 100.0);
+        Check(worst <= 1.0 / 256.0, "relative error within 1/256");
+        Check(h.GetPercentile(100.0) == *std::max_element(values.begin(), values.end()), "p100 is the max");
+        Check(h.GetCount() == values.size(), "count matches");
+    }
+
+    // 16.667ms が続く中に 1% だけ 40ms：p50 は 16.7ms 付近、p99.9 は 40ms 付近
+    void TestFrameTimes()
+    {
+        std::printf("60fps with 1%% hitches\n");
+        FrameTimeHistogram h;
+        for (int i = 0; i < 10000; ++i) {
+            h.RecordSeconds(i % 100 == 0 ? 0.040 : 1.0 / 60.0);
+        }
+        Check(std::fabs(h.GetPercentile(50.0) / 1000.0 - 16.667) < 0.07, "p50 ~ 16.667 ms");
+        Check(std::fabs(h.GetPercentile(99.0) / 1000.0 - 16.667) < 0.07, "p99 ~ 16.667 ms (exactly 1% slow)");
+        Check(std::fabs(h.GetPercentile(99.9) / 1000.0 - 40.0) < 0.16, "p99.9 ~ 40 ms");
+
+        FrameTimeHistogram merged;
+        merged.Add(h);
+        merged.Add(h);
+        Check(merged.GetCount() == 2 * h.GetCount() && merged.GetPercentile(99.9) == h.GetPercentile(99.9),
+            "merging two copies keeps the percentiles");
+    }
+
+    void TestHitches()
+    {
+        std::printf("hitch detection\n");
+        FrameTimeMonitor monitor;
+        monitor.SetHitchThresholds({ 100.0, 30.0 }); // 並べ替えられる
+        monitor.SetWarmupFrames(1);
+        int contextCalls = 0;
+        monitor.SetContextProvider([&contextCalls](std::string& context) {
+            ++contextCalls;
+            context = "scene test";
+        });
+
+        monitor.AddFrame(2.0); // 起動直後の読み込み（数えない）
+        for (int i = 0; i < 100; ++i) {
+            monitor.AddFrame(i == 50 ? 0.150 : (i == 70 ? 0.035 : 1.0 / 60.0));
+        }
+        Check(monitor.GetHistogram().GetCount() == 100, "warm-up frame is not recorded");
+        Check(monitor.GetHitchThresholds().front() == 30.0, "thresholds are sorted");
+        Check(monitor.GetHitchCount(0) == 2 && monitor.GetHitchCount(1) == 1, "hitches counted per threshold");
+        Check(contextCalls == 2 && monitor.GetHitches().size() == 2, "context captured for each hitch");
+        Check(!monitor.GetHitches().empty() && monitor.GetHitches()[0].frame == 51 &&
+            monitor.GetHitches()[0].context == "scene test", "hitch record has frame number and context");
+
+        // プロファイラが有効なら、ヒッチしたフレームの長い区間が残る
+        Profiler::SetEnabled(true);
+        monitor.Reset();
+        monitor.SetWarmupFrames(0);
+        {
+            PROFILE_ZONE("slow load");
+            std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        }
+        {
+            PROFILE_ZONE("short work");
+        }
+        monitor.AddFrame(0.045);
+        Profiler::SetEnabled(false);
+        const std::vector<HitchRecord>& hitches = monitor.GetHitches();
+        Check(hitches.size() == 1 && !hitches[0].zones.empty() &&
+            std::strcmp(hitches[0].zones[0].name, "slow load") == 0 &&
+            hitches[0].zones[0].durationUs > 30000.0, "slowest profiler zone is attached to the hitch");
+
+        std::printf("summary:\n");
+        monitor.WriteSummary(stdout);
+    }
+}
+
+int main()
+{
+    TestAccuracy();
+    TestFrameTimes();
+    TestHitches();
+
+    return TestCheck::Finish();
+}
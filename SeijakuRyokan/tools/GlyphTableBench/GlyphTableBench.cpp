@@ -0,0 +1,170 @@
+﻿/*****************************************************************//**
+ * @file   GlyphTableBench.cpp
+ * @brief  グリフ情報の読み込み・検索の比較（JSON ↔ バイナリテーブル）
+ *
+ * @details
+ * - 使い方（SeijakuRyokan ディレクトリで実行）
+ *     GlyphTableBench [rom/fonts/sdf_atlas.json] [rom/fonts/sdf_atlas.glyphs]
+ * - JSON   : json.hpp でパースし codepoint → グリフの unordered_map を作る（従来の起動時処理）
+ * - binary : GlyphTable::Load（マップのみ）
+ * - 計測項目は読み込み時間（中央値）、ヒープ使用量、1検索あたりの時間
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/GlyphTableBench/GlyphTableBench.cpp \
+ *         common_src/Graphics/GlyphTable.cpp common_src/System/MappedFile.cpp -o GlyphTableBench
+ *********************************************************************/
+#include "../../common_src/Graphics/GlyphTable.h"
+#include "../../common_src/System/json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+// ==============================
+// ヒープ使用量の計測（確保サイズを先頭に持たせる）
+// ==============================
+namespace
+{
+    std::atomic<size_t> g_heapBytes{ 0 };
+    constexpr size_t HEADER = alignof(std::max_align_t);
+}
+
+void* operator new(size_t size)
+{
+    void* p = std::malloc(size + HEADER);
+    if (!p) throw std::bad_alloc();
+    *static_cast<size_t*>(p) = size;
+    g_heapBytes += size;
+    return static_cast<char*>(p) + HEADER;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (!p) return;
+    char* base = static_cast<char*>(p) - HEADER;
+    g_heapBytes -= *reinterpret_cast<size_t*>(base);
+    std::free(base);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct JsonGlyph
+    {
+        int x, y, w, h;
+        float u0, v0, u1, v1;
+        int xoff, yoff, xadvance;
+    };
+
+    using JsonFont = std::unordered_map<uint32_t, JsonGlyph>;
+
+    bool LoadJsonFont(const char* path, JsonFont& font)
+    {
+        std::ifstream ifs(path);
+        json j = json::parse(ifs, nullptr, false);
+        if (j.is_discarded()) {
+            return false;
+        }
+        font.clear();
+        for (const json& g : j["glyphs"]) {
+            JsonGlyph glyph = {
+                g["x"].get<int>(), g["y"].get<int>(), g["w"].get<int>(), g["h"].get<int>(),
+                g["u0"].get<float>(), g["v0"].get<float>(), g["u1"].get<float>(), g["v1"].get<float>(),
+                g["xoff"].get<int>(), g["yoff"].get<int>(), g["xadvance"].get<int>(),
+            };
+            font[g["codepoint"].get<uint32_t>()] = glyph;
+        }
+        return true;
+    }
+
+    double Microseconds(Clock::duration d)
+    {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+
+    double Median(std::vector<double> v)
+    {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* jsonPath = argc > 1 ? argv[1] : "rom/fonts/sdf_atlas.json";
+    const char* tablePath = argc > 2 ? argv[2] : "rom/fonts/sdf_atlas.glyphs";
+    constexpr int LOAD_RUNS = 15;
+    constexpr size_t LOOKUPS = 4 * 1000 * 1000;
+
+    // --- 読み込み時間とヒープ ---
+    std::vector<double> jsonTimes, tableTimes;
+    size_t jsonHeap = 0, tableHeap = 0;
+    JsonFont font;
+    GlyphTable table;
+    for (int i = 0; i < LOAD_RUNS; ++i) {
+        font = JsonFont();
+        const size_t before = g_heapBytes;
+        const Clock::time_point t0 = Clock::now();
+        if (!LoadJsonFont(jsonPath, font)) {
+            std::fprintf(stderr, "failed to load %s\n", jsonPath);
+            return 1;
+        }
+        jsonTimes.push_back(Microseconds(Clock::now() - t0));
+        jsonHeap = g_heapBytes - before;
+    }
+    for (int i = 0; i < LOAD_RUNS; ++i) {
+        table.Unload();
+        const size_t before = g_heapBytes;
+        const Clock::time_point t0 = Clock::now();
+        if (!table.Load(tablePath)) {
+            std::fprintf(stderr, "failed to load %s\n", tablePath);
+            return 1;
+        }
+        tableTimes.push_back(Microseconds(Clock::now() - t0));
+        tableHeap = g_heapBytes - before;
+    }
+
+    // --- 検索（フォントに含まれる文字をランダムな順で引く） ---
+    std::vector<uint32_t> text;
+    for (uint32_t g = 0; g < table.GetGlyphCount(); ++g) {
+        text.push_back(table.GetGlyphs()[g].codepoint);
+    }
+    std::mt19937 rng(12345);
+    std::shuffle(text.begin(), text.end(), rng);
+
+    long long checksum = 0;
+    Clock::time_point t0 = Clock::now();
+    for (size_t i = 0; i < LOOKUPS; ++i) {
+        auto it = font.find(text[i % text.size()]);
+        if (it != font.end()) checksum += it->second.xadvance;
+    }
+    const double jsonLookup = Microseconds(Clock::now() - t0) * 1000.0 / LOOKUPS;
+
+    t0 = Clock::now();
+    for (size_t i = 0; i < LOOKUPS; ++i) {
+        const GlyphRecord* g = table.Find(text[i % text.size()]);
+        if (g) checksum -= g->xadvance;
+    }
+    const double tableLookup = Microseconds(Clock::now() - t0) * 1000.0 / LOOKUPS;
+
+    std::printf("glyphs        : %zu (json) / %u (table)\n", font.size(), table.GetGlyphCount());
+    std::printf("load  (median): json %10.1f us   table %10.1f us\n", Median(jsonTimes), Median(tableTimes));
+    std::printf("heap (kept)   : json %10zu B    table %10zu B (+%zu B mapped)\n", jsonHeap, tableHeap, table.GetDataSize());
+    std::printf("lookup        : json %10.2f ns   table %10.2f ns\n", jsonLookup, tableLookup);
+    // 両方で同じグリフが引けていれば checksum は 0 に戻る
+    return checksum == 0 ? 0 : 1;
+}
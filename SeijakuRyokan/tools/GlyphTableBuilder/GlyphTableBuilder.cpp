@@ -0,0 +1,103 @@
+﻿/*****************************************************************//**
+ * @file   GlyphTableBuilder.cpp
+ * @brief  sdf_atlas.json からバイナリのグリフテーブルを生成するビルドツール
+ *
+ * @details
+ * - 使い方（SeijakuRyokan ディレクトリで実行）
+ *     GlyphTableBuilder rom/fonts/sdf_atlas.json rom/fonts/sdf_atlas.glyphs
+ * - 出力形式は common_src/Graphics/GlyphTable.h を参照
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/GlyphTableBuilder/GlyphTableBuilder.cpp \
+ *         common_src/Graphics/GlyphTable.cpp common_src/System/MappedFile.cpp -o GlyphTableBuilder
+ *********************************************************************/
+#include "../../common_src/Graphics/GlyphTable.h"
+#include "../../common_src/System/json.hpp"
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace
+{
+    template <typename T>
+    T Get(const json& j, const char* key)
+    {
+        return j.contains(key) ? j[key].get<T>() : T();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::printf("usage: GlyphTableBuilder <sdf_atlas.json> <out.glyphs>\n");
+        return 1;
+    }
+
+    std::ifstream ifs(argv[1]);
+    json j = json::parse(ifs, nullptr, false);
+    if (j.is_discarded() || !j.contains("glyphs")) {
+        std::fprintf(stderr, "failed to parse %s\n", argv[1]);
+        return 1;
+    }
+
+    GlyphTableHeader metrics = {};
+    metrics.fontPx = Get<int32_t>(j, "fontPx");
+    metrics.ascent = Get<int32_t>(j, "ascent");
+    metrics.descent = Get<int32_t>(j, "descent");
+    metrics.lineGap = Get<int32_t>(j, "lineGap");
+    metrics.spread = Get<int32_t>(j, "spread");
+    metrics.atlasWidth = Get<int32_t>(j, "atlasWidth");
+    metrics.atlasHeight = Get<int32_t>(j, "atlasHeight");
+
+    std::vector<GlyphRecord> glyphs;
+    size_t skipped = 0;
+    for (const json& g : j["glyphs"]) {
+        GlyphRecord r = {};
+        r.codepoint = Get<uint32_t>(g, "codepoint");
+        if (r.codepoint > 0xFFFF) {
+            ++skipped;
+            continue;
+        }
+        r.x = Get<uint16_t>(g, "x");
+        r.y = Get<uint16_t>(g, "y");
+        r.w = Get<uint16_t>(g, "w");
+        r.h = Get<uint16_t>(g, "h");
+        r.u0 = Get<float>(g, "u0");
+        r.v0 = Get<float>(g, "v0");
+        r.u1 = Get<float>(g, "u1");
+        r.v1 = Get<float>(g, "v1");
+        r.xoff = Get<int16_t>(g, "xoff");
+        r.yoff = Get<int16_t>(g, "yoff");
+        r.xadvance = Get<int16_t>(g, "xadvance");
+        glyphs.push_back(r);
+    }
+
+    const std::vector<uint8_t> table = GlyphTable::Build(metrics, glyphs);
+
+    // 書き出したものを読み直し、全グリフが引けることを確認する
+    GlyphTable check;
+    if (!check.LoadFromMemory(table.data(), table.size())) {
+        std::fprintf(stderr, "generated table failed validation\n");
+        return 1;
+    }
+    for (const GlyphRecord& r : glyphs) {
+        const GlyphRecord* found = check.Find(r.codepoint);
+        if (!found || found->x != r.x || found->y != r.y) {
+            std::fprintf(stderr, "lookup mismatch for U+%04X\n", r.codepoint);
+            return 1;
+        }
+    }
+
+    std::ofstream ofs(argv[2], std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size()));
+    if (!ofs) {
+        std::fprintf(stderr, "failed to write %s\n", argv[2]);
+        return 1;
+    }
+    std::printf("%u glyphs, %u pages -> %s (%zu bytes)%s\n",
+        check.GetGlyphCount(), check.GetHeader().pageCount, argv[2], table.size(),
+        skipped ? " [non-BMP glyphs skipped]" : "");
+    return 0;
+}
@@ -0,0 +1,315 @@
+﻿/*****************************************************************//**
+ * @file   HotPathBench.cpp
+ * @brief  CPU 側のホットパスのマイクロベンチ集（リリースごとの比較用）
+ *
+ * @details
+ * - 使い方（SeijakuRyokan ディレクトリで実行）
+ *     HotPathBench [--data file.json]... [--filter text] [--min-time sec] [--repetitions n] [--json out.json]
+ * - 計測対象
+ *   - Quads : SpriteBatch の頂点生成、DrawCommandBuffer の記録＋ソート、基数ソート単体（std::sort と比較）
+ *   - Text  : GlyphTable の検索、テキストレイアウト（キャッシュなし／ヒット時）
+ *   - Json  : rom 以下の JSON（sdf_atlas.json・atlas.json）のパース。
+ *             マップやスケジュールの JSON は --data で渡すと同じ形で測る
+ *   - Input : GamepadAxis::NormalizeThumb / NormalizeTrigger
+ * - --json の出力は Google Benchmark と同じ形式なので、リリース間の比較は compare.py などにそのまま渡せる
+ * - 読めなかったデータファイルの項目は登録せず、標準エラーにその旨を出す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/HotPathBench/HotPathBench.cpp tools/Common/MicroBench.cpp \
+ *         common_src/Graphics/SpriteBatch.cpp common_src/Graphics/DrawCommandBuffer.cpp \
+ *         common_src/Graphics/TextLayoutCache.cpp common_src/Graphics/GlyphTable.cpp \
+ *         common_src/System/MappedFile.cpp -o HotPathBench
+ *********************************************************************/
+#include "../Common/MicroBench.h"
+#include "../../common_src/Graphics/DrawCommandBuffer.h"
+#include "../../common_src/Graphics/SpriteBatch.h"
+#include "../../common_src/Graphics/TextLayoutCache.h"
+#include "../../common_src/System/GamepadAxis.h"
+#include "../../common_src/System/json.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace
+{
+    constexpr uint32_t SEED = 12345;
+
+    // 実際の画面に近いよう、テクスチャは 16 枚ごとに切り替わる
+    constexpr int QUADS_PER_TEXTURE = 16;
+    int g_textures[4];
+
+    void* TextureFor(int i)
+    {
+        return &g_textures[(i / QUADS_PER_TEXTURE) % 4];
+    }
+
+    class NullSink : public ISpriteBatchSink
+    {
+    public:
+        void OnFlush(const SpriteBatchVertex* vertices, uint32_t quadCount, const SpriteBatchRun*, uint32_t runCount) override
+        {
+            MicroBench::DoNotOptimize(vertices);
+            m_quads += quadCount;
+            m_runs += runCount;
+        }
+
+    private:
+        uint64_t m_quads = 0;
+        uint64_t m_runs = 0;
+    };
+
+    // ==============================
+    // Quads
+    // ==============================
+    void RegisterQuadBenchmarks()
+    {
+        for (int count : { 64, 1024, 4096 }) {
+            MicroBench::Register("Quads/SpriteBatch/Add/" + std::to_string(count), [count](MicroBench::State& state) {
+                NullSink sink;
+                SpriteBatch batch;
+                batch.SetSink(&sink);
+                const MyGame::Float4 color{ 1.0f, 1.0f, 1.0f, 1.0f };
+                for (auto _ : state) {
+                    batch.Begin();
+                    for (int i = 0; i < count; ++i) {
+                        // 半分は回転あり（客・カーソルなど）
+                        const float angle = (i & 1) ? 15.0f : 0.0f;
+                        batch.Add(TextureFor(i), false, MyGame::Float2(float(i % 64) * 20.0f, float(i / 64) * 20.0f),
+                            MyGame::Float2(16.0f, 16.0f), color, angle, MyGame::Float2(0.0f, 0.0f), MyGame::Float2(1.0f, 1.0f));
+                    }
+                    batch.End();
+                }
+                state.SetItemsProcessed(state.Iterations() * count);
+            });
+        }
+
+        for (LayerSortMode mode : { LayerSortMode::Ordered, LayerSortMode::ByState }) {
+            const char* modeName = mode == LayerSortMode::Ordered ? "Ordered" : "ByState";
+            MicroBench::Register(std::string("Quads/DrawCommandBuffer/RecordSort/") + modeName + "/4096",
+                [mode](MicroBench::State& state) {
+                    constexpr int COUNT = 4096;
+                    DrawCommandBuffer buffer;
+                    for (int layer = 0; layer < 4; ++layer) {
+                        buffer.SetLayerSortMode(static_cast<uint8_t>(layer), mode);
+                    }
+                    for (auto _ : state) {
+                        buffer.Reset();
+                        for (int i = 0; i < COUNT; ++i) {
+                            Quad q;
+                            q.texture = TextureFor(i * 7);
+                            q.position = { float(i), float(i) };
+                            buffer.SetLayer(static_cast<uint8_t>(i * 4 / COUNT));
+                            buffer.Record(q, (i % 97) == 0);
+                        }
+                        buffer.Sort();
+                        MicroBench::DoNotOptimize(buffer.GetSorted(0));
+                    }
+                    state.SetItemsProcessed(state.Iterations() * COUNT);
+                });
+        }
+
+        // 基数ソート単体（キーはバラバラ）と std::sort の比較
+        auto makeEntries = [] {
+            std::mt19937_64 rng(SEED);
+            std::vector<DrawSortEntry> entries(65536);
+            for (uint32_t i = 0; i < entries.size(); ++i) {
+                entries[i] = DrawSortEntry{ rng(), i };
+            }
+            return entries;
+        };
+        MicroBench::Register("Quads/RadixSort/65536", [makeEntries](MicroBench::State& state) {
+            const std::vector<DrawSortEntry> source = makeEntries();
+            std::vector<DrawSortEntry> entries;
+            std::vector<DrawSortEntry> scratch;
+            for (auto _ : state) {
+                state.PauseTiming();
+                entries = source;
+                state.ResumeTiming();
+                DrawCommandBuffer::RadixSort(entries, scratch);
+                MicroBench::DoNotOptimize(entries.front());
+            }
+            state.SetItemsProcessed(state.Iterations() * source.size());
+        });
+        MicroBench::Register("Quads/StdSort/65536", [makeEntries](MicroBench::State& state) {
+            const std::vector<DrawSortEntry> source = makeEntries();
+            std::vector<DrawSortEntry> entries;
+            for (auto _ : state) {
+                state.PauseTiming();
+                entries = source;
+                state.ResumeTiming();
+                std::sort(entries.begin(), entries.end(),
+                    [](const DrawSortEntry& a, const DrawSortEntry& b) { return a.key < b.key; });
+                MicroBench::DoNotOptimize(entries.front());
+            }
+            state.SetItemsProcessed(state.Iterations() * source.size());
+        });
+    }
+
+    // ==============================
+    // Text
+    // ==============================
+    const char* const SHORT_TEXT = u8"スコア 12345";
+    const char* const PARAGRAPH = u8"お客様が到着しました。空いている客室へ案内しましょう。"
+        u8"温泉や食事処を建てると、お客様の満足度が上がります。Press A to build a room, B to cancel.";
+
+    void RegisterTextBenchmarks(const std::shared_ptr<GlyphTable>& glyphs)
+    {
+        MicroBench::Register("Text/GlyphTable/Find/4096", [glyphs](MicroBench::State& state) {
+            // テーブルにある文字を 7 割、ない文字を 3 割
+            std::mt19937 rng(SEED);
+            std::vector<uint32_t> codepoints(4096);
+            const GlyphRecord* records = glyphs->GetGlyphs();
+            const uint32_t count = glyphs->GetGlyphCount();
+            for (uint32_t& cp : codepoints) {
+                cp = rng() % 10 < 7 && count > 0 ? records[rng() % count].codepoint : rng() % 0x10000;
+            }
+            for (auto _ : state) {
+                uint32_t found = 0;
+                for (uint32_t cp : codepoints) {
+                    found += glyphs->Find(cp) != nullptr;
+                }
+                MicroBench::DoNotOptimize(found);
+            }
+            state.SetItemsProcessed(state.Iterations() * codepoints.size());
+        });
+
+        struct Case
+        {
+            const char* name;
+            const char* text;
+            float wrap;
+        };
+        for (const Case& c : { Case{ "Short", SHORT_TEXT, 0.0f }, Case{ "Paragraph", PARAGRAPH, 640.0f } }) {
+            const std::string text = c.text;
+            const float wrap = c.wrap;
+            MicroBench::Register(std::string("Text/Layout/") + c.name, [glyphs, text, wrap](MicroBench::State& state) {
+                TextLayout layout;
+                for (auto _ : state) {
+                    TextLayoutCache::Layout(*glyphs, text, 28.0f, wrap, TextAlign::Left, layout);
+                    MicroBench::DoNotOptimize(layout.quads.data());
+                }
+                state.SetBytesProcessed(state.Iterations() * text.size());
+            });
+            MicroBench::Register(std::string("Text/LayoutCache/Hit/") + c.name, [glyphs, text, wrap](MicroBench::State& state) {
+                TextLayoutCache cache(*glyphs);
+                for (auto _ : state) {
+                    MicroBench::DoNotOptimize(cache.Get(text, 28.0f, wrap, TextAlign::Left).width);
+                }
+                state.SetBytesProcessed(state.Iterations() * text.size());
+            });
+        }
+    }
+
+    // ==============================
+    // Json
+    // ==============================
+    bool ReadFile(const std::string& path, std::string& out)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs) {
+            return false;
+        }
+        std::ostringstream ss;
+        ss << ifs.rdbuf();
+        out = ss.str();
+        return true;
+    }
+
+    void RegisterJsonBenchmark(const std::string& path)
+    {
+        auto text = std::make_shared<std::string>();
+        if (!ReadFile(path, *text) || json::parse(*text, nullptr, false).is_discarded()) {
+            std::fprintf(stderr, "skip Json/Parse: %s could not be read as JSON\n", path.c_str());
+            return;
+        }
+        const size_t slash = path.find_last_of("/\\");
+        const std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+        MicroBench::Register("Json/Parse/" + name, [text](MicroBench::State& state) {
+            for (auto _ : state) {
+                const json j = json::parse(*text, nullptr, false);
+                MicroBench::DoNotOptimize(j.size());
+            }
+            state.SetBytesProcessed(state.Iterations() * text->size());
+        });
+    }
+
+    // ==============================
+    // Input
+    // ==============================
+    void RegisterInputBenchmarks()
+    {
+        MicroBench::Register("Input/NormalizeThumb/4096", [](MicroBench::State& state) {
+            std::mt19937 rng(SEED);
+            std::vector<short> values(4096);
+            for (short& v : values) {
+                v = static_cast<short>(static_cast<int>(rng() % 65536) - 32768);
+            }
+            for (auto _ : state) {
+                float sum = 0.0f;
+                for (short v : values) {
+                    sum += GamepadAxis::NormalizeThumb(v, 7849); // XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE
+                }
+                MicroBench::DoNotOptimize(sum);
+            }
+            state.SetItemsProcessed(state.Iterations() * values.size());
+        });
+        MicroBench::Register("Input/NormalizeTrigger/4096", [](MicroBench::State& state) {
+            std::mt19937 rng(SEED);
+            std::vector<unsigned char> values(4096);
+            for (unsigned char& v : values) {
+                v = static_cast<unsigned char>(rng() % 256);
+            }
+            for (auto _ : state) {
+                float sum = 0.0f;
+                for (unsigned char v : values) {
+                    sum += GamepadAxis::NormalizeTrigger(v, 30); // XINPUT_GAMEPAD_TRIGGER_THRESHOLD
+                }
+                MicroBench::DoNotOptimize(sum);
+            }
+            state.SetItemsProcessed(state.Iterations() * values.size());
+        });
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // --data は自前で取り、残りを MicroBench に渡す
+    std::vector<std::string> dataFiles = { "rom/fonts/sdf_atlas.json", "rom/images/atlas/atlas.json" };
+    std::vector<char*> rest = { argv[0] };
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+            const std::string path = argv[++i];
+            if (std::find(dataFiles.begin(), dataFiles.end(), path) == dataFiles.end()) {
+                dataFiles.push_back(path);
+            }
+        }
+        else {
+            rest.push_back(argv[i]);
+        }
+    }
+
+    RegisterQuadBenchmarks();
+
+    auto glyphs = std::make_shared<GlyphTable>();
+    if (glyphs->Load("rom/fonts/sdf_atlas.glyphs")) {
+        RegisterTextBenchmarks(glyphs);
+    }
+    else {
+        std::fprintf(stderr, "skip Text: rom/fonts/sdf_atlas.glyphs could not be loaded\n");
+    }
+
+    for (const std::string& path : dataFiles) {
+        RegisterJsonBenchmark(path);
+    }
+    RegisterInputBenchmarks();
+
+    return MicroBench::RunAll(static_cast<int>(rest.size()), rest.data());
+}
@@ -0,0 +1,258 @@
+﻿/*****************************************************************//**
+ * @file   NavGridTest.cpp
+ * @brief  GridAStar の AStar / JumpPoint が同じコストの経路を返すかを確かめる（ヘッドレス）
+ *
+ * @details
+ * - 障害物の密度を変えたランダムなグリッドと、廊下と部屋のグリッドで、ランダムな start / goal の組を両方で解く
+ * - 見つかるかどうか・コストが一致すること、JumpPoint の経路もセル単位でつながっていて
+ *   一歩ごとのコストの合計が cost と同じであることを見る
+ * - 開けたグリッドでは JumpPoint の展開ノード数が大きく減ることも見る
+ * - 探索の合間にセルを書き換えても、JumpPoint のジャンプ表が作り直されて結果が合うことを見る
+ * - Begin / Resume で数ノードずつ刻んで進めても、FindPath と同じ経路・展開ノード数になることを見る
+ * - 失敗した項目があれば 1 を返す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/NavGridTest/NavGridTest.cpp common_src/System/NavGrid.cpp -o NavGridTest
+ *********************************************************************/
+#include "../../common_src/System/NavGrid.h"
+#include "../Common/TestCheck.h"
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    using TestCheck::Check;
+
+    // 外周を壁にして、内側を wallPercent % の確率で壁にする
+    NavGrid MakeRandomGrid(int width, int height, int wallPercent, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        NavGrid grid(width, height, false);
+        for (int y = 1; y < height - 1; ++y) {
+            for (int x = 1; x < width - 1; ++x) {
+                grid.SetWalkable(x, y, static_cast<int>(rng() % 100) >= wallPercent);
+            }
+        }
+        return grid;
+    }
+
+    // 14 マスおきの横の廊下と両端の縦の通路、廊下の上に扉 1 つの部屋を並べる（旅館の間取りに近い形）
+    NavGrid MakeCorridorGrid(int width, int height)
+    {
+        NavGrid grid(width, height, false);
+        for (int y = 6; y + 3 < height; y += 14) {
+            grid.FillRect(1, y, width - 2, 3, true);
+        }
+        grid.FillRect(1, 1, 3, height - 2, true);
+        grid.FillRect(width - 4, 1, 3, height - 2, true);
+        for (int y = 1; y + 8 < height; y += 14) { // 扉の下に廊下がある段だけ
+            for (int x = 6; x + 6 < width - 4; x += 7) {
+                grid.FillRect(x, y, 6, 4, true);
+                grid.SetWalkable(x + 2, y + 4, true);
+                grid.SetWalkable(x + 2, y + 5, true);
+            }
+        }
+        return grid;
+    }
+
+    GridPoint RandomWalkable(const NavGrid& grid, std::mt19937& rng)
+    {
+        for (;;) {
+            const GridPoint p{ static_cast<int>(rng() % grid.GetWidth()), static_cast<int>(rng() % grid.GetHeight()) };
+            if (grid.IsWalkable(p)) {
+                return p;
+            }
+        }
+    }
+
+    // 隣どうしのセルの列で、一歩ごとのコストの合計が cost と同じか
+    bool IsValidPath(const NavGrid& grid, const NavPath& path, const GridPoint& start, const GridPoint& goal)
+    {
+        if (path.points.empty() || path.points.front() != start || path.points.back() != goal) {
+            return false;
+        }
+        int cost = 0;
+        for (size_t i = 1; i < path.points.size(); ++i) {
+            const GridPoint& a = path.points[i - 1];
+            const GridPoint& b = path.points[i];
+            int direction = -1;
+            for (int d = 0; d < NavGrid::DIRECTION_COUNT; ++d) {
+                if (a.x + NavGrid::DX[d] == b.x && a.y + NavGrid::DY[d] == b.y) {
+                    direction = d;
+                }
+            }
+            if (direction < 0 || !grid.CanStep(a.x, a.y, direction)) {
+                return false;
+            }
+            cost += NavGrid::StepCost(direction);
+        }
+        return cost == path.cost;
+    }
+
+    struct Comparison
+    {
+        int solved = 0;
+        int unsolved = 0;
+        int costMismatches = 0;
+        int invalidPaths = 0;
+        uint64_t aStarExpanded = 0;
+        uint64_t jumpExpanded = 0;
+    };
+
+    Comparison Compare(const NavGrid& grid, int queries, uint32_t seed)
+    {
+        Comparison c;
+        GridAStar aStar(NavSearchMode::AStar);
+        GridAStar jump(NavSearchMode::JumpPoint);
+        NavPath aStarPath;
+        NavPath jumpPath;
+        std::mt19937 rng(seed);
+        for (int i = 0; i < queries; ++i) {
+            const GridPoint start = RandomWalkable(grid, rng);
+            const GridPoint goal = i % 50 == 0 ? start : RandomWalkable(grid, rng);
+            const bool aStarFound = aStar.FindPath(grid, start, goal, aStarPath);
+            const bool jumpFound = jump.FindPath(grid, start, goal, jumpPath);
+            c.aStarExpanded += aStar.GetLastStats().expanded;
+            c.jumpExpanded += jump.GetLastStats().expanded;
+            if (aStarFound != jumpFound) {
+                ++c.costMismatches;
+                continue;
+            }
+            if (!aStarFound) {
+                ++c.unsolved;
+                continue;
+            }
+            ++c.solved;
+            if (aStarPath.cost != jumpPath.cost) {
+                ++c.costMismatches;
+            }
+            if (!IsValidPath(grid, jumpPath, start, goal) || !IsValidPath(grid, aStarPath, start, goal)) {
+                ++c.invalidPaths;
+            }
+        }
+        std::printf("    %d solved, %d unreachable, expanded A* %llu / JPS %llu\n", c.solved, c.unsolved,
+            static_cast<unsigned long long>(c.aStarExpanded), static_cast<unsigned long long>(c.jumpExpanded));
+        return c;
+    }
+
+    void TestRandomGrids()
+    {
+        for (int wallPercent : { 0, 10, 25, 40 }) {
+            std::printf("random grid, %d%% walls\n", wallPercent);
+            const NavGrid grid = MakeRandomGrid(80, 60, wallPercent, 100 + wallPercent);
+            const Comparison c = Compare(grid, 1000, 3);
+            Check(c.solved > 0, "some queries are solvable");
+            Check(c.costMismatches == 0, "JumpPoint finds the same paths (existence and cost) as AStar");
+            Check(c.invalidPaths == 0, "both paths are connected cell by cell and their step costs add up");
+            if (wallPercent == 0) {
+                Check(c.jumpExpanded * 10 < c.aStarExpanded, "open grid: JumpPoint expands a tenth of the nodes or fewer");
+            }
+        }
+    }
+
+    void TestCorridors()
+    {
+        std::printf("corridors and rooms\n");
+        const NavGrid grid = MakeCorridorGrid(120, 64);
+        const Comparison c = Compare(grid, 1000, 5);
+        Check(c.solved > 900, "rooms and corridors are connected");
+        Check(c.costMismatches == 0, "JumpPoint finds the same paths (existence and cost) as AStar");
+        Check(c.invalidPaths == 0, "both paths are connected cell by cell and their step costs add up");
+        Check(c.jumpExpanded < c.aStarExpanded, "JumpPoint expands fewer nodes");
+    }
+
+    // 同じインスタンスでマップを書き換えながら解く（ジャンプ表の作り直し）
+    void TestEdits()
+    {
+        std::printf("edits between queries\n");
+        NavGrid grid = MakeRandomGrid(64, 48, 20, 9);
+        GridAStar aStar(NavSearchMode::AStar);
+        GridAStar jump(NavSearchMode::JumpPoint);
+        NavPath aStarPath;
+        NavPath jumpPath;
+        std::mt19937 rng(21);
+        int mismatches = 0;
+        for (int i = 0; i < 500; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                const int x = 1 + static_cast<int>(rng() % 62);
+                const int y = 1 + static_cast<int>(rng() % 46);
+                grid.SetWalkable(x, y, !grid.IsWalkable(x, y));
+            }
+            const GridPoint start = RandomWalkable(grid, rng);
+            const GridPoint goal = RandomWalkable(grid, rng);
+            const bool a = aStar.FindPath(grid, start, goal, aStarPath);
+            const bool j = jump.FindPath(grid, start, goal, jumpPath);
+            if (a != j || aStarPath.cost != jumpPath.cost || (j && !IsValidPath(grid, jumpPath, start, goal))) {
+                ++mismatches;
+            }
+        }
+        Check(mismatches == 0, "JumpPoint stays exact while cells are toggled between queries");
+    }
+
+    // 探索を刻んで進める（1 tick の持ち時間に合わせる用）
+    void TestSliced()
+    {
+        std::printf("sliced search\n");
+        const NavGrid grid = MakeCorridorGrid(120, 64);
+        std::mt19937 rng(17);
+        int mismatches = 0;
+        int sliced = 0;
+        for (NavSearchMode mode : { NavSearchMode::AStar, NavSearchMode::JumpPoint }) {
+            GridAStar whole(mode);
+            GridAStar steps(mode);
+            NavPath expected;
+            NavPath path;
+            for (int i = 0; i < 200; ++i) {
+                const GridPoint start = RandomWalkable(grid, rng);
+                const GridPoint goal = RandomWalkable(grid, rng);
+                const bool found = whole.FindPath(grid, start, goal, expected);
+                steps.Begin(grid, start, goal);
+                NavSearchStatus status = NavSearchStatus::Running;
+                int resumes = 0;
+                while (status == NavSearchStatus::Running) {
+                    status = steps.Resume(1 + static_cast<uint32_t>(rng() % 16), path);
+                    ++resumes;
+                }
+                sliced += resumes > 1 ? 1 : 0;
+                if ((status == NavSearchStatus::Found) != found || path.points != expected.points || path.cost != expected.cost
+                    || steps.GetLastStats().expanded != whole.GetLastStats().expanded) {
+                    ++mismatches;
+                }
+            }
+        }
+        Check(sliced > 300, "most searches take several slices");
+        Check(mismatches == 0, "sliced searches give the same path and node count as FindPath");
+    }
+
+    void TestEdgeCases()
+    {
+        std::printf("edge cases\n");
+        NavGrid grid(8, 8, true);
+        GridAStar jump(NavSearchMode::JumpPoint);
+        NavPath path;
+        Check(jump.FindPath(grid, GridPoint{ 3, 3 }, GridPoint{ 3, 3 }, path) && path.points.size() == 1 && path.cost == 0,
+            "start == goal gives a single point");
+        grid.FillRect(4, 0, 1, 8, false);
+        Check(!jump.FindPath(grid, GridPoint{ 0, 0 }, GridPoint{ 7, 7 }, path) && path.IsEmpty(), "a full wall is unreachable");
+        Check(!jump.FindPath(grid, GridPoint{ 4, 2 }, GridPoint{ 0, 0 }, path), "starting inside a wall fails");
+        // 角を切らない：斜めの隙間は通れない
+        NavGrid pinch(3, 3, true);
+        pinch.SetWalkable(1, 0, false);
+        pinch.SetWalkable(0, 1, false);
+        pinch.SetWalkable(2, 1, false);
+        pinch.SetWalkable(1, 2, false);
+        Check(!jump.FindPath(pinch, GridPoint{ 0, 0 }, GridPoint{ 1, 1 }, path), "no corner cutting through a diagonal gap");
+    }
+}
+
+int main()
+{
+    TestRandomGrids();
+    TestCorridors();
+    TestEdits();
+    TestSliced();
+    TestEdgeCases();
+
+    return TestCheck::Finish();
+}
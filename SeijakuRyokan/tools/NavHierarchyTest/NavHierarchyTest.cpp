@@ -0,0 +1,215 @@
+﻿/*****************************************************************//**
+ * @file   NavHierarchyTest.cpp
+ * @brief  NavHierarchy（HPA*）の経路と、書き換え後の部分的な作り直しを確かめる（ヘッドレス）
+ *
+ * @details
+ * - 廊下と部屋のグリッド・ランダムな障害物のグリッドで、到達できるかどうかが A* と一致し、
+ *   経路がセル単位でつながっていて、コストが最短以上・平均で最短の 1 割増し以内であることを見る
+ * - セルを書き換えるたびに Update した階層と、毎回作り直した階層で、
+ *   ノード数・辺の数・経路のコストが一致することを見る（部分的な作り直しで取りこぼしがないか）
+ * - 1 セルの書き換えで作り直すクラスタが近くの数個で済むことも見る
+ * - 失敗した項目があれば 1 を返す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/NavHierarchyTest/NavHierarchyTest.cpp \
+ *         common_src/System/NavHierarchy.cpp common_src/System/NavGrid.cpp -o NavHierarchyTest
+ *********************************************************************/
+#include "../../common_src/System/NavHierarchy.h"
+#include "../Common/TestCheck.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    using TestCheck::Check;
+
+    NavGrid MakeRandomGrid(int width, int height, int wallPercent, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        NavGrid grid(width, height, false);
+        for (int y = 1; y < height - 1; ++y) {
+            for (int x = 1; x < width - 1; ++x) {
+                grid.SetWalkable(x, y, static_cast<int>(rng() % 100) >= wallPercent);
+            }
+        }
+        return grid;
+    }
+
+    // 14 マスおきの横の廊下と両端の縦の通路、廊下の上に扉 1 つの部屋を並べる
+    NavGrid MakeCorridorGrid(int width, int height)
+    {
+        NavGrid grid(width, height, false);
+        for (int y = 6; y + 3 < height; y += 14) {
+            grid.FillRect(1, y, width - 2, 3, true);
+        }
+        grid.FillRect(1, 1, 3, height - 2, true);
+        grid.FillRect(width - 4, 1, 3, height - 2, true);
+        for (int y = 1; y + 8 < height; y += 14) {
+            for (int x = 6; x + 6 < width - 4; x += 7) {
+                grid.FillRect(x, y, 6, 4, true);
+                grid.SetWalkable(x + 2, y + 4, true);
+                grid.SetWalkable(x + 2, y + 5, true);
+            }
+        }
+        return grid;
+    }
+
+    GridPoint RandomWalkable(const NavGrid& grid, std::mt19937& rng)
+    {
+        for (;;) {
+            const GridPoint p{ static_cast<int>(rng() % grid.GetWidth()), static_cast<int>(rng() % grid.GetHeight()) };
+            if (grid.IsWalkable(p)) {
+                return p;
+            }
+        }
+    }
+
+    bool IsValidPath(const NavGrid& grid, const NavPath& path, const GridPoint& start, const GridPoint& goal)
+    {
+        if (path.points.empty() || path.points.front() != start || path.points.back() != goal) {
+            return false;
+        }
+        int cost = 0;
+        for (size_t i = 1; i < path.points.size(); ++i) {
+            const GridPoint& a = path.points[i - 1];
+            const GridPoint& b = path.points[i];
+            int direction = -1;
+            for (int d = 0; d < NavGrid::DIRECTION_COUNT; ++d) {
+                if (a.x + NavGrid::DX[d] == b.x && a.y + NavGrid::DY[d] == b.y) {
+                    direction = d;
+                }
+            }
+            if (direction < 0 || !grid.CanStep(a.x, a.y, direction)) {
+                return false;
+            }
+            cost += NavGrid::StepCost(direction);
+        }
+        return cost == path.cost;
+    }
+
+    void TestAgainstAStar(const NavGrid& grid, const char* title)
+    {
+        std::printf("%s\n", title);
+        NavHierarchy hierarchy;
+        hierarchy.Build(grid);
+        const NavHierarchyStats& stats = hierarchy.GetStats();
+        std::printf("    %zu clusters, %zu nodes, %zu edges, built in %.0f us\n",
+            stats.clusters, stats.nodes, stats.edges, stats.rebuildMicros);
+
+        GridAStar search(NavSearchMode::JumpPoint);
+        NavPath optimal;
+        NavPath path;
+        std::mt19937 rng(17);
+        int solved = 0;
+        int reachMismatches = 0;
+        int invalid = 0;
+        int shorter = 0;
+        double overhead = 0.0;
+        double worst = 0.0;
+        for (int i = 0; i < 600; ++i) {
+            const GridPoint start = RandomWalkable(grid, rng);
+            const GridPoint goal = RandomWalkable(grid, rng);
+            const bool expected = search.FindPath(grid, start, goal, optimal);
+            const bool found = hierarchy.FindPath(grid, start, goal, path);
+            if (expected != found) {
+                ++reachMismatches;
+                continue;
+            }
+            if (!found) {
+                continue;
+            }
+            ++solved;
+            invalid += IsValidPath(grid, path, start, goal) ? 0 : 1;
+            shorter += path.cost < optimal.cost ? 1 : 0;
+            const double ratio = optimal.cost > 0 ? static_cast<double>(path.cost) / optimal.cost - 1.0 : 0.0;
+            overhead += ratio;
+            worst = (std::max)(worst, ratio);
+        }
+        const double mean = solved > 0 ? overhead / solved : 0.0;
+        std::printf("    %d solved, mean %.2f%% / worst %.1f%% longer than optimal\n", solved, mean * 100.0, worst * 100.0);
+        Check(solved > 300, "most random pairs are solvable");
+        Check(reachMismatches == 0, "reachability matches A*");
+        Check(invalid == 0, "paths are connected cell by cell and their step costs add up");
+        Check(shorter == 0, "never shorter than the optimal path");
+        Check(mean < 0.10, "mean overhead under 10%");
+    }
+
+    // 書き換えのたびに Update したものと、作り直したものを比べる
+    void TestIncrementalUpdate()
+    {
+        std::printf("incremental update vs rebuild\n");
+        NavGrid grid = MakeCorridorGrid(120, 64);
+        NavHierarchy incremental;
+        incremental.Build(grid);
+        const double fullMicros = incremental.GetStats().rebuildMicros;
+
+        std::mt19937 rng(23);
+        int graphMismatches = 0;
+        int costMismatches = 0;
+        uint32_t maxClusters = 0;
+        double updateMicros = 0.0;
+        NavPath a;
+        NavPath b;
+        for (int edit = 0; edit < 300; ++edit) {
+            // 1 マス〜3x2 の矩形を壁にするか床にする（ついたて・廊下・看板の置き換えに相当）
+            const int w = 1 + static_cast<int>(rng() % 3);
+            const int h = 1 + static_cast<int>(rng() % 2);
+            const int x = 1 + static_cast<int>(rng() % (118 - w));
+            const int y = 1 + static_cast<int>(rng() % (62 - h));
+            grid.FillRect(x, y, w, h, rng() % 3 == 0);
+            incremental.Update(grid, x, y, w, h);
+            if (w * h == 1) {
+                maxClusters = (std::max)(maxClusters, incremental.GetStats().rebuiltClusters);
+            }
+            updateMicros += incremental.GetStats().rebuildMicros;
+
+            if (edit % 10 != 9) {
+                continue;
+            }
+            NavHierarchy fresh;
+            fresh.Build(grid);
+            if (fresh.GetStats().nodes != incremental.GetStats().nodes || fresh.GetStats().edges != incremental.GetStats().edges) {
+                ++graphMismatches;
+            }
+            for (int q = 0; q < 30; ++q) {
+                const GridPoint start = RandomWalkable(grid, rng);
+                const GridPoint goal = RandomWalkable(grid, rng);
+                const bool foundA = incremental.FindPath(grid, start, goal, a);
+                const bool foundB = fresh.FindPath(grid, start, goal, b);
+                if (foundA != foundB || a.cost != b.cost || (foundA && !IsValidPath(grid, a, start, goal))) {
+                    ++costMismatches;
+                }
+            }
+        }
+        std::printf("    full build %.0f us, mean update %.1f us, at most %u cluster(s) per single-cell edit\n",
+            fullMicros, updateMicros / 300, maxClusters);
+        Check(graphMismatches == 0, "updated graph has the same nodes and edges as a rebuild");
+        Check(costMismatches == 0, "updated graph answers queries like a rebuild");
+        Check(maxClusters <= 4, "a single-cell edit rebuilds at most the 4 clusters around it");
+    }
+
+    void TestStaleRevision()
+    {
+        std::printf("edit without Update\n");
+        NavGrid grid(64, 64, true);
+        NavHierarchy hierarchy;
+        hierarchy.Build(grid);
+        NavPath path;
+        Check(hierarchy.FindPath(grid, GridPoint{ 1, 1 }, GridPoint{ 60, 60 }, path), "open grid is solvable");
+        grid.FillRect(32, 0, 1, 64, false);
+        Check(!hierarchy.FindPath(grid, GridPoint{ 1, 1 }, GridPoint{ 60, 60 }, path),
+            "a wall added without Update is still seen (full rebuild on revision change)");
+    }
+}
+
+int main()
+{
+    TestAgainstAStar(MakeCorridorGrid(200, 120), "corridors and rooms 200x120");
+    TestAgainstAStar(MakeRandomGrid(160, 120, 20, 4), "random 20% walls 160x120");
+    TestIncrementalUpdate();
+    TestStaleRevision();
+
+    return TestCheck::Finish();
+}
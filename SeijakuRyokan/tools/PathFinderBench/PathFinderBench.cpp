@@ -0,0 +1,276 @@
+﻿/*****************************************************************//**
+ * @file   PathFinderBench.cpp
+ * @brief  GridAStar の AStar / JumpPoint と NavHierarchy（HPA*）を同じ問い合わせで比べる（展開ノード数と 1 回の時間）
+ *
+ * @details
+ * - 使い方（どこで実行してもよい）
+ *     PathFinderBench [--filter text] [--min-time sec] [--repetitions n] [--json out.json]
+ * - マップ
+ *   - Ryokan  : 負荷試験と同じ合成マップ（StressScenario::GenerateMap）。部屋の目的地どうしを結ぶ
+ *   - Open    : 外周だけ壁の大部屋。ランダムな 2 点
+ *   - Scatter : 2 割のセルをランダムに壁にしたもの。到達できるランダムな 2 点
+ * - 計測の前に、全部の問い合わせで AStar と JumpPoint のコストが一致するかを確かめて表にする（不一致があれば 1 を返す）。
+ *   HPA* は最短より何 % 長いかを同じ表に出す
+ * - Path/... は 1 反復 = 1 回の探索。label に 1 回あたりの展開ノード数とジャンプで見たセル数を出す。
+ *   HPA は抽象グラフだけ（Abstract）とセル単位まで詰めたもの（Refined）を分けて測る
+ * - Hierarchy/... は階層グラフの全体の構築と、1 セルの書き換え（ついたての設置・撤去に相当）後の Update
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -pthread -I. tools/PathFinderBench/PathFinderBench.cpp tools/Common/MicroBench.cpp \
+ *         headless_src/Stress/StressScenario.cpp common_src/System/NavGrid.cpp common_src/System/FlowField.cpp \
+ *         common_src/System/NavHierarchy.cpp common_src/System/PathRequestService.cpp \
+ *         common_src/System/FramePacer.cpp common_src/System/Profiler.cpp common_src/System/MemoryTracker.cpp \
+ *         common_src/System/FrameCounters.cpp -o PathFinderBench
+ *********************************************************************/
+#include "../Common/MicroBench.h"
+#include "../../headless_src/Stress/StressScenario.h"
+#include "../../common_src/System/NavHierarchy.h"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr int QUERY_COUNT = 256;
+    constexpr uint32_t SEED = 12345;
+
+    struct Scenario
+    {
+        std::string name;
+        NavGrid grid;
+        std::vector<std::pair<GridPoint, GridPoint>> queries;
+    };
+
+    GridPoint RandomWalkable(const NavGrid& grid, std::mt19937& rng)
+    {
+        for (;;) {
+            const GridPoint p{ static_cast<int>(rng() % grid.GetWidth()), static_cast<int>(rng() % grid.GetHeight()) };
+            if (grid.IsWalkable(p)) {
+                return p;
+            }
+        }
+    }
+
+    // 到達できる組だけを集める
+    void AddRandomQueries(Scenario& scenario, std::mt19937& rng)
+    {
+        GridAStar search;
+        NavPath path;
+        while (scenario.queries.size() < QUERY_COUNT) {
+            const GridPoint a = RandomWalkable(scenario.grid, rng);
+            const GridPoint b = RandomWalkable(scenario.grid, rng);
+            if (search.FindPath(scenario.grid, a, b, path)) {
+                scenario.queries.emplace_back(a, b);
+            }
+        }
+    }
+
+    Scenario MakeRyokan(int width, int height)
+    {
+        const StressMap map = StressScenario::GenerateMap(width, height, 1);
+        Scenario scenario;
+        scenario.name = "Ryokan/" + std::to_string(width) + "x" + std::to_string(height);
+        scenario.grid = map.grid;
+        std::mt19937 rng(SEED);
+        while (scenario.queries.size() < QUERY_COUNT) {
+            const StressRoom& from = map.rooms[rng() % map.rooms.size()];
+            const StressRoom& to = map.rooms[rng() % map.rooms.size()];
+            scenario.queries.emplace_back(from.spot, to.spot);
+        }
+        return scenario;
+    }
+
+    Scenario MakeOpen(int width, int height)
+    {
+        Scenario scenario;
+        scenario.name = "Open/" + std::to_string(width) + "x" + std::to_string(height);
+        scenario.grid.Resize(width, height, false);
+        scenario.grid.FillRect(1, 1, width - 2, height - 2, true);
+        std::mt19937 rng(SEED);
+        AddRandomQueries(scenario, rng);
+        return scenario;
+    }
+
+    Scenario MakeScatter(int width, int height)
+    {
+        Scenario scenario;
+        scenario.name = "Scatter/" + std::to_string(width) + "x" + std::to_string(height);
+        scenario.grid.Resize(width, height, false);
+        std::mt19937 rng(SEED);
+        for (int y = 1; y < height - 1; ++y) {
+            for (int x = 1; x < width - 1; ++x) {
+                scenario.grid.SetWalkable(x, y, rng() % 5 != 0);
+            }
+        }
+        AddRandomQueries(scenario, rng);
+        return scenario;
+    }
+
+    // 全部の問い合わせを両モードで解き、コストの一致と平均の展開ノード数を出す
+    int Verify(const std::vector<Scenario>& scenarios)
+    {
+        std::printf("%-18s %8s %12s %12s %14s %10s %12s %10s\n",
+            "map", "queries", "A* nodes/q", "JPS nodes/q", "JPS scanned/q", "mismatch", "HPA nodes/q", "HPA over");
+        int totalMismatches = 0;
+        for (const Scenario& scenario : scenarios) {
+            GridAStar aStar(NavSearchMode::AStar);
+            GridAStar jump(NavSearchMode::JumpPoint);
+            NavHierarchy hierarchy;
+            NavPath aStarPath;
+            NavPath jumpPath;
+            NavPath hierarchyPath;
+            uint64_t aStarNodes = 0;
+            uint64_t jumpNodes = 0;
+            uint64_t jumpScanned = 0;
+            uint64_t hierarchyNodes = 0;
+            double hierarchyOver = 0.0;
+            int mismatches = 0;
+            for (const auto& query : scenario.queries) {
+                const bool a = aStar.FindPath(scenario.grid, query.first, query.second, aStarPath);
+                const bool j = jump.FindPath(scenario.grid, query.first, query.second, jumpPath);
+                const bool h = hierarchy.FindPath(scenario.grid, query.first, query.second, hierarchyPath);
+                aStarNodes += aStar.GetLastStats().expanded;
+                jumpNodes += jump.GetLastStats().expanded;
+                jumpScanned += jump.GetLastStats().scanned;
+                hierarchyNodes += hierarchy.GetLastQueryStats().expanded;
+                if (a != j || aStarPath.cost != jumpPath.cost) {
+                    ++mismatches;
+                }
+                if (a && h && aStarPath.cost > 0) {
+                    hierarchyOver += static_cast<double>(hierarchyPath.cost) / aStarPath.cost - 1.0;
+                }
+            }
+            const double n = static_cast<double>(scenario.queries.size());
+            std::printf("%-18s %8zu %12.1f %12.1f %14.1f %10d %12.1f %9.2f%%\n", scenario.name.c_str(), scenario.queries.size(),
+                aStarNodes / n, jumpNodes / n, jumpScanned / n, mismatches, hierarchyNodes / n, hierarchyOver / n * 100.0);
+            totalMismatches += mismatches;
+        }
+        std::printf("\n");
+        return totalMismatches;
+    }
+
+    void RegisterHierarchy(const Scenario& scenario)
+    {
+        // 構築は探索の外でしておき、問い合わせだけを測る
+        static std::vector<std::unique_ptr<NavHierarchy>> hierarchies;
+        hierarchies.push_back(std::make_unique<NavHierarchy>());
+        NavHierarchy& hierarchy = *hierarchies.back();
+        hierarchy.Build(scenario.grid);
+
+        MicroBench::Register("Path/" + scenario.name + "/HPA-Abstract", [&scenario, &hierarchy](MicroBench::State& state) {
+            std::vector<GridPoint> waypoints;
+            int cost = 0;
+            uint64_t nodes = 0;
+            size_t next = 0;
+            for (auto _ : state) {
+                const auto& query = scenario.queries[next];
+                next = next + 1 < scenario.queries.size() ? next + 1 : 0;
+                hierarchy.FindAbstractPath(scenario.grid, query.first, query.second, waypoints, cost);
+                MicroBench::DoNotOptimize(cost);
+                nodes += hierarchy.GetLastQueryStats().expanded;
+            }
+            state.SetItemsProcessed(state.Iterations());
+            char label[64];
+            std::snprintf(label, sizeof(label), "nodes/query=%.1f", static_cast<double>(nodes) / state.Iterations());
+            state.SetLabel(label);
+        });
+        MicroBench::Register("Path/" + scenario.name + "/HPA-Refined", [&scenario, &hierarchy](MicroBench::State& state) {
+            NavPath path;
+            size_t next = 0;
+            for (auto _ : state) {
+                const auto& query = scenario.queries[next];
+                next = next + 1 < scenario.queries.size() ? next + 1 : 0;
+                hierarchy.FindPath(scenario.grid, query.first, query.second, path);
+                MicroBench::DoNotOptimize(path.cost);
+            }
+            state.SetItemsProcessed(state.Iterations());
+        });
+
+        MicroBench::Register("Hierarchy/" + scenario.name + "/Build", [&scenario](MicroBench::State& state) {
+            NavHierarchy built;
+            for (auto _ : state) {
+                built.Build(scenario.grid);
+            }
+            char label[64];
+            std::snprintf(label, sizeof(label), "nodes=%zu edges=%zu", built.GetStats().nodes, built.GetStats().edges);
+            state.SetLabel(label);
+        });
+        MicroBench::Register("Hierarchy/" + scenario.name + "/Edit", [&scenario](MicroBench::State& state) {
+            // 通れるセルを 1 つずつ壁にして、次の反復で戻す
+            NavGrid grid = scenario.grid;
+            NavHierarchy edited;
+            edited.Build(grid);
+            std::mt19937 rng(SEED);
+            GridPoint last{ -1, -1 };
+            uint64_t clusters = 0;
+            for (auto _ : state) {
+                if (last.x >= 0) {
+                    grid.SetWalkable(last.x, last.y, true);
+                    edited.Update(grid, last.x, last.y, 1, 1);
+                    clusters += edited.GetStats().rebuiltClusters;
+                    last = GridPoint{ -1, -1 };
+                }
+                else {
+                    last = RandomWalkable(grid, rng);
+                    grid.SetWalkable(last.x, last.y, false);
+                    edited.Update(grid, last.x, last.y, 1, 1);
+                    clusters += edited.GetStats().rebuiltClusters;
+                }
+            }
+            state.SetItemsProcessed(state.Iterations());
+            char label[64];
+            std::snprintf(label, sizeof(label), "clusters/edit=%.2f", static_cast<double>(clusters) / state.Iterations());
+            state.SetLabel(label);
+        });
+    }
+
+    void Register(const Scenario& scenario, NavSearchMode mode, const char* modeName)
+    {
+        MicroBench::Register("Path/" + scenario.name + "/" + modeName, [&scenario, mode](MicroBench::State& state) {
+            GridAStar search(mode);
+            NavPath path;
+            uint64_t nodes = 0;
+            uint64_t scanned = 0;
+            size_t next = 0;
+            for (auto _ : state) {
+                const auto& query = scenario.queries[next];
+                next = next + 1 < scenario.queries.size() ? next + 1 : 0;
+                search.FindPath(scenario.grid, query.first, query.second, path);
+                MicroBench::DoNotOptimize(path.cost);
+                nodes += search.GetLastStats().expanded;
+                scanned += search.GetLastStats().scanned;
+            }
+            const uint64_t queries = state.Iterations();
+            state.SetItemsProcessed(queries);
+            char label[96];
+            std::snprintf(label, sizeof(label), "nodes/query=%.1f scanned/query=%.1f",
+                static_cast<double>(nodes) / queries, static_cast<double>(scanned) / queries);
+            state.SetLabel(label);
+        });
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // Register は参照を持つので、計測が終わるまで消さない
+    static std::vector<Scenario> scenarios;
+    scenarios.push_back(MakeRyokan(128, 96));
+    scenarios.push_back(MakeRyokan(256, 192));
+    scenarios.push_back(MakeOpen(256, 192));
+    scenarios.push_back(MakeScatter(256, 192));
+
+    if (Verify(scenarios) > 0) {
+        std::fprintf(stderr, "AStar and JumpPoint disagree on path cost\n");
+        return 1;
+    }
+    for (const Scenario& scenario : scenarios) {
+        Register(scenario, NavSearchMode::AStar, "AStar");
+        Register(scenario, NavSearchMode::JumpPoint, "JPS");
+        RegisterHierarchy(scenario);
+    }
+    return MicroBench::RunAll(argc, argv);
+}
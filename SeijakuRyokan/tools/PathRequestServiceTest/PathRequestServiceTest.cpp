@@ -0,0 +1,296 @@
+﻿/*****************************************************************//**
+ * @file   PathRequestServiceTest.cpp
+ * @brief  PathRequestService の結果が、解き方（ワーカー数・持ち時間）によらず同じ tick に同じ内容で届くかを確かめる（ヘッドレス）
+ *
+ * @details
+ * - 到着の重なりを模した依頼の列を、メインスレッド（持ち時間 0 / 少し / たっぷり）とワーカー 1 / 4 本で流し、
+ *   届いた tick・見つかったか・経路が全部一致し、GridAStar で直接解いたコストと同じになること
+ * - 一度に大量に依頼しても 1 tick に届く数が上限を超えず、latencyTicks より早く届かないこと
+ * - メインスレッドで解くとき、長い探索が並んでいても 1 回の Update が持ち時間を大きく超えないこと
+ * - Submit の後にグリッドを書き換えても、その依頼は Submit の時点のグリッドで解かれること
+ * - Cancel した依頼は届かないこと
+ * - 仮の一歩が壁を抜けず、goal に近づくこと
+ * - 失敗した項目があれば 1 を返す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -pthread -I. tools/PathRequestServiceTest/PathRequestServiceTest.cpp \
+ *         common_src/System/PathRequestService.cpp common_src/System/NavGrid.cpp \
+ *         common_src/System/FramePacer.cpp common_src/System/Profiler.cpp common_src/System/MemoryTracker.cpp \
+ *         -o PathRequestServiceTest
+ *********************************************************************/
+#include "../../common_src/System/PathRequestService.h"
+#include "../Common/TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    using TestCheck::Check;
+
+    NavGrid MakeRandomGrid(int width, int height, int wallPercent, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        NavGrid grid(width, height, false);
+        for (int y = 1; y < height - 1; ++y) {
+            for (int x = 1; x < width - 1; ++x) {
+                grid.SetWalkable(x, y, static_cast<int>(rng() % 100) >= wallPercent);
+            }
+        }
+        return grid;
+    }
+
+    GridPoint RandomWalkable(const NavGrid& grid, std::mt19937& rng)
+    {
+        for (;;) {
+            const GridPoint p{ static_cast<int>(rng() % grid.GetWidth()), static_cast<int>(rng() % grid.GetHeight()) };
+            if (grid.IsWalkable(p)) {
+                return p;
+            }
+        }
+    }
+
+    struct Delivery
+    {
+        uint32_t tick;
+        PathResult result;
+    };
+
+    // 数 tick おきに 1〜40 件の依頼がまとめて来る列を流し、届いたものを順に返す
+    std::vector<Delivery> RunBursts(const NavGrid& grid, const PathServiceConfig& config, PathServiceStats& stats)
+    {
+        PathRequestService service(config);
+        std::mt19937 rng(99);
+        std::vector<Delivery> deliveries;
+        std::vector<PathResult> results;
+        for (uint32_t tick = 0; tick < 400; ++tick) {
+            if (tick < 300 && rng() % 6 == 0) {
+                const int count = 1 + static_cast<int>(rng() % 40);
+                for (int i = 0; i < count; ++i) {
+                    const GridPoint start = RandomWalkable(grid, rng);
+                    service.Submit(grid, start, RandomWalkable(grid, rng), tick);
+                }
+            }
+            service.Update(tick, results);
+            for (PathResult& result : results) {
+                deliveries.push_back(Delivery{ tick, std::move(result) });
+            }
+        }
+        stats = service.GetStats();
+        return deliveries;
+    }
+
+    bool SameDeliveries(const std::vector<Delivery>& a, const std::vector<Delivery>& b)
+    {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i) {
+            const PathResult& x = a[i].result;
+            const PathResult& y = b[i].result;
+            if (a[i].tick != b[i].tick || x.ticket != y.ticket || x.found != y.found || x.path.cost != y.path.cost
+                || x.path.points != y.path.points) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestDeterminism()
+    {
+        std::printf("same deliveries regardless of workers / budget\n");
+        const NavGrid grid = MakeRandomGrid(160, 120, 25, 5);
+
+        PathServiceConfig config;
+        config.budgetMs = 0.0; // 先には解かず、全部届ける tick に解く
+        PathServiceStats stats;
+        const std::vector<Delivery> reference = RunBursts(grid, config, stats);
+        std::printf("    %zu delivered, max delay %u tick(s), %llu forced\n", reference.size(), stats.maxDelayTicks,
+            static_cast<unsigned long long>(stats.forced));
+        Check(reference.size() > 1000 && stats.delivered == stats.submitted, "every request is delivered");
+        Check(stats.forced == stats.delivered, "budget 0 solves everything on its delivery tick");
+
+        // 直接解いた結果と比べる（依頼の列は RunBursts と同じ乱数で作り直す）
+        GridAStar search(NavSearchMode::JumpPoint);
+        NavPath expected;
+        std::mt19937 rng(99);
+        size_t index = 0;
+        int mismatches = 0;
+        for (uint32_t tick = 0; tick < 300; ++tick) {
+            if (rng() % 6 != 0) {
+                continue;
+            }
+            const int count = 1 + static_cast<int>(rng() % 40);
+            for (int i = 0; i < count; ++i, ++index) {
+                const GridPoint start = RandomWalkable(grid, rng);
+                const GridPoint goal = RandomWalkable(grid, rng);
+                const bool found = search.FindPath(grid, start, goal, expected);
+                if (index >= reference.size()) {
+                    ++mismatches;
+                    continue;
+                }
+                const PathResult& r = reference[index].result;
+                if (r.found != found || (found && (r.path.cost != expected.cost || r.path.points.front() != start
+                    || r.path.points.back() != goal)) || reference[index].tick < tick + config.latencyTicks) {
+                    ++mismatches;
+                }
+            }
+        }
+        Check(mismatches == 0 && index == reference.size(), "results match GridAStar and never arrive early");
+
+        const struct
+        {
+            const char* name;
+            unsigned workers;
+            double budgetMs;
+        } variants[] = {
+            { "main thread, 0.05 ms budget", 0, 0.05 },
+            { "main thread, 100 ms budget", 0, 100.0 },
+            { "1 worker", 1, 0.0 },
+            { "4 workers", 4, 0.0 },
+        };
+        for (const auto& variant : variants) {
+            PathServiceConfig c = config;
+            c.workerCount = variant.workers;
+            c.budgetMs = variant.budgetMs;
+            const std::vector<Delivery> deliveries = RunBursts(grid, c, stats);
+            std::printf("    %-28s %llu solved ahead, %llu forced\n", variant.name,
+                static_cast<unsigned long long>(stats.solvedAhead), static_cast<unsigned long long>(stats.forced));
+            Check(SameDeliveries(reference, deliveries), variant.name);
+        }
+    }
+
+    void TestDeliveryLimit()
+    {
+        std::printf("burst spread over ticks\n");
+        const NavGrid grid = MakeRandomGrid(64, 48, 10, 8);
+        PathServiceConfig config;
+        config.latencyTicks = 3;
+        config.deliveriesPerTick = 8;
+        PathRequestService service(config);
+        std::mt19937 rng(3);
+        std::vector<PathTicket> tickets;
+        for (int i = 0; i < 100; ++i) {
+            tickets.push_back(service.Submit(grid, RandomWalkable(grid, rng), RandomWalkable(grid, rng), 10));
+        }
+        // 後から来た依頼は、前の依頼より先には届かない
+        const PathTicket late = service.Submit(grid, RandomWalkable(grid, rng), RandomWalkable(grid, rng), 12);
+        Check(service.GetDeliveryTick(tickets.front()) == 13 && service.GetDeliveryTick(tickets.back()) == 25,
+            "100 requests are spread over 13 ticks of 8");
+        Check(service.GetDeliveryTick(late) == 25, "a later request queues behind the burst");
+
+        std::vector<PathResult> results;
+        size_t maxPerTick = 0;
+        size_t total = 0;
+        bool ordered = true;
+        PathTicket last = 0;
+        for (uint32_t tick = 10; tick < 30; ++tick) {
+            service.Update(tick, results);
+            if (tick < 13 && !results.empty()) {
+                ordered = false;
+            }
+            for (const PathResult& r : results) {
+                ordered = ordered && r.ticket > last;
+                last = r.ticket;
+            }
+            maxPerTick = (std::max)(maxPerTick, results.size());
+            total += results.size();
+        }
+        Check(total == 101 && maxPerTick <= 8, "never more than 8 per tick");
+        Check(ordered, "delivered in ticket order, not before the latency");
+    }
+
+    void TestBudget()
+    {
+        std::printf("main thread budget\n");
+        const NavGrid grid = MakeRandomGrid(256, 192, 30, 12);
+        PathServiceConfig config;
+        config.mode = NavSearchMode::AStar; // 1 本が長い方で試す
+        config.budgetMs = 0.25;
+        config.latencyTicks = 60;
+        config.deliveriesPerTick = 1000;
+        PathRequestService service(config);
+        std::mt19937 rng(4);
+        for (int i = 0; i < 200; ++i) {
+            // 端から端への長い探索
+            const GridPoint start = RandomWalkable(grid, rng);
+            const GridPoint goal{ grid.GetWidth() - 1 - start.x, grid.GetHeight() - 1 - start.y };
+            service.Submit(grid, start, grid.IsWalkable(goal) ? goal : RandomWalkable(grid, rng), 0);
+        }
+        std::vector<PathResult> results;
+        double maxMs = 0.0;
+        for (uint32_t tick = 1; tick < config.latencyTicks; ++tick) {
+            const auto start = std::chrono::steady_clock::now();
+            service.Update(tick, results);
+            maxMs = (std::max)(maxMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        service.Update(config.latencyTicks, results);
+        const PathServiceStats& stats = service.GetStats();
+        std::printf("    slowest Update %.3f ms (budget %.2f ms), %llu solved ahead, %llu expanded\n", maxMs, config.budgetMs,
+            static_cast<unsigned long long>(stats.solvedAhead), static_cast<unsigned long long>(stats.expanded));
+        Check(results.size() == 200, "everything arrives on the delivery tick");
+        Check(stats.solvedAhead > 0, "some requests are solved ahead within the budget");
+        Check(maxMs < config.budgetMs + 1.0, "each Update stays near the budget even with long searches");
+    }
+
+    void TestSnapshot()
+    {
+        std::printf("grid snapshot and cancel\n");
+        NavGrid grid(20, 5, true);
+        PathServiceConfig config;
+        config.latencyTicks = 2;
+        PathRequestService service(config);
+        const uint32_t revision = grid.GetRevision();
+        const PathTicket open = service.Submit(grid, GridPoint{ 0, 2 }, GridPoint{ 19, 2 }, 0);
+        const PathTicket cancelled = service.Submit(grid, GridPoint{ 0, 0 }, GridPoint{ 19, 4 }, 0);
+        grid.FillRect(10, 0, 1, 5, false); // 壁で分断する
+        const PathTicket blocked = service.Submit(grid, GridPoint{ 0, 2 }, GridPoint{ 19, 2 }, 0);
+        service.Cancel(cancelled);
+
+        std::vector<PathResult> results;
+        service.Update(1, results);
+        Check(results.empty(), "nothing arrives before latencyTicks");
+        service.Update(2, results);
+        Check(results.size() == 2 && results[0].ticket == open && results[1].ticket == blocked, "cancelled request is not delivered");
+        if (results.size() == 2) {
+            Check(results[0].found && results[0].path.cost == 190 && results[0].revision == revision,
+                "request submitted before the edit is solved on the old grid");
+            Check(!results[1].found && results[1].revision == grid.GetRevision(), "request after the edit sees the wall");
+        }
+        Check(service.GetPendingCount() == 0 && service.GetStats().cancelled == 1, "nothing left pending");
+    }
+
+    void TestProvisionalStep()
+    {
+        std::printf("provisional step\n");
+        NavGrid grid(9, 9, true);
+        grid.FillRect(4, 0, 1, 8, false); // 下だけ開いた壁
+        const GridPoint goal{ 8, 0 };
+        GridPoint p{ 0, 0 };
+        bool throughWall = false;
+        for (int i = 0; i < 10; ++i) {
+            const GridPoint next = PathRequestService::GetProvisionalStep(grid, p, goal);
+            throughWall = throughWall || !grid.IsWalkable(next);
+            p = next;
+        }
+        Check(!throughWall, "never steps into a wall");
+        Check(p == GridPoint{ 3, 0 }, "walks toward the goal and stops at the wall");
+
+        const GridPoint open = PathRequestService::GetProvisionalStep(grid, GridPoint{ 5, 5 }, goal);
+        Check(open == GridPoint{ 6, 4 }, "takes the diagonal when it is open");
+        Check(PathRequestService::GetProvisionalStep(grid, goal, goal) == goal, "stays on the goal");
+    }
+}
+
+int main()
+{
+    TestDeterminism();
+    TestDeliveryLimit();
+    TestBudget();
+    TestSnapshot();
+    TestProvisionalStep();
+
+    return TestCheck::Finish();
+}
@@ -0,0 +1,535 @@
+﻿/*****************************************************************//**
+ * @file   RenderThreadTest.cpp
+ * @brief  ThreadedGraphics / TripleBuffer の受け渡しを確かめる（ヘッドレス）
+ *
+ * @details
+ * - 描かずに中身を確かめるだけのバックエンドを描画スレッド側に置き、ゲーム側から
+ *   フレームごとに本数・テクスチャ・SDF の違う RenderList を流す
+ *   - 各 Quad にフレーム番号と本数を埋め込み、描画スレッドで「途中で混ざっていない」
+ *     「フレーム番号が増える一方」「SDF の切り替えが記録どおり」を確かめる
+ *   - UnloadTexture したハンドルが、それを使うフレームを描き終える前に壊されないこと
+ * - IGraphicsExtensions を実装したバックエンドで
+ *   - SetDrawLayer / SetLayerSortMode が DrawQuad ごとに記録どおり流し直されること
+ *   - 描画スレッドの FrameCounters が、描いたその RenderList のフレームとして確定すること
+ *   - 描画スレッドが重いフレームを描いている間も LoadTexture が待たされないこと
+ *   - LoadTextureAsync / GetTextureState / WaitForTextures がバックエンドに届くこと
+ * - Update / 描画にそれぞれ重さを持たせ、直列より速く回る（並行している）ことも見る
+ * - 失敗した項目があれば 1 を返す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -pthread -I. tools/RenderThreadTest/RenderThreadTest.cpp \
+ *         common_src/Graphics/ThreadedGraphics.cpp common_src/System/FrameArena.cpp \
+ *         common_src/System/FrameCounters.cpp common_src/System/MemoryTracker.cpp \
+ *         common_src/System/Profiler.cpp -o RenderThreadTest
+ *********************************************************************/
+#include "../../common_src/Graphics/ThreadedGraphics.h"
+#include "../Common/TestCheck.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using TestCheck::Check;
+
+    void BusyFor(std::chrono::microseconds duration)
+    {
+        const auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end) {
+        }
+    }
+
+    // 描画スレッドから呼ばれ、受け取った内容を確かめるバックエンド
+    class CheckingBackend : public IGraphics
+    {
+    public:
+        struct Texture
+        {
+            int id = 0;
+            std::atomic<bool> alive{ true };
+            uint64_t lastFrameUsed = 0;
+        };
+
+        std::chrono::microseconds drawCost{ 0 };
+
+        bool Initialize(void*, int, int) override { return true; }
+        void Finalize() override {}
+
+        void BeginDraw() override
+        {
+            m_inFrame = true;
+            m_frameId = 0;
+            m_quads = 0;
+            m_sdf = false;
+        }
+
+        void EndDraw() override
+        {
+            if (m_quads > 0) {
+                if (m_frameId <= m_lastFrame) ++m_outOfOrder;
+                if (m_quads != m_expectedQuads) ++m_torn;
+                m_lastFrame = m_frameId;
+            }
+            ++m_frames;
+            m_inFrame = false;
+            BusyFor(drawCost);
+        }
+
+        TextureHandle LoadTexture(const char*) override
+        {
+            m_textures.push_back(std::make_unique<Texture>());
+            m_textures.back()->id = static_cast<int>(m_textures.size());
+            return m_textures.back().get();
+        }
+
+        void UnloadTexture(TextureHandle handle) override
+        {
+            Texture* tex = static_cast<Texture*>(handle);
+            // ゲーム側が Unload を呼んだフレーム（unloadFrame）を描き終えていないのに壊された
+            if (m_lastFrame < unloadFrame.load()) ++m_earlyUnloads;
+            tex->alive = false;
+        }
+
+        void DrawQuad(const Quad& q) override
+        {
+            // position.x = フレーム番号、position.y = そのフレームの本数、size.x = 1 なら SDF
+            const uint64_t frame = static_cast<uint64_t>(q.position.x);
+            if (m_quads == 0) {
+                m_frameId = frame;
+                m_expectedQuads = static_cast<uint32_t>(q.position.y);
+            }
+            else if (frame != m_frameId) {
+                ++m_torn;
+            }
+            if ((q.size.x == 1.0f) != m_sdf) ++m_sdfMismatch;
+            Texture* tex = static_cast<Texture*>(q.texture);
+            if (tex && !tex->alive) ++m_useAfterUnload;
+            if (tex) tex->lastFrameUsed = frame;
+            ++m_quads;
+        }
+
+        void SetSdfMode(bool enable) override { m_sdf = enable; }
+
+        std::atomic<uint64_t> unloadFrame{ 0 };
+
+        uint64_t m_frames = 0;
+        uint64_t m_torn = 0;
+        uint64_t m_outOfOrder = 0;
+        uint64_t m_sdfMismatch = 0;
+        uint64_t m_useAfterUnload = 0;
+        uint64_t m_earlyUnloads = 0;
+        uint64_t m_lastFrame = 0;
+
+    private:
+        bool m_inFrame = false;
+        bool m_sdf = false;
+        uint64_t m_frameId = 0;
+        uint32_t m_quads = 0;
+        uint32_t m_expectedQuads = 0;
+        std::vector<std::unique_ptr<Texture>> m_textures;
+    };
+
+    // レイヤ・非同期読み込みも受け付けるバックエンド（描画スレッドから呼ばれる）
+    // position.x = 期待するレイヤ、position.y = 期待する並べ方（0 = Ordered, 1 = ByState）
+    class ExtensionBackend : public IGraphics, public IGraphicsExtensions
+    {
+    public:
+        std::chrono::microseconds drawCost{ 0 };
+
+        bool Initialize(void*, int, int) override { return true; }
+        void Finalize() override {}
+
+        void BeginDraw() override
+        {
+            ++m_beginDraws;
+            m_frameQuads = 0;
+            // 非同期読み込みは BeginDraw を 3 回経ると終わる（DirectXGraphics の GPU 作成の代わり）
+            for (auto& entry : m_async) {
+                if (entry.second == TextureLoadState::Pending && m_beginDraws >= m_readyAt[entry.first]) {
+                    entry.second = TextureLoadState::Ready;
+                }
+            }
+        }
+
+        void EndDraw() override
+        {
+            FrameCounters::Add(FrameCounter::Quads, m_frameQuads);
+            BusyFor(drawCost);
+        }
+
+        TextureHandle LoadTexture(const char* path) override
+        {
+            m_loadThread = std::this_thread::get_id();
+            if (std::strcmp(path, "missing.png") == 0) {
+                return nullptr;
+            }
+            m_textures.push_back(std::make_unique<int>(0));
+            return m_textures.back().get();
+        }
+
+        void UnloadTexture(TextureHandle) override {}
+
+        void DrawQuad(const Quad& q) override
+        {
+            if (static_cast<int>(q.position.x) != m_layer) ++m_layerMismatch;
+            const int mode = m_modes[m_layer] == LayerSortMode::ByState ? 1 : 0;
+            if (static_cast<int>(q.position.y) != mode) ++m_modeMismatch;
+            if (!q.texture) ++m_nullTextures;
+            ++m_frameQuads;
+            ++m_quads;
+        }
+
+        void SetSdfMode(bool) override {}
+
+        void SetDrawLayer(uint8_t layer) override { m_layer = layer; }
+        void SetLayerSortMode(uint8_t layer, LayerSortMode mode) override { m_modes[layer] = mode; }
+
+        TextureHandle LoadTextureAsync(const char*) override
+        {
+            m_textures.push_back(std::make_unique<int>(0));
+            TextureHandle handle = m_textures.back().get();
+            m_async[handle] = TextureLoadState::Pending;
+            m_readyAt[handle] = m_beginDraws + 3;
+            ++m_asyncLoads;
+            return handle;
+        }
+
+        TextureLoadState GetTextureState(TextureHandle handle) const override
+        {
+            auto it = m_async.find(handle);
+            if (it != m_async.end()) {
+                return it->second;
+            }
+            return handle ? TextureLoadState::Ready : TextureLoadState::Failed;
+        }
+
+        void WaitForTextures() override
+        {
+            for (auto& entry : m_async) {
+                entry.second = TextureLoadState::Ready;
+            }
+            m_waitThread = std::this_thread::get_id();
+            ++m_waitCalls;
+        }
+
+        uint64_t m_quads = 0;
+        uint64_t m_layerMismatch = 0;
+        uint64_t m_modeMismatch = 0;
+        uint64_t m_nullTextures = 0;
+        uint64_t m_asyncLoads = 0;
+        uint64_t m_waitCalls = 0;
+        std::thread::id m_loadThread;
+        std::thread::id m_waitThread;
+
+    private:
+        int m_layer = 0;
+        LayerSortMode m_modes[DrawCommandBuffer::LAYER_COUNT] = {};
+        uint64_t m_beginDraws = 0;
+        uint64_t m_frameQuads = 0;
+        std::unordered_map<TextureHandle, TextureLoadState> m_async;
+        std::unordered_map<TextureHandle, uint64_t> m_readyAt;
+        std::vector<std::unique_ptr<int>> m_textures;
+    };
+
+    void DrawFrame(IGraphics& g, uint64_t frame, const std::vector<TextureHandle>& textures)
+    {
+        const uint32_t count = 1 + static_cast<uint32_t>(frame * 7 % 400);
+        g.BeginDraw();
+        for (uint32_t i = 0; i < count; ++i) {
+            const bool sdf = (i / 16) % 2 == 1;
+            g.SetSdfMode(sdf);
+            Quad q;
+            q.texture = textures[(frame + i) % textures.size()];
+            q.position = { static_cast<float>(frame), static_cast<float>(count) };
+            q.size = { sdf ? 1.0f : 0.0f, 0.0f };
+            g.DrawQuad(q);
+        }
+        g.SetSdfMode(false);
+        g.EndDraw();
+    }
+
+    void TestHandoff()
+    {
+        std::printf("handoff integrity (5000 frames, render thread slower than update)\n");
+        CheckingBackend backend;
+        backend.drawCost = std::chrono::microseconds(150);
+        ThreadedGraphics graphics(backend);
+        graphics.Initialize(nullptr, 1920, 1080);
+
+        std::vector<TextureHandle> textures;
+        for (int i = 0; i < 4; ++i) {
+            textures.push_back(graphics.LoadTexture("dummy.png"));
+        }
+        for (uint64_t frame = 1; frame <= 5000; ++frame) {
+            DrawFrame(graphics, frame, textures);
+            BusyFor(std::chrono::microseconds(50));
+        }
+        graphics.Flush();
+        const ThreadedGraphicsStats stats = graphics.GetStats();
+        graphics.Finalize();
+
+        std::printf("  published %llu, rendered %llu (skipped %llu)\n",
+            static_cast<unsigned long long>(stats.published), static_cast<unsigned long long>(stats.rendered),
+            static_cast<unsigned long long>(stats.published - stats.rendered));
+        Check(backend.m_torn == 0, "every rendered list is one complete frame");
+        Check(backend.m_outOfOrder == 0, "frame numbers only increase");
+        Check(backend.m_sdfMismatch == 0, "SDF state matches what was recorded");
+        Check(backend.m_lastFrame == 5000, "the last published frame is rendered");
+        Check(stats.rendered <= stats.published && stats.rendered > 0, "stale lists are skipped, not queued");
+    }
+
+    void TestDeferredUnload()
+    {
+        std::printf("deferred UnloadTexture\n");
+        CheckingBackend backend;
+        backend.drawCost = std::chrono::microseconds(300);
+        ThreadedGraphics graphics(backend);
+        graphics.Initialize(nullptr, 1920, 1080);
+
+        std::vector<TextureHandle> textures;
+        for (int i = 0; i < 8; ++i) {
+            textures.push_back(graphics.LoadTexture("dummy.png"));
+        }
+        uint64_t frame = 0;
+        for (int round = 0; round < 200; ++round) {
+            ++frame;
+            DrawFrame(graphics, frame, textures);
+
+            // 今描いたフレームで使ったテクスチャを 1 枚捨てて作り直す
+            const size_t slot = static_cast<size_t>(round) % textures.size();
+            backend.unloadFrame = frame;
+            graphics.UnloadTexture(textures[slot]);
+            textures[slot] = graphics.LoadTexture("dummy.png");
+        }
+        const uint64_t deferred = graphics.GetStats().deferredUnloads;
+        graphics.Finalize();
+
+        Check(deferred == 200, "all unloads were deferred while the render thread ran");
+        Check(backend.m_useAfterUnload == 0, "no quad used a texture after it was unloaded");
+        Check(backend.m_earlyUnloads == 0, "no texture was unloaded before its last frame was rendered");
+    }
+
+    void TestLayers()
+    {
+        std::printf("layers and sort modes replayed on the render thread\n");
+        ExtensionBackend backend;
+        ThreadedGraphics graphics(backend);
+        graphics.Initialize(nullptr, 1920, 1080);
+
+        // Game は IGraphics* しか持たないので、そこから拡張を取り出せること
+        IGraphics* base = &graphics;
+        IGraphicsExtensions* extensions = dynamic_cast<IGraphicsExtensions*>(base);
+        Check(extensions != nullptr, "ThreadedGraphics exposes IGraphicsExtensions");
+        if (!extensions) {
+            graphics.Finalize();
+            return;
+        }
+
+        extensions->SetLayerSortMode(3, LayerSortMode::ByState);
+        for (int frame = 1; frame <= 50; ++frame) {
+            graphics.BeginDraw();
+            if (frame == 25) {
+                extensions->SetLayerSortMode(3, LayerSortMode::Ordered);
+            }
+            for (int i = 0; i < 20; ++i) {
+                const int layer = (i % 3 == 0) ? 1 : 3;
+                extensions->SetDrawLayer(static_cast<uint8_t>(layer));
+                Quad q;
+                q.position = { static_cast<float>(layer), (layer == 3 && frame < 25) ? 1.0f : 0.0f };
+                graphics.DrawQuad(q);
+            }
+            graphics.EndDraw();
+            graphics.Flush();
+        }
+        graphics.Finalize();
+
+        Check(backend.m_quads == 50 * 20, "every quad reached the backend");
+        Check(backend.m_layerMismatch == 0, "each quad is drawn in the layer it was recorded in");
+        Check(backend.m_modeMismatch == 0, "each quad is drawn with the sort mode its layer had when recorded");
+    }
+
+    void TestCounters()
+    {
+        std::printf("frame counters attributed per RenderList (render thread slower than update)\n");
+        FrameCounters::Reset();
+        ExtensionBackend backend;
+        backend.drawCost = std::chrono::microseconds(300);
+        ThreadedGraphics graphics(backend);
+        graphics.Initialize(nullptr, 1920, 1080);
+
+        constexpr uint64_t FRAMES = 200; // 全部描かれても FrameCounters の履歴に収まる数
+        uint64_t guestsTotal = 0;
+        for (uint64_t frame = 1; frame <= FRAMES; ++frame) {
+            FrameCounters::Add(FrameCounter::GuestsUpdated, frame);
+            guestsTotal += frame;
+            graphics.BeginDraw();
+            const uint64_t count = 1 + frame * 7 % 50;
+            for (uint64_t i = 0; i < count; ++i) {
+                graphics.DrawQuad(Quad());
+            }
+            graphics.EndDraw();
+            BusyFor(std::chrono::microseconds(100));
+        }
+        graphics.Flush();
+        const ThreadedGraphicsStats stats = graphics.GetStats();
+        graphics.Finalize();
+
+        const uint64_t committed = FrameCounters::GetCommittedCount();
+        uint64_t wrongFrame = 0;
+        uint64_t guests = 0;
+        FrameCounters::Snapshot snapshot;
+        for (uint64_t i = 0; i < committed; ++i) {
+            if (!FrameCounters::GetCommitted(i, snapshot)) {
+                ++wrongFrame;
+                continue;
+            }
+            if (snapshot[FrameCounter::Quads] != 1 + snapshot.frame * 7 % 50) ++wrongFrame;
+            guests += snapshot[FrameCounter::GuestsUpdated];
+        }
+        std::printf("  rendered %llu of %llu, committed %llu\n", static_cast<unsigned long long>(stats.rendered),
+            static_cast<unsigned long long>(stats.published), static_cast<unsigned long long>(committed));
+        Check(committed == stats.rendered, "one committed frame per rendered list");
+        Check(wrongFrame == 0, "render-thread counts land in the frame that was drawn");
+        Check(guests == guestsTotal, "game-side counts of skipped lists carry into the next drawn frame");
+        FrameCounters::Reset();
+    }
+
+    void TestLoadDuringSubmit()
+    {
+        std::printf("LoadTexture while the render thread draws a slow frame\n");
+        ExtensionBackend backend;
+        ThreadedGraphics graphics(backend);
+        graphics.Initialize(nullptr, 1920, 1080);
+
+        backend.drawCost = std::chrono::microseconds(30000);
+        graphics.BeginDraw();
+        graphics.DrawQuad(Quad());
+        graphics.EndDraw();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2)); // 描画スレッドを Submit に入らせる
+
+        const auto start = std::chrono::steady_clock::now();
+        const TextureHandle loaded = graphics.LoadTexture("a.png");
+        const TextureHandle missing = graphics.LoadTexture("missing.png");
+        const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        graphics.WaitForTextures();
+        const TextureLoadState loadedState = graphics.GetTextureState(loaded);
+        const TextureLoadState missingState = graphics.GetTextureState(missing);
+        graphics.Flush();
+        const uint64_t nullBefore = backend.m_nullTextures; // 1 フレーム目はテクスチャ無しで描いた
+
+        backend.drawCost = std::chrono::microseconds(0);
+        graphics.BeginDraw();
+        Quad q;
+        q.texture = loaded;
+        graphics.DrawQuad(q);
+        q.texture = missing;
+        graphics.DrawQuad(q);
+        graphics.EndDraw();
+        graphics.Flush();
+        graphics.UnloadTexture(loaded);
+        graphics.UnloadTexture(missing);
+        graphics.Finalize();
+
+        std::printf("  two LoadTexture calls took %.3f ms during a 30 ms frame\n", loadMs);
+        Check(loadMs < 5.0, "LoadTexture does not wait for the frame being drawn");
+        Check(backend.m_loadThread != std::this_thread::get_id(), "the backend load runs on the render thread");
+        Check(loadedState == TextureLoadState::Ready, "a loaded texture becomes Ready");
+        Check(missingState == TextureLoadState::Failed, "a failed load reports Failed");
+        Check(backend.m_nullTextures - nullBefore == 1, "a failed load is drawn with the default texture");
+    }
+
+    void TestAsyncLoad()
+    {
+        std::printf("LoadTextureAsync / GetTextureState / WaitForTextures forwarding\n");
+        ExtensionBackend backend;
+        ThreadedGraphics graphics(backend);
+        graphics.Initialize(nullptr, 1920, 1080);
+
+        const TextureHandle first = graphics.LoadTextureAsync("first.png");
+        const TextureLoadState initial = graphics.GetTextureState(first);
+        for (int frame = 0; frame < 5; ++frame) {
+            graphics.BeginDraw();
+            Quad q;
+            q.texture = first;
+            graphics.DrawQuad(q);
+            graphics.EndDraw();
+            graphics.Flush();
+        }
+        const TextureLoadState afterFrames = graphics.GetTextureState(first);
+
+        const TextureHandle second = graphics.LoadTextureAsync("second.png");
+        graphics.WaitForTextures();
+        const TextureLoadState afterWait = graphics.GetTextureState(second);
+        graphics.Finalize();
+
+        Check(initial == TextureLoadState::Pending, "an async load starts Pending");
+        Check(afterFrames == TextureLoadState::Ready, "the state follows the backend as frames are drawn");
+        Check(backend.m_asyncLoads == 2, "LoadTextureAsync reaches the backend's async path");
+        Check(afterWait == TextureLoadState::Ready && backend.m_waitCalls == 1, "WaitForTextures forwards to the backend");
+        Check(backend.m_waitThread != std::this_thread::get_id(), "the backend wait runs on the render thread");
+
+        // IGraphicsExtensions でないバックエンドでは同期読み込みになる
+        CheckingBackend plain;
+        ThreadedGraphics fallback(plain);
+        fallback.Initialize(nullptr, 1920, 1080);
+        const TextureHandle handle = fallback.LoadTextureAsync("plain.png");
+        fallback.WaitForTextures();
+        Check(fallback.GetTextureState(handle) == TextureLoadState::Ready, "without backend support it falls back to LoadTexture");
+        fallback.Finalize();
+    }
+
+    void TestOverlap()
+    {
+        std::printf("overlap (update 2 ms + draw 2 ms per frame)\n");
+        constexpr int FRAMES = 200;
+        const auto cost = std::chrono::microseconds(2000);
+
+        CheckingBackend serialBackend;
+        serialBackend.drawCost = cost;
+        std::vector<TextureHandle> textures{ serialBackend.LoadTexture("dummy.png") };
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t frame = 1; frame <= FRAMES; ++frame) {
+            BusyFor(cost);
+            DrawFrame(serialBackend, frame, textures);
+        }
+        const double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        CheckingBackend backend;
+        backend.drawCost = cost;
+        ThreadedGraphics graphics(backend);
+        graphics.Initialize(nullptr, 1920, 1080);
+        textures = { graphics.LoadTexture("dummy.png") };
+        start = std::chrono::steady_clock::now();
+        for (uint64_t frame = 1; frame <= FRAMES; ++frame) {
+            BusyFor(cost);
+            DrawFrame(graphics, frame, textures);
+        }
+        graphics.Flush();
+        const double threadedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        graphics.Finalize();
+
+        std::printf("  serial %.0f ms, threaded %.0f ms\n", serialMs, threadedMs);
+        if (std::thread::hardware_concurrency() >= 2) {
+            Check(threadedMs < serialMs * 0.75, "update and draw overlap");
+        }
+    }
+}
+
+int main()
+{
+    TestHandoff();
+    TestDeferredUnload();
+    TestLayers();
+    TestCounters();
+    TestLoadDuringSubmit();
+    TestAsyncLoad();
+    TestOverlap();
+
+    return TestCheck::Finish();
+}
@@ -0,0 +1,228 @@
+﻿/*****************************************************************//**
+ * @file   SoftwareRasterBench.cpp
+ * @brief  SoftwareGraphics の 1920x1080 フレーム時間の計測
+ *
+ * @details
+ * - 使い方（SeijakuRyokan ディレクトリで実行）
+ *     SoftwareRasterBench [frames] [threads] [out.png]
+ * - シーン（カーネル Scalar / SSE2 / AVX2 ごとに平均フレーム時間を出す）
+ *   - stress : 全画面の背景 ＋ 回転する半透明スプライト 2000 枚 ＋ 半透明の白矩形 500 枚 ＋ SDF 文字 400 枚。
+ *              重なりで 1 フレーム 12.6 Mpx 描く（不透明なのは背景だけなので、後ろからの除去はほぼ効かない）
+ *   - rooms  : ゲーム画面に近い構成。背景 ＋ 床タイル（48px・不透明）＋ 部屋の画像 12 枚（等倍・不透明）
+ *              ＋ 客 200 人 ＋ SDF 文字 200 枚
+ *   - culled : 後の不透明な Quad に隠れて 1 ピクセルも描かなかった（タイル, Quad）の数
+ *   - copied : 回転なし・等倍の不透明 Quad をテクセルの行コピーで描いたピクセル数
+ * - 計測（SoftwareRasterBench 10 1、1 コアの VM・AVX2。このマシンはスカラの単色ブレンドで 1px 10ns かかる）
+ *              前             後
+ *     stress : 192 ms 12.6 Mpx → 75 ms 12.6 Mpx（ミップでキャッシュミスが減り、SDF を AVX2 にした分）
+ *     rooms  :  32 ms  4.7 Mpx → 19 ms  2.6 Mpx（後ろからの除去で背景と床の下が消える）
+ *   複数コアでの時間はこの環境では測れていない（タイルは独立なので、よくてコア数に比例）
+ * - 「1080p を数 ms」は CPU ラスタライザの目標にしない。SoftwareGraphics は GPU の無い CI で
+ *   絵を確かめるためのもので、テクスチャ付きのブレンドはこのマシンの AVX2 で 1px 6ns 前後かかる。
+ *   目安は rooms 程度の画面で 1 コア 20 ms 前後。毎フレーム描くと 60fps には届かないので、CI では --draw-every で間引く
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -pthread -I. tools/SoftwareRasterBench/SoftwareRasterBench.cpp \
+ *         headless_src/Graphics/SoftwareGraphics.cpp headless_src/Graphics/SpanKernels.cpp \
+ *         common_src/Graphics/DrawCommandBuffer.cpp common_src/System/FrameArena.cpp \
+ *         common_src/System/MemoryTracker.cpp common_src/System/Profiler.cpp tools/Common/PngIO.cpp tools/Common/JpegIO.cpp \
+ *         -lpng -ljpeg -o SoftwareRasterBench
+ *********************************************************************/
+#include "../../headless_src/Graphics/SoftwareGraphics.h"
+#include "../../headless_src/Graphics/SpanKernels.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr int WIDTH = 1920;
+    constexpr int HEIGHT = 1080;
+
+    struct Sprite
+    {
+        float x, y, size, angle, speed;
+    };
+
+    // 円の距離場（アルファに距離、0.5 が輪郭）
+    TextureHandle MakeSdfTexture(SoftwareGraphics& g)
+    {
+        constexpr int N = 64;
+        std::vector<uint32_t> texels(N * N);
+        for (int y = 0; y < N; ++y) {
+            for (int x = 0; x < N; ++x) {
+                const float d = std::sqrt((x - N / 2 + 0.5f) * (x - N / 2 + 0.5f) + (y - N / 2 + 0.5f) * (y - N / 2 + 0.5f));
+                const float sd = std::fmin(std::fmax(0.5f + (20.0f - d) / 24.0f, 0.0f), 1.0f);
+                texels[y * N + x] = 0x00FFFFFFu | (static_cast<uint32_t>(sd * 255.0f + 0.5f) << 24);
+            }
+        }
+        return g.CreateTexture(N, N, texels.data());
+    }
+
+    void DrawStressScene(SoftwareGraphics& g, TextureHandle bg, TextureHandle sprite, TextureHandle sdf,
+        std::vector<Sprite>& sprites, int frame)
+    {
+        g.BeginDraw();
+
+        Quad back;
+        back.texture = bg;
+        back.position.x = WIDTH * 0.5f; back.position.y = HEIGHT * 0.5f;
+        back.size.x = WIDTH; back.size.y = HEIGHT;
+        g.DrawQuad(back);
+
+        for (size_t i = 0; i < sprites.size(); ++i) {
+            Sprite& s = sprites[i];
+            Quad q;
+            q.position.x = s.x; q.position.y = s.y;
+            q.size.x = s.size; q.size.y = s.size;
+            q.angleDeg = s.angle + frame * s.speed;
+            if (i < 2000) {
+                q.texture = sprite;
+                q.color = MyGame::Float4(1.0f, 1.0f, 1.0f, 0.9f);
+            }
+            else {
+                q.texture = nullptr; // 白矩形
+                q.color = MyGame::Float4(0.2f, 0.6f, 1.0f, 0.5f);
+                q.angleDeg = 0.0f;
+            }
+            g.DrawQuad(q);
+        }
+
+        g.SetSdfMode(true);
+        for (int i = 0; i < 400; ++i) {
+            Quad q;
+            q.texture = sdf;
+            q.position.x = 40.0f + (i % 40) * 46.0f;
+            q.position.y = 40.0f + (i / 40) * 46.0f;
+            q.size.x = 40.0f; q.size.y = 40.0f;
+            q.color = MyGame::Float4(1.0f, 0.9f, 0.7f, 1.0f);
+            g.DrawQuad(q);
+        }
+        g.SetSdfMode(false);
+
+        g.EndDraw();
+    }
+
+    void DrawRoomScene(SoftwareGraphics& g, TextureHandle bg, TextureHandle floor, TextureHandle room,
+        TextureHandle guest, TextureHandle sdf, int frame)
+    {
+        g.BeginDraw();
+
+        Quad back;
+        back.texture = bg;
+        back.position.x = WIDTH * 0.5f; back.position.y = HEIGHT * 0.5f;
+        back.size.x = WIDTH; back.size.y = HEIGHT;
+        g.DrawQuad(back);
+
+        // 床は画面全体を 48px のタイルで敷き詰める（背景は見えない）
+        constexpr int TILE = 48;
+        for (int y = 0; y < HEIGHT; y += TILE) {
+            for (int x = 0; x < WIDTH; x += TILE) {
+                Quad q;
+                q.texture = floor;
+                q.position.x = x + TILE * 0.5f; q.position.y = y + TILE * 0.5f;
+                q.size.x = TILE; q.size.y = TILE;
+                g.DrawQuad(q);
+            }
+        }
+
+        // 部屋は 190px の画像を等倍で 4x3 に並べる
+        for (int i = 0; i < 12; ++i) {
+            Quad q;
+            q.texture = room;
+            q.position.x = 300.0f + (i % 4) * 440.0f; q.position.y = 220.0f + (i / 4) * 320.0f;
+            q.size.x = 190.0f; q.size.y = 190.0f;
+            g.DrawQuad(q);
+        }
+
+        for (int i = 0; i < 200; ++i) {
+            Quad q;
+            q.texture = guest;
+            q.position.x = std::fmod(37.0f * i + frame * 3.0f, static_cast<float>(WIDTH));
+            q.position.y = std::fmod(53.0f * i + frame * 2.0f, static_cast<float>(HEIGHT));
+            q.size.x = 48.0f; q.size.y = 52.0f;
+            g.DrawQuad(q);
+        }
+
+        g.SetSdfMode(true);
+        for (int i = 0; i < 200; ++i) {
+            Quad q;
+            q.texture = sdf;
+            q.position.x = 20.0f + (i % 100) * 19.0f;
+            q.position.y = 1040.0f + (i / 100) * 20.0f;
+            q.size.x = 18.0f; q.size.y = 18.0f;
+            g.DrawQuad(q);
+        }
+        g.SetSdfMode(false);
+
+        g.EndDraw();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 60;
+    const unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0;
+    const char* outPath = argc > 3 ? argv[3] : nullptr;
+
+    SoftwareGraphics g(threads);
+    if (!g.Initialize(nullptr, WIDTH, HEIGHT)) {
+        return 1;
+    }
+    TextureHandle bg = g.LoadTexture("rom/images/title_bg.png");
+    TextureHandle sprite = g.LoadTexture("rom/images/guest.png");
+    TextureHandle floor = g.LoadTexture("rom/images/tile_floor.png");
+    TextureHandle room = g.LoadTexture("rom/images/room_bath.png");
+    TextureHandle sdf = MakeSdfTexture(g);
+    if (!bg || !sprite || !floor || !room) {
+        std::fprintf(stderr, "run from the SeijakuRyokan directory (rom/images is needed)\n");
+        return 1;
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> ux(0.0f, WIDTH), uy(0.0f, HEIGHT), us(24.0f, 96.0f), ua(0.0f, 360.0f), uv(-2.0f, 2.0f);
+    std::vector<Sprite> sprites(2500);
+    for (Sprite& s : sprites) {
+        s = { ux(rng), uy(rng), us(rng), ua(rng), uv(rng) };
+    }
+
+    std::printf("%dx%d, %u threads\n", WIDTH, HEIGHT, g.GetThreadCount());
+    const char* const sceneNames[] = { "stress", "rooms" };
+    const SpanKernelLevel best = GetSpanKernelLevel();
+    for (int scene = 0; scene < 2; ++scene) {
+        auto draw = [&](int f) {
+            if (scene == 0) {
+                DrawStressScene(g, bg, sprite, sdf, sprites, f);
+            }
+            else {
+                DrawRoomScene(g, bg, floor, room, sprite, sdf, f);
+            }
+        };
+        for (int level = 0; level <= static_cast<int>(best); ++level) {
+            SetSpanKernelLevel(static_cast<SpanKernelLevel>(level));
+            draw(0); // ウォームアップ
+
+            double total = 0.0, worst = 0.0;
+            for (int f = 0; f < frames; ++f) {
+                const auto t0 = std::chrono::steady_clock::now();
+                draw(f);
+                const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                total += ms;
+                worst = std::fmax(worst, ms);
+            }
+            const SoftwareRasterStats& st = g.GetStats();
+            std::printf("%-6s %-6s : avg %7.2f ms  worst %7.2f ms  (bin %.2f ms, %u quads, %u tile refs, %u culled, %.1f Mpx, %.1f Mpx copied)\n",
+                sceneNames[scene], GetSpanKernelName(static_cast<SpanKernelLevel>(level)), total / frames, worst,
+                st.binMicros / 1000.0, st.quads, st.tileRefs, st.culledRefs, st.pixels / 1e6, st.copiedPixels / 1e6);
+        }
+    }
+
+    // 保存するのは最後に描いた rooms
+    if (outPath && !g.SaveFramebuffer(outPath)) {
+        return 1;
+    }
+    return 0;
+}
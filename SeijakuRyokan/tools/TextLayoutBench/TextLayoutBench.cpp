@@ -0,0 +1,94 @@
+﻿/*****************************************************************//**
+ * @file   TextLayoutBench.cpp
+ * @brief  テキストレイアウトのキャッシュ有無の比較（文字の多い画面を模擬）
+ *
+ * @details
+ * - 使い方（SeijakuRyokan ディレクトリで実行）
+ *     TextLayoutBench [rom/fonts/sdf_atlas.glyphs] [frames]
+ * - 1フレームに「チュートリアル文 × 数本（固定）＋ スコア・客ごとのタイマー（数値が変化）」を描く想定
+ * - 毎フレーム全文をレイアウトする場合と TextLayoutCache を通す場合の
+ *   1フレームあたりのレイアウト時間とヒット率を出す
+ *
+ * - ビルド例（Linux）
+ *     g++ -std=c++17 -O2 -I. tools/TextLayoutBench/TextLayoutBench.cpp common_src/Graphics/TextLayoutCache.cpp \
+ *         common_src/Graphics/GlyphTable.cpp common_src/System/MappedFile.cpp -o TextLayoutBench
+ *********************************************************************/
+#include "../../common_src/Graphics/TextLayoutCache.h"
+#include "../../common_src/System/NumberText.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const char* const TUTORIAL[] = {
+        u8"お客様が到着しました。空いている客室へ案内しましょう。",
+        u8"温泉や食事処を建てると、お客様の満足度が上がります。",
+        u8"Press A to build a room, B to cancel.",
+        u8"待ち時間が長くなると、お客様は怒って帰ってしまいます。",
+    };
+    constexpr int GUESTS = 24;
+
+    // 1フレーム分の文字列を visit に渡す
+    template <typename Visit>
+    void EmitFrame(int frame, NumberText& number, Visit visit)
+    {
+        for (const char* line : TUTORIAL) {
+            visit(std::string_view(line), 28.0f, 640.0f, TextAlign::Left);
+        }
+        visit(number.Format(u8"スコア ", frame / 30 * 10), 32.0f, 0.0f, TextAlign::Right);
+        for (int g = 0; g < GUESTS; ++g) {
+            // 客ごとの残り秒数（1秒ごとに変わる）
+            visit(number.Format("", 90 - (frame / 60 + g) % 90, u8"秒"), 20.0f, 0.0f, TextAlign::Center);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* tablePath = argc > 1 ? argv[1] : "rom/fonts/sdf_atlas.glyphs";
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 3600;
+
+    GlyphTable glyphs;
+    if (!glyphs.Load(tablePath)) {
+        std::fprintf(stderr, "failed to load %s\n", tablePath);
+        return 1;
+    }
+
+    NumberText number;
+    size_t quads = 0;
+
+    // --- 毎フレームレイアウトし直す ---
+    TextLayout scratch;
+    Clock::time_point t0 = Clock::now();
+    for (int f = 0; f < frames; ++f) {
+        EmitFrame(f, number, [&](std::string_view text, float size, float wrap, TextAlign align) {
+            TextLayoutCache::Layout(glyphs, text, size, wrap, align, scratch);
+            quads += scratch.quads.size();
+        });
+    }
+    const double uncached = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / frames;
+
+    // --- キャッシュ経由 ---
+    TextLayoutCache cache(glyphs);
+    t0 = Clock::now();
+    for (int f = 0; f < frames; ++f) {
+        EmitFrame(f, number, [&](std::string_view text, float size, float wrap, TextAlign align) {
+            quads -= cache.Get(text, size, wrap, align).quads.size();
+        });
+        cache.EndFrame();
+    }
+    const double cached = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / frames;
+
+    const TextLayoutStats& total = cache.GetTotalStats();
+    std::printf("frames        : %d (%zu strings/frame)\n", frames, sizeof(TUTORIAL) / sizeof(TUTORIAL[0]) + 1 + GUESTS);
+    std::printf("uncached      : %8.2f us/frame\n", uncached);
+    std::printf("cached        : %8.2f us/frame (layout %.2f us/frame on misses)\n", cached, total.layoutMicros / frames);
+    std::printf("hit rate      : %6.2f %%  (hits %u, misses %u, evictions %u, entries %zu)\n",
+        total.GetHitRate() * 100.0f, total.hits, total.misses, total.evictions, cache.GetEntryCount());
+
+    // 両方で同じ数の Quad が出ていれば 0 に戻る
+    return quads == 0 ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+﻿/*****************************************************************//**
+ * @file   TextureCooker.cpp
+ * @brief  rom/images を BC圧縮＋ミップマップ付き DDS に焼くビルドツール
+ *
+ * @details
+ * - 使い方（SeijakuRyokan ディレクトリで実行）
+ *     TextureCooker [--format bc7|bc4|r8] [--no-mips] [--atlas atlas.json] rom/images rom/images/atlas
+ * - 入力はファイルまたはディレクトリ（直下の .png）。出力は同じ場所の同名 .dds
+ *   （rom/images/guest.png → rom/images/guest.dds）。LoadTexture が自動で優先する
+ * - bc7 : RGBA。ミップはアルファ乗算済みで縮小し、保存前に Straight Alpha に戻す
+ *         （描画側のブレンドは Straight Alpha 前提のまま）
+ * - bc4 : 1チャンネル。アルファを R に入れて保存する（SDF/マスク用）
+ * - r8  : bc4 と同じく1チャンネルだが非圧縮（SDF の精度を落としたくない場合）
+ * - SDF フォントアトラス（距離はアルファに入っている）は1チャンネルで焼く
+ *     TextureCooker --format bc4 rom/fonts/sdf_atlas.png
+ *   8192x4096 の RGBA8 で 128MB → BC4 で 16MB / R8 で 32MB（＋ミップ分 1/3）。
+ *   SpriteDrawer は R8/BC4 の SRV を見て距離を .r から読むシェーダに切り替える
+ * - BC はブロック単位なので、幅・高さが4の倍数でなければ4の倍数へリサイズする
+ * - アトラスのページ（--atlas のマニフェストに載っている画像。既定 rom/images/atlas/atlas.json）は
+ *   ミップを付けない。スプライト間の余白は数 px しかなく、2 段目以降のミップでは隣のスプライトが混ざるため
+ *
+ * - 画像の読み込みは WIC を使わず libpng/libjpeg で行う
+ * - ビルドは tools/TextureCooker/CMakeLists.txt。Windows ではゲームと同じ同梱の DirectXTex
+ *   （DirectXTex/x64 の .lib）をリンクする。同梱のヘッダは Windows 専用なので、Linux では公式の
+ *   DirectXTex を DirectX-Headers と一緒に入れてそのパッケージを使う（DirectXTex.h は include パスで切り替える）
+ *********************************************************************/
+#include "../Common/JpegIO.h"
+#include "../../common_src/Graphics/TextureAtlas.h"
+#include <DirectXTex.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+namespace fs = std::filesystem;
+
+namespace
+{
+    enum class CookFormat
+    {
+        BC7,
+        BC4,
+        R8,
+    };
+
+    struct Options
+    {
+        CookFormat format = CookFormat::BC7;
+        bool mips = true;
+        std::string atlas = "rom/images/atlas/atlas.json";
+        std::vector<std::string> inputs;
+        std::vector<fs::path> atlasPages; // ミップを付けない画像
+    };
+
+    constexpr TEX_FILTER_FLAGS FILTER = static_cast<TEX_FILTER_FLAGS>(TEX_FILTER_BOX | TEX_FILTER_FORCE_NON_WIC);
+
+    bool HasTranslucency(const RgbaImage& img)
+    {
+        for (size_t i = 3; i < img.pixels.size(); i += 4) {
+            if (img.pixels[i] != 0xFF) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool IsSingleChannel(CookFormat format)
+    {
+        return format == CookFormat::BC4 || format == CookFormat::R8;
+    }
+
+    const char* FormatName(CookFormat format)
+    {
+        switch (format) {
+        case CookFormat::BC4: return "BC4";
+        case CookFormat::R8:  return "R8";
+        default:              return "BC7";
+        }
+    }
+
+    // RgbaImage → ScratchImage（bc4 / r8 はアルファを R8 に取り出す）
+    HRESULT ToScratch(const RgbaImage& img, CookFormat format, ScratchImage& out)
+    {
+        const DXGI_FORMAT fmt = IsSingleChannel(format) ? DXGI_FORMAT_R8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+        HRESULT hr = out.Initialize2D(fmt, img.width, img.height, 1, 1);
+        if (FAILED(hr)) {
+            return hr;
+        }
+        const Image* dst = out.GetImage(0, 0, 0);
+        for (int y = 0; y < img.height; ++y) {
+            uint8_t* row = dst->pixels + dst->rowPitch * y;
+            if (IsSingleChannel(format)) {
+                for (int x = 0; x < img.width; ++x) {
+                    row[x] = img.At(x, y)[3];
+                }
+            }
+            else {
+                std::memcpy(row, img.At(0, y), static_cast<size_t>(img.width) * 4);
+            }
+        }
+        return S_OK;
+    }
+
+    bool IsAtlasPage(const std::string& src, const Options& opt)
+    {
+        const fs::path path = fs::weakly_canonical(src);
+        return std::find(opt.atlasPages.begin(), opt.atlasPages.end(), path) != opt.atlasPages.end();
+    }
+
+    bool Cook(const std::string& src, const Options& opt)
+    {
+        RgbaImage img;
+        if (!LoadImageRgba(src, img)) {
+            return false;
+        }
+        const bool mips = opt.mips && !IsAtlasPage(src, opt);
+
+        ScratchImage image;
+        HRESULT hr = ToScratch(img, opt.format, image);
+
+        // BC はブロック（4x4）単位なので最上位ミップを4の倍数に揃える
+        const size_t w4 = (static_cast<size_t>(img.width) + 3) & ~size_t(3);
+        const size_t h4 = (static_cast<size_t>(img.height) + 3) & ~size_t(3);
+        if (SUCCEEDED(hr) && opt.format != CookFormat::R8 && (w4 != static_cast<size_t>(img.width) || h4 != static_cast<size_t>(img.height))) {
+            ScratchImage resized;
+            hr = Resize(*image.GetImage(0, 0, 0), w4, h4, FILTER, resized);
+            if (SUCCEEDED(hr)) image = std::move(resized);
+        }
+
+        // アルファ乗算済みで縮小しないと、透明部分の色が縁に滲む
+        const bool premultiply = opt.format == CookFormat::BC7 && mips && HasTranslucency(img);
+        if (SUCCEEDED(hr) && premultiply) {
+            ScratchImage pm;
+            hr = PremultiplyAlpha(*image.GetImage(0, 0, 0), TEX_PMALPHA_IGNORE_SRGB, pm);
+            if (SUCCEEDED(hr)) image = std::move(pm);
+        }
+
+        if (SUCCEEDED(hr) && mips) {
+            ScratchImage mipChain;
+            hr = GenerateMipMaps(*image.GetImage(0, 0, 0), FILTER, 0, mipChain);
+            if (SUCCEEDED(hr)) image = std::move(mipChain);
+        }
+
+        if (SUCCEEDED(hr) && premultiply) {
+            ScratchImage straight;
+            hr = PremultiplyAlpha(image.GetImages(), image.GetImageCount(), image.GetMetadata(),
+                static_cast<TEX_PMALPHA_FLAGS>(TEX_PMALPHA_IGNORE_SRGB | TEX_PMALPHA_REVERSE), straight);
+            if (SUCCEEDED(hr)) image = std::move(straight);
+        }
+
+        if (SUCCEEDED(hr) && opt.format != CookFormat::R8) {
+            const DXGI_FORMAT target = (opt.format == CookFormat::BC4) ? DXGI_FORMAT_BC4_UNORM : DXGI_FORMAT_BC7_UNORM;
+            ScratchImage compressed;
+            hr = Compress(image.GetImages(), image.GetImageCount(), image.GetMetadata(),
+                target, TEX_COMPRESS_PARALLEL, TEX_THRESHOLD_DEFAULT, compressed);
+            if (SUCCEEDED(hr)) image = std::move(compressed);
+        }
+
+        const fs::path dst = fs::path(src).replace_extension(".dds");
+        if (SUCCEEDED(hr)) {
+            hr = SaveToDDSFile(image.GetImages(), image.GetImageCount(), image.GetMetadata(),
+                DDS_FLAGS_NONE, dst.wstring().c_str());
+        }
+        if (FAILED(hr)) {
+            std::fprintf(stderr, "failed to cook %s (hr=0x%08x)\n", src.c_str(), static_cast<unsigned>(hr));
+            return false;
+        }
+
+        const TexMetadata& meta = image.GetMetadata();
+        std::printf("%-32s -> %s  %zux%zu, %zu mips, %s (%zu KB, RGBA8 %zu KB)\n",
+            src.c_str(), dst.filename().string().c_str(), meta.width, meta.height, meta.mipLevels,
+            FormatName(opt.format),
+            static_cast<size_t>(fs::file_size(dst) / 1024), static_cast<size_t>(img.width) * img.height * 4 / 1024);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char* f = argv[++i];
+            if (std::strcmp(f, "bc7") == 0) opt.format = CookFormat::BC7;
+            else if (std::strcmp(f, "bc4") == 0) opt.format = CookFormat::BC4;
+            else if (std::strcmp(f, "r8") == 0) opt.format = CookFormat::R8;
+            else { std::fprintf(stderr, "unknown format %s\n", f); return 1; }
+        }
+        else if (std::strcmp(argv[i], "--no-mips") == 0) {
+            opt.mips = false;
+        }
+        else if (std::strcmp(argv[i], "--atlas") == 0 && i + 1 < argc) {
+            opt.atlas = argv[++i];
+        }
+        else {
+            opt.inputs.push_back(argv[i]);
+        }
+    }
+    if (opt.inputs.empty()) {
+        std::printf("usage: TextureCooker [--format bc7|bc4|r8] [--no-mips] [--atlas atlas.json] <file-or-dir>...\n");
+        return 1;
+    }
+
+    // マニフェストが無ければアトラスは無いものとして、すべてミップ付きで焼く
+    AtlasManifest manifest;
+    if (manifest.Load(opt.atlas.c_str())) {
+        for (const AtlasPage& page : manifest.GetPages()) {
+            opt.atlasPages.push_back(fs::weakly_canonical(page.file));
+        }
+    }
+
+    int failed = 0;
+    for (const std::string& input : opt.inputs) {
+        if (fs::is_directory(input)) {
+            std::vector<std::string> files;
+            for (const auto& entry : fs::directory_iterator(input)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".png") {
+                    files.push_back(entry.path().generic_string());
+                }
+            }
+            std::sort(files.begin(), files.end());
+            for (const std::string& file : files) {
+                failed += Cook(file, opt) ? 0 : 1;
+            }
+        }
+        else {
+            failed += Cook(input, opt) ? 0 : 1;
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}